@@ -0,0 +1,105 @@
+﻿// Bench v 1.0
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 无窗口的基准与正确性检查程序（bench.vcxproj）。不创建 GL 上下文，只调用各模块的 CPU 部分
+// （用到 GL 的模块随 glad 一起链接，但用例不调用 createGL / upload / draw）。
+// 每个用例用 BENCH_CASE 注册，按名字排序依次运行：
+//   bench [名字子串 ...] [--scale s] [--repeat n]
+// --scale 按比例缩放用例的数据规模（默认 1，即请求里给出的规模），--repeat 为每项测量的重复次数，取最短。
+// 任一检查失败时退出码非 0
+class BenchContext {
+private:
+    std::string name_;
+    double scale_ = 1.0;
+    int repeat_ = 3;
+    int failures_ = 0;
+public:
+    BenchContext(const std::string& name, double scale, int repeat)
+        : name_(name), scale_(scale), repeat_(std::max(repeat, 1)) {
+
+    }
+
+    const std::string& name() const {
+        return name_;
+    }
+    double scale() const {
+        return scale_;
+    }
+    int repeat() const {
+        return repeat_;
+    }
+    int failures() const {
+        return failures_;
+    }
+
+    // 按 --scale 缩放的数据规模，至少为 minimum
+    size_t scaled(size_t n, size_t minimum = 1) const {
+        return std::max(minimum, size_t(double(n) * scale_));
+    }
+
+    // ok 为 false 时记一次失败并打印 what（printf 格式）
+    bool check(bool ok, const char* what, ...);
+    // 打印一行测量结果（printf 格式）
+    void report(const char* what, ...);
+
+    // fn 运行 repeat 次，返回最短一次的耗时（毫秒）
+    template <typename Fn>
+    double best(Fn&& fn) {
+        double result = 0.0;
+        for (int i = 0; i < repeat_; ++i) {
+            auto t0 = std::chrono::steady_clock::now();
+            fn();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            result = i == 0 ? ms : std::min(result, ms);
+        }
+        return result;
+    }
+};
+
+using BenchFunction = void (*)(BenchContext&);
+
+struct BenchCase {
+    const char* name;
+    BenchFunction function;
+};
+
+std::vector<BenchCase>& benchCases();
+
+struct BenchRegistrar {
+    BenchRegistrar(const char* name, BenchFunction function) {
+        benchCases().push_back({ name, function });
+    }
+};
+
+#define BENCH_CASE(name) \
+    static void bench_##name(BenchContext& ctx); \
+    static BenchRegistrar benchRegistrar_##name(#name, bench_##name); \
+    static void bench_##name(BenchContext& ctx)
+
+// 可复现的伪随机数（xorshift），各用例生成合成数据用，不依赖标准库实现
+class BenchRandom {
+private:
+    uint64_t state_;
+public:
+    explicit BenchRandom(uint64_t seed) : state_(seed * 0x9E3779B97F4A7C15ull + 1) {
+
+    }
+
+    uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+    // [lo, hi) 内的均匀分布
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * float(next() >> 40) * (1.0f / 16777216.0f);
+    }
+};
@@ -0,0 +1,110 @@
+﻿// BenchAtomBuffers v 1.0
+#include "Bench.h"
+#include "AtomBuffers.h"
+#include "Element.h"
+#include "SphereImpostor.h"
+#include <cstring>
+
+namespace {
+    AtomTable makeAtoms(size_t n) {
+        AtomTable atoms;
+        atoms.resizeAtoms(n);
+        BenchRandom random(11);
+        const uint8_t elements[5] = { 1, 6, 7, 8, 16 };
+        for (size_t i = 0; i < n; ++i) {
+            atoms.x[i] = random.uniform(-500.0f, 500.0f);
+            atoms.y[i] = random.uniform(-500.0f, 500.0f);
+            atoms.z[i] = random.uniform(-500.0f, 500.0f);
+            atoms.element[i] = elements[random.next() % 5];
+        }
+        return atoms;
+    }
+
+    // 区间按 begin 升序、互不重叠，相邻区间至少隔开 kMergeGap
+    bool wellFormed(const DirtyRanges& dirty) {
+        const std::vector<DirtyRanges::Range>& r = dirty.ranges();
+        for (size_t k = 0; k < r.size(); ++k) {
+            if (r[k].begin >= r[k].end) return false;
+            if (k > 0 && r[k - 1].end + DirtyRanges::kMergeGap >= r[k].begin) return false;
+        }
+        return true;
+    }
+
+    bool covers(const DirtyRanges& dirty, size_t index) {
+        for (const DirtyRanges::Range& r : dirty.ranges()) {
+            if (index >= r.begin && index < r.end) return true;
+        }
+        return false;
+    }
+}
+
+// 原子球与键共用 AtomBuffers：打包与轨迹帧更新只写一份逐原子数据；
+// 另测不对应原子的球经 SphereImpostor::setInstances 进入自有实例数组的耗时
+BENCH_CASE(atom_buffers) {
+    const size_t n = ctx.scaled(1000000, 1000);
+    AtomTable atoms = makeAtoms(n);
+    AtomBuffers buffers;
+    double packMs = ctx.best([&] {
+        buffers.pack(atoms);
+    });
+    double frameMs = ctx.best([&] {
+        buffers.updatePositions(atoms.x.data(), atoms.y.data(), atoms.z.data());
+    });
+
+    double bytesPerAtom = double(buffers.positions().size() * sizeof(float) + buffers.colors().size() * 4) / double(n);
+    ctx.report("%zu atoms: pack %.2f ms, frame update %.2f ms, %.0f B/atom", n, packMs, frameMs, bytesPerAtom);
+
+    // 不对应原子的球（StructureLod 的残基球，约每 10 个原子一个）走 setInstances，自带实例数组
+    RenderAnchor residueAnchor;
+    residueAnchor.setWorld(glm::dvec3(atoms.x[0], atoms.y[0], atoms.z[0]));
+    std::vector<SphereInstance> residues(n / 10);
+    for (size_t r = 0; r < residues.size(); ++r) {
+        const size_t a = 10 * r;
+        residues[r] = SphereInstance{ float(atoms.x[a] - residueAnchor.world.x), float(atoms.y[a] - residueAnchor.world.y),
+            float(atoms.z[a] - residueAnchor.world.z), 3.0f, buffers.colors()[a] };
+    }
+    SphereImpostor impostor;
+    double instancesMs = ctx.best([&] {
+        impostor.setInstances(residues, residueAnchor);
+    });
+    ctx.report("%zu residue spheres: setInstances %.2f ms, %zu B/sphere", residues.size(), instancesMs,
+        sizeof(SphereInstance));
+    ctx.check(impostor.sphereCount() == residues.size() &&
+        std::memcmp(impostor.instances().data(), residues.data(), residues.size() * sizeof(SphereInstance)) == 0,
+        "setInstances did not keep the residue spheres");
+
+    // 坐标相对原子所在块的锚点
+    bool packed = buffers.atomCount() == n;
+    for (size_t i = 0; packed && i < n; i += 4099) {
+        const glm::dvec3 anchor = buffers.blockAnchor(buffers.atomBlock(i)).world;
+        const float* p = &buffers.positions()[4 * i];
+        packed = p[0] == float(double(atoms.x[i]) - anchor.x) && p[1] == float(double(atoms.y[i]) - anchor.y) &&
+            p[2] == float(double(atoms.z[i]) - anchor.z) && p[3] == vdwRadius(atoms.element[i]) &&
+            buffers.colors()[i] == elementColor(atoms.element[i]);
+    }
+    ctx.check(packed, "packed positions, radii or colors differ from the atom table");
+
+    // 稀疏修改：每次只标记改动的原子，脏区间必须覆盖它们且保持有序
+    AtomBuffers sparse;
+    sparse.pack(atoms);
+    sparse.clearDirty();
+    BenchRandom random(12);
+    std::vector<size_t> touched;
+    for (int k = 0; k < 1000; ++k) {
+        size_t atom = size_t(random.next() % n);
+        sparse.setColor(atom, 0xFF00FF00u);
+        touched.push_back(atom);
+    }
+    size_t missing = 0;
+    for (size_t atom : touched) missing += covers(sparse.dirtyColors(), atom) ? 0 : 1;
+    ctx.report("1000 scattered color edits: %zu ranges, %zu colors to upload", sparse.dirtyColors().ranges().size(),
+        sparse.dirtyColors().count());
+    ctx.check(missing == 0, "%zu edited atoms are not covered by a dirty range", missing);
+    ctx.check(wellFormed(sparse.dirtyColors()), "color dirty ranges are unsorted, overlapping or unmerged");
+
+    size_t half = n / 2;
+    sparse.updatePositions(atoms.x.data(), atoms.y.data(), atoms.z.data(), half, half + 100);
+    sparse.setRadius(half + 150, 2.0f);
+    ctx.check(sparse.dirtyPositions().ranges().size() == 1 && sparse.dirtyPositions().ranges()[0].begin == half &&
+        sparse.dirtyPositions().ranges()[0].end == half + 151, "nearby position edits were not merged into one range");
+}
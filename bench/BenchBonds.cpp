@@ -0,0 +1,88 @@
+﻿// BenchBonds v 1.0
+#include "Bench.h"
+#include "AtomTable.h"
+#include "BondPerception.h"
+#include "Element.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+    // 每行的相邻原子：行内升序，且 i 出现在 j 的行里当且仅当 j 出现在 i 的行里
+    bool validCsr(const BondTable& bonds, size_t atomCount) {
+        if (bonds.offsets.size() != atomCount + 1 || bonds.offsets.back() != bonds.neighbors.size()) return false;
+        for (size_t a = 0; a < atomCount; ++a) {
+            const uint32_t* begin = bonds.neighbors.data() + bonds.offsets[a];
+            const uint32_t* end = bonds.neighbors.data() + bonds.offsets[a + 1];
+            if (!std::is_sorted(begin, end)) return false;
+            for (const uint32_t* p = begin; p < end; ++p) {
+                const uint32_t* row = bonds.neighbors.data() + bonds.offsets[*p];
+                const uint32_t* rowEnd = bonds.neighbors.data() + bonds.offsets[*p + 1];
+                if (!std::binary_search(row, rowEnd, uint32_t(a))) return false;
+            }
+        }
+        return true;
+    }
+}
+
+// 随机原子与暴力枚举逐对比较；大规模的碳链晶格测耗时
+BENCH_CASE(bond_perception) {
+    BondPerception perception;
+    BondTable bonds;
+
+    {
+        const size_t n = 3000;
+        const uint8_t elements[5] = { 1, 6, 7, 8, 16 };
+        AtomTable atoms;
+        atoms.resizeAtoms(n);
+        BenchRandom random(8);
+        for (size_t i = 0; i < n; ++i) {
+            atoms.x[i] = random.uniform(0.0f, 12.0f);
+            atoms.y[i] = random.uniform(0.0f, 12.0f);
+            atoms.z[i] = random.uniform(0.0f, 12.0f);
+            atoms.element[i] = elements[random.next() % 5];
+        }
+        perception.perceive(atoms, bonds);
+
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                float dx = atoms.x[i] - atoms.x[j];
+                float dy = atoms.y[i] - atoms.y[j];
+                float dz = atoms.z[i] - atoms.z[j];
+                float d2 = dx * dx + dy * dy + dz * dz;
+                float limit = covalentRadius(atoms.element[i]) + covalentRadius(atoms.element[j]) + 0.45f;
+                if (d2 <= limit * limit && d2 >= 0.16f && !(atoms.element[i] == 1 && atoms.element[j] == 1)) {
+                    expected.push_back(uint32_t(i));
+                    expected.push_back(uint32_t(j));
+                }
+            }
+        }
+        std::vector<uint32_t> pairs;
+        bondPairs(bonds, pairs);
+        ctx.check(validCsr(bonds, n), "bond table rows are not sorted and symmetric");
+        ctx.check(pairs == expected, "%zu bonds, brute force finds %zu", pairs.size() / 2, expected.size() / 2);
+    }
+
+    // 碳原子沿 x 间隔 1.5 埃成链，链之间相隔 4 埃：只有同一行的相邻原子成键
+    const size_t n = ctx.scaled(1000000, 1000);
+    const size_t side = size_t(std::cbrt(double(n))) + 1;
+    AtomTable lattice;
+    lattice.resizeAtoms(n);
+    size_t expectedBonds = 0;
+    for (size_t i = 0; i < n; ++i) {
+        size_t xx = i % side;
+        size_t yy = i / side % side;
+        size_t zz = i / (side * side);
+        lattice.x[i] = float(xx) * 1.5f;
+        lattice.y[i] = float(yy) * 4.0f;
+        lattice.z[i] = float(zz) * 4.0f;
+        lattice.element[i] = 6;
+        if (xx > 0) ++expectedBonds;
+    }
+    double ms = ctx.best([&] {
+        perception.perceive(lattice, bonds);
+    });
+    ctx.report("%zu atoms, %zu bonds: %.1f ms", n, bonds.bondCount(), ms);
+    ctx.check(bonds.bondCount() == expectedBonds, "%zu lattice bonds, expected %zu", bonds.bondCount(), expectedBonds);
+}
@@ -0,0 +1,209 @@
+﻿// BenchBvh v 1.0
+#include "Bench.h"
+#include "Bvh.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    struct Spheres {
+        std::vector<float> x, y, z, radius;
+    };
+
+    // 盒子里均匀分布的原子（数密度约为蛋白质的一半），半径 1.5 - 1.9 埃。
+    // coherent 时按 8 埃的格子排序，近似真实文件里逐残基排列的局部性；否则完全打乱
+    Spheres makeSpheres(size_t n, uint64_t seed, bool coherent) {
+        Spheres s;
+        BenchRandom random(seed);
+        float side = std::cbrt(float(n) / 0.05f);
+        for (size_t i = 0; i < n; ++i) {
+            s.x.push_back(random.uniform(0.0f, side));
+            s.y.push_back(random.uniform(0.0f, side));
+            s.z.push_back(random.uniform(0.0f, side));
+            s.radius.push_back(random.uniform(1.5f, 1.9f));
+        }
+        if (!coherent) return s;
+        std::vector<uint64_t> key(n);
+        std::vector<uint32_t> order(n);
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t cx = uint64_t(s.x[i] / 8.0f), cy = uint64_t(s.y[i] / 8.0f), cz = uint64_t(s.z[i] / 8.0f);
+            key[i] = (cz << 40) | (cy << 20) | cx;
+            order[i] = uint32_t(i);
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return key[a] < key[b];
+        });
+        Spheres sorted;
+        for (uint32_t i : order) {
+            sorted.x.push_back(s.x[i]);
+            sorted.y.push_back(s.y[i]);
+            sorted.z.push_back(s.z[i]);
+            sorted.radius.push_back(s.radius[i]);
+        }
+        return sorted;
+    }
+
+    // 轨迹帧：每个原子移动 0.2 埃以内
+    Spheres jitter(const Spheres& s, BenchRandom& random) {
+        Spheres moved = s;
+        for (size_t i = 0; i < s.x.size(); ++i) {
+            moved.x[i] += random.uniform(-0.2f, 0.2f);
+            moved.y[i] += random.uniform(-0.2f, 0.2f);
+            moved.z[i] += random.uniform(-0.2f, 0.2f);
+        }
+        return moved;
+    }
+
+    // 射线与球的最近交点，没有交点时返回 false
+    bool raySphere(const float o[3], const float d[3], float cx, float cy, float cz, float r, float& t) {
+        float ox = o[0] - cx, oy = o[1] - cy, oz = o[2] - cz;
+        float b = ox * d[0] + oy * d[1] + oz * d[2];
+        float c = ox * ox + oy * oy + oz * oz - r * r;
+        float disc = b * b - c;
+        if (disc < 0.0f) return false;
+        t = -b - std::sqrt(disc);
+        return t >= 0.0f;
+    }
+
+    // 每个节点的盒子包住它的全部图元，order 是图元下标的排列，slot 是它的逆，
+    // 图元包围盒按 order 排列且与原始数据一致
+    bool consistent(const Bvh& bvh, const Spheres& s) {
+        const AabbArray& boxes = bvh.boxes();
+        std::vector<uint8_t> seen(bvh.primitiveCount(), 0);
+        for (size_t k = 0; k < bvh.order().size(); ++k) {
+            uint32_t p = bvh.order()[k];
+            if (p >= seen.size() || seen[p] || bvh.slot(p) != k) return false;
+            seen[p] = 1;
+            if (boxes.minX[k] != s.x[p] - s.radius[p] || boxes.maxZ[k] != s.z[p] + s.radius[p]) return false;
+        }
+        for (const BvhNode& node : bvh.nodes()) {
+            for (uint32_t k = node.first; k < node.first + node.count; ++k) {
+                if (boxes.minX[k] < node.lo[0] || boxes.minY[k] < node.lo[1] || boxes.minZ[k] < node.lo[2] ||
+                    boxes.maxX[k] > node.hi[0] || boxes.maxY[k] > node.hi[1] || boxes.maxZ[k] > node.hi[2]) return false;
+            }
+        }
+        return bvh.order().size() == bvh.primitiveCount();
+    }
+}
+
+// 1M 原子：构建、轨迹帧 refit 的耗时（目标分别约 100 ms 与 1 ms）；
+// 视锥剔除、邻近查询与射线求交与暴力结果一致，并和暴力做法比较耗时
+BENCH_CASE(bvh) {
+    const size_t n = ctx.scaled(1000000, 1000);
+    BenchRandom random(41);
+    {
+        // 原子顺序打乱时的对照：叶子里的图元在内存中分散，构建与 refit 都更慢
+        Spheres shuffled = makeSpheres(n, 40, false);
+        Spheres moved = jitter(shuffled, random);
+        Bvh bvh;
+        double buildMs = ctx.best([&] {
+            bvh.build(shuffled.x.data(), shuffled.y.data(), shuffled.z.data(), shuffled.radius.data(), n);
+        });
+        double refitMs = ctx.best([&] {
+            bvh.refit(moved.x.data(), moved.y.data(), moved.z.data(), moved.radius.data(), n);
+        });
+        ctx.report("%zu atoms, shuffled order: build %.1f ms, refit %.2f ms", n, buildMs, refitMs);
+    }
+
+    Spheres s = makeSpheres(n, 40, true);
+    Bvh bvh;
+    double buildMs = ctx.best([&] {
+        bvh.build(s.x.data(), s.y.data(), s.z.data(), s.radius.data(), n);
+    });
+    ctx.check(consistent(bvh, s), "BVH nodes do not bound their primitives after build");
+    Spheres moved = jitter(s, random);
+    double refitMs = ctx.best([&] {
+        bvh.refit(moved.x.data(), moved.y.data(), moved.z.data(), moved.radius.data(), n);
+    });
+    ctx.check(consistent(bvh, moved), "BVH nodes do not bound their primitives after refit");
+    ctx.report("%zu atoms, file order: build %.1f ms, refit %.2f ms, %zu nodes", n, buildMs, refitMs,
+        bvh.nodes().size());
+
+    // 视锥剔除：从盒子一角看向中心，约一部分原子在视锥内
+    float side = std::cbrt(float(n) / 0.05f);
+    glm::vec3 center(0.5f * side);
+    glm::mat4 view = glm::lookAt(glm::vec3(-0.2f * side, 0.3f * side, 1.4f * side), center, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(30.0f), 16.0f / 9.0f, 1.0f, 10.0f * side);
+    FrustumCuller culler;
+    culler.setMatrices(projection, view);
+    // 平铺的对照直接扫 Bvh 内按叶子顺序的盒子，结果换回图元下标
+    std::vector<uint32_t> flat, hierarchical;
+    double flatMs = ctx.best([&] {
+        flat.clear();
+        culler.cull(bvh.boxes(), flat);
+    });
+    for (uint32_t& k : flat) k = bvh.order()[k];
+    double bvhCullMs = ctx.best([&] {
+        hierarchical.clear();
+        bvh.cull(culler, hierarchical);
+    });
+    std::sort(flat.begin(), flat.end());
+    std::sort(hierarchical.begin(), hierarchical.end());
+    ctx.report("frustum cull: %zu of %zu visible, flat SIMD %.2f ms, BVH %.2f ms", hierarchical.size(), n, flatMs,
+        bvhCullMs);
+    ctx.check(flat == hierarchical, "BVH cull returns %zu boxes, flat cull %zu", hierarchical.size(), flat.size());
+
+    // 邻近查询：100 个 10 埃的盒子
+    size_t overlapMismatch = 0;
+    const AabbArray& boxes = bvh.boxes();
+    for (int q = 0; q < 100; ++q) {
+        float lo[3] = { random.uniform(0.0f, side), random.uniform(0.0f, side), random.uniform(0.0f, side) };
+        float hi[3] = { lo[0] + 10.0f, lo[1] + 10.0f, lo[2] + 10.0f };
+        std::vector<uint32_t> found, expected;
+        bvh.forEachOverlap(lo, hi, [&](uint32_t p) {
+            found.push_back(p);
+        });
+        for (size_t k = 0; k < n; ++k) {
+            if (boxes.minX[k] <= hi[0] && boxes.maxX[k] >= lo[0] && boxes.minY[k] <= hi[1] && boxes.maxY[k] >= lo[1] &&
+                boxes.minZ[k] <= hi[2] && boxes.maxZ[k] >= lo[2]) expected.push_back(bvh.order()[k]);
+        }
+        std::sort(found.begin(), found.end());
+        std::sort(expected.begin(), expected.end());
+        overlapMismatch += found == expected ? 0 : 1;
+    }
+    ctx.check(overlapMismatch == 0, "%zu of 100 overlap queries differ from brute force", overlapMismatch);
+
+    // 拾取射线：从盒子外射向随机点，最近的命中原子与暴力一致
+    const int rayCount = 200;
+    std::vector<glm::vec3> origins, dirs;
+    for (int r = 0; r < rayCount; ++r) {
+        glm::vec3 target(random.uniform(0.0f, side), random.uniform(0.0f, side), random.uniform(0.0f, side));
+        glm::vec3 origin(random.uniform(0.0f, side), random.uniform(0.0f, side), -0.5f * side);
+        origins.push_back(origin);
+        dirs.push_back(glm::normalize(target - origin));
+    }
+    std::vector<uint32_t> bvhHits(rayCount), bruteHits(rayCount);
+    double rayMs = ctx.best([&] {
+        for (int r = 0; r < rayCount; ++r) {
+            const float o[3] = { origins[r].x, origins[r].y, origins[r].z };
+            const float d[3] = { dirs[r].x, dirs[r].y, dirs[r].z };
+            float tMax = 1e30f;
+            uint32_t best = 0xffffffffu;
+            bvh.traceRay(o, d, tMax, [&](uint32_t p, float& t) {
+                float hit;
+                if (raySphere(o, d, moved.x[p], moved.y[p], moved.z[p], moved.radius[p], hit) && hit < t) {
+                    t = hit;
+                    best = p;
+                }
+            });
+            bvhHits[r] = best;
+        }
+    });
+    double bruteMs = ctx.best([&] {
+        for (int r = 0; r < rayCount; ++r) {
+            const float o[3] = { origins[r].x, origins[r].y, origins[r].z };
+            const float d[3] = { dirs[r].x, dirs[r].y, dirs[r].z };
+            float tMax = 1e30f;
+            uint32_t best = 0xffffffffu;
+            for (size_t p = 0; p < n; ++p) {
+                float hit;
+                if (raySphere(o, d, moved.x[p], moved.y[p], moved.z[p], moved.radius[p], hit) && hit < tMax) {
+                    tMax = hit;
+                    best = uint32_t(p);
+                }
+            }
+            bruteHits[r] = best;
+        }
+    });
+    ctx.report("%d pick rays: BVH %.3f ms, brute force %.1f ms", rayCount, rayMs, bruteMs);
+    ctx.check(bvhHits == bruteHits, "BVH ray hits differ from brute force");
+}
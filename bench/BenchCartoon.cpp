@@ -0,0 +1,110 @@
+﻿// BenchCartoon v 1.0
+#include "Bench.h"
+#include "AtomTable.h"
+#include "CartoonBuilder.h"
+#include <cstring>
+#include <glm/glm.hpp>
+
+namespace {
+    // Cα 间距 3.6 埃的随机折线链，二级结构按给定模式循环；每 7 个残基缺一个 O
+    AtomTable makeTrace(size_t residueCount, const char* pattern, uint64_t seed) {
+        static const char* names[4] = { "N", "CA", "C", "O" };
+        static const uint8_t elements[4] = { 7, 6, 6, 8 };
+        AtomTable table;
+        BenchRandom random(seed);
+        Chain chain;
+        chain.id = uint32_t('A');
+        chain.firstResidue = 0;
+        chain.residueCount = uint32_t(residueCount);
+        table.chains.push_back(chain);
+        size_t patternLength = std::strlen(pattern);
+        glm::vec3 ca(0.0f);
+        glm::vec3 direction(1.0f, 0.0f, 0.0f);
+        for (size_t r = 0; r < residueCount; ++r) {
+            glm::vec3 turn(random.uniform(-0.6f, 0.6f), random.uniform(-0.6f, 0.6f), random.uniform(-0.6f, 0.6f));
+            direction = glm::normalize(direction + turn);
+            ca += 3.6f * direction;
+            glm::vec3 side = glm::normalize(glm::cross(direction, glm::vec3(0.3f, 1.0f, 0.2f)));
+            if (r % 2 == 1) side = -side;
+            const glm::vec3 p[4] = { ca - 1.2f * direction, ca, ca + 1.2f * direction, ca + 1.2f * direction + 1.2f * side };
+
+            Residue res;
+            res.name = packName4("ALA", 3);
+            res.seq = int32_t(r) + 1;
+            res.chain = 0;
+            res.firstAtom = uint32_t(table.x.size());
+            res.atomCount = r % 7 == 3 ? 3 : 4;
+            char code = pattern[r % patternLength];
+            res.ss = code == 'H' ? SecondaryStructure::AlphaHelix : code == 'E' ? SecondaryStructure::Strand :
+                SecondaryStructure::Coil;
+            for (uint32_t k = 0; k < res.atomCount; ++k) {
+                table.x.push_back(p[k].x);
+                table.y.push_back(p[k].y);
+                table.z.push_back(p[k].z);
+                table.element.push_back(elements[k]);
+                table.name.push_back(packName4(names[k], k == 1 ? 2 : 1));
+                table.flags.push_back(0);
+                table.residueIndex.push_back(int32_t(r));
+                table.chainIndex.push_back(0);
+            }
+            table.residues.push_back(res);
+        }
+        return table;
+    }
+
+    bool sameMesh(const Mesh& a, const Mesh& b) {
+        return a.positions == b.positions && a.normals == b.normals && a.atomIds == b.atomIds && a.indices == b.indices;
+    }
+
+    Mesh buildFresh(const AtomTable& table, const std::vector<float>& x, const std::vector<float>& y,
+        const std::vector<float>& z) {
+        CartoonBuilder builder;
+        builder.prepare(table);
+        builder.build(x.data(), y.data(), z.data());
+        return builder.mesh();
+    }
+}
+
+// 逐帧增量重建只重建坐标变化波及的段，结果必须与从头生成完全一致：
+// 依次移动每个残基的 Cα，增量结果与新建的 CartoonBuilder 逐字节比较
+BENCH_CASE(cartoon) {
+    const char* pattern = "CCCCEEEEEEECCCHHHHHHHHHHCCEEEEECCC";
+    {
+        AtomTable table = makeTrace(120, pattern, 13);
+        std::vector<float> x = table.x, y = table.y, z = table.z;
+        CartoonBuilder incremental;
+        incremental.prepare(table);
+        incremental.build(x.data(), y.data(), z.data());
+        size_t mismatched = 0;
+        for (size_t r = 0; r < table.residues.size(); ++r) {
+            const Residue& res = table.residues[r];
+            size_t ca = res.firstAtom + 1;
+            y[ca] += 0.3f;
+            incremental.build(x.data(), y.data(), z.data());
+            if (!sameMesh(incremental.mesh(), buildFresh(table, x, y, z))) ++mismatched;
+            y[ca] -= 0.3f;
+            incremental.build(x.data(), y.data(), z.data());
+        }
+        ctx.check(incremental.mesh().vertexCount() > 0, "cartoon mesh is empty");
+        ctx.check(mismatched == 0, "%zu of %zu single-residue moves rebuilt a different mesh than a fresh build",
+            mismatched, table.residues.size());
+    }
+
+    // 1 万个残基：整体生成与只移动一个残基后的增量重建
+    AtomTable table = makeTrace(ctx.scaled(10000, 200), pattern, 14);
+    std::vector<float> x = table.x, y = table.y, z = table.z;
+    CartoonBuilder builder;
+    builder.prepare(table);
+    double fullMs = ctx.best([&] {
+        builder.setSubdivisions(8);
+        builder.build(x.data(), y.data(), z.data());
+    });
+    size_t ca = table.residues[table.residues.size() / 2].firstAtom + 1;
+    double singleMs = ctx.best([&] {
+        y[ca] += 0.1f;
+        builder.build(x.data(), y.data(), z.data());
+    });
+    ctx.report("%zu residues, %zu segments, %zu triangles: full build %.2f ms, one residue moved %.2f ms (%zu segments)",
+        table.residues.size(), builder.segmentCount(), builder.mesh().triangleCount(), fullMs, singleMs,
+        builder.lastRebuiltSegments());
+}
@@ -0,0 +1,166 @@
+﻿// BenchDssp v 1.0
+#include "Bench.h"
+#include "AtomTable.h"
+#include "Dssp.h"
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace {
+    struct BackboneResidue {
+        glm::dvec3 n, ca, c, o;
+    };
+
+    // 由 a、b、c 三点按键长、键角、二面角（度）放置第四个点
+    glm::dvec3 place(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c, double length, double angle,
+        double torsion) {
+        angle = glm::radians(angle);
+        torsion = glm::radians(torsion);
+        glm::dvec3 bc = glm::normalize(c - b);
+        glm::dvec3 n = glm::normalize(glm::cross(b - a, bc));
+        glm::dvec3 m = glm::cross(n, bc);
+        return c + bc * (-length * std::cos(angle)) + m * (length * std::sin(angle) * std::cos(torsion)) +
+            n * (length * std::sin(angle) * std::sin(torsion));
+    }
+
+    // 按每个残基的 (phi, psi) 用理想键长键角搭出主链
+    std::vector<BackboneResidue> buildChain(const std::vector<glm::dvec2>& dihedrals) {
+        std::vector<BackboneResidue> out;
+        glm::dvec3 n(0.0), ca(1.458, 0.0, 0.0);
+        glm::dvec3 c = place(glm::dvec3(0.0, 1.0, 0.0), n, ca, 1.525, 111.2, 0.0);
+        for (size_t i = 0; i < dihedrals.size(); ++i) {
+            double psi = dihedrals[i].y;
+            double nextPhi = i + 1 < dihedrals.size() ? dihedrals[i + 1].x : -60.0;
+            BackboneResidue r;
+            r.n = n;
+            r.ca = ca;
+            r.c = c;
+            r.o = place(n, ca, c, 1.231, 120.5, psi + 180.0);
+            glm::dvec3 nextN = place(n, ca, c, 1.329, 116.2, psi);
+            glm::dvec3 nextCa = place(ca, c, nextN, 1.458, 121.7, 180.0);
+            glm::dvec3 nextC = place(c, nextN, nextCa, 1.525, 111.2, nextPhi);
+            out.push_back(r);
+            n = nextN;
+            ca = nextCa;
+            c = nextC;
+        }
+        return out;
+    }
+
+    void addChain(AtomTable& table, const std::vector<BackboneResidue>& residues, const glm::dvec3& shift) {
+        static const char* names[4] = { "N", "CA", "C", "O" };
+        static const uint8_t elements[4] = { 7, 6, 6, 8 };
+        Chain chain;
+        chain.id = uint32_t('A' + table.chains.size() % 26);
+        chain.firstResidue = uint32_t(table.residues.size());
+        chain.residueCount = uint32_t(residues.size());
+        table.chains.push_back(chain);
+        for (const BackboneResidue& r : residues) {
+            Residue res;
+            res.name = packName4("ALA", 3);
+            res.seq = int32_t(table.residues.size() - chain.firstResidue) + 1;
+            res.chain = int32_t(table.chains.size() - 1);
+            res.firstAtom = uint32_t(table.x.size());
+            res.atomCount = 4;
+            const glm::dvec3 p[4] = { r.n + shift, r.ca + shift, r.c + shift, r.o + shift };
+            for (int k = 0; k < 4; ++k) {
+                table.x.push_back(float(p[k].x));
+                table.y.push_back(float(p[k].y));
+                table.z.push_back(float(p[k].z));
+                table.element.push_back(elements[k]);
+                table.name.push_back(packName4(names[k], k == 1 ? 2 : 1));
+                table.flags.push_back(0);
+                table.residueIndex.push_back(int32_t(table.residues.size()));
+                table.chainIndex.push_back(res.chain);
+            }
+            table.residues.push_back(res);
+        }
+    }
+
+    size_t countType(const std::vector<SecondaryStructure>& ss, SecondaryStructure type) {
+        size_t count = 0;
+        for (SecondaryStructure s : ss) count += s == type ? 1 : 0;
+        return count;
+    }
+
+    std::vector<SecondaryStructure> assignFresh(const AtomTable& table, const float* x, const float* y, const float* z) {
+        Dssp dssp;
+        dssp.prepare(table);
+        std::vector<SecondaryStructure> ss;
+        dssp.assign(x, y, z, ss);
+        return ss;
+    }
+}
+
+// 理想螺旋与折叠片的指认，以及逐帧调用（近邻网格增量更新）与每帧重新 prepare 的结果一致
+BENCH_CASE(dssp) {
+    {
+        AtomTable table;
+        addChain(table, buildChain(std::vector<glm::dvec2>(30, glm::dvec2(-57.0, -47.0))), glm::dvec3(0.0));
+        std::vector<SecondaryStructure> ss = assignFresh(table, table.x.data(), table.y.data(), table.z.data());
+        ctx.check(countType(ss, SecondaryStructure::AlphaHelix) >= 24, "ideal alpha helix: %zu of 30 residues H",
+            countType(ss, SecondaryStructure::AlphaHelix));
+    }
+    {
+        AtomTable table;
+        addChain(table, buildChain(std::vector<glm::dvec2>(20, glm::dvec2(-49.0, -26.0))), glm::dvec3(0.0));
+        std::vector<SecondaryStructure> ss = assignFresh(table, table.x.data(), table.y.data(), table.z.data());
+        ctx.check(countType(ss, SecondaryStructure::Helix310) > 0, "ideal 3-10 helix has no G residues");
+    }
+    {
+        // 同一条伸展链沿羰基方向平移 4.8 埃得到平行的第二条链
+        std::vector<BackboneResidue> strand = buildChain(std::vector<glm::dvec2>(12, glm::dvec2(-120.0, 130.0)));
+        glm::dvec3 carbonyl(0.0);
+        for (size_t i = 1; i < strand.size(); i += 2) carbonyl += strand[i].o - strand[i].c;
+        AtomTable table;
+        addChain(table, strand, glm::dvec3(0.0));
+        addChain(table, strand, glm::normalize(carbonyl) * 4.8);
+        std::vector<SecondaryStructure> ss = assignFresh(table, table.x.data(), table.y.data(), table.z.data());
+        ctx.check(countType(ss, SecondaryStructure::Strand) >= 8, "parallel strand pair: %zu of 24 residues E",
+            countType(ss, SecondaryStructure::Strand));
+    }
+
+    // 约 1 万个残基：螺旋、伸展与无规片段混合的 50 条链
+    AtomTable table;
+    BenchRandom random(10);
+    const size_t residueTarget = ctx.scaled(10000, 200);
+    while (table.residues.size() < residueTarget) {
+        std::vector<glm::dvec2> dihedrals;
+        while (dihedrals.size() < 200) {
+            uint64_t kind = random.next() % 3;
+            size_t length = 5 + random.next() % 15;
+            for (size_t k = 0; k < length; ++k) {
+                if (kind == 0) dihedrals.push_back(glm::dvec2(-57.0, -47.0));
+                else if (kind == 1) dihedrals.push_back(glm::dvec2(-120.0, 130.0));
+                else dihedrals.push_back(glm::dvec2(random.uniform(-180.0f, 180.0f), random.uniform(-180.0f, 180.0f)));
+            }
+        }
+        size_t c = table.chains.size();
+        addChain(table, buildChain(dihedrals), glm::dvec3(double(c % 5) * 30.0, double(c / 5 % 5) * 30.0,
+            double(c / 25) * 30.0));
+    }
+
+    Dssp dssp;
+    dssp.prepare(table);
+    std::vector<SecondaryStructure> ss;
+    const size_t n = table.atomCount();
+    std::vector<float> x(n), y(n), z(n);
+    size_t mismatched = 0;
+    double totalMs = 0.0;
+    double bestMs = 0.0;
+    const int frames = 10;
+    for (int frame = 0; frame < frames; ++frame) {
+        // 模拟轨迹：每帧在原始坐标上加 0.1 埃以内的扰动
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = table.x[i] + random.uniform(-0.1f, 0.1f);
+            y[i] = table.y[i] + random.uniform(-0.1f, 0.1f);
+            z[i] = table.z[i] + random.uniform(-0.1f, 0.1f);
+        }
+        dssp.assign(x.data(), y.data(), z.data(), ss);
+        totalMs += dssp.lastAssignMs();
+        bestMs = frame == 0 ? dssp.lastAssignMs() : std::min(bestMs, dssp.lastAssignMs());
+        if (ss != assignFresh(table, x.data(), y.data(), z.data())) ++mismatched;
+    }
+    ctx.report("%zu residues: %.2f ms per frame (best %.2f), H %zu, E %zu", table.residues.size(), totalMs / frames,
+        bestMs, countType(ss, SecondaryStructure::AlphaHelix), countType(ss, SecondaryStructure::Strand));
+    ctx.check(mismatched == 0, "%zu of %d frames differ from a fresh prepare + assign", mismatched, frames);
+}
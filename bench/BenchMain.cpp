@@ -0,0 +1,73 @@
+﻿// BenchMain v 1.0
+#include "Bench.h"
+#include "Parallel.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+std::vector<BenchCase>& benchCases() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+bool BenchContext::check(bool ok, const char* what, ...) {
+    if (ok) return true;
+    ++failures_;
+    std::printf("  FAIL ");
+    va_list args;
+    va_start(args, what);
+    std::vprintf(what, args);
+    va_end(args);
+    std::printf("\n");
+    return false;
+}
+
+void BenchContext::report(const char* what, ...) {
+    std::printf("  ");
+    va_list args;
+    va_start(args, what);
+    std::vprintf(what, args);
+    va_end(args);
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    double scale = 1.0;
+    int repeat = 3;
+    std::vector<const char*> filters;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    // 静态注册的顺序取决于链接顺序，按名字排序使输出稳定
+    std::vector<BenchCase> cases = benchCases();
+    std::sort(cases.begin(), cases.end(), [](const BenchCase& a, const BenchCase& b) {
+        return std::strcmp(a.name, b.name) < 0;
+    });
+
+    std::printf("threads %u, scale %g, repeat %d\n", workerCount(), scale, repeat);
+    int failed = 0;
+    int run = 0;
+    for (const BenchCase& c : cases) {
+        bool selected = filters.empty();
+        for (const char* f : filters) selected = selected || std::strstr(c.name, f) != nullptr;
+        if (!selected) continue;
+
+        std::printf("%s\n", c.name);
+        std::fflush(stdout);
+        BenchContext ctx(c.name, scale, repeat);
+        c.function(ctx);
+        ++run;
+        if (ctx.failures() > 0) ++failed;
+    }
+    std::printf("%d case(s), %d failed\n", run, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+﻿// BenchMeshLod v 1.0
+#include "Bench.h"
+#include "MeshSimplifier.h"
+#include "MolecularSurface.h"
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace {
+    // 高斯密度表面作为输入网格：n 个原子随机分布在半径 side 的球里
+    Mesh makeSurface(size_t n, float side, float spacing, uint64_t seed) {
+        BenchRandom random(seed);
+        std::vector<float> x, y, z, radius;
+        while (x.size() < n) {
+            glm::vec3 p(random.uniform(-side, side), random.uniform(-side, side), random.uniform(-side, side));
+            if (glm::dot(p, p) > side * side) continue;
+            x.push_back(p.x);
+            y.push_back(p.y);
+            z.push_back(p.z);
+            radius.push_back(1.7f);
+        }
+        MolecularSurface surface;
+        surface.setSpacing(spacing);
+        Mesh mesh;
+        surface.build(x.data(), y.data(), z.data(), radius.data(), n, SurfaceKind::GaussianDensity, mesh);
+        return mesh;
+    }
+
+    // 点到三角形的距离（Ericson, Real-Time Collision Detection 5.1.5）
+    float pointTriangleDistance(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+        float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return glm::length(ap);
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return glm::length(bp);
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return glm::length(cp);
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+            return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+        }
+        float denom = 1.0f / (va + vb + vc);
+        return glm::length(p - (a + ab * (vb * denom) + ac * (vc * denom)));
+    }
+
+    glm::vec3 vertex(const Mesh& mesh, uint32_t v) {
+        return glm::vec3(mesh.positions[3 * size_t(v)], mesh.positions[3 * size_t(v) + 1], mesh.positions[3 * size_t(v) + 2]);
+    }
+
+    // 原始网格各顶点到简化网格的最大距离（单侧 Hausdorff 距离的下界）
+    float measuredError(const Mesh& original, const Mesh& level) {
+        float worst = 0.0f;
+        for (size_t v = 0; v < original.vertexCount(); ++v) {
+            glm::vec3 p = vertex(original, uint32_t(v));
+            float best = 1e30f;
+            for (size_t t = 0; t < level.indices.size(); t += 3) {
+                best = std::min(best, pointTriangleDistance(p, vertex(level, level.indices[t]),
+                    vertex(level, level.indices[t + 1]), vertex(level, level.indices[t + 2])));
+            }
+            worst = std::max(worst, best);
+        }
+        return worst;
+    }
+}
+
+// LOD 链的 errors 不能低估：原始顶点到每一级网格的实测距离不超过 errors[l]；另测大网格的建链耗时
+BENCH_CASE(mesh_lod) {
+    // 几个不同形状的小网格：原子数、分布半径、格距各不相同
+    const struct {
+        size_t atoms;
+        float side;
+        float spacing;
+    } shapes[3] = { { 40, 8.0f, 0.5f }, { 12, 4.0f, 0.3f }, { 150, 14.0f, 0.7f } };
+    for (int k = 0; k < 3; ++k) {
+        MeshSimplifier simplifier;
+        simplifier.setClusterTriangles(1024);
+        MeshLod lod;
+        Mesh mesh = makeSurface(shapes[k].atoms, shapes[k].side, shapes[k].spacing, 20 + uint64_t(k));
+        simplifier.build(mesh, lod);
+        size_t violated = 0;
+        float tightest = 0.0f;
+        for (size_t l = 1; l < lod.levels.size(); ++l) {
+            float measured = measuredError(lod.levels[0], lod.levels[l]);
+            violated += measured > lod.errors[l] * 1.0001f + 1e-5f ? 1 : 0;
+            tightest = std::max(tightest, measured / std::max(lod.errors[l], 1e-6f));
+        }
+        ctx.report("%zu triangles, %zu levels: coarsest %zu triangles, error %.3f; measured / error at most %.2f",
+            mesh.triangleCount(), lod.levels.size(), lod.levels.back().triangleCount(), lod.errors.back(), tightest);
+        ctx.check(lod.levels.size() > 2, "only %zu LOD levels for a %zu-triangle mesh", lod.levels.size(),
+            mesh.triangleCount());
+        ctx.check(violated == 0, "%zu LOD levels measure a larger error than errors[l]", violated);
+    }
+
+    MeshSimplifier simplifier;
+    Mesh mesh = makeSurface(ctx.scaled(20000, 200), 60.0f, 0.8f, 21);
+    size_t triangles = mesh.triangleCount();
+    MeshLod lod;
+    double ms = ctx.best([&] {
+        simplifier.build(mesh, lod);
+    });
+    ctx.report("%zu triangles: LOD chain of %zu levels in %.0f ms, coarsest %zu triangles (error %.2f)", triangles,
+        lod.levels.size(), ms, lod.levels.back().triangleCount(), lod.errors.back());
+}
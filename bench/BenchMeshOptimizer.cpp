@@ -0,0 +1,150 @@
+﻿// BenchMeshOptimizer v 1.0
+#include "Bench.h"
+#include "MeshOptimizer.h"
+#include "MolecularSurface.h"
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace {
+    // 高斯密度表面，再把三角形与顶点的顺序打乱，模拟未经优化的导入网格
+    Mesh makeShuffledSurface(size_t n, uint64_t seed) {
+        BenchRandom random(seed);
+        std::vector<float> x, y, z, radius;
+        float side = std::cbrt(float(n) / 0.05f);
+        for (size_t i = 0; i < n; ++i) {
+            x.push_back(random.uniform(0.0f, side));
+            y.push_back(random.uniform(0.0f, side));
+            z.push_back(random.uniform(0.0f, side));
+            radius.push_back(1.7f);
+        }
+        MolecularSurface surface;
+        surface.setSpacing(0.7f);
+        Mesh mesh;
+        surface.build(x.data(), y.data(), z.data(), radius.data(), n, SurfaceKind::GaussianDensity, mesh);
+
+        const size_t vertexCount = mesh.vertexCount();
+        std::vector<uint32_t> permutation(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) permutation[v] = uint32_t(v);
+        for (size_t v = vertexCount; v > 1; --v) std::swap(permutation[v - 1], permutation[random.next() % v]);
+        Mesh shuffled;
+        shuffled.resizeVertices(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            const uint32_t to = permutation[v];
+            for (int d = 0; d < 3; ++d) {
+                shuffled.positions[3 * size_t(to) + d] = mesh.positions[3 * v + d];
+                shuffled.normals[3 * size_t(to) + d] = mesh.normals[3 * v + d];
+            }
+            shuffled.atomIds[to] = mesh.atomIds[v];
+        }
+        const size_t triangleCount = mesh.triangleCount();
+        std::vector<uint32_t> order(triangleCount);
+        for (size_t t = 0; t < triangleCount; ++t) order[t] = uint32_t(t);
+        for (size_t t = triangleCount; t > 1; --t) std::swap(order[t - 1], order[random.next() % t]);
+        for (uint32_t t : order) {
+            for (int k = 0; k < 3; ++k) shuffled.indices.push_back(permutation[mesh.indices[3 * size_t(t) + k]]);
+        }
+        return shuffled;
+    }
+
+    typedef std::array<float, 9> TriangleKey;
+
+    // 三角形按顶点坐标比较，转到最小的顶点打头（保持绕向），与顶点编号无关
+    std::vector<TriangleKey> triangleKeys(const Mesh& mesh) {
+        std::vector<TriangleKey> keys;
+        for (size_t t = 0; t < mesh.triangleCount(); ++t) {
+            std::array<std::array<float, 3>, 3> p;
+            for (int k = 0; k < 3; ++k) {
+                const float* q = &mesh.positions[3 * size_t(mesh.indices[3 * t + k])];
+                p[k] = { q[0], q[1], q[2] };
+            }
+            int first = 0;
+            for (int k = 1; k < 3; ++k) {
+                if (p[k] < p[first]) first = k;
+            }
+            TriangleKey key;
+            for (int k = 0; k < 3; ++k) {
+                for (int d = 0; d < 3; ++d) key[3 * k + d] = p[(first + k) % 3][d];
+            }
+            keys.push_back(key);
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    glm::vec3 vertex(const Mesh& mesh, uint32_t v) {
+        return glm::vec3(mesh.positions[3 * size_t(v)], mesh.positions[3 * size_t(v) + 1], mesh.positions[3 * size_t(v) + 2]);
+    }
+}
+
+// 导入网格后处理：前后的 ACMR / ATVR，三角形集合（含绕向）不变，
+// meshlet 覆盖全部三角形，法线锥判为背面时 meshlet 里的每个三角形确实背对视点
+BENCH_CASE(mesh_optimizer) {
+    Mesh mesh = makeShuffledSurface(ctx.scaled(20000, 300), 70);
+    const std::vector<TriangleKey> original = triangleKeys(mesh);
+    MeshOptimizer optimizer;
+    MeshletSet meshlets;
+    Mesh optimized;
+    double ms = ctx.best([&] {
+        optimized = mesh;
+        optimizer.optimize(optimized, &meshlets);
+    });
+    const VertexCacheStats& before = optimizer.lastBefore();
+    const VertexCacheStats& after = optimizer.lastAfter();
+    ctx.report("%zu triangles, %zu vertices: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (cache 16), optimize %.1f ms",
+        mesh.triangleCount(), mesh.vertexCount(), before.acmr, after.acmr, before.atvr, after.atvr, ms);
+    ctx.check(after.acmr < before.acmr, "ACMR did not improve (%.3f -> %.3f)", before.acmr, after.acmr);
+    ctx.check(triangleKeys(optimized) == original, "optimization changed the triangle set or winding");
+
+    // meshlet 展开回全局三角形应当恰好是优化后的网格
+    Mesh expanded;
+    expanded.positions = optimized.positions;
+    size_t overLimit = 0;
+    for (const Meshlet& m : meshlets.meshlets) {
+        overLimit += m.vertexCount > 64 || m.triangleCount > 124 ? 1 : 0;
+        for (uint32_t i = 0; i < 3 * m.triangleCount; ++i) {
+            expanded.indices.push_back(meshlets.vertices[m.vertexOffset + meshlets.triangles[m.triangleOffset + i]]);
+        }
+    }
+    ctx.check(overLimit == 0, "%zu meshlets exceed 64 vertices / 124 triangles", overLimit);
+    ctx.check(triangleKeys(expanded) == original, "meshlets do not cover exactly the mesh triangles");
+
+    // 视点：网格周围不同距离的随机点。判为背面的 meshlet 中，每个三角形的平面都必须把视点放在背面一侧
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (size_t v = 0; v < optimized.vertexCount(); ++v) {
+        lo = glm::min(lo, vertex(optimized, uint32_t(v)));
+        hi = glm::max(hi, vertex(optimized, uint32_t(v)));
+    }
+    const glm::vec3 center = 0.5f * (lo + hi);
+    const float extent = glm::length(hi - lo);
+    BenchRandom random(71);
+    size_t culled = 0, tested = 0, wrong = 0;
+    for (int e = 0; e < 200; ++e) {
+        glm::vec3 dir(random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f));
+        if (glm::dot(dir, dir) < 1e-4f) continue;
+        const glm::vec3 eye = center + glm::normalize(dir) * extent * random.uniform(0.1f, 3.0f);
+        const float eyeArray[3] = { eye.x, eye.y, eye.z };
+        for (const Meshlet& m : meshlets.meshlets) {
+            ++tested;
+            if (!m.backfacing(eyeArray)) continue;
+            ++culled;
+            for (uint32_t t = 0; t < m.triangleCount; ++t) {
+                const uint8_t* local = &meshlets.triangles[m.triangleOffset + 3 * t];
+                const glm::vec3 a = vertex(optimized, meshlets.vertices[m.vertexOffset + local[0]]);
+                const glm::vec3 b = vertex(optimized, meshlets.vertices[m.vertexOffset + local[1]]);
+                const glm::vec3 c = vertex(optimized, meshlets.vertices[m.vertexOffset + local[2]]);
+                const glm::vec3 n = glm::cross(b - a, c - a);
+                // 允许 float 舍入：视点在平面正面的距离不超过 1e-4 个包围盒尺寸
+                if (glm::dot(n, eye - a) > 1e-4f * extent * glm::length(n)) {
+                    ++wrong;
+                    break;
+                }
+            }
+        }
+    }
+    ctx.report("%zu meshlets (%.1f triangles each): cone test culls %.1f%% over 200 viewpoints, %zu wrongly",
+        meshlets.meshlets.size(), double(optimized.triangleCount()) / double(std::max<size_t>(meshlets.meshlets.size(), 1)),
+        100.0 * double(culled) / double(std::max<size_t>(tested, 1)), wrong);
+    ctx.check(culled > 0, "no meshlet was ever backface-culled");
+    ctx.check(wrong == 0, "%zu meshlets were culled although a triangle faces the eye", wrong);
+}
@@ -0,0 +1,251 @@
+﻿// BenchOcclusion v 1.0
+#include "Bench.h"
+#include "OcclusionCuller.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    struct ScreenTriangle {
+        float x[3], y[3], d[3];     // 与 OcclusionCuller 相同的屏幕坐标与 1 / w
+    };
+
+    bool toScreen(const glm::mat4& viewProjection, const glm::vec3& p, int width, int height, float& sx, float& sy,
+        float& depth) {
+        glm::vec4 c = viewProjection * glm::vec4(p, 1.0f);
+        if (c.w <= 1e-4f) return false;
+        depth = 1.0f / c.w;
+        sx = (c.x * depth * 0.5f + 0.5f) * float(width);
+        sy = (0.5f - c.y * depth * 0.5f) * float(height);
+        return true;
+    }
+
+    // 屏幕上 (sx, sy) 处是否有遮挡三角形比 depth 更近（精确的点覆盖，不经过深度缓冲）
+    bool covered(const std::vector<ScreenTriangle>& triangles, float sx, float sy, float depth) {
+        for (const ScreenTriangle& t : triangles) {
+            float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+            if (std::fabs(area) < 1e-9f) continue;
+            float w0 = ((t.x[1] - sx) * (t.y[2] - sy) - (t.x[2] - sx) * (t.y[1] - sy)) / area;
+            float w1 = ((t.x[2] - sx) * (t.y[0] - sy) - (t.x[0] - sx) * (t.y[2] - sy)) / area;
+            float w2 = 1.0f - w0 - w1;
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+            if (w0 * t.d[0] + w1 * t.d[1] + w2 * t.d[2] >= depth) return true;
+        }
+        return false;
+    }
+
+    // 经纬剖分的球面，外侧逆时针；两极的每个顶点各有一份，遮挡剔除按坐标焊接后是封闭的壳
+    void makeShell(float radius, int slices, int stacks, std::vector<float>& positions, std::vector<uint32_t>& indices) {
+        for (int j = 0; j <= stacks; ++j) {
+            float phi = 3.14159265f * float(j) / float(stacks);
+            // 两极的顶点坐标完全相同（float 的 sin(pi) 不是 0）
+            float ring = j == 0 || j == stacks ? 0.0f : std::sin(phi);
+            for (int i = 0; i < slices; ++i) {
+                float theta = 6.28318531f * float(i) / float(slices);
+                positions.push_back(radius * ring * std::cos(theta));
+                positions.push_back(radius * std::cos(phi));
+                positions.push_back(radius * ring * std::sin(theta));
+            }
+        }
+        for (int j = 0; j < stacks; ++j) {
+            for (int i = 0; i < slices; ++i) {
+                uint32_t a = uint32_t(j * slices + i), b = uint32_t(j * slices + (i + 1) % slices);
+                uint32_t c = a + uint32_t(slices), d = b + uint32_t(slices);
+                indices.insert(indices.end(), { a, b, c, b, d, c });
+            }
+        }
+    }
+}
+
+// 没有误剔：被判为挡住的盒子，表面上的采样点在屏幕上必须确实被某个遮挡三角形更近地覆盖。
+// 遮挡体是斜放的大三角形，边缘穿过纹素中间，部分覆盖的纹素正是按中心采样会误剔的地方；
+// 实心球代理同样不误剔，并测光栅化与剔除的耗时；细分的封闭球壳靠覆盖掩码合并共享边，挡住壳内的盒子，
+// 壳外的盒子同样不误剔
+BENCH_CASE(occlusion) {
+    const int width = 256, height = 128;
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 2.0f, 0.5f, 1000.0f);
+    const glm::mat4 viewProjection = projection * view;
+    OcclusionCuller culler;
+    culler.setResolution(width, height);
+    BenchRandom random(50);
+    {
+        culler.beginFrame(projection, view);
+        std::vector<ScreenTriangle> screen;
+        for (int t = 0; t < 24; ++t) {
+            float positions[9];
+            glm::vec3 center(random.uniform(-60.0f, 60.0f), random.uniform(-30.0f, 30.0f), random.uniform(-60.0f, -40.0f));
+            ScreenTriangle s;
+            for (int k = 0; k < 3; ++k) {
+                glm::vec3 p = center + glm::vec3(random.uniform(-25.0f, 25.0f), random.uniform(-25.0f, 25.0f),
+                    random.uniform(-5.0f, 5.0f));
+                positions[3 * k] = p.x;
+                positions[3 * k + 1] = p.y;
+                positions[3 * k + 2] = p.z;
+                toScreen(viewProjection, p, width, height, s.x[k], s.y[k], s.d[k]);
+            }
+            const uint32_t indices[3] = { 0, 1, 2 };
+            culler.addOccluder(positions, indices, 1);
+            screen.push_back(s);
+        }
+        culler.buildPyramid();
+
+        size_t culled = 0;
+        size_t wrong = 0;
+        const size_t boxCount = 20000;
+        for (size_t b = 0; b < boxCount; ++b) {
+            float z = random.uniform(-120.0f, -70.0f);
+            glm::vec3 c(random.uniform(-1.2f, 1.2f) * -z, random.uniform(-0.6f, 0.6f) * -z, z);
+            float half = random.uniform(0.2f, 2.0f);
+            const float lo[3] = { c.x - half, c.y - half, c.z - half };
+            const float hi[3] = { c.x + half, c.y + half, c.z + half };
+            if (culler.visible(lo, hi)) continue;
+            ++culled;
+            // 八个角加上朝向相机那一面的 7x7 个点
+            bool ok = true;
+            for (int k = 0; k < 8 + 49 && ok; ++k) {
+                glm::vec3 p;
+                if (k < 8) p = glm::vec3(k & 1 ? hi[0] : lo[0], k & 2 ? hi[1] : lo[1], k & 4 ? hi[2] : lo[2]);
+                else p = glm::vec3(lo[0] + (hi[0] - lo[0]) * float((k - 8) % 7) / 6.0f,
+                    lo[1] + (hi[1] - lo[1]) * float((k - 8) / 7) / 6.0f, hi[2]);
+                float sx, sy, depth;
+                if (!toScreen(viewProjection, p, width, height, sx, sy, depth)) continue;
+                if (sx < 0.0f || sy < 0.0f || sx > float(width) || sy > float(height)) continue;
+                ok = covered(screen, sx, sy, depth);
+            }
+            wrong += ok ? 0 : 1;
+        }
+        ctx.report("24 slanted occluders: %zu of %zu boxes culled, %zu culled but visible", culled, boxCount, wrong);
+        ctx.check(culled > 0, "no box was culled behind the occluders");
+        ctx.check(wrong == 0, "%zu boxes were culled although part of them is not covered by an occluder", wrong);
+    }
+
+    // 实心球代理（链级遮挡体的用法）：盒子被判为挡住时，从相机射向它的采样点的视线必须先穿过某个球
+    std::vector<glm::vec4> spheres;
+    const size_t sphereCount = 40;
+    for (size_t s = 0; s < sphereCount; ++s) {
+        spheres.push_back(glm::vec4(random.uniform(-50.0f, 50.0f), random.uniform(-25.0f, 25.0f),
+            random.uniform(-70.0f, -45.0f), random.uniform(5.0f, 12.0f)));
+    }
+    auto behindSphere = [&](const glm::vec3& p) {
+        const float distance = glm::length(p);
+        const glm::vec3 dir = p / distance;
+        for (const glm::vec4& s : spheres) {
+            const glm::vec3 c(s);
+            const float b = glm::dot(dir, c);
+            const float disc = b * b - glm::dot(c, c) + s.w * s.w;
+            if (disc >= 0.0f && b - std::sqrt(disc) < distance) return true;
+        }
+        return false;
+    };
+    AabbArray boxes;
+    std::vector<uint32_t> candidates;
+    const size_t boxCount = ctx.scaled(200000, 2000);
+    boxes.resize(boxCount);
+    for (size_t b = 0; b < boxCount; ++b) {
+        float z = random.uniform(-140.0f, -80.0f);
+        const float center[3] = { random.uniform(-1.0f, 1.0f) * -z, random.uniform(-0.5f, 0.5f) * -z, z };
+        boxes.setSphere(b, center, random.uniform(0.5f, 2.0f));
+        candidates.push_back(uint32_t(b));
+    }
+    double rasterMs = ctx.best([&] {
+        culler.beginFrame(projection, view);
+        for (const glm::vec4& s : spheres) {
+            const float center[3] = { s.x, s.y, s.z };
+            culler.addSphereOccluder(center, s.w);
+        }
+        culler.buildPyramid();
+    });
+    std::vector<uint32_t> visible;
+    double cullMs = ctx.best([&] {
+        visible.clear();
+        culler.cull(boxes, candidates, visible);
+    });
+    std::vector<uint8_t> kept(boxCount, 0);
+    for (uint32_t b : visible) kept[b] = 1;
+    size_t wrong = 0;
+    for (size_t b = 0; b < boxCount; ++b) {
+        if (kept[b]) continue;
+        const float lo[3] = { boxes.minX[b], boxes.minY[b], boxes.minZ[b] };
+        const float hi[3] = { boxes.maxX[b], boxes.maxY[b], boxes.maxZ[b] };
+        bool ok = true;
+        for (int k = 0; k < 8 + 49 && ok; ++k) {
+            glm::vec3 p;
+            if (k < 8) p = glm::vec3(k & 1 ? hi[0] : lo[0], k & 2 ? hi[1] : lo[1], k & 4 ? hi[2] : lo[2]);
+            else p = glm::vec3(lo[0] + (hi[0] - lo[0]) * float((k - 8) % 7) / 6.0f,
+                lo[1] + (hi[1] - lo[1]) * float((k - 8) / 7) / 6.0f, hi[2]);
+            ok = behindSphere(p);
+        }
+        wrong += ok ? 0 : 1;
+    }
+    const size_t culled = boxCount - visible.size();
+    ctx.report("%zu sphere occluders: raster + pyramid %.2f ms, cull %zu boxes %.2f ms; %zu culled, "
+        "%zu culled but visible", sphereCount, rasterMs, boxCount, cullMs, culled, wrong);
+    ctx.check(culled > 0, "no box was culled behind the sphere occluders");
+    ctx.check(wrong == 0, "%zu boxes were culled although part of them is not behind a sphere", wrong);
+
+    // 封闭球壳（4k 个三角形）：共享边上的纹素没有一个三角形完整覆盖，靠块的覆盖掩码合并
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    makeShell(40.0f, 64, 32, positions, indices);
+    for (size_t i = 2; i < positions.size(); i += 3) positions[i] -= 150.0f;
+    AabbArray inner;
+    std::vector<uint32_t> innerCandidates;
+    const size_t inside = 2000;
+    inner.resize(inside);
+    for (size_t b = 0; b < inside; ++b) {
+        glm::vec3 c;
+        do {
+            c = glm::vec3(random.uniform(-25.0f, 25.0f), random.uniform(-25.0f, 25.0f), random.uniform(-25.0f, 25.0f));
+        } while (glm::dot(c, c) > 25.0f * 25.0f);
+        const float center[3] = { c.x, c.y, c.z - 150.0f };
+        inner.setSphere(b, center, 1.5f);
+        innerCandidates.push_back(uint32_t(b));
+    }
+    double shellMs = ctx.best([&] {
+        culler.beginFrame(projection, view);
+        culler.addOccluder(positions.data(), indices.data(), indices.size() / 3);
+        culler.buildPyramid();
+    });
+    visible.clear();
+    culler.cull(inner, innerCandidates, visible);
+    const size_t innerCulled = inside - visible.size();
+
+    // 壳后面与轮廓附近的盒子：被判为挡住的，采样点必须确实被壳上的某个三角形更近地覆盖
+    std::vector<ScreenTriangle> shell;
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        ScreenTriangle s;
+        for (int k = 0; k < 3; ++k) {
+            const float* p = &positions[3 * size_t(indices[t + k])];
+            toScreen(viewProjection, glm::vec3(p[0], p[1], p[2]), width, height, s.x[k], s.y[k], s.d[k]);
+        }
+        shell.push_back(s);
+    }
+    size_t outerCulled = 0, outerWrong = 0;
+    const size_t outerCount = 20000;
+    for (size_t b = 0; b < outerCount; ++b) {
+        const float z = random.uniform(-260.0f, -195.0f);
+        const glm::vec3 c(random.uniform(-0.35f, 0.35f) * -z, random.uniform(-0.35f, 0.35f) * -z, z);
+        const float half = random.uniform(0.2f, 2.0f);
+        const float lo[3] = { c.x - half, c.y - half, c.z - half };
+        const float hi[3] = { c.x + half, c.y + half, c.z + half };
+        if (culler.visible(lo, hi)) continue;
+        ++outerCulled;
+        bool ok = true;
+        for (int k = 0; k < 8 + 49 && ok; ++k) {
+            glm::vec3 p;
+            if (k < 8) p = glm::vec3(k & 1 ? hi[0] : lo[0], k & 2 ? hi[1] : lo[1], k & 4 ? hi[2] : lo[2]);
+            else p = glm::vec3(lo[0] + (hi[0] - lo[0]) * float((k - 8) % 7) / 6.0f,
+                lo[1] + (hi[1] - lo[1]) * float((k - 8) / 7) / 6.0f, hi[2]);
+            float sx, sy, depth;
+            if (!toScreen(viewProjection, p, width, height, sx, sy, depth)) continue;
+            if (sx < 0.0f || sy < 0.0f || sx > float(width) || sy > float(height)) continue;
+            ok = covered(shell, sx, sy, depth);
+        }
+        outerWrong += ok ? 0 : 1;
+    }
+    ctx.report("closed shell of %zu triangles: raster + pyramid %.2f ms, %zu of %zu boxes inside it culled; "
+        "%zu of %zu boxes behind it culled, %zu culled but visible", indices.size() / 3, shellMs, innerCulled, inside,
+        outerCulled, outerCount, outerWrong);
+    ctx.check(innerCulled > 0, "the closed shell did not cull any box inside it");
+    ctx.check(outerWrong == 0, "%zu boxes were culled although part of them is not covered by the shell", outerWrong);
+}
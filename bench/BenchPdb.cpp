@@ -0,0 +1,91 @@
+﻿// BenchPdb v 1.0
+#include "Bench.h"
+#include "AtomTable.h"
+#include "Element.h"
+#include "PdbLoader.h"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    // 合成 PDB：每个残基五个原子（N CA C O CB），每 5000 个残基一条链并写 TER，
+    // 坐标取三位小数，解析结果可以逐个比对
+    struct SyntheticPdb {
+        std::string text;
+        std::vector<float> x, y, z;
+        size_t residues = 0;
+        size_t chains = 0;
+    };
+
+    const size_t kResiduesPerChain = 5000;
+
+    SyntheticPdb makePdb(size_t atomCount) {
+        static const char* names[5] = { " N  ", " CA ", " C  ", " O  ", " CB " };
+        static const char* elements[5] = { " N", " C", " C", " O", " C" };
+        SyntheticPdb pdb;
+        pdb.text.reserve(atomCount * 81 + 64);
+        pdb.x.reserve(atomCount);
+        pdb.y.reserve(atomCount);
+        pdb.z.reserve(atomCount);
+        BenchRandom random(1);
+        char line[128];
+        size_t residue = 0;
+        for (size_t i = 0; i < atomCount; ++i) {
+            residue = i / 5;
+            char chain = char('A' + (residue / kResiduesPerChain) % 26);
+            int seq = int(residue % kResiduesPerChain) + 1;
+            // 三位小数的整数表示，保证写出的文本与期望值一致
+            int v[3];
+            for (int d = 0; d < 3; ++d) v[d] = int(random.next() % 400000) - 200000;
+            std::snprintf(line, sizeof(line), "ATOM  %5d %4s ALA %c%4d    %8.3f%8.3f%8.3f  1.00 20.00          %s\n",
+                int((i + 1) % 100000), names[i % 5], chain, seq, v[0] / 1000.0, v[1] / 1000.0, v[2] / 1000.0,
+                elements[i % 5]);
+            pdb.text += line;
+            pdb.x.push_back(float(v[0] / 1000.0));
+            pdb.y.push_back(float(v[1] / 1000.0));
+            pdb.z.push_back(float(v[2] / 1000.0));
+            if (i % 5 == 4 && (residue + 1) % kResiduesPerChain == 0) pdb.text += "TER\n";
+        }
+        pdb.text += "END\n";
+        pdb.residues = (atomCount + 4) / 5;
+        pdb.chains = (pdb.residues + kResiduesPerChain - 1) / kResiduesPerChain;
+        return pdb;
+    }
+}
+
+// 100 MB 左右的 PDB（约 125 万个原子）从内存解析到 AtomTable
+BENCH_CASE(pdb_parse) {
+    const size_t atomCount = ctx.scaled(1250000, 10);
+    SyntheticPdb pdb = makePdb(atomCount);
+
+    PdbLoader loader;
+    AtomTable table;
+    bool ok = true;
+    double ms = ctx.best([&] {
+        ok = loader.parse(pdb.text.data(), pdb.text.size(), table) && ok;
+    });
+    if (!ctx.check(ok, "parse failed: %s", loader.lastError().c_str())) return;
+
+    double mb = double(pdb.text.size()) / (1024.0 * 1024.0);
+    ctx.report("%zu atoms, %.1f MB: %.1f ms, %.0f MB/s", atomCount, mb, ms, mb / (ms / 1000.0));
+
+    ctx.check(table.atomCount() == atomCount, "atom count %zu, expected %zu", table.atomCount(), atomCount);
+    ctx.check(table.residues.size() == pdb.residues, "residue count %zu, expected %zu", table.residues.size(),
+        pdb.residues);
+    ctx.check(table.chains.size() == pdb.chains, "chain count %zu, expected %zu", table.chains.size(), pdb.chains);
+    if (table.atomCount() != atomCount) return;
+
+    size_t wrongPosition = 0;
+    size_t wrongElement = 0;
+    size_t wrongResidue = 0;
+    for (size_t i = 0; i < atomCount; ++i) {
+        if (std::fabs(table.x[i] - pdb.x[i]) > 1e-3f || std::fabs(table.y[i] - pdb.y[i]) > 1e-3f ||
+            std::fabs(table.z[i] - pdb.z[i]) > 1e-3f) ++wrongPosition;
+        uint8_t expected = i % 5 == 0 ? elementFromSymbol("N", 1) : (i % 5 == 3 ? elementFromSymbol("O", 1) :
+            elementFromSymbol("C", 1));
+        if (table.element[i] != expected) ++wrongElement;
+        if (table.residueIndex[i] != int32_t(i / 5)) ++wrongResidue;
+    }
+    ctx.check(wrongPosition == 0, "%zu atoms with wrong coordinates", wrongPosition);
+    ctx.check(wrongElement == 0, "%zu atoms with wrong element", wrongElement);
+    ctx.check(wrongResidue == 0, "%zu atoms with wrong residue index", wrongResidue);
+}
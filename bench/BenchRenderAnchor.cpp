@@ -0,0 +1,162 @@
+﻿// BenchRenderAnchor v 1.1
+#include "Bench.h"
+#include "AtomBuffers.h"
+#include "Camera.h"
+#include "FrustumCuller.h"
+#include "StructureLod.h"
+#include <cmath>
+
+namespace {
+    // 远离世界原点（约 50 微米）、跨 1e5 埃的场景：每 1000 个原子一条链，链内原子在 ±20 埃内，
+    // 链中心在 offset 周围 ±5e4 埃内随机分布；每 10 个原子一个残基
+    AtomTable makeAtoms(size_t n, const glm::dvec3& offset) {
+        AtomTable atoms;
+        atoms.resizeAtoms(n);
+        BenchRandom random(60);
+        std::vector<int32_t> seq(n);
+        std::vector<char> insertion(n, ' ');
+        std::vector<uint32_t> residueName(n, packName4("ALA", 3)), chainName(n, packName4("A", 1)), chainKey(n);
+        glm::dvec3 center = offset;
+        for (size_t i = 0; i < n; ++i) {
+            if (i % 1000 == 0) {
+                center = offset + glm::dvec3(random.uniform(-5e4f, 5e4f), random.uniform(-5e4f, 5e4f),
+                    random.uniform(-5e4f, 5e4f));
+            }
+            atoms.x[i] = float(center.x + random.uniform(-20.0f, 20.0f));
+            atoms.y[i] = float(center.y + random.uniform(-20.0f, 20.0f));
+            atoms.z[i] = float(center.z + random.uniform(-20.0f, 20.0f));
+            atoms.element[i] = 6;
+            seq[i] = int32_t(i / 10);
+            chainKey[i] = uint32_t(i / 1000);
+        }
+        buildResidues(atoms, seq.data(), insertion.data(), residueName.data(), chainName.data(), chainKey.data());
+        return atoms;
+    }
+
+    glm::dvec3 worldAtom(const AtomTable& atoms, size_t i) {
+        return glm::dvec3(atoms.x[i], atoms.y[i], atoms.z[i]);
+    }
+}
+
+// 大场景放大到埃级：相机贴近远离世界原点的原子时，视空间坐标的误差（相对双精度参考）。
+// 旧做法一是 float 世界坐标乘 getView()，二是全场景一个锚点（包围盒中心，离原子可达 5e4 埃）；
+// 新做法照着色器算：相对块锚点的坐标加上 blockOffsets，再乘 getRenderView()。
+// 相机在各链之间跳动并跨过多次渲染原点的移动，原子缓冲不必重传，只重算块偏移
+BENCH_CASE(render_anchor) {
+    const glm::dvec3 offset(412345.0, 298765.0, 187654.0);
+    const size_t n = ctx.scaled(100000, 2000);
+    AtomTable atoms = makeAtoms(n, offset);
+    AtomBuffers buffers;
+    buffers.pack(atoms);
+    buffers.clearDirty();
+    float lo[3], hi[3];
+    atomBounds(atoms, lo, hi);
+    RenderAnchor single;
+    single.setWorld(0.5 * (glm::dvec3(lo[0], lo[1], lo[2]) + glm::dvec3(hi[0], hi[1], hi[2])));
+    std::vector<float> singleRelative(3 * n);
+    for (size_t i = 0; i < n; ++i) {
+        singleRelative[3 * i] = float(atoms.x[i] - single.world.x);
+        singleRelative[3 * i + 1] = float(atoms.y[i] - single.world.y);
+        singleRelative[3 * i + 2] = float(atoms.z[i] - single.world.z);
+    }
+
+    // 60 度视角、1080 像素高，相机离原子 8 埃：1 埃约 117 像素
+    const float pixelsPerAngstrom = 1080.0f / (2.0f * std::tan(glm::radians(30.0f)) * 8.0f);
+    Camera camera;
+    camera.setRebaseDistance(64.0);
+    // 斜着看：视图矩阵的旋转把很大的世界坐标混到各分量里
+    camera.processMouseMovement(237.0f, -183.0f);
+    const uint32_t firstVersion = camera.originVersion();
+    double worldError = 0.0, singleError = 0.0, blockError = 0.0;
+    size_t samples = 0;
+    for (size_t step = 0; step < 64; ++step) {
+        const size_t target = (step * 7919) % n;
+        const glm::dvec3 eye = worldAtom(atoms, target) - 8.0 * glm::dvec3(camera.getFront());
+        camera.setWorldPos(eye);
+        buffers.updateBlockOffsets(camera);
+        const glm::dmat4 reference = glm::lookAt(eye, eye + glm::dvec3(camera.getFront()), glm::dvec3(camera.getUp()));
+        const glm::mat4 worldView = camera.getView();
+        const glm::mat4 singleView = single.modelView(camera);
+        const glm::mat4 renderView = camera.getRenderView();
+        const std::vector<float>& offsets = buffers.blockOffsets();
+        for (size_t i = 0; i < n; ++i) {
+            const glm::dvec3 p = worldAtom(atoms, i);
+            if (glm::length(p - eye) > 20.0) continue;
+            const glm::dvec3 expected(reference * glm::dvec4(p, 1.0));
+            const glm::vec3 oldWay(worldView * glm::vec4(glm::vec3(p), 1.0f));
+            const float* q = &singleRelative[3 * i];
+            const glm::vec3 singleWay(singleView * glm::vec4(q[0], q[1], q[2], 1.0f));
+            const float* r = &buffers.positions()[4 * i];
+            const float* o = &offsets[4 * size_t(buffers.atomBlock(i))];
+            const glm::vec3 blockWay(renderView * glm::vec4(r[0] + o[0], r[1] + o[1], r[2] + o[2], 1.0f));
+            worldError = std::max(worldError, glm::length(glm::dvec3(oldWay) - expected));
+            singleError = std::max(singleError, glm::length(glm::dvec3(singleWay) - expected));
+            blockError = std::max(blockError, glm::length(glm::dvec3(blockWay) - expected));
+            ++samples;
+        }
+    }
+    const uint32_t rebases = camera.originVersion() - firstVersion;
+    ctx.report("%zu atoms in %zu blocks, %.0f x %.0f x %.0f A around (%.0f, %.0f, %.0f): %zu samples within 20 A of "
+        "the camera", n, buffers.blockCount(), double(hi[0] - lo[0]), double(hi[1] - lo[1]), double(hi[2] - lo[2]),
+        offset.x, offset.y, offset.z, samples);
+    ctx.report("view-space error: float world %.4f A (%.1f px), single anchor %.4f A (%.2f px), block anchors "
+        "%.6f A (%.3f px); %u rebases, %zu positions re-uploaded", worldError, worldError * pixelsPerAngstrom,
+        singleError, singleError * pixelsPerAngstrom, blockError, blockError * pixelsPerAngstrom, rebases,
+        buffers.dirtyPositions().count());
+    ctx.check(samples > 0, "no atoms near the camera");
+    ctx.check(blockError * pixelsPerAngstrom < 0.1, "block-anchor view error %.6f A is visible at this zoom",
+        blockError);
+    ctx.check(rebases > 0 && buffers.dirtyPositions().empty(), "rebasing the render origin dirtied the atom buffers");
+
+    // StructureLod：链的锚点就是双精度质心；剔除用的链中心相对全场景锚点，
+    // 只要求在 float 的舍入以内（1e5 埃的场景里约 2e-3 埃，对剔除无影响）
+    StructureLod lod;
+    lod.setBuildSurfaces(false);
+    lod.build(atoms);
+    double anchorOffError = 0.0, centerUlps = 0.0;
+    for (size_t c = 0; c < lod.chainCount(); ++c) {
+        const StructureLod::ChainInfo& info = lod.chain(c);
+        glm::dvec3 sum(0.0);
+        for (uint32_t a = info.firstAtom; a < info.firstAtom + info.atomCount; ++a) sum += worldAtom(atoms, a);
+        const glm::dvec3 centroid = sum / double(info.atomCount);
+        anchorOffError = std::max(anchorOffError, glm::length(lod.chainAnchor(c).world - centroid));
+        const glm::dvec3 relative = centroid - lod.anchor().world;
+        const glm::dvec3 center(info.center[0], info.center[1], info.center[2]);
+        const double ulp = std::max(glm::length(relative), 1.0) * std::ldexp(1.0, -23);
+        centerUlps = std::max(centerUlps, glm::length(center - relative) / ulp);
+    }
+    const glm::dvec3 chainCenter = glm::dvec3(lod.chain(0).center[0], lod.chain(0).center[1], lod.chain(0).center[2]) +
+        lod.anchor().world;
+    camera.setWorldPos(chainCenter - 400.0 * glm::dvec3(camera.getFront()));
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.5f, 5000.0f);
+    FrustumCuller culler;
+    culler.setCamera(camera, projection, lod.anchor());
+    lod.select(camera, glm::radians(60.0f), 1080.0f, &culler);
+    ctx.report("%zu chains: chain anchors %.2e A off the centroid, culling centers within %.2f float ulps, "
+        "%zu of them in view from 400 A", lod.chainCount(), anchorOffError, centerUlps,
+        lod.visibleChains(LodLevel::Atoms).size() + lod.visibleChains(LodLevel::Residues).size() +
+        lod.visibleChains(LodLevel::Surface).size() + lod.visibleChains(LodLevel::Blob).size());
+    ctx.check(anchorOffError < 1e-6, "chain anchors are %.2e A off the double-precision centroid", anchorOffError);
+    ctx.check(centerUlps <= 1.0, "chain culling centers are %.2f float ulps off", centerUlps);
+
+    // 残基球相对链的锚点：相机贴近各链的残基时视空间误差同样不可见
+    double residueError = 0.0;
+    for (size_t step = 0; step < 64; ++step) {
+        const size_t r = (step * 7919) % atoms.residues.size();
+        const Residue& res = atoms.residues[r];
+        glm::dvec3 sum(0.0);
+        for (uint32_t a = res.firstAtom; a < res.firstAtom + res.atomCount; ++a) sum += worldAtom(atoms, a);
+        const glm::dvec3 world = sum / double(res.atomCount);
+        const glm::dvec3 eye = world - 8.0 * glm::dvec3(camera.getFront());
+        camera.setWorldPos(eye);
+        const glm::dmat4 reference = glm::lookAt(eye, eye + glm::dvec3(camera.getFront()), glm::dvec3(camera.getUp()));
+        const SphereInstance& s = lod.residueSpheres()[r];
+        const glm::vec3 view(lod.chainAnchor(size_t(res.chain)).modelView(camera) * glm::vec4(s.x, s.y, s.z, 1.0f));
+        residueError = std::max(residueError, glm::length(glm::dvec3(view) - glm::dvec3(reference * glm::dvec4(world, 1.0))));
+    }
+    ctx.report("residue spheres relative to chain anchors: view-space error %.6f A (%.3f px)", residueError,
+        residueError * pixelsPerAngstrom);
+    ctx.check(residueError * pixelsPerAngstrom < 0.1, "residue sphere view error %.6f A is visible at this zoom",
+        residueError);
+    ctx.check(lod.selection(0).visible, "the chain in front of the camera was culled");
+}
@@ -0,0 +1,110 @@
+﻿// BenchSceneCache v 1.0
+#include "Bench.h"
+#include "AtomTable.h"
+#include "SceneCache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    AtomTable makeTable(size_t atomCount) {
+        AtomTable table;
+        table.resizeAtoms(atomCount);
+        BenchRandom random(4);
+        std::vector<int32_t> seq(atomCount);
+        std::vector<char> insertion(atomCount, ' ');
+        std::vector<uint32_t> residueName(atomCount, packName4("ALA", 3));
+        std::vector<uint32_t> chainName(atomCount);
+        for (size_t i = 0; i < atomCount; ++i) {
+            table.x[i] = random.uniform(-100.0f, 100.0f);
+            table.y[i] = random.uniform(-100.0f, 100.0f);
+            table.z[i] = random.uniform(-100.0f, 100.0f);
+            table.element[i] = uint8_t(1 + random.next() % 20);
+            table.name[i] = packName4("CA", 2);
+            seq[i] = int32_t(i / 8 % 5000) + 1;
+            char chain = char('A' + i / 40000 % 26);
+            chainName[i] = packName4(&chain, 1);
+        }
+        buildResidues(table, seq.data(), insertion.data(), residueName.data(), chainName.data(), chainName.data());
+        return table;
+    }
+
+    template <typename T>
+    bool sameArray(const std::vector<T>& a, const std::vector<T>& b) {
+        return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+    }
+
+    bool writeBytes(const std::string& path, const std::vector<char>& bytes) {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (f == nullptr) return false;
+        bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+        return std::fclose(f) == 0 && ok;
+    }
+}
+
+// 写缓存、映射打开并拷回原子表；再确认篡改过的节表会被拒绝
+BENCH_CASE(scene_cache) {
+    const size_t atomCount = ctx.scaled(2000000, 100);
+    AtomTable table = makeTable(atomCount);
+    const uint64_t hash = 0x1234567890ABCDEFull;
+    const uint64_t sourceSize = 42;
+
+    std::string path = (std::filesystem::temp_directory_path() / "bench_scene_cache.thc").string();
+    SceneCacheWriter writer(hash, sourceSize);
+    writer.addAtomTable(table);
+    bool written = false;
+    double writeMs = ctx.best([&] {
+        written = writer.write(path);
+    });
+    if (!ctx.check(written, "cannot write %s", path.c_str())) return;
+
+    SceneCache cache;
+    AtomTable loaded;
+    bool opened = false;
+    bool copied = false;
+    double openMs = ctx.best([&] {
+        opened = cache.open(path, hash, sourceSize);
+    });
+    double loadMs = ctx.best([&] {
+        copied = opened && cache.loadAtomTable(loaded);
+    });
+    ctx.report("%zu atoms: write %.1f ms, open %.3f ms, loadAtomTable %.1f ms", atomCount, writeMs, openMs, loadMs);
+    ctx.check(opened, "open failed");
+    ctx.check(copied, "loadAtomTable failed");
+    ctx.check(sameArray(loaded.x, table.x) && sameArray(loaded.y, table.y) && sameArray(loaded.z, table.z) &&
+        sameArray(loaded.element, table.element) && sameArray(loaded.residueIndex, table.residueIndex) &&
+        sameArray(loaded.chainIndex, table.chainIndex), "atom arrays differ after round trip");
+    ctx.check(loaded.residues.size() == table.residues.size() && loaded.chains.size() == table.chains.size(),
+        "residue or chain count differs after round trip");
+
+    SceneCache stale;
+    ctx.check(!stale.open(path, hash + 1, sourceSize), "cache with a different source hash was accepted");
+
+    // 篡改第一节的元素个数：大于 size / elementSize 时必须拒绝，否则 sectionAs 会越界
+    std::vector<char> bytes(std::filesystem::file_size(path));
+    FILE* f = std::fopen(path.c_str(), "rb");
+    bool read = f != nullptr && std::fread(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    if (f) std::fclose(f);
+    cache.close();
+    if (!ctx.check(read, "cannot read back %s", path.c_str())) return;
+
+    SceneCacheSection first;
+    std::memcpy(&first, bytes.data() + sizeof(SceneCacheHeader), sizeof(first));
+    first.count = first.size / first.elementSize + 1;
+    std::memcpy(bytes.data() + sizeof(SceneCacheHeader), &first, sizeof(first));
+    std::string corrupt = path + ".corrupt";
+    if (ctx.check(writeBytes(corrupt, bytes), "cannot write %s", corrupt.c_str())) {
+        SceneCache bad;
+        ctx.check(!bad.open(corrupt, hash, sourceSize), "section count larger than its size was accepted");
+    }
+
+    first.count = first.size / first.elementSize;
+    std::memcpy(bytes.data() + sizeof(SceneCacheHeader), &first, sizeof(first));
+    bytes.resize(bytes.size() / 2);
+    if (ctx.check(writeBytes(corrupt, bytes), "cannot write %s", corrupt.c_str())) {
+        SceneCache truncated;
+        ctx.check(!truncated.open(corrupt, hash, sourceSize), "truncated cache was accepted");
+    }
+    std::remove(corrupt.c_str());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,192 @@
+﻿// BenchSurface v 1.0
+#include "Bench.h"
+#include "MolecularSurface.h"
+#include <cmath>
+
+namespace {
+    struct Atoms {
+        std::vector<float> x, y, z, radius;
+
+        size_t size() const {
+            return x.size();
+        }
+    };
+
+    // 盒子里均匀分布的原子，数密度约为蛋白质的一半（0.05 / 埃^3），半径取 C、N、O、S 的范德华半径
+    Atoms makeAtoms(size_t n, uint64_t seed) {
+        const float radii[4] = { 1.7f, 1.55f, 1.52f, 1.8f };
+        Atoms atoms;
+        BenchRandom random(seed);
+        float side = std::cbrt(float(n) / 0.05f);
+        for (size_t i = 0; i < n; ++i) {
+            atoms.x.push_back(random.uniform(0.0f, side));
+            atoms.y.push_back(random.uniform(0.0f, side));
+            atoms.z.push_back(random.uniform(0.0f, side));
+            atoms.radius.push_back(radii[random.next() % 4]);
+        }
+        return atoms;
+    }
+
+    void build(MolecularSurface& surface, const Atoms& atoms, SurfaceKind kind, Mesh& mesh) {
+        surface.build(atoms.x.data(), atoms.y.data(), atoms.z.data(), atoms.radius.data(), atoms.size(), kind, mesh);
+    }
+
+    // 顶点到各原子球面的最小有符号距离 min(|p - c| - (r + extra))，以及取得最小值的原子
+    float nearestSurface(const Atoms& atoms, const float* p, float extra, uint32_t* atom) {
+        float best = 1e30f;
+        for (size_t a = 0; a < atoms.size(); ++a) {
+            float dx = p[0] - atoms.x[a], dy = p[1] - atoms.y[a], dz = p[2] - atoms.z[a];
+            float d = std::sqrt(dx * dx + dy * dy + dz * dz) - (atoms.radius[a] + extra);
+            if (d < best) {
+                best = d;
+                if (atom != nullptr) *atom = uint32_t(a);
+            }
+        }
+        return best;
+    }
+
+    // 暴力求和的高斯场（双精度 exp，同样在 2.63 * s * r 处截断）
+    double gaussianField(const Atoms& atoms, const float* p, float scale, float iso) {
+        double density = 0.0;
+        for (size_t a = 0; a < atoms.size(); ++a) {
+            double dx = p[0] - atoms.x[a], dy = p[1] - atoms.y[a], dz = p[2] - atoms.z[a];
+            double d2 = dx * dx + dy * dy + dz * dz;
+            double sr = double(scale) * atoms.radius[a];
+            if (d2 <= 2.63 * 2.63 * sr * sr) density += std::exp(-d2 / (sr * sr));
+        }
+        return double(iso) - density;
+    }
+}
+
+// SAS / SES：单个原子的表面半径，小团簇的顶点与暴力距离、原子归属一致，1M 原子的耗时
+BENCH_CASE(surface) {
+    const float probe = 1.4f;
+    MolecularSurface surface;
+    surface.setProbeRadius(probe);
+    Mesh mesh;
+    {
+        Atoms one;
+        one.x.push_back(0.0f);
+        one.y.push_back(0.0f);
+        one.z.push_back(0.0f);
+        one.radius.push_back(1.7f);
+        surface.setSpacing(0.2f);
+        const SurfaceKind kinds[2] = { SurfaceKind::SolventAccessible, SurfaceKind::SolventExcluded };
+        const float expected[2] = { 1.7f + probe, 1.7f };
+        for (int k = 0; k < 2; ++k) {
+            build(surface, one, kinds[k], mesh);
+            float worst = 0.0f;
+            for (size_t v = 0; v < mesh.vertexCount(); ++v) {
+                const float* p = &mesh.positions[3 * v];
+                worst = std::max(worst, std::fabs(std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]) - expected[k]));
+            }
+            ctx.check(mesh.vertexCount() > 0 && worst <= surface.spacing(),
+                "single atom %s: %zu vertices, radius off by %.3f (spacing %.2f)", k == 0 ? "SAS" : "SES",
+                mesh.vertexCount(), worst, surface.spacing());
+        }
+    }
+    {
+        // SAS 顶点落在 r + probe 球的并上；SES 顶点不进入范德华球，也不超出 SAS；顶点归属最近的范德华球面
+        Atoms atoms = makeAtoms(300, 15);
+        surface.setSpacing(0.3f);
+        const float tolerance = 0.5f * 0.3f;
+        build(surface, atoms, SurfaceKind::SolventAccessible, mesh);
+        float sasWorst = 0.0f;
+        size_t wrongAtom = 0;
+        for (size_t v = 0; v < mesh.vertexCount(); ++v) {
+            sasWorst = std::max(sasWorst, std::fabs(nearestSurface(atoms, &mesh.positions[3 * v], probe, nullptr)));
+            uint32_t atom = 0;
+            nearestSurface(atoms, &mesh.positions[3 * v], 0.0f, &atom);
+            wrongAtom += atom == mesh.atomIds[v] ? 0 : 1;
+        }
+        ctx.check(sasWorst <= tolerance, "SAS vertices are up to %.3f off the probe-inflated spheres", sasWorst);
+        ctx.check(wrongAtom == 0, "%zu of %zu SAS vertices are assigned to the wrong atom", wrongAtom, mesh.vertexCount());
+
+        build(surface, atoms, SurfaceKind::SolventExcluded, mesh);
+        size_t insideVdw = 0;
+        size_t outsideSas = 0;
+        wrongAtom = 0;
+        for (size_t v = 0; v < mesh.vertexCount(); ++v) {
+            uint32_t atom = 0;
+            insideVdw += nearestSurface(atoms, &mesh.positions[3 * v], 0.0f, &atom) < -tolerance ? 1 : 0;
+            outsideSas += nearestSurface(atoms, &mesh.positions[3 * v], probe, nullptr) > tolerance ? 1 : 0;
+            wrongAtom += atom == mesh.atomIds[v] ? 0 : 1;
+        }
+        ctx.check(mesh.vertexCount() > 0 && insideVdw == 0 && outsideSas == 0,
+            "SES: %zu of %zu vertices inside a vdW sphere, %zu outside the SAS", insideVdw, mesh.vertexCount(),
+            outsideSas);
+        ctx.check(wrongAtom == 0, "%zu of %zu SES vertices are assigned to the wrong atom", wrongAtom, mesh.vertexCount());
+    }
+
+    Atoms atoms = makeAtoms(ctx.scaled(1000000, 1000), 16);
+    surface.setSpacing(0.5f);
+    const SurfaceKind kinds[2] = { SurfaceKind::SolventAccessible, SurfaceKind::SolventExcluded };
+    for (int k = 0; k < 2; ++k) {
+        double ms = ctx.best([&] {
+            build(surface, atoms, kinds[k], mesh);
+        });
+        ctx.report("%zu atoms %s: %.0f ms (field %.0f, extract %.0f), spacing %.2f, %zu triangles", atoms.size(),
+            k == 0 ? "SAS" : "SES", ms, surface.lastFieldMs(), surface.lastExtractMs(), surface.spacing(),
+            mesh.triangleCount());
+    }
+}
+
+// 高斯密度表面：splat 核（2^x 近似）与双精度 exp 的误差，以及逐帧重建的耗时
+BENCH_CASE(gaussian_surface) {
+    MolecularSurface surface;
+    Mesh mesh;
+    const float iso = 0.5f;
+    surface.setGaussianScale(1.0f);
+    surface.setDensityIso(iso);
+    {
+        // 单个原子：exp(-d^2 / r^2) = iso 处 d = r * sqrt(ln 2)
+        Atoms one;
+        one.x.push_back(0.0f);
+        one.y.push_back(0.0f);
+        one.z.push_back(0.0f);
+        one.radius.push_back(1.7f);
+        surface.setSpacing(0.2f);
+        build(surface, one, SurfaceKind::GaussianDensity, mesh);
+        float expected = 1.7f * std::sqrt(std::log(2.0f));
+        float worst = 0.0f;
+        for (size_t v = 0; v < mesh.vertexCount(); ++v) {
+            const float* p = &mesh.positions[3 * v];
+            worst = std::max(worst, std::fabs(std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]) - expected));
+        }
+        ctx.check(mesh.vertexCount() > 0 && worst <= 0.5f * surface.spacing(),
+            "single atom gaussian surface radius off by %.3f", worst);
+    }
+    {
+        Atoms atoms = makeAtoms(500, 17);
+        surface.setSpacing(0.4f);
+        build(surface, atoms, SurfaceKind::GaussianDensity, mesh);
+        const ScalarGrid& field = surface.field();
+        BenchRandom random(18);
+        double worst = 0.0;
+        for (int s = 0; s < 2000; ++s) {
+            int i = int(random.next() % uint64_t(field.nx));
+            int j = int(random.next() % uint64_t(field.ny));
+            int k = int(random.next() % uint64_t(field.nz));
+            const float p[3] = { field.origin[0] + field.spacing * float(i), field.origin[1] + field.spacing * float(j),
+                field.origin[2] + field.spacing * float(k) };
+            worst = std::max(worst, std::fabs(double(field.at(i, j, k)) - gaussianField(atoms, p, 1.0f, iso)));
+        }
+        ctx.check(worst <= 1e-4, "gaussian field differs from a double-precision sum by up to %.2e", worst);
+    }
+
+    // 逐帧：几万个原子，格距 1 埃（动画常用）与 0.5 埃
+    Atoms atoms = makeAtoms(ctx.scaled(50000, 500), 19);
+    const float spacings[2] = { 1.0f, 0.5f };
+    for (float spacing : spacings) {
+        surface.setSpacing(spacing);
+        double splatMs = 0.0;
+        double ms = ctx.best([&] {
+            build(surface, atoms, SurfaceKind::GaussianDensity, mesh);
+            splatMs = surface.lastFieldMs();
+        });
+        const ScalarGrid& field = surface.field();
+        ctx.report("%zu atoms, spacing %.1f (%dx%dx%d): %.1f ms per frame, splat %.1f ms (%.2f us/atom), %zu triangles",
+            atoms.size(), spacing, field.nx, field.ny, field.nz, ms, splatMs, splatMs * 1e3 / double(atoms.size()),
+            mesh.triangleCount());
+    }
+}
@@ -0,0 +1,121 @@
+﻿// BenchTrajectory v 1.0
+#include "Bench.h"
+#include "DcdReader.h"
+#include "FramePrefetcher.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+namespace {
+    // 第 frame 帧第 atom 个原子的坐标分量，写文件与校验共用
+    inline float coordinate(size_t frame, size_t atom, int axis) {
+        return float(atom % 1000) * 0.1f + float(axis) * 100.0f + float(frame) * 0.5f;
+    }
+
+    void writeRecord(FILE* f, const void* data, uint32_t size) {
+        std::fwrite(&size, 4, 1, f);
+        std::fwrite(data, 1, size, f);
+        std::fwrite(&size, 4, 1, f);
+    }
+
+    // 本机字节序的 CHARMM 格式 DCD，没有晶胞记录
+    bool writeDcd(const std::string& path, size_t atomCount, size_t frameCount) {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if (f == nullptr) return false;
+        uint8_t head[84] = {};
+        std::memcpy(head, "CORD", 4);
+        int32_t icntrl[20] = {};
+        icntrl[0] = int32_t(frameCount);
+        icntrl[2] = 1;
+        float delta = 1.0f;
+        std::memcpy(&icntrl[9], &delta, 4);
+        icntrl[19] = 24;
+        std::memcpy(head + 4, icntrl, sizeof(icntrl));
+        writeRecord(f, head, sizeof(head));
+        uint8_t title[84] = {};
+        int32_t lines = 1;
+        std::memcpy(title, &lines, 4);
+        std::memcpy(title + 4, "bench", 5);
+        writeRecord(f, title, sizeof(title));
+        int32_t atoms = int32_t(atomCount);
+        writeRecord(f, &atoms, 4);
+
+        std::vector<float> axis(atomCount);
+        for (size_t frame = 0; frame < frameCount; ++frame) {
+            for (int k = 0; k < 3; ++k) {
+                for (size_t a = 0; a < atomCount; ++a) axis[a] = coordinate(frame, a, k);
+                writeRecord(f, axis.data(), uint32_t(atomCount * 4));
+            }
+        }
+        return std::fclose(f) == 0;
+    }
+
+    bool frameMatches(const TrajectoryFrame& frame, size_t index) {
+        if (frame.index != index) return false;
+        for (size_t a = 0; a < frame.atomCount(); a += 997) {
+            if (frame.x[a] != coordinate(index, a, 0) || frame.y[a] != coordinate(index, a, 1) ||
+                frame.z[a] != coordinate(index, a, 2)) return false;
+        }
+        return true;
+    }
+}
+
+// 10 万原子的 DCD：同步逐帧读取与 FramePrefetcher 正放、倒放的帧率，以及暂停在第 0 帧时的预取
+BENCH_CASE(trajectory_prefetch) {
+    const size_t atomCount = ctx.scaled(100000, 1000);
+    const size_t frameCount = 400;
+    std::string path = (std::filesystem::temp_directory_path() / "bench_trajectory.dcd").string();
+    if (!ctx.check(writeDcd(path, atomCount, frameCount), "cannot write %s", path.c_str())) return;
+
+    DcdReader reader;
+    if (!ctx.check(reader.open(path), "open failed: %s", reader.lastError().c_str())) return;
+    ctx.check(reader.frameCount() == frameCount && reader.atomCount() == atomCount, "DCD header mismatch");
+
+    // 同步读取作为基准（文件已在页缓存中，测的是读取与解码本身）
+    TrajectoryFrame frame;
+    size_t wrong = 0;
+    double syncMs = ctx.best([&] {
+        for (size_t i = 0; i < frameCount; ++i) {
+            if (!reader.readFrame(i, frame) || !frameMatches(frame, i)) ++wrong;
+        }
+    });
+    ctx.report("%zu atoms, sync readFrame: %.0f frames/s", atomCount, frameCount / (syncMs / 1000.0));
+
+    {
+        FramePrefetcher prefetcher(reader, 32);
+        for (int step : { 1, -1 }) {
+            prefetcher.setPlayback(step, false);
+            uint64_t hits0 = prefetcher.hits();
+            uint64_t misses0 = prefetcher.misses();
+            double ms = ctx.best([&] {
+                for (size_t k = 0; k < frameCount; ++k) {
+                    size_t i = step > 0 ? k : frameCount - 1 - k;
+                    const TrajectoryFrame* f = prefetcher.acquire(i);
+                    if (f == nullptr || !frameMatches(*f, i)) ++wrong;
+                }
+            });
+            ctx.report("prefetch step %+d (%s): %.0f frames/s, hits %llu, misses %llu", step,
+                prefetcher.usingIoRing() ? "io_uring" : "sync reads", frameCount / (ms / 1000.0),
+                (unsigned long long)(prefetcher.hits() - hits0), (unsigned long long)(prefetcher.misses() - misses0));
+        }
+    }
+    ctx.check(wrong == 0, "%zu frames decoded with wrong coordinates", wrong);
+
+    // 暂停在第 0 帧：负方向越界的帧要跳过，正方向照常预取
+    {
+        FramePrefetcher prefetcher(reader, 32);
+        prefetcher.setPlayback(0, false);
+        prefetcher.acquire(0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        uint64_t misses0 = prefetcher.misses();
+        const TrajectoryFrame* f = prefetcher.acquire(8);
+        ctx.check(f != nullptr && frameMatches(*f, 8), "frame 8 wrong while paused");
+        ctx.check(prefetcher.misses() == misses0, "frame 8 was not prefetched while paused at frame 0");
+    }
+
+    reader.close();
+    std::remove(path.c_str());
+}
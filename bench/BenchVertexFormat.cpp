@@ -0,0 +1,104 @@
+﻿// BenchVertexFormat v 1.0
+#include "Bench.h"
+#include "MolecularSurface.h"
+#include "PackedMeshRenderer.h"
+#include "VertexFormat.h"
+#include <cmath>
+
+namespace {
+    // 双精度的 atan2(|a x b|, a . b)：float 的 acos 在 1 附近误差就有 0.02 度
+    float angleDegrees(const glm::vec3& a, const glm::vec3& b) {
+        glm::dvec3 da(a), db(b);
+        return float(glm::degrees(std::atan2(glm::length(glm::cross(da, db)), glm::dot(da, db))));
+    }
+}
+
+// 压缩顶点的往返误差：位置每轴不超过 extent / 131070，法线小于 0.01 度，atomIds 原样保留；
+// 以及相对 Mesh float 布局（28 字节）的大小与打包耗时
+BENCH_CASE(vertex_format) {
+    {
+        // 坐标轴、八个卦限的对角线与随机方向
+        std::vector<glm::vec3> normals;
+        for (int d = 0; d < 3; ++d) {
+            glm::vec3 axis(0.0f);
+            axis[d] = 1.0f;
+            normals.push_back(axis);
+            normals.push_back(-axis);
+        }
+        for (int k = 0; k < 8; ++k) {
+            normals.push_back(glm::vec3(k & 1 ? 1.0f : -1.0f, k & 2 ? 1.0f : -1.0f, k & 4 ? 1.0f : -1.0f));
+        }
+        BenchRandom random(30);
+        while (normals.size() < 200000) {
+            glm::vec3 n(random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f));
+            if (glm::dot(n, n) > 1e-6f) normals.push_back(n);
+        }
+        float worst = 0.0f;
+        for (const glm::vec3& n : normals) worst = std::max(worst, angleDegrees(n, decodeOctahedral(encodeOctahedral(n))));
+        ctx.report("octahedral normals: %zu directions, worst %.4f degrees", normals.size(), worst);
+        ctx.check(worst < 0.01f, "octahedral normal error %.4f degrees exceeds 0.01", worst);
+    }
+
+    // 高斯表面网格：原子随机分布
+    const size_t atomCount = ctx.scaled(20000, 200);
+    std::vector<float> x, y, z, radius;
+    BenchRandom random(31);
+    float side = std::cbrt(float(atomCount) / 0.05f);
+    for (size_t i = 0; i < atomCount; ++i) {
+        x.push_back(random.uniform(0.0f, side));
+        y.push_back(random.uniform(0.0f, side));
+        z.push_back(random.uniform(0.0f, side));
+        radius.push_back(1.7f);
+    }
+    MolecularSurface surface;
+    surface.setSpacing(0.7f);
+    Mesh mesh;
+    surface.build(x.data(), y.data(), z.data(), radius.data(), atomCount, SurfaceKind::GaussianDensity, mesh);
+    const size_t n = mesh.vertexCount();
+
+    PackedMesh packed;
+    double packMs = ctx.best([&] {
+        packMesh(mesh, packed);
+    });
+    Mesh unpacked;
+    unpackMesh(packed, unpacked);
+
+    float positionError[3] = { 0.0f, 0.0f, 0.0f };
+    float normalError = 0.0f;
+    for (size_t v = 0; v < n; ++v) {
+        for (int d = 0; d < 3; ++d) {
+            positionError[d] = std::max(positionError[d], std::fabs(unpacked.positions[3 * v + d] - mesh.positions[3 * v + d]));
+        }
+        glm::vec3 a(mesh.normals[3 * v], mesh.normals[3 * v + 1], mesh.normals[3 * v + 2]);
+        glm::vec3 b(unpacked.normals[3 * v], unpacked.normals[3 * v + 1], unpacked.normals[3 * v + 2]);
+        normalError = std::max(normalError, angleDegrees(a, b));
+    }
+    // 量化步长的一半，外加 float 反量化本身的舍入
+    bool positionsOk = true;
+    for (int d = 0; d < 3; ++d) {
+        float bound = packed.extent[d] / 131070.0f + 4.0f * 1.2e-7f * (std::fabs(packed.origin[d]) + packed.extent[d]);
+        positionsOk = positionsOk && positionError[d] <= bound;
+    }
+    const size_t floatBytes = n * (6 * sizeof(float) + sizeof(uint32_t));
+    ctx.report("%zu vertices: %.1f MB as float (28 B) -> %.1f MB packed (%zu B), %.2fx, pack %.1f ms", n,
+        double(floatBytes) / 1e6, double(packed.vertexBytes()) / 1e6, sizeof(PackedVertex),
+        double(floatBytes) / double(packed.vertexBytes()), packMs);
+    ctx.report("round trip: position error %.2e / %.2e / %.2e (extent %.0f / %.0f / %.0f), normal %.4f degrees",
+        positionError[0], positionError[1], positionError[2], packed.extent[0], packed.extent[1], packed.extent[2],
+        normalError);
+    ctx.check(n > 0, "gaussian surface is empty");
+    ctx.check(positionsOk, "position round-trip error exceeds extent / 131070");
+    ctx.check(normalError < 0.01f, "normal round-trip error %.4f degrees exceeds 0.01", normalError);
+    ctx.check(unpacked.atomIds == mesh.atomIds, "atom ids changed in the round trip");
+    ctx.check(unpacked.indices == mesh.indices, "indices changed in the round trip");
+
+    // 绘制路径保留的 CPU 副本：拾取时由三角形的顶点查回原子
+    PackedMeshRenderer renderer;
+    renderer.setMesh(mesh, RenderAnchor());
+    size_t wrongPick = 0;
+    for (size_t i = 0; i < mesh.indices.size(); ++i) {
+        const uint32_t v = renderer.mesh().indices[i];
+        wrongPick += renderer.mesh().vertices[v].atomId == mesh.atomIds[mesh.indices[i]] ? 0 : 1;
+    }
+    ctx.check(wrongPick == 0, "%zu triangle corners pick the wrong atom from the packed mesh", wrongPick);
+}
@@ -0,0 +1,123 @@
+﻿// AtomBuffers v 1.3
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AtomTable.h"
+#include "Camera.h"
+#include "DirtyRanges.h"
+
+// 按原子下标存放的 GL 缓冲，以纹理缓冲（TBO）形式供多个表示共用：
+//   位置：GL_RGBA32F，xyz 为相对所在块锚点的坐标，w 为半径（默认范德华半径）
+//   颜色：GL_RGBA8，0xAABBGGRR
+//   所在块：GL_R32UI；块偏移：GL_RGBA32F，xyz 为块锚点相对渲染原点的偏移
+// 着色器用 texelFetch(原子下标) 读取：原子球（SphereImpostor）以实例号为下标，
+// 键、卡通等表示只需保存原子下标，原子数据在 CPU 和 GPU 上都只有这一份。
+// 修改按区间记录，upload 只提交脏区间；轨迹播放时每帧只有位置缓冲需要重传
+// （GL 3.3 的 TBO 不支持 RGB32F，因此按 16 字节存放）。
+// 只用一个锚点时，跨 1e5 埃的场景边缘的原子相对锚点有 5e4 埃，float 只剩 0.004 埃的分辨率。
+// 因此 pack 时按 2048 埃的网格把原子分块，每块一个锚点（格子中心，双精度），坐标在双精度下减去
+// 所在块的锚点再存成 float，块内坐标的误差约 1e-4 埃。着色器取原子坐标时加上所在块的偏移，
+// 再乘 Camera::getRenderView()；块偏移只在渲染原点移动后由 updateBlockOffsets 重算重传，原子缓冲不动
+class AtomBuffers {
+private:
+    std::vector<float> positions_;      // 每原子 4 个 float
+    std::vector<uint32_t> colors_;
+    std::vector<uint32_t> atomBlocks_;  // 每原子所在块的下标
+    std::vector<RenderAnchor> blocks_;
+    std::vector<float> blockOffsets_;   // 每块 4 个 float，xyz 为锚点相对渲染原点的偏移
+    uint32_t offsetsVersion_ = 0xFFFFFFFFu;     // blockOffsets_ 对应的 Camera::originVersion
+    DirtyRanges positionsDirty_;
+    DirtyRanges colorsDirty_;
+    bool blocksDirty_ = false;
+
+    unsigned int positionBuffer_ = 0;
+    unsigned int positionTexture_ = 0;
+    unsigned int colorBuffer_ = 0;
+    unsigned int colorTexture_ = 0;
+    unsigned int blockBuffer_ = 0;
+    unsigned int blockTexture_ = 0;
+    unsigned int offsetBuffer_ = 0;
+    unsigned int offsetTexture_ = 0;
+    size_t positionCapacity_ = 0;       // GL 缓冲已分配的原子数
+    size_t colorCapacity_ = 0;
+    size_t uploadBytes_ = 0;
+    size_t uploadCalls_ = 0;
+
+    void uploadRanges(unsigned int buffer, DirtyRanges& dirty, size_t& capacity, const void* data,
+        size_t elementSize, unsigned int usage);
+public:
+    AtomBuffers() {
+
+    }
+
+    // 按原子表填写坐标、半径与元素颜色并重新分块，全部标脏
+    void pack(const AtomTable& atoms);
+    // 替换 [begin, end) 的坐标（轨迹帧，世界坐标数组按原子下标），半径不变，分块与锚点不变
+    void updatePositions(const float* x, const float* y, const float* z, size_t begin, size_t end);
+    void updatePositions(const float* x, const float* y, const float* z) {
+        updatePositions(x, y, z, 0, atomCount());
+    }
+    void setColor(size_t atom, uint32_t color);
+    void setRadius(size_t atom, float radius);
+
+    size_t atomCount() const {
+        return colors_.size();
+    }
+    // 每原子 4 个 float，xyz 相对 blockAnchor(atomBlock(i))
+    const std::vector<float>& positions() const {
+        return positions_;
+    }
+    size_t blockCount() const {
+        return blocks_.size();
+    }
+    uint32_t atomBlock(size_t atom) const {
+        return atomBlocks_[atom];
+    }
+    const RenderAnchor& blockAnchor(size_t block) const {
+        return blocks_[block];
+    }
+    // 每块 4 个 float，最近一次 updateBlockOffsets 的结果（与着色器读到的相同）
+    const std::vector<float>& blockOffsets() const {
+        return blockOffsets_;
+    }
+    const std::vector<uint32_t>& colors() const {
+        return colors_;
+    }
+    // 丢弃待上传的区间
+    void clearDirty() {
+        positionsDirty_.clear();
+        colorsDirty_.clear();
+    }
+    // 下次 upload 要提交的区间
+    const DirtyRanges& dirtyPositions() const {
+        return positionsDirty_;
+    }
+    const DirtyRanges& dirtyColors() const {
+        return colorsDirty_;
+    }
+
+    // 以下需要 GL 上下文
+    void createGL();
+    void destroyGL();
+    // 提交脏区间；原子数超过缓冲容量或脏数据过半时整体重传
+    void upload();
+    // 每帧绘制前调用：渲染原点移动或重新分块后重算块偏移，有 GL 缓冲时重传（每块 16 字节）
+    void updateBlockOffsets(const Camera& camera);
+    // 把位置、颜色纹理绑定到给定纹理单元（GL_TEXTURE0 + unit）
+    void bind(unsigned int positionUnit, unsigned int colorUnit) const;
+    // 把所在块、块偏移纹理绑定到给定纹理单元；读位置的着色器都要用
+    void bindBlocks(unsigned int blockUnit, unsigned int offsetUnit) const;
+    bool isReady() const {
+        return positionTexture_ != 0;
+    }
+
+    // 最近一次 upload 提交的字节数与 GL 调用次数
+    size_t lastUploadBytes() const {
+        return uploadBytes_;
+    }
+    size_t lastUploadCalls() const {
+        return uploadCalls_;
+    }
+};
@@ -0,0 +1,121 @@
+﻿// AtomTable v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 二级结构类型（DSSP 八类），按残基存储
+enum class SecondaryStructure : uint8_t {
+    Coil = 0,
+    AlphaHelix,   // H
+    Helix310,     // G
+    PiHelix,      // I
+    Strand,       // E
+    Bridge,       // B
+    Turn,         // T
+    Bend          // S
+};
+
+// 原子标志位
+enum AtomFlags : uint8_t {
+    AtomHetero = 1 << 0     // HETATM 记录
+};
+
+// 不超过 4 个字符的名字（原子名、残基名、链名）打包成 uint32_t，
+// 首字符在最低字节，前后空格被去掉，不足补 0
+inline uint32_t packName4(const char* s, size_t n) {
+    while (n > 0 && *s == ' ') {
+        ++s;
+        --n;
+    }
+    while (n > 0 && (s[n - 1] == ' ' || s[n - 1] == '\0')) --n;
+    uint32_t v = 0;
+    for (size_t i = 0; i < n && i < 4; ++i) {
+        v |= uint32_t(uint8_t(s[i])) << (8 * i);
+    }
+    return v;
+}
+
+// 解包为以 0 结尾的字符串，out 至少 5 字节
+inline void unpackName4(uint32_t v, char* out) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = char((v >> (8 * i)) & 0xFF);
+    }
+    out[4] = '\0';
+}
+
+struct Residue {
+    uint32_t name = 0;          // packName4
+    int32_t seq = 0;            // 残基序号
+    char insertion = ' ';       // 插入码
+    SecondaryStructure ss = SecondaryStructure::Coil;
+    int32_t chain = 0;          // 所属链下标
+    uint32_t firstAtom = 0;
+    uint32_t atomCount = 0;
+};
+
+struct Chain {
+    uint32_t id = 0;            // packName4（auth_asym_id / PDB 链标识）
+    uint32_t firstResidue = 0;
+    uint32_t residueCount = 0;
+};
+
+// 结构的原子表：原子按 SoA 存储，坐标数组可以直接交给渲染器上传，
+// 不含任何逐原子的 std::string
+struct AtomTable {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<uint8_t> element;       // 原子序数，见 Element.h
+    std::vector<uint32_t> name;         // packName4 打包的原子名
+    std::vector<uint8_t> flags;         // AtomFlags
+    std::vector<int32_t> residueIndex;
+    std::vector<int32_t> chainIndex;
+
+    std::vector<Residue> residues;
+    std::vector<Chain> chains;
+
+    size_t atomCount() const {
+        return x.size();
+    }
+
+    void resizeAtoms(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        element.resize(n);
+        name.resize(n);
+        flags.resize(n);
+        residueIndex.resize(n);
+        chainIndex.resize(n);
+    }
+
+    void clear() {
+        resizeAtoms(0);
+        residues.clear();
+        chains.clear();
+    }
+};
+
+// 文件中记录的二级结构区间（PDB 的 HELIX/SHEET，mmCIF 的 _struct_conf/_struct_sheet_range）
+struct SecondaryStructureRange {
+    SecondaryStructure type = SecondaryStructure::Coil;
+    uint32_t chain = 0;         // packName4 打包的链标识
+    int32_t beginSeq = 0;
+    char beginInsertion = ' ';
+    int32_t endSeq = 0;
+    char endInsertion = ' ';
+};
+
+// 由逐原子的残基键生成 residues/chains 并填写 residueIndex/chainIndex。
+// chainKey 变化即开始新链（相当于 PDB 的 TER），chainName 为链的显示名；
+// 其余键任一变化即开始新残基。原子数组必须已经 resizeAtoms
+void buildResidues(AtomTable& table, const int32_t* seq, const char* insertion, const uint32_t* residueName,
+    const uint32_t* chainName, const uint32_t* chainKey);
+
+// 把区间写入 Residue::ss，找不到起止残基的区间被忽略
+void applySecondaryStructure(AtomTable& table, const std::vector<SecondaryStructureRange>& ranges);
+
+// 原子坐标的包围盒；没有原子时返回 false，lo / hi 置零
+bool atomBounds(const AtomTable& table, float lo[3], float hi[3]);
@@ -0,0 +1,66 @@
+﻿// BinaryCifReader v 1.0
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AtomTable.h"
+#include "MappedFile.h"
+#include "MsgPack.h"
+
+// 解码后的一列
+struct BinaryCifColumn {
+    enum class Kind { Empty, Int, Float, String };
+    Kind kind = Kind::Empty;
+    std::vector<int32_t> ints;              // Int 列的值；String 列为字符串表下标
+    std::vector<float> floats;
+    std::vector<std::string_view> strings;  // String 列的字符串表，指向文件内容
+    std::vector<int32_t> mask;              // 空表示全部存在；否则 0 存在，1 为 '.'，2 为 '?'
+
+    size_t size() const {
+        return kind == Kind::Float ? floats.size() : ints.size();
+    }
+    bool present(size_t row) const {
+        return mask.empty() || mask[row] == 0;
+    }
+    std::string_view stringAt(size_t row) const;
+    int32_t intAt(size_t row) const;
+    float floatAt(size_t row) const;
+};
+
+// BinaryCIF 读取：MessagePack 只解析元数据，列数据在请求时才按编码链解码
+// （ByteArray、IntegerPacking、Delta、RunLength、FixedPoint、IntervalQuantization、StringArray）
+class BinaryCifReader {
+private:
+    MappedFile file_;
+    MsgPackDocument doc_;
+    MsgPackDocument::Ref block_;
+    size_t inputSize_ = 0;
+    std::string error_;
+
+    MsgPackDocument::Ref findCategory(std::string_view name) const;
+    MsgPackDocument::Ref findColumn(std::string_view category, std::string_view column) const;
+public:
+    BinaryCifReader() {
+
+    }
+
+    bool open(const std::string& path);
+    // 直接使用调用者的内存，data 必须在读取期间保持有效
+    bool parse(const char* data, size_t size);
+
+    // 类别名可以带或不带前导下划线
+    bool hasCategory(std::string_view name) const;
+    size_t rowCount(std::string_view category) const;
+    bool decodeColumn(std::string_view category, std::string_view column, BinaryCifColumn& out) const;
+
+    // 读取 _atom_site（第一个模型）写入原子表
+    bool loadAtomSite(AtomTable& out);
+    // 读取 _struct_conf 与 _struct_sheet_range 写入 Residue::ss
+    void loadSecondaryStructure(AtomTable& out);
+
+    const std::string& lastError() const {
+        return error_;
+    }
+};
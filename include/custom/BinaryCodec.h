@@ -0,0 +1,33 @@
+﻿// BinaryCodec v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// BinaryCIF 与 MMTF 共用的列编码解码核心。
+// 所有函数都写入调用者预先分配好的缓冲区，不分配内存；
+// 在支持 SSE2 的平台上使用向量化实现
+
+// 整数解包（BinaryCIF 的 IntegerPacking、MMTF 的 recursive index）：
+// 遇到类型上/下限的值时与后一个值累加。返回写入 out 的个数（不超过 outCapacity）
+size_t unpackInt8(const int8_t* src, size_t count, int32_t* out, size_t outCapacity);
+size_t unpackUint8(const uint8_t* src, size_t count, int32_t* out, size_t outCapacity);
+size_t unpackInt16(const int16_t* src, size_t count, int32_t* out, size_t outCapacity);
+size_t unpackUint16(const uint16_t* src, size_t count, int32_t* out, size_t outCapacity);
+
+// 差分解码（原地前缀和）：data[0] += origin，data[i] += data[i - 1]
+void deltaDecode(int32_t* data, size_t count, int32_t origin);
+
+// 游程解码：pairs 为 (值, 次数) 对。返回写入的个数（不超过 outCapacity）
+size_t runLengthDecode(const int32_t* pairs, size_t pairCount, int32_t* out, size_t outCapacity);
+// 游程展开后的总长度
+size_t runLengthSize(const int32_t* pairs, size_t pairCount);
+
+// 定点数：out[i] = src[i] / factor
+void fixedPointDecode(const int32_t* src, size_t count, float factor, float* out);
+// 区间量化：out[i] = min + (max - min) / (steps - 1) * src[i]
+void intervalDecode(const int32_t* src, size_t count, float min, float max, int32_t steps, float* out);
+
+// 大端 -> 本机字节序（MMTF），可以原地转换
+void byteSwap16(const uint8_t* src, size_t count, int16_t* out);
+void byteSwap32(const uint8_t* src, size_t count, int32_t* out);
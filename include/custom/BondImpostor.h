@@ -0,0 +1,68 @@
+﻿// BondImpostor v 1.1
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "AtomBuffers.h"
+#include "BondPerception.h"
+#include "Camera.h"
+#include "Shader.h"
+
+// 键的圆柱冒名顶替体：每条键只存两个原子下标（8 字节实例），
+// 端点坐标与颜色在顶点着色器中从 AtomBuffers 的纹理缓冲按下标读取，
+// 每个实例画一个包住圆柱的长方体，片段着色器对圆柱求交并写深度，两半各取端点原子的颜色
+// （shaders/bond_impostor.*）。键表不变时键缓冲只上传一次，
+// 轨迹播放时每帧只有 AtomBuffers 的位置缓冲需要重传。端点是相对所在块锚点的坐标，
+// 着色器加上 AtomBuffers 的块偏移后乘 Camera::getRenderView 变换到视空间
+class BondImpostor {
+private:
+    std::vector<uint32_t> pairs_;       // 每条键两个原子下标
+    bool pairsDirty_ = false;
+    const AtomBuffers* atoms_ = nullptr;
+    float radius_ = 0.15f;
+
+    unsigned int vao_ = 0;
+    unsigned int boxBuffer_ = 0;
+    unsigned int bondBuffer_ = 0;
+    size_t uploadedCount_ = 0;          // GL 缓冲中的键数
+    Shader shader_;
+    std::string error_;
+public:
+    BondImpostor() {
+
+    }
+
+    // 坐标与颜色来源；可与其他表示共用同一个 AtomBuffers，须在 draw 之前 upload
+    void setAtomBuffers(const AtomBuffers* atoms) {
+        atoms_ = atoms;
+    }
+    // 键表变化（重新成键、换结构）时调用
+    void setBonds(const BondTable& bonds);
+    void setBonds(const std::vector<uint32_t>& pairs);
+
+    size_t bondCount() const {
+        return pairs_.size() / 2;
+    }
+    void setRadius(float radius) {
+        radius_ = radius;
+    }
+    float radius() const {
+        return radius_;
+    }
+
+    // 以下需要 GL 上下文
+    bool createGL(const std::string& vertexPath, const std::string& fragmentPath);
+    void destroyGL();
+    // 键表变化后重传键缓冲，否则什么都不做
+    void upload();
+    // 视图取 camera 的渲染视图，调用方本帧已调用过 AtomBuffers::updateBlockOffsets；
+    // 占用纹理单元 0 到 3，调用方负责开启深度测试
+    void draw(const Camera& camera, const glm::mat4& projection) const;
+
+    const std::string& lastError() const {
+        return error_;
+    }
+};
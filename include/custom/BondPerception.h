@@ -0,0 +1,60 @@
+﻿// BondPerception v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AtomTable.h"
+#include "NeighborGrid.h"
+
+// 键表（CSR）：原子 i 的相邻原子为 neighbors[offsets[i] .. offsets[i + 1])，
+// 每条键在两端各出现一次，每行按原子下标升序
+struct BondTable {
+    std::vector<uint32_t> offsets;      // atomCount + 1
+    std::vector<uint32_t> neighbors;
+
+    size_t bondCount() const {
+        return neighbors.size() / 2;
+    }
+    size_t degree(size_t atom) const {
+        return offsets[atom + 1] - offsets[atom];
+    }
+    void clear() {
+        offsets.clear();
+        neighbors.clear();
+    }
+};
+
+// 按距离判定共价键（用于没有 CONECT 记录的结构）：
+// 两原子距离在 [minDistance, r1 + r2 + tolerance] 之间即成键，氢原子之间不成键。
+// 近邻搜索用 NeighborGrid，格子边长取结构中实际出现的元素可能成键的最大距离，
+// 每个原子只需检查相邻格子；按格子区间多线程搜索，O(N)。
+// 网格作为成员保留，反复调用时复用内存
+class BondPerception {
+private:
+    NeighborGrid grid_;
+    float tolerance_ = 0.45f;
+    float minDistance_ = 0.4f;
+    double perceiveMs_ = 0.0;
+public:
+    BondPerception() {
+
+    }
+
+    void setTolerance(float tolerance) {
+        tolerance_ = tolerance;
+    }
+    void setMinDistance(float distance) {
+        minDistance_ = distance;
+    }
+
+    void perceive(const AtomTable& atoms, BondTable& out);
+
+    // 最近一次 perceive 的耗时（毫秒）
+    double lastPerceiveMs() const {
+        return perceiveMs_;
+    }
+};
+
+// 把键表展开为不重复的原子对（a < b），每条键两个下标，可直接作为 GL 索引缓冲
+void bondPairs(const BondTable& bonds, std::vector<uint32_t>& out);
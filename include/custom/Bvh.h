@@ -0,0 +1,169 @@
+﻿// Bvh v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FrustumCuller.h"
+
+// 节点 36 字节。left 为 0 表示叶子（0 号是根，不会是子节点），否则两个子节点为 left 与 left + 1；
+// 任何节点的图元都是 order 中连续的 [first, first + count)，子节点的下标总比父节点大
+struct BvhNode {
+    float lo[3];
+    float hi[3];
+    uint32_t first;
+    uint32_t count;
+    uint32_t left;
+};
+
+// 图元包围盒上的层次包围盒（原子、残基球、网格实例都先化成包围盒）。
+// 构建：按质心分 16 个桶做 SAH（只在质心跨度最大的轴上分桶），
+// 大节点在调用线程上逐层划分、桶统计并行；剩下的子树足够多以后各子树并行构建，最后拼接。
+// 子树不再做 SAH：图元按质心的 30 位 Morton 码基数排序，在码的最高不同位处划分（LBVH），
+// 质量略差但省掉逐层分桶与划分，子树之上的几层仍是 SAH。
+// 拓扑不变（轨迹帧）时用 refit：只更新图元包围盒，再自底向上合并节点包围盒——
+// 子节点下标总比父节点大，倒序扫一遍节点数组即可，各子树的区间并行扫，顶层最后扫。
+// 图元包围盒保存在 Bvh 内并按叶子顺序（order）排列：构建时换一次顺序，之后 refit 与查询访问叶子都是连续内存
+class Bvh {
+private:
+    std::vector<BvhNode> nodes_;
+    std::vector<uint32_t> order_;       // 按叶子排列的图元下标
+    std::vector<uint32_t> slots_;       // order_ 的逆：图元下标 -> 在 order_ 中的位置
+    AabbArray boxes_;                   // 按 order_ 排列
+    std::vector<uint32_t> spans_;       // 并行构建的子树在 nodes_ 中各占一段连续区间，spans_[i] 到 spans_[i + 1]
+    size_t maxLeafSize_ = 4;
+    double buildMs_ = 0.0;
+    double refitMs_ = 0.0;
+
+    void buildNodes();
+    void refitNodes();
+    void refitRange(size_t begin, size_t end);
+
+    static bool rayBox(const BvhNode& node, const float origin[3], const float inv[3], float tMax, float& tNear) {
+        float t0 = 0.0f;
+        float t1 = tMax;
+        for (int d = 0; d < 3; ++d) {
+            float a = (node.lo[d] - origin[d]) * inv[d];
+            float b = (node.hi[d] - origin[d]) * inv[d];
+            if (a > b) {
+                float t = a;
+                a = b;
+                b = t;
+            }
+            t0 = a > t0 ? a : t0;
+            t1 = b < t1 ? b : t1;
+        }
+        tNear = t0;
+        return t0 <= t1;
+    }
+public:
+    // 遍历栈的深度；构建时节点深度不会超过它的一半
+    static const int kStackSize = 128;
+    // 视锥剔除时，与视锥相交、图元不超过这么多的子树整段批量测试
+    static const uint32_t kCullBatch = 64;
+
+    Bvh() {
+
+    }
+
+    // 叶子中图元数的下限目标（SAH 认为更划算时叶子可以更大）
+    void setMaxLeafSize(size_t count) {
+        maxLeafSize_ = count;
+    }
+
+    void build(const AabbArray& boxes);
+    // 球（原子：坐标 + 半径；radius 为空时按点处理）
+    void build(const float* x, const float* y, const float* z, const float* radius, size_t n);
+    // 图元数与拓扑不变，只有位置变化
+    void refit(const AabbArray& boxes);
+    void refit(const float* x, const float* y, const float* z, const float* radius, size_t n);
+
+    // 与视锥相交的图元下标追加到 visible：完全在视锥内的子树整段输出，不再逐个测试
+    void cull(const FrustumCuller& culler, std::vector<uint32_t>& visible) const;
+
+    // 包围盒与 [lo, hi] 相交的图元逐个交给 fn(index)（邻近查询）
+    template <typename Fn>
+    void forEachOverlap(const float lo[3], const float hi[3], Fn&& fn) const {
+        if (nodes_.empty()) return;
+        uint32_t stack[kStackSize];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = nodes_[stack[--top]];
+            if (node.lo[0] > hi[0] || node.hi[0] < lo[0] || node.lo[1] > hi[1] || node.hi[1] < lo[1] ||
+                node.lo[2] > hi[2] || node.hi[2] < lo[2]) continue;
+            if (node.left != 0) {
+                stack[top++] = node.left;
+                stack[top++] = node.left + 1;
+                continue;
+            }
+            for (uint32_t k = node.first; k < node.first + node.count; ++k) {
+                if (boxes_.minX[k] > hi[0] || boxes_.maxX[k] < lo[0] || boxes_.minY[k] > hi[1] ||
+                    boxes_.maxY[k] < lo[1] || boxes_.minZ[k] > hi[2] || boxes_.maxZ[k] < lo[2]) continue;
+                fn(order_[k]);
+            }
+        }
+    }
+
+    // 沿射线 origin + t * dir（0 <= t <= tMax）遍历，近的子节点先访问。
+    // 包围盒被射线穿过的图元交给 hit(index, tMax)，hit 求交成功时把 tMax 缩短为交点，
+    // 之后更远的节点自动跳过，结束时 tMax 为最近的交点
+    template <typename Fn>
+    void traceRay(const float origin[3], const float dir[3], float& tMax, Fn&& hit) const {
+        if (nodes_.empty()) return;
+        const float inv[3] = { 1.0f / dir[0], 1.0f / dir[1], 1.0f / dir[2] };
+        uint32_t stack[kStackSize];
+        int top = 0;
+        float tNear;
+        if (!rayBox(nodes_[0], origin, inv, tMax, tNear)) return;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BvhNode& node = nodes_[stack[--top]];
+            if (!rayBox(node, origin, inv, tMax, tNear)) continue;
+            if (node.left == 0) {
+                for (uint32_t i = 0; i < node.count; ++i) hit(order_[node.first + i], tMax);
+                continue;
+            }
+            float ta, tb;
+            bool hitA = rayBox(nodes_[node.left], origin, inv, tMax, ta);
+            bool hitB = rayBox(nodes_[node.left + 1], origin, inv, tMax, tb);
+            if (hitA && hitB) {
+                // 远的先入栈，近的先出栈
+                if (ta <= tb) {
+                    stack[top++] = node.left + 1;
+                    stack[top++] = node.left;
+                } else {
+                    stack[top++] = node.left;
+                    stack[top++] = node.left + 1;
+                }
+            } else if (hitA) {
+                stack[top++] = node.left;
+            } else if (hitB) {
+                stack[top++] = node.left + 1;
+            }
+        }
+    }
+
+    const std::vector<BvhNode>& nodes() const {
+        return nodes_;
+    }
+    const std::vector<uint32_t>& order() const {
+        return order_;
+    }
+    // 图元包围盒按 order() 排列：第 k 个是图元 order()[k] 的；图元 p 的在 slot(p)
+    const AabbArray& boxes() const {
+        return boxes_;
+    }
+    uint32_t slot(uint32_t primitive) const {
+        return slots_[primitive];
+    }
+    size_t primitiveCount() const {
+        return boxes_.size();
+    }
+    double lastBuildMs() const {
+        return buildMs_;
+    }
+    double lastRefitMs() const {
+        return refitMs_;
+    }
+};
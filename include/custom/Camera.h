@@ -1,11 +1,21 @@
-﻿// Camera v 1.2
+﻿// Camera v 1.3
 #pragma once 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cstdint>
+
+// 相机位置用双精度存放；另有一个双精度的渲染原点，跟着相机按格子跳动。
+// 顶点数据相对各自的锚点（RenderAnchor）存成 float，锚点与相机都先减去渲染原点（双精度）再转 float，
+// 所以 GPU 上的坐标总是很小：微米尺度的整细胞场景放大到埃级细节也不抖。
+// 渲染原点只在相机离开它超过 rebaseDistance 时移动，移动时 originVersion 加一，
+// 各对象只需重算一个平移，顶点缓冲不必重传
 class Camera {
 private:
-    glm::vec3 pos_ = glm::vec3(0.0f, 0.0f, 1.5f);
+    glm::dvec3 pos_ = glm::dvec3(0.0, 0.0, 1.5);
+    glm::dvec3 origin_ = glm::dvec3(0.0);
+    double rebaseDistance_ = 1024.0;
+    uint32_t originVersion_ = 0;
     glm::vec3 front_ = glm::vec3(0.0f, 0.0f, -1.0f);
     glm::vec3 up_ = glm::vec3(0.0f, 1.0f, 0.0f);
     float yaw_ = -90.0f;
@@ -31,10 +41,15 @@ public:
 
     }
     Camera(glm::vec3 pos_origin) {
-        pos_ = pos_origin;
+        setWorldPos(glm::dvec3(pos_origin));
     }
     void setPos(glm::vec3 pos_tochange) {
-        pos_ = pos_tochange;
+        setWorldPos(glm::dvec3(pos_tochange));
+    }
+    // 双精度位置；需要时移动渲染原点
+    void setWorldPos(const glm::dvec3& pos) {
+        pos_ = pos;
+        updateOrigin();
     }
     void setFront(glm::vec3 front_tochange) {
         front_ = front_tochange;
@@ -43,7 +58,11 @@ public:
         up_ = up_tochange;
     }
 
+    // 单精度的世界坐标，远离世界原点时会丢精度；渲染用 getRenderPos / getRenderView
     glm::vec3 getPos() const {
+        return glm::vec3(pos_);
+    }
+    glm::dvec3 getWorldPos() const {
         return pos_;
     }
     glm::vec3 getFront() const {
@@ -53,8 +72,39 @@ public:
         return up_;
     }
     glm::vec3 getRight() const;
+    // 世界坐标下的视图矩阵（双精度计算后转 float），用于坐标本身就是 float 世界坐标的数据
     glm::mat4 getView() const;
 
+    // 渲染原点：相机离它超过 distance 时跳到相机所在格子（边长 distance）的中心
+    void setRebaseDistance(double distance) {
+        rebaseDistance_ = distance;
+        updateOrigin();
+    }
+    double rebaseDistance() const {
+        return rebaseDistance_;
+    }
+    // 移动渲染原点；返回是否移动了
+    bool updateOrigin();
+    glm::dvec3 getRenderOrigin() const {
+        return origin_;
+    }
+    // 渲染原点每移动一次加一
+    uint32_t originVersion() const {
+        return originVersion_;
+    }
+    // 相对渲染原点的相机位置与视图矩阵（与 RenderAnchor::offset 配合使用）
+    glm::vec3 getRenderPos() const {
+        return glm::vec3(pos_ - origin_);
+    }
+    glm::mat4 getRenderView() const;
+    // 世界坐标与相对渲染原点坐标的换算
+    glm::vec3 toRender(const glm::dvec3& world) const {
+        return glm::vec3(world - origin_);
+    }
+    glm::dvec3 toWorld(const glm::vec3& render) const {
+        return glm::dvec3(render) + origin_;
+    }
+
     void processMouseMovement(float xoffset, float yoffset) {
         xoffset *= sensitivity_;
         yoffset *= sensitivity_;
@@ -71,3 +121,42 @@ public:
     ~Camera();
 };
 
+// 对象的双精度锚点：顶点缓冲存相对 world 的 float 坐标，只上传一次。
+// 每帧 update 取模型平移（锚点相对渲染原点），只在渲染原点移动后重算
+struct RenderAnchor {
+    glm::dvec3 world = glm::dvec3(0.0);
+    glm::vec3 offset = glm::vec3(0.0f);
+    uint32_t version = 0xFFFFFFFFu;
+
+    RenderAnchor() {
+
+    }
+    RenderAnchor(const glm::dvec3& position) : world(position) {
+    }
+    // 锚点移动后调用，下次 update 重算
+    void setWorld(const glm::dvec3& position) {
+        world = position;
+        version = 0xFFFFFFFFu;
+    }
+    const glm::vec3& update(const Camera& camera) {
+        if (version != camera.originVersion()) {
+            offset = camera.toRender(world);
+            version = camera.originVersion();
+        }
+        return offset;
+    }
+    // 配合 Camera::getRenderView 使用的模型矩阵
+    glm::mat4 model(const Camera& camera) {
+        return glm::translate(glm::mat4(1.0f), update(camera));
+    }
+    // 相对锚点的坐标到视空间：getRenderView() 再平移锚点相对渲染原点的偏移（偏移在双精度下求得）。
+    // 不走缓存，供 const 的绘制与剔除路径使用
+    glm::mat4 modelView(const Camera& camera) const {
+        return glm::translate(camera.getRenderView(), camera.toRender(world));
+    }
+    // 相机相对锚点的位置（双精度相减后转 float）
+    glm::vec3 eye(const Camera& camera) const {
+        return glm::vec3(camera.getWorldPos() - world);
+    }
+};
+
@@ -0,0 +1,127 @@
+﻿// CartoonBuilder v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AtomTable.h"
+#include "Mesh.h"
+
+// 蛋白卡通（cartoon）网格：Cα 轨迹上的 Catmull-Rom 样条作为骨架，
+// 螺旋挤出扁椭圆带，折叠片挤出矩形带并在末端画箭头，其余挤出圆管；
+// 截面的宽度方向取自 Cα→O 向量（折叠片上逐残基翻转以保持一致）。
+//
+// 链按断链（相邻 Cα 超过 4.2 埃）切成连续片段，片段再按二级结构切成段（segment），
+// 每段单独成网格，段与段之间并行生成。段的网格只取决于本段及前后三个残基的 Cα、O 坐标，
+// 轨迹帧之间只重建这些坐标有变化的段；二级结构不变时顶点布局不变，
+// changedRanges 给出需要重传的顶点与索引区间
+class CartoonBuilder {
+public:
+    // 合并网格中一段连续的顶点与索引
+    struct Range {
+        uint32_t vertexBegin;
+        uint32_t vertexCount;
+        uint32_t indexBegin;
+        uint32_t indexCount;
+    };
+private:
+    enum class Profile : uint8_t {
+        Coil,
+        Helix,
+        Sheet
+    };
+    struct TraceResidue {
+        uint32_t residue;       // AtomTable::residues 下标
+        uint32_t ca;
+        uint32_t o;             // 没有 O 原子时为 kNoAtom
+    };
+    struct Segment {
+        uint32_t begin;         // residues_ 下标区间
+        uint32_t end;
+        uint32_t traceBegin;    // 所在连续片段
+        uint32_t traceEnd;
+        Profile profile;
+        uint8_t context;        // 前后各两个残基的截面，每个 2 位（影响折叠片的平滑），片段之外为 3
+        bool dirty;
+        Mesh mesh;              // 顶点下标从 0 开始
+        uint32_t vertexBegin;   // 在合并网格中的位置
+        uint32_t indexBegin;
+    };
+
+    static const uint32_t kNoAtom = 0xffffffffu;
+
+    std::vector<TraceResidue> residues_;
+    std::vector<uint32_t> traceStart_;      // 按连续片段划分 residues_，末尾为总数
+    std::vector<Profile> profile_;          // 按 residues_
+    std::vector<float> control_;            // 上一帧每残基的 Cα、O 坐标
+    std::vector<uint32_t> changedPrefix_;   // 坐标变化残基数的前缀和
+    bool hasFrame_ = false;
+    std::vector<Segment> segments_;
+    bool layoutChanged_ = true;
+
+    Mesh mesh_;
+    std::vector<Range> changed_;
+
+    int subdivisions_ = 8;
+    float coilRadius_ = 0.3f;
+    float helixWidth_ = 2.4f;
+    float helixThickness_ = 0.5f;
+    float sheetWidth_ = 2.0f;
+    float sheetThickness_ = 0.5f;
+    float arrowWidth_ = 3.2f;
+
+    double buildMs_ = 0.0;
+    size_t rebuiltSegments_ = 0;
+
+    uint8_t segmentContext(uint32_t begin, uint32_t end, uint32_t traceBegin, uint32_t traceEnd) const;
+    void splitSegments();
+    void buildSegment(Segment& s, const float* x, const float* y, const float* z) const;
+    void assemble(const std::vector<uint32_t>& rebuilt);
+public:
+    CartoonBuilder() {
+
+    }
+
+    // 每个残基在样条上的采样数（越大越平滑），改变后下一次 build 全部重建
+    void setSubdivisions(int subdivisions);
+
+    // 收集有 Cα 的蛋白残基并按链、断链切分，二级结构取自 residues[].ss。
+    // 原子表的拓扑变化时调用
+    void prepare(const AtomTable& atoms);
+
+    // 更新二级结构（通常是每帧的 DSSP 结果，按 AtomTable 残基下标）。
+    // 只有截面类型（螺旋 / 折叠片 / 无规）真正变化的段需要重建
+    void setSecondaryStructure(const std::vector<SecondaryStructure>& ss);
+
+    // 用给定坐标生成网格，原子顺序与 prepare 时的原子表相同
+    void build(const float* x, const float* y, const float* z);
+
+    // prepare 并用原子表自身的坐标生成
+    void build(const AtomTable& atoms) {
+        prepare(atoms);
+        build(atoms.x.data(), atoms.y.data(), atoms.z.data());
+    }
+
+    const Mesh& mesh() const {
+        return mesh_;
+    }
+    // 最近一次 build 是否改变了顶点布局（段数或顶点数变化），为 true 时整个网格需要重传
+    bool layoutChanged() const {
+        return layoutChanged_;
+    }
+    // 最近一次 build 中重建过的区间（按顶点位置排序，相邻的已合并）
+    const std::vector<Range>& changedRanges() const {
+        return changed_;
+    }
+
+    size_t segmentCount() const {
+        return segments_.size();
+    }
+    size_t lastRebuiltSegments() const {
+        return rebuiltSegments_;
+    }
+    // 最近一次 build 的耗时（毫秒）
+    double lastBuildMs() const {
+        return buildMs_;
+    }
+};
@@ -0,0 +1,104 @@
+﻿// CifReader v 1.0
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AtomTable.h"
+#include "MappedFile.h"
+
+// 单个词元在所属类别文本中的位置；length 的最高位标记“带引号的值”
+struct CifToken {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// 已物化的类别：只保存词元偏移，取值时直接指向映射的文件内容
+class CifCategory {
+private:
+    const char* base_ = nullptr;
+    std::vector<std::string_view> items_;   // 不含类别前缀的条目名
+    std::vector<CifToken> values_;
+    size_t columns_ = 0;
+
+    friend class CifReader;
+public:
+    static const uint32_t kQuotedBit = 0x80000000u;
+
+    size_t rowCount() const {
+        return columns_ == 0 ? 0 : values_.size() / columns_;
+    }
+    size_t columnCount() const {
+        return columns_;
+    }
+    const std::vector<std::string_view>& items() const {
+        return items_;
+    }
+
+    // 条目名不含类别前缀，如 "Cartn_x"；不存在返回 -1
+    int columnIndex(std::string_view item) const;
+
+    std::string_view value(size_t row, int column) const {
+        const CifToken& t = values_[row * columns_ + size_t(column)];
+        return std::string_view(base_ + t.offset, t.length & ~kQuotedBit);
+    }
+    // 未加引号的 '.'（不适用）和 '?'（未知）
+    bool isNull(size_t row, int column) const {
+        const CifToken& t = values_[row * columns_ + size_t(column)];
+        return t.length == 1 && (base_[t.offset] == '.' || base_[t.offset] == '?');
+    }
+    float floatValue(size_t row, int column) const;
+    int32_t intValue(size_t row, int column) const;
+};
+
+// mmCIF 读取：打开时只做一遍行扫描，记录每个类别在文件中的字节范围；
+// 类别在第一次被请求时才用向量化分词器切分词元。
+// 只处理第一个 data_ 块。category() 会修改内部缓存，不是线程安全的
+class CifReader {
+private:
+    struct CategoryEntry {
+        std::string_view name;          // 含前导下划线，如 "_atom_site"
+        size_t begin = 0;
+        size_t valuesBegin = 0;         // loop_ 的第一行数据
+        size_t end = 0;
+        bool loop = false;
+        bool hasTextField = false;
+        std::unique_ptr<CifCategory> data;
+    };
+
+    MappedFile file_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<CategoryEntry> categories_;
+    std::string error_;
+
+    CategoryEntry* findEntry(std::string_view name);
+    void buildIndex();
+    void materialize(CategoryEntry& entry);
+public:
+    CifReader() {
+
+    }
+
+    bool open(const std::string& path);
+    // 直接使用调用者的内存，data 必须在读取期间保持有效
+    bool parse(const char* data, size_t size);
+
+    bool hasCategory(std::string_view name) const;
+    std::vector<std::string_view> categoryNames() const;
+    // 按需物化，如 category("_atom_site")；不存在返回 nullptr
+    const CifCategory* category(std::string_view name);
+    // 释放已物化类别的词元表
+    void releaseCategory(std::string_view name);
+
+    // 读取 _atom_site（第一个模型）写入原子表
+    bool loadAtomSite(AtomTable& out);
+    // 读取 _struct_conf 与 _struct_sheet_range 写入 Residue::ss
+    void loadSecondaryStructure(AtomTable& out);
+
+    const std::string& lastError() const {
+        return error_;
+    }
+};
@@ -0,0 +1,12 @@
+﻿// ContentHash v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64 位非加密哈希（XXH64 算法），用于缓存键
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+// 大文件内容哈希：按固定大小分块并行计算，再对各块哈希做一次哈希。
+// 结果只取决于内容与长度，与线程数无关
+uint64_t hashContent(const void* data, size_t size);
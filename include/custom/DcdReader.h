@@ -0,0 +1,39 @@
+﻿// DcdReader v 1.0
+#pragma once
+
+#include <string>
+#include "TrajectoryReader.h"
+
+// CHARMM/NAMD DCD 轨迹读取（Fortran 无格式记录，4 字节记录标记）。
+// 所有帧长度相同，帧偏移直接由头部长度和帧长计算，不需要索引；
+// 帧数按文件大小计算（头部的 NSET 经常没有更新）。
+// 自动识别字节序；不支持固定原子（NAMNF != 0）的文件
+class DcdReader : public TrajectoryReader {
+private:
+    size_t atomCount_ = 0;
+    size_t frameCount_ = 0;
+    uint64_t headerSize_ = 0;
+    uint64_t frameSize_ = 0;
+    bool swap_ = false;         // 文件字节序与本机不同
+    bool hasCell_ = false;      // 每帧前有 6 个 double 的晶胞记录
+    int64_t firstStep_ = 0;
+    int64_t stepInterval_ = 1;
+    float timeStep_ = 0.0f;     // ps
+public:
+    DcdReader() {
+
+    }
+
+    bool open(const std::string& path) override;
+    void close() override;
+
+    size_t frameCount() const override {
+        return frameCount_;
+    }
+    size_t atomCount() const override {
+        return atomCount_;
+    }
+
+    bool frameExtent(size_t index, uint64_t& offset, size_t& size) const override;
+    bool decodeFrame(size_t index, const uint8_t* data, size_t size, TrajectoryFrame& out) const override;
+};
@@ -0,0 +1,38 @@
+﻿// DirtyRanges v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 待上传的元素区间：按 begin 排序，间隔小于 kMergeGap 的区间合并为一个
+// （多传少量数据换更少的 glBufferSubData 调用）。元素总数由调用方给出，越界部分被截掉
+class DirtyRanges {
+public:
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+    };
+private:
+    std::vector<Range> ranges_;
+public:
+    static const uint32_t kMergeGap = 64;
+
+    DirtyRanges() {
+
+    }
+
+    // 标记 [begin, end) ∩ [0, limit)，与已有区间合并
+    void mark(size_t begin, size_t end, size_t limit);
+    void clear() {
+        ranges_.clear();
+    }
+    bool empty() const {
+        return ranges_.empty();
+    }
+    const std::vector<Range>& ranges() const {
+        return ranges_;
+    }
+    // 各区间的元素数之和
+    size_t count() const;
+};
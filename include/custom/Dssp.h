@@ -0,0 +1,99 @@
+﻿// Dssp v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AtomTable.h"
+#include "NeighborGrid.h"
+
+// DSSP 二级结构指认（Kabsch & Sander，判据与 mkdssp 一致）：
+// 按主链原子的静电模型计算 N-H…O=C 氢键能量，能量低于 -0.5 kcal/mol 视为氢键，
+// 由氢键模式得到螺旋（H/G/I）、β 桥与折叠片（B/E）、转角（T）和弯折（S）。
+// 预测模型和 MD 轨迹没有 HELIX/SHEET 记录，卡通渲染靠它得到二级结构。
+// 拓扑（主链原子下标）在 prepare 中收集一次，之后每帧只传坐标：
+// Cα 近邻网格在帧之间增量更新，氢键按供体残基并行，螺旋与转角按链并行
+class Dssp {
+private:
+    // 一个蛋白残基的主链原子（拓扑，不随帧变化）
+    struct Backbone {
+        uint32_t residue;       // AtomTable::residues 下标
+        uint32_t n, ca, c, o;   // 原子下标
+        int32_t chain;
+        bool proline;           // 脯氨酸没有酰胺氢，不能作为供体
+    };
+    // 当前帧的主链坐标，h 为按前一残基 C=O 方向推出的酰胺氢；
+    // 作为受体时，供体 N 与本残基 O 的距离平方超过 reach2 就不可能成键
+    struct BackboneFrame {
+        float n[3], ca[3], c[3], o[3], h[3];
+        float reach2;
+    };
+    struct HBond {
+        int32_t partner;
+        float energy;
+    };
+    struct HBondCandidate {
+        uint32_t donor;
+        uint32_t acceptor;
+        float energy;
+    };
+
+    std::vector<Backbone> backbone_;
+    std::vector<uint32_t> chainStart_;  // 按链划分 backbone_，末尾为总数
+    size_t residueCount_ = 0;
+
+    std::vector<BackboneFrame> frame_;
+    std::vector<uint32_t> segment_;     // 连续片段编号，相同表示中间没有断链
+    std::vector<float> caX_;
+    std::vector<float> caY_;
+    std::vector<float> caZ_;
+    NeighborGrid caGrid_;
+    bool gridReady_ = false;
+    std::vector<std::vector<HBondCandidate>> candidates_;   // 按搜索块，帧之间复用
+    std::vector<HBond> acceptors_;      // 每个供体能量最低的两个受体，-1 表示空
+    std::vector<uint8_t> helixFlags_;   // 每残基 3 个（间隔 3、4、5）
+    std::vector<uint8_t> bend_;
+    std::vector<SecondaryStructure> ss_;
+    bool preferPiHelices_ = true;
+    double assignMs_ = 0.0;
+
+    void loadFrame(const float* x, const float* y, const float* z);
+    void computeHBonds();
+    // 计算 list 中每个候选的能量，原地只留下低于 -0.5 的
+    void evaluateHBonds(std::vector<HBondCandidate>& list) const;
+    void computeSheets();
+    void computeHelices();
+    // acceptors_ 只保存低于 -0.5 kcal/mol 的氢键
+    bool testBond(size_t donor, size_t acceptor) const {
+        const HBond* a = &acceptors_[2 * donor];
+        return a[0].partner == int32_t(acceptor) || a[1].partner == int32_t(acceptor);
+    }
+    bool noChainBreak(size_t from, size_t to) const {
+        return segment_[from] == segment_[to];
+    }
+public:
+    Dssp() {
+
+    }
+
+    // π 螺旋是否优先于 α 螺旋（mkdssp 4 的默认行为；设为 false 得到经典 DSSP 结果）
+    void setPreferPiHelices(bool prefer) {
+        preferPiHelices_ = prefer;
+    }
+
+    // 收集主链原子。原子表的拓扑变化时调用；
+    // 只有 N、CA、C、O 齐全的残基参与计算，其余残基为 Coil
+    void prepare(const AtomTable& atoms);
+
+    // 用给定坐标（通常是轨迹帧，原子顺序与 prepare 时的原子表相同）计算，
+    // out 按残基下标，长度为残基数
+    void assign(const float* x, const float* y, const float* z, std::vector<SecondaryStructure>& out);
+
+    // prepare 并用原子表自身的坐标计算，结果写回 residues[].ss
+    void assign(AtomTable& atoms);
+
+    // 最近一次 assign 的耗时（毫秒，不含 prepare）
+    double lastAssignMs() const {
+        return assignMs_;
+    }
+};
@@ -0,0 +1,20 @@
+﻿// Element v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 元素以原子序数（uint8_t）存储，0 表示未知元素
+
+// 按元素符号查找原子序数（大小写不敏感，前后空白忽略），未知返回 0
+uint8_t elementFromSymbol(const char* symbol, size_t length);
+// 元素符号，未知元素返回 "X"
+const char* elementSymbol(uint8_t element);
+// 共价半径（埃），用于成键判定
+float covalentRadius(uint8_t element);
+// 范德华半径（埃），用于空间填充与表面计算
+float vdwRadius(uint8_t element);
+// CPK 颜色，打包为 0xAABBGGRR（与 glm::packUnorm4x8 的字节序一致）
+uint32_t elementColor(uint8_t element);
+// 所有已知元素中最大的共价半径
+float maxCovalentRadius();
@@ -0,0 +1,67 @@
+﻿// FastNumber v 1.0
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// 结构文件中的数字都是简单的十进制文本，这里用不依赖 locale 的快速解析
+// 替代 strtod/atoi。输入区间为 [p, e)，前后空白会被跳过
+
+inline int32_t parseIntField(const char* p, const char* e) {
+    while (p < e && *p == ' ') ++p;
+    bool neg = false;
+    if (p < e && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+    int32_t v = 0;
+    for (; p < e && *p >= '0' && *p <= '9'; ++p) {
+        v = v * 10 + (*p - '0');
+    }
+    return neg ? -v : v;
+}
+
+inline float parseFloatField(const char* p, const char* e) {
+    static const double kNegPow10[] = {
+        1.0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9,
+        1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18
+    };
+    while (p < e && *p == ' ') ++p;
+    bool neg = false;
+    if (p < e && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int fracDigits = 0;
+    int digits = 0;
+    bool dot = false;
+    for (; p < e; ++p) {
+        char c = *p;
+        if (c >= '0' && c <= '9') {
+            // 超过 18 位有效数字后的精度对 float 已无意义
+            if (digits < 18) {
+                mantissa = mantissa * 10 + uint64_t(c - '0');
+                ++digits;
+                if (dot) ++fracDigits;
+            }
+            else if (!dot) {
+                --fracDigits;
+            }
+        }
+        else if (c == '.' && !dot) {
+            dot = true;
+        }
+        else {
+            break;
+        }
+    }
+    int exponent = -fracDigits;
+    if (p < e && (*p == 'e' || *p == 'E')) {
+        exponent += parseIntField(p + 1, e);
+    }
+    double v = static_cast<double>(mantissa);
+    if (exponent < 0 && exponent >= -18) v *= kNegPow10[-exponent];
+    else if (exponent != 0) v *= std::pow(10.0, exponent);
+    return static_cast<float>(neg ? -v : v);
+}
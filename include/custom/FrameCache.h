@@ -0,0 +1,108 @@
+﻿// FrameCache v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "TrajectoryReader.h"
+
+// 淘汰策略
+enum class FrameEvictionPolicy : uint8_t {
+    Lru,            // 最久未用
+    Playback        // 按播放方向和循环区间，淘汰最晚才会再用到的帧
+};
+
+// 缓存统计（给监控面板用）
+struct FrameCacheStats {
+    uint64_t hits = 0;              // 全精度层命中
+    uint64_t quantizedHits = 0;     // 量化层命中
+    uint64_t misses = 0;            // 需要读盘
+    uint64_t demotions = 0;         // 全精度帧降级为量化帧
+    uint64_t evictions = 0;         // 被移出缓存
+    size_t residentFrames = 0;
+    size_t residentBytes = 0;
+};
+
+// 轨迹帧的内存缓存，总字节数不超过预算。两层存储：
+//   全精度层：float 坐标，最多占预算的 fullFraction；
+//   量化层：每帧按自身包围盒把坐标量化为 uint16，体积是全精度的一半，
+//           误差不超过包围盒边长 / 131070。
+// 新读入的帧进入全精度层，全精度层超额时把最该淘汰的帧降级到量化层，
+// 总量超出预算时再从量化层移除。
+// 循环播放的区间能放进预算时，第一遍之后不再读盘。
+// 不是线程安全的，由播放线程独占使用
+class FrameCache {
+private:
+    enum class Tier : uint8_t {
+        Full,
+        Quantized
+    };
+    struct Entry {
+        size_t index = 0;
+        Tier tier = Tier::Full;
+        std::vector<float> full;        // x[n] y[n] z[n]
+        std::vector<uint16_t> packed;   // 同样按轴排列
+        float origin[3] = {};
+        float scale[3] = {};            // 量化步长
+        float box[9] = {};
+        int64_t step = 0;
+        float time = 0.0f;
+
+        size_t bytes() const {
+            return sizeof(Entry) + full.capacity() * sizeof(float) + packed.capacity() * sizeof(uint16_t);
+        }
+    };
+    typedef std::list<Entry> EntryList;
+
+    const TrajectoryReader& reader_;
+    size_t budget_ = 0;
+    size_t fullBudget_ = 0;
+    size_t fullBytes_ = 0;
+    size_t quantizedBytes_ = 0;
+    EntryList full_;                    // 表头为最近使用
+    EntryList quantized_;
+    std::unordered_map<size_t, EntryList::iterator> lookup_;
+
+    FrameEvictionPolicy policy_ = FrameEvictionPolicy::Lru;
+    size_t playhead_ = 0;
+    int step_ = 1;
+    size_t loopBegin_ = 0;
+    size_t loopEnd_ = 0;                // loopEnd_ <= loopBegin_ 表示不循环
+
+    FrameCacheStats stats_;
+
+    // 距离下一次用到该帧还有多少步，用不到时返回最大值
+    uint64_t nextUse(size_t index) const;
+    EntryList::iterator pickVictim(EntryList& list);
+    void demote(EntryList::iterator it);
+    void enforceBudget();
+    void store(const TrajectoryFrame& frame);
+    static void quantize(const float* const axes[3], size_t n, Entry& e);
+    static void expand(const Entry& e, TrajectoryFrame& out);
+public:
+    // fullFraction：全精度层占预算的比例（0 表示只用量化层，1 表示只用全精度层）
+    FrameCache(const TrajectoryReader& reader, size_t byteBudget, float fullFraction = 0.25f);
+    FrameCache(const FrameCache&) = delete;
+    FrameCache& operator=(const FrameCache&) = delete;
+
+    void setBudget(size_t byteBudget, float fullFraction);
+    void setPolicy(FrameEvictionPolicy policy) {
+        policy_ = policy;
+    }
+    // 播放参数：step 为每次前进的帧数（负数倒放），[loopBegin, loopEnd) 为循环区间
+    void setPlayback(int step, size_t loopBegin, size_t loopEnd);
+
+    // 取得第 index 帧（未缓存时读盘并放入缓存），同时把播放头移到 index
+    bool get(size_t index, TrajectoryFrame& out);
+    bool contains(size_t index) const {
+        return lookup_.count(index) != 0;
+    }
+    void clear();
+
+    const FrameCacheStats& stats() const {
+        return stats_;
+    }
+    void resetStats();
+};
@@ -0,0 +1,83 @@
+﻿// FramePrefetcher v 1.0
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "IoRing.h"
+#include "TrajectoryReader.h"
+
+// 播放用的帧预取环：后台线程按播放方向和速度把播放头前方的帧读进一组帧缓冲。
+// Linux 上通过 io_uring 一次提交一批读请求，读到一帧就解码一帧，I/O 与解码重叠；
+// 不支持 io_uring 时退回同步的 pread / ReadFile。
+// acquire 只应由一个线程（渲染循环）调用
+class FramePrefetcher {
+private:
+    enum class SlotState : uint8_t {
+        Empty,
+        Loading,        // 正由某个线程读取，其他线程不能动
+        Ready
+    };
+    struct Slot {
+        TrajectoryFrame frame;
+        std::vector<uint8_t> raw;
+        size_t index = size_t(-1);
+        SlotState state = SlotState::Empty;
+    };
+
+    const TrajectoryReader& reader_;
+    std::vector<Slot> slots_;
+    size_t depth_ = 0;                  // 播放头前方预取的帧数
+    IoRing ring_;
+    std::atomic<bool> useRing_{ false };
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;      // 播放头变化，唤醒预取线程
+    std::condition_variable ready_;     // 某个槽读取完成
+    size_t playhead_ = 0;
+    int step_ = 1;
+    bool loop_ = false;
+    size_t pinned_ = size_t(-1);        // 上一次 acquire 返回的槽
+    bool stop_ = false;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+
+    void prefetchLoop();
+    // 播放头之后第 k 个（k 从 1 开始）需要的帧，超出范围返回 -1
+    size_t wantedFrame(size_t k) const;
+    bool isWanted(size_t index) const;
+    size_t findSlot(size_t index) const;
+    size_t pickVictim() const;
+    void loadBatch(const std::vector<size_t>& batch);
+    void finishSlot(size_t slot, bool ok);
+public:
+    // ringSize 为帧缓冲个数（至少 4），预取深度为 ringSize - 2
+    FramePrefetcher(const TrajectoryReader& reader, size_t ringSize = 32);
+    FramePrefetcher(const FramePrefetcher&) = delete;
+    FramePrefetcher& operator=(const FramePrefetcher&) = delete;
+
+    // 播放参数：step 为每次前进的帧数（负数倒放，0 表示暂停/拖动，此时向两侧预取），
+    // loop 为到达末尾后是否回到开头
+    void setPlayback(int step, bool loop);
+
+    // 取得第 index 帧并把播放头移到这里；预取命中时不做任何 I/O，
+    // 否则同步读取。返回的指针在下一次 acquire 之前有效，失败返回 nullptr
+    const TrajectoryFrame* acquire(size_t index);
+
+    uint64_t hits() const {
+        return hits_;
+    }
+    uint64_t misses() const {
+        return misses_;
+    }
+    bool usingIoRing() const {
+        return useRing_;
+    }
+
+    ~FramePrefetcher();
+};
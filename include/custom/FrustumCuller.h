@@ -0,0 +1,113 @@
+﻿// FrustumCuller v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.h"
+
+// 一组轴对齐包围盒，按分量分数组存放（SoA），便于一次比较 4 / 8 个
+struct AabbArray {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    size_t size() const {
+        return minX.size();
+    }
+    void resize(size_t n) {
+        minX.resize(n);
+        minY.resize(n);
+        minZ.resize(n);
+        maxX.resize(n);
+        maxY.resize(n);
+        maxZ.resize(n);
+    }
+    void set(size_t i, const float lo[3], const float hi[3]) {
+        minX[i] = lo[0];
+        minY[i] = lo[1];
+        minZ[i] = lo[2];
+        maxX[i] = hi[0];
+        maxY[i] = hi[1];
+        maxZ[i] = hi[2];
+    }
+    // 包住球的盒子
+    void setSphere(size_t i, const float center[3], float radius) {
+        minX[i] = center[0] - radius;
+        minY[i] = center[1] - radius;
+        minZ[i] = center[2] - radius;
+        maxX[i] = center[0] + radius;
+        maxY[i] = center[1] + radius;
+        maxZ[i] = center[2] + radius;
+    }
+};
+
+enum class CullResult : uint8_t {
+    Outside = 0,
+    Intersect,
+    Inside
+};
+
+// 视锥剔除：从 projection * view 提取六个平面（Gribb-Hartmann），view 与盒子同一坐标系，
+// 对每个平面只测包围盒在法线方向上最远的角（p 顶点），该角在平面外侧则整个盒子在外。
+// 平面在一次剔除中对所有盒子相同，p 顶点的分量按法线符号直接选 min / max 数组，
+// 批量测试时没有逐盒的分支：AVX 一次 8 个，SSE2 一次 4 个（展开两次，同样每批 8 个），
+// 运行时检测 AVX，不支持时退回 SSE2 / 标量。保守剔除：视锥角附近的盒子可能被判为可见
+class FrustumCuller {
+public:
+    struct Plane {
+        float nx, ny, nz, d;    // 单位法线指向视锥内，内部 nx * x + ny * y + nz * z + d >= 0
+    };
+private:
+    Plane planes_[6] = {};
+    bool useAvx_ = false;
+    size_t tested_ = 0;
+    size_t visible_ = 0;
+    double cullMs_ = 0.0;
+public:
+    FrustumCuller();
+
+    // 设置视锥。projection 为 OpenGL 约定（裁剪空间 z 属于 [-w, w]）
+    void setMatrices(const glm::mat4& projection, const glm::mat4& view);
+    // 盒子是 float 世界坐标时用；远离世界原点的大场景会丢精度
+    void setCamera(const Camera& camera, const glm::mat4& projection) {
+        setMatrices(projection, camera.getView());
+    }
+    // 盒子相对 anchor 时用（StructureLod::chainBounds、PackedMeshRenderer 的网格）：平面在锚点坐标系里
+    void setCamera(const Camera& camera, const glm::mat4& projection, const RenderAnchor& anchor) {
+        setMatrices(projection, anchor.modelView(camera));
+    }
+    const Plane& plane(int i) const {
+        return planes_[i];
+    }
+
+    // 强制关闭 AVX（对比测试用）；CPU 不支持时打开无效
+    void setUseAvx(bool enabled);
+    bool usingAvx() const {
+        return useAvx_;
+    }
+
+    // 把 [begin, end) 中与视锥相交的盒子下标追加到 visible，返回追加的个数
+    size_t cull(const AabbArray& boxes, size_t begin, size_t end, std::vector<uint32_t>& visible);
+    size_t cull(const AabbArray& boxes, std::vector<uint32_t>& visible) {
+        return cull(boxes, 0, boxes.size(), visible);
+    }
+    // 同样的批量测试，可见的下标写入 out（至少 end - begin 个），返回个数；
+    // 不计时也不更新统计，供层次遍历对叶子的连续区间调用
+    size_t testRange(const AabbArray& boxes, size_t begin, size_t end, uint32_t* out) const;
+
+    // 单个盒子：完全在外、相交、完全在内（层次遍历时完全在内的子树不必再测）
+    CullResult classify(const float lo[3], const float hi[3]) const;
+    bool visible(const float lo[3], const float hi[3]) const;
+
+    // 最近一次 cull 测试的盒子数、可见数与耗时（毫秒）
+    size_t lastTested() const {
+        return tested_;
+    }
+    size_t lastVisible() const {
+        return visible_;
+    }
+    double lastCullMs() const {
+        return cullMs_;
+    }
+};
@@ -16,6 +16,12 @@ private:
     float lastY_ = 300.0f;       // 上一帧鼠标 Y 坐标
     bool firstMouse_ = true;     // 是否是第一次接收鼠标输入
     float sensitivity_ = 0.1f;   // 鼠标灵敏度
+    bool cursorMoved_ = false;   // 上次取走后光标是否移动过（悬停拾取）
+
+    // --- 等值面控制（[ / ] 键连续调整）---
+    float isoLevel_ = 0.0f;      // 当前等值面数值
+    float isoRate_ = 1.0f;       // 按住按键时每秒的变化量
+    bool isoChanged_ = false;    // 上次取走后是否改变过
 public:
     // 构造函数：必须传入要控制的 Camera 实例的引用
     InputController(Camera& camera, float speed)
@@ -26,4 +32,34 @@ public:
     void processKeyboardInput(GLFWwindow* window, float deltaTime);
     // 新增：处理鼠标（旋转）
     void processMouseInput(GLFWwindow* window);
+
+    // 最近一次 processMouseInput 读到的光标位置（窗口像素，原点在左上角），交给 Picker::pick
+    float cursorX() const {
+        return lastX_;
+    }
+    float cursorY() const {
+        return lastY_;
+    }
+    // 光标自上次调用以来是否移动（调用后清除），移动时由调用方重新拾取
+    bool consumeCursorMove() {
+        bool moved = cursorMoved_;
+        cursorMoved_ = false;
+        return moved;
+    }
+
+    // 等值面数值：processKeyboardInput 中按住 ] 增大、[ 减小，rate 为每秒变化量
+    void setIsoLevel(float level, float rate) {
+        isoLevel_ = level;
+        isoRate_ = rate;
+        isoChanged_ = false;
+    }
+    float isoLevel() const {
+        return isoLevel_;
+    }
+    // 等值面数值自上次调用以来是否变化（调用后清除），变化时由调用方重新提取
+    bool consumeIsoChange() {
+        bool changed = isoChanged_;
+        isoChanged_ = false;
+        return changed;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+﻿// IoRing v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define THC_IO_URING 1
+#endif
+#endif
+#ifndef THC_IO_URING
+#define THC_IO_URING 0
+#endif
+
+// 异步读请求队列。Linux 上直接用系统调用驱动 io_uring（不依赖 liburing），
+// 内核不支持（ENOSYS / 老内核）或其他平台上 available() 返回 false，
+// 调用者应退回同步的 pread。
+// 只供单个线程使用
+class IoRing {
+private:
+    int fd_ = -1;
+    unsigned entries_ = 0;
+    unsigned pending_ = 0;      // 已放入提交队列但还没交给内核的请求数
+    unsigned inFlight_ = 0;     // 已提交、还没取走完成事件的请求数
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    void* sqes_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    size_t sqesSize_ = 0;
+    // 环形队列各字段在映射内存中的位置
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqMask_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned* cqMask_ = nullptr;
+    void* cqes_ = nullptr;
+public:
+    IoRing() {
+
+    }
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    // 建立深度为 entries 的队列，失败时保持不可用
+    bool init(unsigned entries);
+    void close();
+
+    bool available() const {
+        return fd_ >= 0;
+    }
+    unsigned capacity() const {
+        return entries_;
+    }
+    unsigned inFlight() const {
+        return inFlight_ + pending_;
+    }
+
+    // 排队一个读请求（size 不超过 2GB），队列满时返回 false
+    bool queueRead(int fd, void* dst, size_t size, uint64_t offset, uint64_t tag);
+    // 把排队的请求交给内核
+    bool submit();
+    // 等待并取出一个完成事件；result 为读到的字节数或负的 errno
+    bool wait(uint64_t& tag, int& result);
+
+    ~IoRing();
+};
@@ -0,0 +1,40 @@
+﻿// MappedFile v 1.0
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// 只读内存映射文件（Windows 使用 CreateFileMapping，其他平台使用 mmap）
+class MappedFile {
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+public:
+    MappedFile() {
+
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // 打开并映射整个文件；空文件也视为成功（data() 为 nullptr）
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const {
+        return open_;
+    }
+    const char* data() const {
+        return data_;
+    }
+    size_t size() const {
+        return size_;
+    }
+    ~MappedFile();
+};
@@ -0,0 +1,68 @@
+﻿// MarchingCubes v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Mesh.h"
+#include "ScalarGrid.h"
+
+// 通用等值面提取（分子表面、密度图共用）：Marching Cubes。
+// 体数据按 8^3 格子分块，setGrid 时算出每块的最小/最大值，extract 时跳过不跨越等值面的块；
+// 只改 iso 时块摘要与各层块的缓冲区都复用，拖动等值面时只做提取本身。
+// 按 z 层块并行；格边上的顶点按边缓存，相邻格子共用同一个顶点，
+// 层块边界平面上的顶点只由下面的层块生成，上面的层块记下引用，最后统一换成全局下标，
+// 输出的网格是封闭的带索引网格，不需要去重。
+// 一行格子一次分类 63 个：SSE2 比较得到每个格点的内外位，用位运算找出跨越等值面的格子。
+// 每种情况的三角形由面上的线段连接成环生成（二义面总是把内部角点分开），相邻格子在公共面上一致，没有裂缝。
+// 默认小于 iso 的一侧为内部（距离场）；密度图用 setInsideHigh(true)。三角形逆时针朝外，法线取场的梯度
+class MarchingCubes {
+public:
+    // 一个 z 层块的输出与边缓存
+    struct Slab {
+        std::vector<float> positions;
+        std::vector<float> normals;
+        std::vector<uint32_t> indices;      // 最高位为 1 的是对上一层块底平面顶点的引用
+        std::vector<uint32_t> edgeCache[5]; // x、y 边按平面奇偶各两份，z 边一份；存顶点号 + 1
+        uint32_t topBase = 0;               // 顶平面缓存有效的最小顶点号
+        uint32_t vertexBase = 0;
+        size_t indexBase = 0;
+    };
+private:
+    const ScalarGrid* grid_ = nullptr;
+    std::vector<float> blockMin_;
+    std::vector<float> blockMax_;
+    int blocks_[3] = { 0, 0, 0 };
+    bool insideHigh_ = false;
+    std::vector<Slab> slabs_;
+    size_t activeBlocks_ = 0;
+    double extractMs_ = 0.0;
+
+    void processSlab(float iso, int k0, int k1, bool first, Slab& slab) const;
+public:
+    static const int kBlock = 8;
+
+    MarchingCubes() {
+
+    }
+
+    // 设置体数据并计算块摘要；网格的值变化后要再调用一次。extract 期间 grid 必须有效
+    void setGrid(const ScalarGrid& grid);
+    // 为 true 时大于等于 iso 的一侧为内部（密度图）
+    void setInsideHigh(bool insideHigh) {
+        insideHigh_ = insideHigh;
+    }
+    // 提取等值面写入 out（atomIds 填 0）
+    void extract(float iso, Mesh& out);
+
+    size_t blockCount() const {
+        return blockMin_.size();
+    }
+    // 最近一次 extract 实际处理的块数与耗时（毫秒）
+    size_t lastActiveBlocks() const {
+        return activeBlocks_;
+    }
+    double lastExtractMs() const {
+        return extractMs_;
+    }
+};
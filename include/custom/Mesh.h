@@ -0,0 +1,33 @@
+﻿// Mesh v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 三角网格：顶点属性分数组存放（与 SceneCache 的 MeshPositions / MeshNormals / MeshAtomIds 节一致），
+// 每个数组可以直接交给 glBufferData；indices 每三个一个三角形，逆时针为正面
+struct Mesh {
+    std::vector<float> positions;       // xyz
+    std::vector<float> normals;         // xyz，单位向量
+    std::vector<uint32_t> atomIds;      // 每个顶点对应的原子（着色、拾取）
+    std::vector<uint32_t> indices;
+
+    size_t vertexCount() const {
+        return atomIds.size();
+    }
+    size_t triangleCount() const {
+        return indices.size() / 3;
+    }
+
+    void resizeVertices(size_t n) {
+        positions.resize(3 * n);
+        normals.resize(3 * n);
+        atomIds.resize(n);
+    }
+
+    void clear() {
+        resizeVertices(0);
+        indices.clear();
+    }
+};
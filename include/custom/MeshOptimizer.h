@@ -0,0 +1,115 @@
+﻿// MeshOptimizer v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Mesh.h"
+
+#if defined(__has_include)
+#if __has_include(<assimp/scene.h>)
+#define THC_ASSIMP 1
+#endif
+#endif
+#ifndef THC_ASSIMP
+#define THC_ASSIMP 0
+#endif
+
+#if THC_ASSIMP
+struct aiMesh;
+struct aiScene;
+#endif
+
+// 顶点缓存统计（按 FIFO 缓存模拟）：
+// ACMR = 缓存未命中数 / 三角形数，ATVR = 缓存未命中数 / 被引用的顶点数（理想值 1）
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// 一个 meshlet：vertexOffset 起 vertexCount 个全局顶点号，triangleOffset 起 3 * triangleCount 个局部下标
+struct Meshlet {
+    uint32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t triangleOffset = 0;
+    uint32_t triangleCount = 0;
+    float center[3] = { 0.0f, 0.0f, 0.0f };     // 包围球
+    float radius = 0.0f;
+    float coneApex[3] = { 0.0f, 0.0f, 0.0f };   // 法线锥
+    float coneAxis[3] = { 0.0f, 0.0f, 0.0f };
+    float coneCutoff = 1.0f;                    // 锥半角的正弦，1 表示不做背面剔除
+
+    // 从 eye 看过去整个 meshlet 都是背面时返回 true
+    bool backfacing(const float eye[3]) const;
+};
+
+struct MeshletSet {
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertices;     // meshlet 内顶点号 -> 网格顶点号
+    std::vector<uint8_t> triangles;     // 每三个一个三角形，meshlet 内顶点号
+};
+
+// 导入网格的后处理：
+// 1. 顶点缓存：Tipsify（Sander 等 2007）重排三角形，线性时间，按 cacheSize 调整局部性；
+// 2. 过度绘制：在缓存重排的结果上按缓存重启处切簇，再按 ACMR 阈值细分，
+//    簇按朝外程度排序（外侧、朝外的先画），只损失很少的缓存命中；
+// 3. 顶点读取：按索引中第一次出现的顺序重排顶点数组，未引用的顶点放到最后；
+// 4. meshlet：按重排后的三角形顺序贪心装入（默认 64 顶点 / 124 三角形），给出包围球和法线锥供簇级剔除。
+// optimize 一次做完并记录前后的 ACMR / ATVR
+class MeshOptimizer {
+private:
+    unsigned cacheSize_ = 16;
+    float overdrawThreshold_ = 1.05f;
+    size_t maxMeshletVertices_ = 64;
+    size_t maxMeshletTriangles_ = 124;
+    VertexCacheStats before_;
+    VertexCacheStats after_;
+    double optimizeMs_ = 0.0;
+public:
+    MeshOptimizer() {
+
+    }
+
+    // 目标顶点缓存大小（Tipsify 的参数与统计模拟都用它）
+    void setCacheSize(unsigned size) {
+        cacheSize_ = size;
+    }
+    // 过度绘制排序允许 ACMR 变差的比例，1 表示只在缓存本来就重启的地方切簇
+    void setOverdrawThreshold(float threshold) {
+        overdrawThreshold_ = threshold;
+    }
+    // meshlet 上限；顶点数最多 255，局部下标用 uint8
+    void setMeshletLimits(size_t maxVertices, size_t maxTriangles) {
+        maxMeshletVertices_ = maxVertices;
+        maxMeshletTriangles_ = maxTriangles;
+    }
+
+    // 模拟 cacheSize 大小的 FIFO 缓存统计 mesh 的 ACMR / ATVR
+    static VertexCacheStats analyze(const Mesh& mesh, unsigned cacheSize);
+
+    void optimizeVertexCache(Mesh& mesh) const;
+    // 要在 optimizeVertexCache 之后调用
+    void optimizeOverdraw(Mesh& mesh) const;
+    void optimizeVertexFetch(Mesh& mesh) const;
+    void buildMeshlets(const Mesh& mesh, MeshletSet& out) const;
+
+    // 依次做缓存、过度绘制、顶点读取优化；meshlets 非空时再生成 meshlet
+    void optimize(Mesh& mesh, MeshletSet* meshlets = nullptr);
+
+#if THC_ASSIMP
+    // assimp 网格转成 Mesh（只取三角形面，没有法线时按面积加权生成；atomIds 填 meshIndex）
+    static bool fromAssimp(const aiMesh& src, uint32_t meshIndex, Mesh& out);
+    // 按节点层级把场景里的所有网格变换到世界空间并合并，atomIds 为网格号
+    static bool fromAssimp(const aiScene& scene, Mesh& out);
+#endif
+
+    const VertexCacheStats& lastBefore() const {
+        return before_;
+    }
+    const VertexCacheStats& lastAfter() const {
+        return after_;
+    }
+    double lastOptimizeMs() const {
+        return optimizeMs_;
+    }
+};
@@ -0,0 +1,77 @@
+﻿// MeshSimplifier v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Mesh.h"
+
+// 一个网格的 LOD 链：levels[0] 为原始网格，越往后越粗；
+// errors[l] 为第 l 级相对原始网格的最大距离估计（与坐标同单位）：每次折叠取被删顶点到新三角形扇的距离，
+// 沿折叠链和各级累加。不是严格的 Hausdorff 上界，bench 的 mesh_lod 检查原始顶点到各级网格的实测距离不超过它
+struct MeshLod {
+    std::vector<Mesh> levels;
+    std::vector<float> errors;
+    float center[3] = { 0.0f, 0.0f, 0.0f };     // 包围球
+    float radius = 0.0f;
+
+    // 按投影到屏幕上的误差选级：取误差投影后不超过 pixelError 像素的最粗一级。
+    // view 为网格坐标系到视空间的模型视图矩阵：网格相对锚点时取 RenderAnchor::modelView(camera)，
+    // float 世界坐标的网格取 Camera::getView()；fovY 为纵向视角（弧度），viewportHeight 为视口高度（像素）。
+    // 按最大距离而不是均方根选级，切换时表面在屏幕上的移动大致不超过 pixelError 像素
+    size_t selectLevel(const glm::mat4& view, float fovY, float viewportHeight, float pixelError = 1.0f) const;
+};
+
+// 基于二次误差度量（QEM）的网格简化，生成 LOD 链。
+// 每一级把网格按空间格子分成约 clusterTriangles 个三角形的簇，各簇并行做半边折叠：
+// 被多个簇共用的顶点锁定不动，相邻的级把格子错开半格，上一级锁定的簇边界在下一级得到简化。
+// 半边折叠保留被保留顶点的原始属性（位置、法线、原子号），顶点数组可以直接上传；
+// 折叠代价 = 面积加权的平面二次误差 + 法线差异项（属性感知），开放边界另加垂直于边界的约束平面。
+// 代价只决定折叠顺序；误差取被删顶点到简化后表面的最大距离，而不是二次误差的均方根。
+// 折叠前检查三角形翻转与 link 条件，保持流形
+class MeshSimplifier {
+private:
+    float levelRatio_ = 0.5f;
+    size_t minTriangles_ = 256;
+    size_t maxLevels_ = 12;
+    size_t clusterTriangles_ = 8192;
+    float normalWeight_ = 1.0f;
+    double buildMs_ = 0.0;
+
+    // 把 in 简化到约 ratio 比例的三角形写入 out，返回本次新增的误差；shifted 时簇格子错开半格
+    float simplifyLevel(const Mesh& in, float ratio, bool shifted, Mesh& out) const;
+public:
+    MeshSimplifier() {
+
+    }
+
+    // 每一级的目标三角形数比例
+    void setLevelRatio(float ratio) {
+        levelRatio_ = ratio;
+    }
+    // 三角形数少于该值时不再生成更粗的级
+    void setMinTriangles(size_t count) {
+        minTriangles_ = count;
+    }
+    void setMaxLevels(size_t count) {
+        maxLevels_ = count;
+    }
+    // 每个簇的目标三角形数（并行粒度）
+    void setClusterTriangles(size_t count) {
+        clusterTriangles_ = count;
+    }
+    // 法线差异项的权重，0 表示只看几何
+    void setNormalWeight(float weight) {
+        normalWeight_ = weight;
+    }
+
+    // 生成 LOD 链。mesh 按值传入并移动为 levels[0]，调用方可以 std::move 避免复制
+    void build(Mesh mesh, MeshLod& out);
+    // 单独简化一次到约 ratio 比例的三角形，返回最大距离估计
+    float simplify(const Mesh& in, float ratio, Mesh& out) const;
+
+    double lastBuildMs() const {
+        return buildMs_;
+    }
+};
@@ -0,0 +1,31 @@
+﻿// MmtfReader v 1.0
+#pragma once
+
+#include <string>
+#include "AtomTable.h"
+#include "MappedFile.h"
+#include "MsgPack.h"
+
+// MMTF 读取（未压缩的 .mmtf）：二进制字段按 MMTF 编码（codec 1-15）解码，
+// 原子、残基、链直接按 MMTF 的 模型/链/残基 层级写入原子表，只读取第一个模型
+class MmtfReader {
+private:
+    MappedFile file_;
+    MsgPackDocument doc_;
+    size_t inputSize_ = 0;
+    std::string error_;
+public:
+    MmtfReader() {
+
+    }
+
+    bool open(const std::string& path);
+    // 直接使用调用者的内存，data 必须在读取期间保持有效
+    bool parse(const char* data, size_t size);
+
+    bool loadStructure(AtomTable& out);
+
+    const std::string& lastError() const {
+        return error_;
+    }
+};
@@ -0,0 +1,107 @@
+﻿// MolecularSurface v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AtomTable.h"
+#include "MarchingCubes.h"
+#include "Mesh.h"
+#include "NeighborGrid.h"
+#include "ScalarGrid.h"
+
+enum class SurfaceKind : uint8_t {
+    SolventAccessible,      // SAS：原子半径加探针半径的球的并
+    SolventExcluded,        // SES（分子表面）：探针球滚过时触不到的区域的边界
+    GaussianDensity         // 高斯密度表面（QuickSurf 式）：每原子一个高斯球，密度等值面，适合逐帧重建
+};
+
+// 分子表面：在规则网格上计算距离场，再用 MarchingCubes 提取等值面。
+//   SAS 场：d(p) = min_i(|p - c_i| - R_i)，R_i = r_i + probe。每个原子只写到它的影响半径内，
+//           按 z 层块并行，行内按 x 连续计算（SSE2 每次 4 个格点）；
+//           |p - c| - R 用 (|p - c|^2 - R^2) / 2R 代替，零点不变，省去开方。
+//   SES 场：SAS 外部的格点是探针球心可达的位置，SAS 内部的格点到外部的欧氏距离
+//           D(p) 用可分离的精确距离变换（Felzenszwalb-Huttenlocher）按行并行求出，
+//           场为 probe - D(p)，等值面即探针球扫过区域的边界。
+//           D 以格点为单位量化，误差不超过半个格距的量级。
+//   高斯场：iso - sum_i exp(-|p - c_i|^2 / (s * r_i)^2)，每个原子截断在 2.63 * s * r_i（密度 1e-3）以内，
+//           高斯可分离，每个原子在截断球的外接盒上预先算好 x、y、z 三张一维 exp 表
+//           （SSE2 的 2^x 近似：指数位拼接加多项式），沿 x 的每段格点只做乘法和截断掩码；原子按格点小块分桶，
+//           每个线程只写自己的 z 层块，不用原子操作。
+// 每个顶点记录表面离它最近的原子（|p - c| - r 最小），用于着色和拾取。
+// 格点数超过上限时自动放大格距，大组装体也能在几秒内完成
+class MolecularSurface {
+private:
+    ScalarGrid field_;
+    MarchingCubes contour_;
+    NeighborGrid atomGrid_;
+    std::vector<float> radius_;         // 每原子范德华半径
+    std::vector<uint32_t> tileStart_;   // 原子按球心所在的格点小块分桶（CSR）
+    std::vector<uint32_t> tileAtoms_;
+    int tiles_[3] = { 0, 0, 0 };
+    float probeRadius_ = 1.4f;
+    float gaussianScale_ = 1.0f;
+    float densityIso_ = 0.5f;
+    float spacing_ = 0.5f;
+    size_t maxGridPoints_ = size_t(1) << 26;
+    double fieldMs_ = 0.0;
+    double extractMs_ = 0.0;
+    double buildMs_ = 0.0;
+
+    void setupGrid(const float* x, const float* y, const float* z, size_t n, float reach);
+    void bucketAtoms(const float* x, const float* y, const float* z, size_t n);
+    template <class Outer, class RowFn>
+    void splatAtoms(const float* x, const float* y, const float* z, float maxOuter, Outer outerOf, RowFn rowFn);
+    void splatGaussians(const float* x, const float* y, const float* z, float maxOuter);
+    void computeAccessibleField(const float* x, const float* y, const float* z, size_t n, float band);
+    void computeExcludedField();
+    void computeGaussianField(const float* x, const float* y, const float* z, size_t n);
+    void assignAtoms(const float* x, const float* y, const float* z, size_t n, float search, Mesh& mesh);
+public:
+    MolecularSurface() {
+
+    }
+
+    void setProbeRadius(float radius) {
+        probeRadius_ = radius;
+    }
+    // 高斯表面：高斯宽度为 scale * 范德华半径，密度等值面为 iso
+    void setGaussianScale(float scale) {
+        gaussianScale_ = scale;
+    }
+    void setDensityIso(float iso) {
+        densityIso_ = iso;
+    }
+    // 期望的格距（埃）；格点数超过 maxGridPoints 时实际格距会更大
+    void setSpacing(float spacing) {
+        spacing_ = spacing;
+    }
+    void setMaxGridPoints(size_t count) {
+        maxGridPoints_ = count;
+    }
+
+    // 坐标与半径按原子下标，mesh 顶点的 atomIds 为原子下标
+    void build(const float* x, const float* y, const float* z, const float* radius, size_t n,
+        SurfaceKind kind, Mesh& out);
+    // 使用原子表的坐标与元素的范德华半径
+    void build(const AtomTable& atoms, SurfaceKind kind, Mesh& out);
+
+    // 最近一次 build 的距离场（SES 时为 probe - D，高斯表面时为 iso - 密度），内部为负
+    const ScalarGrid& field() const {
+        return field_;
+    }
+    // 实际使用的格距
+    float spacing() const {
+        return field_.spacing;
+    }
+    // 最近一次 build 的耗时（毫秒）：距离场、等值面提取（含原子归属）、总计
+    double lastFieldMs() const {
+        return fieldMs_;
+    }
+    double lastExtractMs() const {
+        return extractMs_;
+    }
+    double lastBuildMs() const {
+        return buildMs_;
+    }
+};
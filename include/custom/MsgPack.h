@@ -0,0 +1,105 @@
+﻿// MsgPack v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// 最小化的 MessagePack 读取，供 BinaryCIF 与 MMTF 使用。
+// 解析结果是一个扁平的节点数组，字符串和二进制块只保存指向原始缓冲区的指针，
+// 不做拷贝，原始缓冲区必须在文档使用期间保持有效
+class MsgPackDocument {
+public:
+    enum class Type : uint8_t { Nil, Bool, Int, UInt, Float, String, Binary, Array, Map, Ext };
+
+    struct Node {
+        Type type = Type::Nil;
+        uint32_t count = 0;     // 数组/映射的元素数，字符串/二进制的字节数
+        uint32_t next = 0;      // 下一个兄弟节点的下标（跳过整棵子树）
+        union {
+            int64_t i;
+            uint64_t u;
+            double f;
+            const uint8_t* data;
+        };
+        Node() : u(0) {
+
+        }
+    };
+
+    // 对某个节点的轻量引用
+    class Ref {
+    private:
+        const MsgPackDocument* doc_ = nullptr;
+        uint32_t index_ = 0;
+    public:
+        Ref() {
+
+        }
+        Ref(const MsgPackDocument* doc, uint32_t index)
+            : doc_(doc), index_(index) {
+        }
+
+        bool valid() const {
+            return doc_ != nullptr;
+        }
+        Type type() const {
+            return valid() ? node().type : Type::Nil;
+        }
+        bool isNil() const {
+            return type() == Type::Nil;
+        }
+        const Node& node() const {
+            return doc_->nodes_[index_];
+        }
+
+        // 数组或映射的元素数
+        size_t size() const {
+            Type t = type();
+            return (t == Type::Array || t == Type::Map) ? node().count : 0;
+        }
+        int64_t asInt(int64_t fallback = 0) const;
+        double asDouble(double fallback = 0.0) const;
+        bool asBool() const {
+            return type() == Type::Bool && node().u != 0;
+        }
+        std::string_view asString() const;
+        // 二进制块（字符串也可以按字节访问）
+        const uint8_t* bytes() const {
+            return (type() == Type::Binary || type() == Type::String) ? node().data : nullptr;
+        }
+        size_t byteCount() const {
+            return (type() == Type::Binary || type() == Type::String) ? node().count : 0;
+        }
+
+        // 数组第 i 个元素（线性跳转，顺序遍历请用 first()/nextSibling()）
+        Ref operator[](size_t i) const;
+        // 映射中按字符串键查找，找不到返回无效引用
+        Ref operator[](std::string_view key) const;
+
+        // 第一个子节点；映射的子节点按 键、值、键、值 排列
+        Ref first() const {
+            return size() == 0 ? Ref() : Ref(doc_, index_ + 1);
+        }
+        Ref nextSibling() const {
+            return Ref(doc_, node().next);
+        }
+    };
+
+    MsgPackDocument() {
+
+    }
+
+    bool parse(const uint8_t* data, size_t size);
+    Ref root() const {
+        return nodes_.empty() ? Ref() : Ref(this, 0);
+    }
+
+private:
+    std::vector<Node> nodes_;
+    const uint8_t* cur_ = nullptr;
+    const uint8_t* end_ = nullptr;
+
+    bool parseValue(unsigned depth);
+};
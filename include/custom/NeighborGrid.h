@@ -0,0 +1,339 @@
+﻿// NeighborGrid v 1.0
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Simd.h"
+
+// 通用近邻搜索网格：距离相关的分析（接触、氢键、碰撞、SASA、成键、拾取半径）共用。
+// 原子按均匀格子做计数排序，排序时格子按 Morton 顺序排列，空间上相邻的格子里的原子在内存中也相邻；
+// 排序后的坐标单独存一份，查询时只访问连续数组。格子表按线性格子号索引，查邻居格子不需要间接跳转。
+// 支持长方体周期盒（最小镜像）。轨迹播放时用 update 只更新坐标，
+// 所有数组复用，没有原子换格子时只刷新排序后的坐标。
+// 构建与更新会使用线程池；查询是只读的，可以多线程同时调用
+class NeighborGrid {
+private:
+    struct CellRange {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    int dims_[3] = { 1, 1, 1 };
+    float origin_[3] = {};
+    float cellLen_[3] = { 1.0f, 1.0f, 1.0f };
+    float invCellLen_[3] = { 1.0f, 1.0f, 1.0f };
+    float box_[3] = {};                 // 周期盒边长，0 表示该方向不周期
+    float cellSize_ = 0.0f;
+    float boundsLo_[3] = {};            // update 可接受的坐标范围（非周期方向）
+    float boundsHi_[3] = {};
+    bool halfStencil_ = true;           // 每个方向格子数 >= 3 或不周期时，成对搜索只看一半邻居
+    size_t atomCount_ = 0;
+
+    std::vector<uint32_t> mortonCells_; // 按 Morton 顺序排列的线性格子号
+    std::vector<CellRange> cells_;      // 线性格子号 -> 排序后的原子区间
+    std::vector<uint32_t> cellOf_;      // 原子 -> 线性格子号
+    std::vector<uint32_t> nextCellOf_;
+    std::vector<uint32_t> order_;       // 排序位置 -> 原子下标
+    std::vector<float> sx_;
+    std::vector<float> sy_;
+    std::vector<float> sz_;
+
+    // 根据坐标范围确定格子划分，返回格子划分是否变化
+    bool setupGeometry(const float* x, const float* y, const float* z, size_t n);
+    void computeMortonOrder();
+    // 计算每个原子所在的格子写入 nextCellOf_；
+    // 返回是否所有原子都在网格范围内，changed 表示是否有原子换了格子
+    bool assignCells(const float* x, const float* y, const float* z, bool& changed);
+    void sortAtoms(const float* x, const float* y, const float* z);
+    void gatherCoordinates(const float* x, const float* y, const float* z);
+
+    int cellIndex(float v, int axis) const {
+        float t = v;
+        if (box_[axis] > 0.0f) t -= box_[axis] * std::floor(v / box_[axis]);
+        int c = int((t - origin_[axis]) * invCellLen_[axis]);
+        return c < 0 ? 0 : (c >= dims_[axis] ? dims_[axis] - 1 : c);
+    }
+    uint32_t linearCell(int cx, int cy, int cz) const {
+        return uint32_t((size_t(cz) * dims_[1] + cy) * dims_[0] + cx);
+    }
+    // 周期方向取最小镜像；Periodic 为 false 时编译期去掉判断，供热循环使用
+    template <bool Periodic = true>
+    float delta(float a, float b, int axis) const {
+        float d = a - b;
+        if (Periodic && box_[axis] > 0.0f) d -= box_[axis] * std::nearbyint(d / box_[axis]);
+        return d;
+    }
+    bool periodic() const {
+        return box_[0] > 0.0f || box_[1] > 0.0f || box_[2] > 0.0f;
+    }
+    // 把格子坐标折回网格内，非周期方向越界返回 -1
+    int wrapCell(int c, int axis) const {
+        if (c >= 0 && c < dims_[axis]) return c;
+        if (box_[axis] <= 0.0f) return -1;
+        c %= dims_[axis];
+        return c < 0 ? c + dims_[axis] : c;
+    }
+    // 把格子坐标区间 [lo, hi] 收缩到有效范围：非周期方向截断；
+    // 周期方向跨度覆盖整圈时取整圈（不重复），否则保留原区间，逐个用 wrapCell 折回
+    void axisRange(int& lo, int& hi, int axis) const {
+        if (box_[axis] > 0.0f) {
+            if (hi - lo + 1 >= dims_[axis]) {
+                lo = 0;
+                hi = dims_[axis] - 1;
+            }
+        }
+        else {
+            lo = lo < 0 ? 0 : lo;
+            hi = hi >= dims_[axis] ? dims_[axis] - 1 : hi;
+        }
+    }
+public:
+    NeighborGrid() {
+
+    }
+
+    // 建立网格。cellSize 通常取最常用的查询半径；
+    // periodicBox 为长方体周期盒的三个边长（某个分量为 0 表示该方向不周期），nullptr 表示无周期
+    void build(const float* x, const float* y, const float* z, size_t n, float cellSize,
+        const float* periodicBox = nullptr);
+
+    // 原子数不变、只有坐标变化时更新（轨迹逐帧）。periodicBox 为 nullptr 时沿用原来的盒子。
+    // 坐标超出原网格范围或盒子变化（NPT 轨迹）时自动完整重建，返回 false
+    bool update(const float* x, const float* y, const float* z, const float* periodicBox = nullptr);
+
+    size_t atomCount() const {
+        return atomCount_;
+    }
+    size_t cellCount() const {
+        return size_t(dims_[0]) * dims_[1] * dims_[2];
+    }
+    float cellSize() const {
+        return cellSize_;
+    }
+
+    // 对与点 p 距离不超过 radius 的每个原子调用 fn(atomIndex, distance2)
+    template <typename Fn>
+    void forEachWithin(float px, float py, float pz, float radius, Fn&& fn) const {
+        if (periodic()) forEachWithinIn<true>(px, py, pz, radius, fn);
+        else forEachWithinIn<false>(px, py, pz, radius, fn);
+    }
+
+    void within(float px, float py, float pz, float radius, std::vector<uint32_t>& out) const {
+        out.clear();
+        forEachWithin(px, py, pz, radius, [&](uint32_t i, float) {
+            out.push_back(i);
+        });
+    }
+
+    // 距离点 p 最近的 k 个原子，按距离升序写入 index / distance2，返回实际个数
+    size_t nearest(float px, float py, float pz, size_t k, uint32_t* index, float* distance2) const;
+
+    // 对距离不超过 cutoff（不超过 cellSize）的每一对原子调用 fn(i, j, distance2)，每对只出现一次。
+    // 把格子按 Morton 顺序分成 blockCount 段，只处理第 block 段，便于调用者并行并按段收集结果
+    template <typename Fn>
+    void forEachPair(float cutoff, Fn&& fn, size_t block = 0, size_t blockCount = 1) const {
+        if (periodic()) forEachPairIn<true>(cutoff, fn, block, blockCount);
+        else forEachPairIn<false>(cutoff, fn, block, blockCount);
+    }
+private:
+    template <bool Periodic, typename Fn>
+    void forEachWithinIn(float px, float py, float pz, float radius, Fn& fn) const;
+    template <bool Periodic, typename Fn>
+    void forEachPairIn(float cutoff, Fn& fn, size_t block, size_t blockCount) const;
+};
+
+template <bool Periodic, typename Fn>
+void NeighborGrid::forEachWithinIn(float px, float py, float pz, float radius, Fn& fn) const {
+    if (atomCount_ == 0 || !(radius >= 0.0f)) return;
+    float p[3] = { px, py, pz };
+    int lo[3], hi[3];
+    for (int k = 0; k < 3; ++k) {
+        float t = p[k];
+        if (box_[k] > 0.0f) t -= box_[k] * std::floor(t / box_[k]);
+        float a = std::floor((t - radius - origin_[k]) * invCellLen_[k]);
+        float b = std::floor((t + radius - origin_[k]) * invCellLen_[k]);
+        // 先在浮点上截断，避免半径极大时 int 溢出
+        float limit = float(2 * dims_[k]);
+        lo[k] = int(std::max(a, -limit));
+        hi[k] = int(std::min(b, limit));
+        axisRange(lo[k], hi[k], k);
+        if (lo[k] > hi[k]) return;
+    }
+    float r2 = radius * radius;
+    for (int cz = lo[2]; cz <= hi[2]; ++cz) {
+        int wz = Periodic ? wrapCell(cz, 2) : cz;
+        for (int cy = lo[1]; cy <= hi[1]; ++cy) {
+            int wy = Periodic ? wrapCell(cy, 1) : cy;
+            const CellRange* row = cells_.data() + linearCell(0, wy, wz);
+            for (int cx = lo[0]; cx <= hi[0]; ++cx) {
+                const CellRange& c = row[Periodic ? wrapCell(cx, 0) : cx];
+                for (uint32_t s = c.begin; s < c.end; ++s) {
+                    float dx = delta<Periodic>(sx_[s], px, 0);
+                    float dy = delta<Periodic>(sy_[s], py, 1);
+                    float dz = delta<Periodic>(sz_[s], pz, 2);
+                    float d2 = dx * dx + dy * dy + dz * dz;
+                    if (d2 <= r2) fn(order_[s], d2);
+                }
+            }
+        }
+    }
+}
+
+template <bool Periodic, typename Fn>
+void NeighborGrid::forEachPairIn(float cutoff, Fn& fn, size_t block, size_t blockCount) const {
+    size_t cells = cellCount();
+    if (atomCount_ == 0 || blockCount == 0 || block >= blockCount) return;
+    size_t step = (cells + blockCount - 1) / blockCount;
+    size_t r0 = block * step;
+    size_t r1 = r0 + step < cells ? r0 + step : cells;
+    float c2 = cutoff * cutoff;
+
+    auto test = [&](uint32_t s, uint32_t t) {
+        float dx = delta<Periodic>(sx_[s], sx_[t], 0);
+        float dy = delta<Periodic>(sy_[s], sy_[t], 1);
+        float dz = delta<Periodic>(sz_[s], sz_[t], 2);
+        float d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 <= c2) fn(order_[s], order_[t], d2);
+    };
+
+    // 不周期时把本格与 13 个邻居格子的原子收集到连续数组，每个原子对后面的整批做距离测试（SSE2 每次 4 个）。
+    // 稀疏网格里每格只有几个原子，逐格子的二重循环开销比距离测试本身还大
+    std::vector<float> gx, gy, gz;
+    std::vector<uint32_t> gatom;
+    if (!Periodic) {
+        gx.resize(64);
+        gy.resize(64);
+        gz.resize(64);
+        gatom.resize(64);
+    }
+
+    for (size_t r = r0; r < r1; ++r) {
+        uint32_t linear = mortonCells_[r];
+        uint32_t a0 = cells_[linear].begin;
+        uint32_t a1 = cells_[linear].end;
+        if (a0 == a1) continue;
+        int cx = int(linear % uint32_t(dims_[0]));
+        int cy = int((linear / uint32_t(dims_[0])) % uint32_t(dims_[1]));
+        int cz = int(linear / (uint32_t(dims_[0]) * uint32_t(dims_[1])));
+
+        if (!Periodic) {
+            static const int kForward[13][3] = {
+                { 1, 0, 0 },
+                { -1, 1, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+                { -1, -1, 1 }, { 0, -1, 1 }, { 1, -1, 1 },
+                { -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 },
+                { -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 }
+            };
+            size_t m = 0;
+            auto gather = [&](uint32_t t0, uint32_t t1) {
+                if (m + (t1 - t0) > gx.size()) {
+                    size_t size = std::max(2 * gx.size(), m + (t1 - t0));
+                    gx.resize(size);
+                    gy.resize(size);
+                    gz.resize(size);
+                    gatom.resize(size);
+                }
+                for (uint32_t t = t0; t < t1; ++t, ++m) {
+                    gx[m] = sx_[t];
+                    gy[m] = sy_[t];
+                    gz[m] = sz_[t];
+                    gatom[m] = order_[t];
+                }
+            };
+            gather(a0, a1);
+            for (const int* o : kForward) {
+                int nx = cx + o[0];
+                int ny = cy + o[1];
+                int nz = cz + o[2];
+                if (nx < 0 || ny < 0 || nx >= dims_[0] || ny >= dims_[1] || nz >= dims_[2]) continue;
+                const CellRange& c = cells_[linearCell(nx, ny, nz)];
+                gather(c.begin, c.end);
+            }
+
+            // 本格原子 k 只和收集数组中 k 之后的原子配对：本格内每对一次，邻居格子全部
+            const size_t home = a1 - a0;
+            for (size_t k = 0; k < home; ++k) {
+                const float px = gx[k];
+                const float py = gy[k];
+                const float pz = gz[k];
+                const uint32_t atom = gatom[k];
+                size_t t = k + 1;
+#if THC_SSE2
+                const __m128 vx = _mm_set1_ps(px);
+                const __m128 vy = _mm_set1_ps(py);
+                const __m128 vz = _mm_set1_ps(pz);
+                const __m128 vc2 = _mm_set1_ps(c2);
+                for (; t + 4 <= m; t += 4) {
+                    __m128 dx = _mm_sub_ps(vx, _mm_loadu_ps(&gx[t]));
+                    __m128 dy = _mm_sub_ps(vy, _mm_loadu_ps(&gy[t]));
+                    __m128 dz = _mm_sub_ps(vz, _mm_loadu_ps(&gz[t]));
+                    __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    unsigned mask = unsigned(_mm_movemask_ps(_mm_cmple_ps(d2, vc2)));
+                    if (mask == 0) continue;
+                    float lane[4];
+                    _mm_storeu_ps(lane, d2);
+                    do {
+                        unsigned b = countTrailingZeros64(mask);
+                        fn(atom, gatom[t + b], lane[b]);
+                        mask &= mask - 1;
+                    } while (mask != 0);
+                }
+#endif
+                for (; t < m; ++t) {
+                    float dx = px - gx[t];
+                    float dy = py - gy[t];
+                    float dz = pz - gz[t];
+                    float d2 = dx * dx + dy * dy + dz * dz;
+                    if (d2 <= c2) fn(atom, gatom[t], d2);
+                }
+            }
+            continue;
+        }
+
+        for (uint32_t s = a0; s < a1; ++s) {
+            for (uint32_t t = s + 1; t < a1; ++t) test(s, t);
+        }
+
+        if (halfStencil_) {
+            // 13 个“在后面”的邻居格子，每对格子只访问一次
+            static const int kForward[13][3] = {
+                { 1, 0, 0 },
+                { -1, 1, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+                { -1, -1, 1 }, { 0, -1, 1 }, { 1, -1, 1 },
+                { -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 },
+                { -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 }
+            };
+            for (const int* o : kForward) {
+                int nx = wrapCell(cx + o[0], 0);
+                int ny = wrapCell(cy + o[1], 1);
+                int nz = wrapCell(cz + o[2], 2);
+                if (nx < 0 || ny < 0 || nz < 0) continue;
+                const CellRange& c = cells_[linearCell(nx, ny, nz)];
+                for (uint32_t s = a0; s < a1; ++s) {
+                    for (uint32_t t = c.begin; t < c.end; ++t) test(s, t);
+                }
+            }
+        }
+        else {
+            // 周期方向格子太少时邻居会重复：去重后遍历全部邻居，只接受原子区间在后面的格子
+            int lo[3] = { cx - 1, cy - 1, cz - 1 };
+            int hi[3] = { cx + 1, cy + 1, cz + 1 };
+            for (int k = 0; k < 3; ++k) axisRange(lo[k], hi[k], k);
+            for (int nz = lo[2]; nz <= hi[2]; ++nz) {
+                for (int ny = lo[1]; ny <= hi[1]; ++ny) {
+                    for (int nx = lo[0]; nx <= hi[0]; ++nx) {
+                        const CellRange& c = cells_[linearCell(wrapCell(nx, 0), wrapCell(ny, 1), wrapCell(nz, 2))];
+                        if (c.begin <= a0) continue;
+                        for (uint32_t s = a0; s < a1; ++s) {
+                            for (uint32_t t = c.begin; t < c.end; ++t) test(s, t);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,144 @@
+﻿// OcclusionCuller v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.h"
+#include "FrustumCuller.h"
+#include "Mesh.h"
+
+// 软件遮挡剔除：每帧把少量遮挡体（链级的实心代理）光栅化到低分辨率的深度缓冲，
+// 再逐级取 2x2 中最远的深度建 Hi-Z 金字塔；候选物体的包围盒投影后在金字塔里选一级，
+// 使屏幕矩形只覆盖 2x2 个纹素，盒子最近的点比这些纹素记录的最远遮挡还远就判为被挡住。
+// 深度存 1 / w（w 为裁剪空间 w，即视空间深度），在屏幕空间线性插值是精确的；越大越近，0 表示没有遮挡。
+// 光栅化用边函数，SSE2 一次 4 个像素，采用内保守覆盖：纹素的四个角都在多边形内才写入
+// （边函数向内收缩半个纹素），写入的是多边形在纹素内最远的深度。这样深度缓冲里每个纹素的值
+// 不比该纹素内任何一条视线上的遮挡体近，被判为挡住的盒子确实被遮挡体挡住。
+// 细分的网格沿共享边的纹素不被任何一个三角形完整覆盖，另外按 Masked Occlusion Culling 的做法
+// 每 4x8 个纹素一块，记录一个工作层：覆盖掩码与合并进来的三角形在块内最远的深度。
+// 网格内部的边（两侧的三角形都画、在屏幕上分居两侧）按纹素中心采样，边界边（开放的边、轮廓上的折边）
+// 经过的纹素不置位；这样置位的纹素整个落在网格投影的并集内，掩码满了整块写入工作层的深度。
+// 工作层合并网格中与该块相交的全部三角形，不像 MOC 那样按深度丢弃，保持保守。
+// 封闭且绕向一致的网格（按坐标焊接顶点后判断）只画正面（OpenGL 约定逆时针），背面不拉远工作层；
+// 相机在封闭网格内时什么都不写。
+// 任一角在近平面后面的三角形不作为遮挡体，这样的包围盒判为可见。
+// 以上只保证相对遮挡体本身是保守的：遮挡体必须在实际画出的几何体之内（实心代理），
+// 比画出的东西大的网格（高斯表面、QEM 简化后的表面 LOD，见 StructureLod）会把透过缝隙可见的物体剔掉
+class OcclusionCuller {
+public:
+    struct Level {
+        int width;
+        int height;
+        std::vector<float> depth;       // 行优先，第 0 行在屏幕顶端
+    };
+private:
+    int width_ = 256;                   // 总是 4 的倍数
+    int height_ = 128;
+    std::vector<Level> levels_;         // levels_[0] 为深度缓冲，之后每级长宽减半（向上取整）直到 1x1
+    glm::mat4 viewProjection_ = glm::mat4(1.0f);
+    glm::vec3 cameraRight_ = glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 cameraUp_ = glm::vec3(0.0f, 1.0f, 0.0f);
+    bool pyramidReady_ = false;
+
+    size_t occluderTriangles_ = 0;
+    size_t tested_ = 0;
+    size_t visible_ = 0;
+    double rasterMs_ = 0.0;
+    double pyramidMs_ = 0.0;
+    double cullMs_ = 0.0;
+
+    // 覆盖掩码的块：4 列 8 行，位 (y % 8) * 4 + x % 4
+    static const int kTileWidth = 4;
+    static const int kTileHeight = 8;
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+    std::vector<float> tileFar_;        // 工作层合并的三角形在块内最远的深度，没有时为 float 最大值
+    std::vector<uint32_t> tileMask_;    // 工作层覆盖的纹素
+    std::vector<uint32_t> tileBits_;    // 光栅化当前三角形时的临时覆盖，合并后清零
+    std::vector<uint32_t> tileBoundary_;    // 当前网格的边界边经过的纹素
+
+    static const int kMaxPolygon = 8;
+    // 裁剪坐标的平面凸多边形（count <= kMaxPolygon），按内保守覆盖写入深度缓冲
+    void rasterizePolygon(const glm::vec4* corners, int count);
+    // 屏幕坐标的多边形；merge 时另按中心采样合并到块的工作层（边界边的纹素除外）。
+    // 面积退化不画时返回 false
+    bool rasterizeScreen(const float* x, const float* y, const float* d, int count, bool merge);
+    // 线段经过的纹素记入 tileBoundary_
+    void markBoundary(float ax, float ay, float bx, float by);
+    // 掩码满了：块内纹素写入工作层的深度，清空工作层
+    void resolveTile(size_t tile);
+public:
+    OcclusionCuller() {
+        setResolution(256, 128);
+    }
+
+    // 深度缓冲分辨率，宽度向上取到 4 的倍数；通常取窗口的 1/4 到 1/8
+    void setResolution(int width, int height);
+    int width() const {
+        return width_;
+    }
+    int height() const {
+        return height_;
+    }
+
+    // 每帧开始：清空深度缓冲并设置相机。projection 为 OpenGL 约定
+    void beginFrame(const glm::mat4& projection, const glm::mat4& view);
+    // 遮挡体与测试的盒子是 float 世界坐标时用；远离世界原点的大场景会丢精度
+    void beginFrame(const Camera& camera, const glm::mat4& projection) {
+        beginFrame(projection, camera.getView());
+    }
+    // 遮挡体与盒子都相对 anchor 时用（如 StructureLod 的链包围盒与链球）
+    void beginFrame(const Camera& camera, const glm::mat4& projection, const RenderAnchor& anchor) {
+        beginFrame(projection, anchor.modelView(camera));
+    }
+
+    // 三角形遮挡体，坐标系与 beginFrame 的视图一致（xyz 紧密排列，indices 每三个一个三角形），
+    // 两面都写；封闭网格只写正面。一个网格整个传进来，共享边才能合并覆盖
+    void addOccluder(const float* positions, const uint32_t* indices, size_t triangleCount);
+    void addOccluder(const Mesh& mesh) {
+        addOccluder(mesh.positions.data(), mesh.indices.data(), mesh.triangleCount());
+    }
+    // 实心球遮挡体：光栅化过球心、平行于像平面的大圆的内接正八边形（作为一个凸多边形）。
+    // 八边形上的点都在球内，射向它的视线先碰到球面，所以是保守的。
+    // 链包围球不是实心的，应当传一个确实被原子填满的半径
+    void addSphereOccluder(const float center[3], float radius);
+
+    // 遮挡体全部加完后调用一次，之后才能测试
+    void buildPyramid();
+
+    // 包围盒是否可能可见（投影到屏幕外的盒子也返回 true，交给视锥剔除）
+    bool visible(const float lo[3], const float hi[3]) const;
+    // 候选（通常是视锥剔除的结果）中没有被挡住的追加到 visible，返回追加的个数
+    size_t cull(const AabbArray& boxes, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& visible);
+
+    // 第 level 级（level 0 为全分辨率）；buildPyramid 之前只有 level 0 有效
+    int levelCount() const {
+        return int(levels_.size());
+    }
+    const Level& level(int index) const {
+        return levels_[index];
+    }
+
+    // 本帧光栅化的三角形数（八边形按六个三角形计）
+    size_t occluderTriangleCount() const {
+        return occluderTriangles_;
+    }
+    size_t lastTested() const {
+        return tested_;
+    }
+    size_t lastVisible() const {
+        return visible_;
+    }
+    // 本帧累计的光栅化耗时、建金字塔耗时与最近一次 cull 的耗时（毫秒）
+    double lastRasterMs() const {
+        return rasterMs_;
+    }
+    double lastPyramidMs() const {
+        return pyramidMs_;
+    }
+    double lastCullMs() const {
+        return cullMs_;
+    }
+};
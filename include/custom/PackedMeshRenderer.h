@@ -0,0 +1,62 @@
+﻿// PackedMeshRenderer v 1.0
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <glm/glm.hpp>
+#include "AtomBuffers.h"
+#include "Camera.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "VertexFormat.h"
+
+// 生成网格（分子表面、简化后的链表面）的绘制：顶点按 PackedVertex 压缩为 16 字节上传
+// （shaders/packed_mesh.*），颜色按顶点的 atomId 从 AtomBuffers 的颜色纹理缓冲读取，
+// 换配色只重传 AtomBuffers 的颜色，网格缓冲不动。网格坐标相对 anchor，draw 用锚点的 modelView
+class PackedMeshRenderer {
+private:
+    PackedMesh mesh_;                   // CPU 端保留：拾取时由三角形查 atomId
+    RenderAnchor anchor_;
+    bool meshDirty_ = false;
+    const AtomBuffers* atoms_ = nullptr;
+
+    unsigned int vao_ = 0;
+    unsigned int vertexBuffer_ = 0;
+    unsigned int indexBuffer_ = 0;
+    size_t uploadedIndices_ = 0;        // GL 缓冲中的下标数
+    glm::vec3 uploadedOrigin_ = glm::vec3(0.0f);    // GL 缓冲中网格的反量化参数
+    glm::vec3 uploadedExtent_ = glm::vec3(0.0f);
+    Shader shader_;
+    std::string error_;
+public:
+    PackedMeshRenderer() {
+
+    }
+
+    // 颜色来源，网格的 atomIds 须是它的原子下标；须在 draw 之前 upload
+    void setAtomBuffers(const AtomBuffers* atoms) {
+        atoms_ = atoms;
+    }
+    // 网格变化时调用：打包后等待 upload。anchor 为网格坐标的参考点
+    void setMesh(const Mesh& mesh, const RenderAnchor& anchor);
+    void setMesh(PackedMesh&& mesh, const RenderAnchor& anchor);
+
+    const PackedMesh& mesh() const {
+        return mesh_;
+    }
+    const RenderAnchor& anchor() const {
+        return anchor_;
+    }
+
+    // 以下需要 GL 上下文
+    bool createGL(const std::string& vertexPath, const std::string& fragmentPath);
+    void destroyGL();
+    // 网格变化后重传顶点与下标缓冲，否则什么都不做
+    void upload();
+    // 视图取 camera 的渲染视图加锚点偏移；占用纹理单元 0、1，调用方负责开启深度测试
+    void draw(const Camera& camera, const glm::mat4& projection) const;
+
+    const std::string& lastError() const {
+        return error_;
+    }
+};
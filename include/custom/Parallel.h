@@ -0,0 +1,71 @@
+﻿// Parallel v 1.0
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 常驻线程池：每帧都要跑的并行任务（解析、分析、网格生成）共用同一组线程，
+// 避免反复创建线程的开销
+class ThreadPool {
+private:
+    std::vector<std::thread> workers_;
+    std::mutex runMutex_;                 // 同一时刻只执行一个任务批次
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t taskCount_ = 0;
+    std::atomic<size_t> next_{ 0 };
+    size_t generation_ = 0;
+    unsigned active_ = 0;
+    bool stop_ = false;
+
+    ThreadPool();
+    void workerLoop();
+public:
+    static ThreadPool& instance();
+
+    // 参与计算的线程数（包括调用线程）
+    unsigned size() const {
+        return static_cast<unsigned>(workers_.size()) + 1;
+    }
+
+    // 执行 task(0) ... task(taskCount - 1)，调用线程也参与，返回时全部完成。
+    // 在池内线程中嵌套调用，或池正被其他线程占用时，直接在当前线程串行执行
+    void run(size_t taskCount, const std::function<void(size_t)>& task);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+};
+
+// 返回可用的工作线程数（至少为 1）
+inline unsigned workerCount() {
+    return ThreadPool::instance().size();
+}
+
+// 把 [begin, end) 切成若干块并行执行 fn(blockBegin, blockEnd)，
+// grain 为每块的最小元素数
+template <typename Fn>
+void parallelFor(size_t begin, size_t end, Fn&& fn, size_t grain = 1024) {
+    if (end <= begin) return;
+    size_t count = end - begin;
+    grain = std::max<size_t>(grain, 1);
+    size_t blocks = std::min<size_t>((count + grain - 1) / grain, size_t(workerCount()) * 4);
+    if (blocks <= 1) {
+        fn(begin, end);
+        return;
+    }
+    size_t step = (count + blocks - 1) / blocks;
+    ThreadPool::instance().run(blocks, [&](size_t b) {
+        size_t b0 = begin + b * step;
+        size_t b1 = std::min(end, b0 + step);
+        if (b0 < b1) fn(b0, b1);
+    });
+}
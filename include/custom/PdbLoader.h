@@ -0,0 +1,31 @@
+﻿// PdbLoader v 1.0
+#pragma once
+
+#include <string>
+#include "AtomTable.h"
+
+// PDB 格式读取：内存映射整个文件，按行对齐切块后多线程解析 ATOM/HETATM，
+// 结果直接写入 AtomTable 的 SoA 数组。
+// 只读取第一个 MODEL；备用位置（altLoc）只保留空白或 'A'/'1'；
+// HELIX/SHEET 记录写入 Residue::ss
+class PdbLoader {
+private:
+    std::string error_;
+    double parseMs_ = 0.0;
+public:
+    PdbLoader() {
+
+    }
+
+    bool load(const std::string& path, AtomTable& out);
+    // 从内存中解析（data 不需要以 0 结尾）
+    bool parse(const char* data, size_t size, AtomTable& out);
+
+    const std::string& lastError() const {
+        return error_;
+    }
+    // 最近一次 parse 的耗时（毫秒，不含打开/映射文件）
+    double lastParseMs() const {
+        return parseMs_;
+    }
+};
@@ -0,0 +1,84 @@
+﻿// Picker v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "AtomTable.h"
+#include "BondPerception.h"
+#include "Bvh.h"
+#include "Camera.h"
+#include "Mesh.h"
+
+enum class PickKind : uint8_t {
+    None = 0,
+    Atom,
+    Bond,
+    Triangle
+};
+
+struct PickHit {
+    PickKind kind = PickKind::None;
+    uint32_t index = 0;         // 原子、键或三角形的下标
+    uint32_t atom = 0;          // 对应的原子：键取离交点近的一端，三角形取最近顶点的 atomIds
+    float t = 0.0f;             // 沿单位方向的距离
+    float position[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// CPU 光线拾取：把光标位置经 Camera 与投影矩阵反投影成世界空间的射线，
+// 在原子球、键圆柱与表面三角形三个 Bvh 上分别求交，取最近的交点。
+// 不读 GPU 的 ID 缓冲，不会让管线停顿；一次拾取只遍历射线经过的几十个节点，
+// 千万原子的场景也可以每次鼠标移动都做（悬停高亮）。
+// 轨迹帧用 updatePositions 只 refit，不重建
+class Picker {
+private:
+    Bvh atoms_;                         // 图元为原子球的外接盒，球心与半径直接从盒子还原
+    std::vector<float> radii_;
+    Bvh bonds_;
+    std::vector<uint32_t> pairs_;       // 每条键两个原子下标
+    AabbArray bondBoxes_;
+    float bondRadius_ = 0.15f;
+    Bvh triangles_;
+    const Mesh* mesh_ = nullptr;
+
+    PickHit hit_;
+    double buildMs_ = 0.0;
+    double pickMs_ = 0.0;
+
+    void updateBondBoxes();
+public:
+    Picker() {
+
+    }
+
+    // 原子半径为范德华半径乘 radiusScale（与 SphereImpostor::setRadiusScale 保持一致）
+    void setAtoms(const AtomTable& atoms, float radiusScale = 1.0f);
+    // 键圆柱的半径与 BondImpostor::setRadius 一致；键表须在 setAtoms 之后设置
+    void setBonds(const BondTable& bonds, float radius);
+    void setBonds(const std::vector<uint32_t>& pairs, float radius);
+    // 表面网格只保存指针，网格在下次 setMesh 之前不能释放或修改；nullptr 表示不拾取表面
+    void setMesh(const Mesh* mesh);
+    // 原子数不变、只有坐标变化（轨迹帧）：refit 原子与键的 Bvh
+    void updatePositions(const float* x, const float* y, const float* z);
+
+    // 窗口坐标（像素，原点在左上角，与 glfwGetCursorPos 一致）对应的射线，dir 为单位向量
+    static void cursorRay(const Camera& camera, const glm::mat4& projection, float cursorX, float cursorY,
+        float width, float height, glm::vec3& origin, glm::vec3& dir);
+
+    // 射线 origin + t * dir（0 <= t <= maxDistance）上最近的交点；没有命中时 hit.kind 为 None 并返回 false
+    bool pickRay(const glm::vec3& origin, const glm::vec3& dir, PickHit& hit, float maxDistance = 1e30f);
+    bool pick(const Camera& camera, const glm::mat4& projection, float cursorX, float cursorY,
+        float width, float height, PickHit& hit);
+
+    // 最近一次拾取的结果
+    const PickHit& lastHit() const {
+        return hit_;
+    }
+    double lastBuildMs() const {
+        return buildMs_;
+    }
+    double lastPickMs() const {
+        return pickMs_;
+    }
+};
@@ -0,0 +1,50 @@
+﻿// RandomAccessFile v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 只读的按偏移读取文件（POSIX pread / Windows ReadFile + OVERLAPPED），
+// 用于轨迹这类远大于内存、不适合整体映射的文件。
+// readAt 不改变共享状态，可以在多个线程中同时调用
+class RandomAccessFile {
+private:
+    uint64_t size_ = 0;
+#ifdef _WIN32
+    void* handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+public:
+    RandomAccessFile() {
+
+    }
+    RandomAccessFile(const RandomAccessFile&) = delete;
+    RandomAccessFile& operator=(const RandomAccessFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const {
+#ifdef _WIN32
+        return handle_ != nullptr;
+#else
+        return fd_ >= 0;
+#endif
+    }
+    uint64_t size() const {
+        return size_;
+    }
+#ifndef _WIN32
+    // 原生描述符（供 io_uring 等异步后端使用）
+    int descriptor() const {
+        return fd_;
+    }
+#endif
+
+    // 从 offset 读取恰好 size 字节，越过文件末尾或出错时返回 false
+    bool readAt(uint64_t offset, void* dst, size_t size) const;
+
+    ~RandomAccessFile();
+};
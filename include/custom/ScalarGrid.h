@@ -0,0 +1,34 @@
+﻿// ScalarGrid v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 规则网格上的标量场（距离场、密度等），x 变化最快。
+// 格点 (i, j, k) 的坐标为 origin + spacing * (i, j, k)
+struct ScalarGrid {
+    int nx = 0;
+    int ny = 0;
+    int nz = 0;
+    float origin[3] = { 0.0f, 0.0f, 0.0f };
+    float spacing = 1.0f;
+    std::vector<float> values;
+
+    size_t pointCount() const {
+        return size_t(nx) * size_t(ny) * size_t(nz);
+    }
+    size_t index(int i, int j, int k) const {
+        return (size_t(k) * size_t(ny) + size_t(j)) * size_t(nx) + size_t(i);
+    }
+    float at(int i, int j, int k) const {
+        return values[index(i, j, k)];
+    }
+
+    void resize(int x, int y, int z) {
+        nx = x;
+        ny = y;
+        nz = z;
+        values.resize(pointCount());
+    }
+};
@@ -0,0 +1,140 @@
+﻿// SceneCache v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AtomTable.h"
+#include "MappedFile.h"
+
+// .thc 场景缓存：解析后的结构与派生几何按节（section）平铺存放，
+// 每节按 64 字节对齐。打开时只映射文件并校验头部，
+// 节的指针可以直接交给 glBufferData，不做任何反序列化。
+//
+// 文件布局：
+//   SceneCacheHeader（64 字节）
+//   SceneCacheSection[sectionCount]
+//   各节数据（64 字节对齐）
+
+// 格式版本：文件布局变化时递增
+const uint32_t kSceneCacheFormatVersion = 1;
+// 生成器版本：解析器或网格生成算法的输出变化时递增，旧缓存随之失效。
+// 2：等值面改为带边缓存的行进立方体，顶点顺序与个数都变了；PDB 跨块的残基不再被拆开
+const uint64_t kSceneGeneratorVersion = 2;
+
+enum class SceneSection : uint32_t {
+    AtomX = 1,
+    AtomY,
+    AtomZ,
+    AtomElement,
+    AtomName,
+    AtomFlags,
+    AtomResidue,
+    AtomChain,
+    Residues,           // Residue[]
+    Chains,             // Chain[]
+    Bonds,              // uint32_t 原子下标对
+    MeshPositions,      // float xyz
+    MeshNormals,        // float xyz
+    MeshIndices,        // uint32_t
+    MeshAtomIds         // uint32_t，每个顶点对应的原子
+};
+
+struct SceneCacheHeader {
+    char magic[8];              // "THCSCENE"
+    uint32_t formatVersion;
+    uint32_t byteOrder;         // 0x01020304，按本机字节序写入
+    uint64_t generatorVersion;
+    uint64_t sourceHash;        // 源文件内容哈希（hashContent）
+    uint64_t sourceSize;
+    uint32_t sectionCount;
+    uint32_t reserved[5];
+};
+
+struct SceneCacheSection {
+    uint32_t type;              // SceneSection
+    uint32_t elementSize;
+    uint64_t offset;            // 相对文件开头
+    uint64_t size;              // 字节数
+    uint64_t count;             // 元素个数
+};
+
+static_assert(sizeof(SceneCacheHeader) == 64, "SceneCacheHeader must stay 64 bytes");
+static_assert(sizeof(SceneCacheSection) == 32, "SceneCacheSection must stay 32 bytes");
+
+// 缓存文件的默认位置：源文件旁的 <source>.thc
+inline std::string sceneCachePath(const std::string& sourcePath) {
+    return sourcePath + ".thc";
+}
+
+// 写缓存：addSection 只记录指针，数据必须保持有效直到 write 返回
+class SceneCacheWriter {
+private:
+    struct Pending {
+        SceneSection type;
+        const void* data;
+        size_t size;
+        uint32_t elementSize;
+    };
+    std::vector<Pending> sections_;
+    uint64_t sourceHash_ = 0;
+    uint64_t sourceSize_ = 0;
+public:
+    SceneCacheWriter(uint64_t sourceHash, uint64_t sourceSize)
+        : sourceHash_(sourceHash), sourceSize_(sourceSize) {
+    }
+
+    void addSection(SceneSection type, const void* data, size_t size, uint32_t elementSize);
+
+    template <typename T>
+    void addSection(SceneSection type, const std::vector<T>& values) {
+        addSection(type, values.data(), values.size() * sizeof(T), uint32_t(sizeof(T)));
+    }
+
+    // 原子表的全部数组
+    void addAtomTable(const AtomTable& table);
+
+    // 先写临时文件再改名，失败时不会留下半个缓存
+    bool write(const std::string& path) const;
+};
+
+// 读缓存
+class SceneCache {
+private:
+    MappedFile file_;
+    const SceneCacheHeader* header_ = nullptr;
+    const SceneCacheSection* sections_ = nullptr;
+public:
+    SceneCache() {
+
+    }
+
+    // 打开并校验：格式版本、生成器版本、源文件哈希与长度都匹配才算命中；
+    // 节表中任一节越出文件或元素个数超过 size / elementSize 时视为损坏
+    bool open(const std::string& path, uint64_t sourceHash, uint64_t sourceSize);
+    void close();
+    bool isOpen() const {
+        return header_ != nullptr;
+    }
+
+    // 节数据的指针（指向映射内存），不存在返回 nullptr
+    const void* section(SceneSection type, size_t* size = nullptr, size_t* count = nullptr) const;
+
+    template <typename T>
+    const T* sectionAs(SceneSection type, size_t* count = nullptr) const {
+        const SceneCacheSection* s = find(type);
+        if (s == nullptr || s->elementSize != sizeof(T)) return nullptr;
+        if (count) *count = size_t(s->count);
+        return reinterpret_cast<const T*>(file_.data() + s->offset);
+    }
+
+    // 把原子数组拷回 AtomTable（仅 memcpy）
+    bool loadAtomTable(AtomTable& out) const;
+
+    // 把一节直接上传到 GL 缓冲：glBindBuffer(target, buffer) + glBufferData(映射指针)
+    bool uploadSection(SceneSection type, unsigned int target, unsigned int buffer, unsigned int usage) const;
+
+private:
+    const SceneCacheSection* find(SceneSection type) const;
+};
@@ -0,0 +1,44 @@
+﻿// Shader v 1.0
+#pragma once
+
+#include <string>
+#include <glm/glm.hpp>
+
+// GLSL 程序：编译顶点/片段着色器并链接，出错时 lastError 返回编译或链接日志。
+// 需要当前线程有 GL 上下文；GL 对象由 destroy 释放（析构时上下文可能已销毁）
+class Shader {
+private:
+    unsigned int program_ = 0;
+    std::string error_;
+
+    bool compile(unsigned int type, const std::string& source, unsigned int& shader);
+public:
+    Shader() {
+
+    }
+
+    // 从源码字符串编译链接，成功时替换原有程序
+    bool loadSources(const std::string& vertexSource, const std::string& fragmentSource);
+    // 从文件读取源码（通常是 shaders/ 下的 .vert / .frag）
+    bool loadFiles(const std::string& vertexPath, const std::string& fragmentPath);
+    void destroy();
+
+    bool isValid() const {
+        return program_ != 0;
+    }
+    unsigned int id() const {
+        return program_;
+    }
+    void use() const;
+
+    // uniform 位置，不存在（或被编译器优化掉）时返回 -1，对应的 set 调用被忽略
+    int uniform(const char* name) const;
+    void setInt(const char* name, int value) const;
+    void setFloat(const char* name, float value) const;
+    void setVec3(const char* name, const glm::vec3& value) const;
+    void setMat4(const char* name, const glm::mat4& value) const;
+
+    const std::string& lastError() const {
+        return error_;
+    }
+};
@@ -0,0 +1,71 @@
+﻿// Simd v 1.0
+#pragma once
+
+#include <cstdint>
+
+// x86-64 上 SSE2 总是可用；32 位 MSVC 需要 /arch:SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define THC_SSE2 1
+#include <emmintrin.h>
+#else
+#define THC_SSE2 0
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// AVX 按函数开启（THC_TARGET_AVX），不要求整个工程用 /arch:AVX 或 -mavx 编译；
+// 调用前用 cpuHasAvx() 做运行时检查
+#if defined(_M_X64) || (defined(_MSC_VER) && defined(_M_IX86))
+#define THC_AVX 1
+#define THC_TARGET_AVX
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define THC_AVX 1
+#define THC_TARGET_AVX __attribute__((target("avx")))
+#else
+#define THC_AVX 0
+#define THC_TARGET_AVX
+#endif
+
+// CPU 支持 AVX 且操作系统保存 YMM 寄存器（OSXSAVE 与 XCR0），结果只检测一次
+inline bool cpuHasAvx() {
+#if THC_AVX
+    static const bool has = []() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx") != 0;
+#endif
+    }();
+    return has;
+#else
+    return false;
+#endif
+}
+
+// 最低位 1 的下标，v 不能为 0
+inline unsigned countTrailingZeros64(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+#if defined(_M_X64)
+    _BitScanForward64(&index, v);
+#else
+    if (static_cast<uint32_t>(v) != 0) {
+        _BitScanForward(&index, static_cast<uint32_t>(v));
+    }
+    else {
+        _BitScanForward(&index, static_cast<uint32_t>(v >> 32));
+        index += 32;
+    }
+#endif
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
@@ -0,0 +1,119 @@
+﻿// SphereImpostor v 1.3
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "AtomBuffers.h"
+#include "Camera.h"
+#include "Shader.h"
+
+// 不对应单个原子的球（残基球、链球等）：球心、半径、颜色紧密排列（20 字节），整块直接作为 GL 实例缓冲
+struct SphereInstance {
+    float x, y, z;      // 相对所属对象的锚点
+    float radius;
+    uint32_t color;     // 0xAABBGGRR，按 GL_UNSIGNED_BYTE 归一化读取
+};
+
+static_assert(sizeof(SphereInstance) == 20, "SphereInstance must stay tightly packed");
+
+// 自有实例中要画的一段，球心都相对 anchor（如 StructureLod 一条链的残基球与 chainAnchor）
+struct SphereBatch {
+    uint32_t first = 0;
+    uint32_t count = 0;
+    RenderAnchor anchor;
+};
+
+// 空间填充 / 球棍模型的原子球：GL 3.3 实例化绘制，每个球只画一个面向相机的四边形，
+// 片段着色器对球做光线求交并写深度（shaders/sphere_impostor.*），不生成三角化的球。
+// 两种数据来源：
+//   原子：setAtomBuffers 之后以实例号为原子下标，从 AtomBuffers 的纹理缓冲读球心、半径和颜色，
+//         与键等表示共用同一份数据，这里不保存逐原子的副本，轨迹帧也只需更新 AtomBuffers；
+//         球心相对原子所在块的锚点，着色器加上块偏移后乘 Camera::getRenderView；
+//   其他球：setInstances 给出 SphereInstance 数组（StructureLod 的残基球、链球），放在自己的实例缓冲里，
+//         按 SphereBatch 分段画，每段一个锚点，draw 用该锚点的 RenderAnchor::modelView(camera)。
+// 球心都是相对锚点的小 float 坐标，大场景放大到埃级也不抖。
+// 半径缩放放在 uniform 里，切换模型不必重写缓冲
+class SphereImpostor {
+private:
+    const AtomBuffers* atoms_ = nullptr;
+    std::vector<SphereInstance> instances_;
+    std::vector<SphereBatch> batches_;
+    bool instancesDirty_ = false;
+    float radiusScale_ = 1.0f;
+
+    unsigned int vao_ = 0;              // 自有实例：四边形角 + 逐实例属性
+    unsigned int atomVao_ = 0;          // 画原子：只有四边形角，实例数据全部来自纹理缓冲
+    unsigned int quadBuffer_ = 0;
+    unsigned int instanceBuffer_ = 0;
+    size_t capacity_ = 0;               // 实例缓冲已分配的实例数
+    size_t uploadedCount_ = 0;          // 实例缓冲中有效的实例数
+    Shader shader_;
+
+    std::string error_;
+    double uploadMs_ = 0.0;
+    size_t uploadBytes_ = 0;
+public:
+    SphereImpostor() {
+
+    }
+
+    // 画原子：数据来自 atoms（须在 draw 之前 upload），可与 BondImpostor 共用；nullptr 表示画 setInstances 的球
+    void setAtomBuffers(const AtomBuffers* atoms) {
+        atoms_ = atoms;
+    }
+    const AtomBuffers* atomBuffers() const {
+        return atoms_;
+    }
+    // 替换全部自有实例（球心都相对 anchor，如链球与 StructureLod::anchor()），作为一段全部画出；
+    // 下次 upload 时整体上传
+    void setInstances(const SphereInstance* instances, size_t count, const RenderAnchor& anchor);
+    void setInstances(const std::vector<SphereInstance>& instances, const RenderAnchor& anchor) {
+        setInstances(instances.data(), instances.size(), anchor);
+    }
+    // 替换全部自有实例，只画 batches 中的段（各段球心相对各自的锚点）
+    void setInstances(const std::vector<SphereInstance>& instances, const std::vector<SphereBatch>& batches);
+    // 只换要画的段（如每帧 StructureLod::residueBatches 的结果），实例缓冲不重传
+    void setBatches(const std::vector<SphereBatch>& batches) {
+        batches_ = batches;
+    }
+    const std::vector<SphereInstance>& instances() const {
+        return instances_;
+    }
+    const std::vector<SphereBatch>& batches() const {
+        return batches_;
+    }
+    // draw 要画的球数
+    size_t sphereCount() const;
+
+    // 所有半径的缩放（空间填充 1.0，球棍模型通常 0.25），只改 uniform
+    void setRadiusScale(float scale) {
+        radiusScale_ = scale;
+    }
+    float radiusScale() const {
+        return radiusScale_;
+    }
+
+    // 以下需要 GL 上下文。
+    // 创建 VAO、缓冲并加载着色器（通常是 shaders/sphere_impostor.vert 与 .frag）
+    bool createGL(const std::string& vertexPath, const std::string& fragmentPath);
+    void destroyGL();
+    // 自有实例变化后上传；原子数据由 AtomBuffers::upload 提交
+    void upload();
+    // 用当前着色器绘制，视图取 camera 的渲染视图加锚点偏移；画原子时占用纹理单元 0 到 3，
+    // 调用方本帧已调用过 AtomBuffers::updateBlockOffsets；调用方负责开启深度测试
+    void draw(const Camera& camera, const glm::mat4& projection) const;
+
+    const std::string& lastError() const {
+        return error_;
+    }
+    double lastUploadMs() const {
+        return uploadMs_;
+    }
+    // 最近一次 upload 提交的字节数
+    size_t lastUploadBytes() const {
+        return uploadBytes_;
+    }
+};
@@ -0,0 +1,167 @@
+﻿// StructureLod v 1.2
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AtomTable.h"
+#include "Camera.h"
+#include "FrustumCuller.h"
+#include "MeshSimplifier.h"
+#include "OcclusionCuller.h"
+#include "SphereImpostor.h"
+
+// 每条链当前使用的表示，从细到粗
+enum class LodLevel : uint8_t {
+    Atoms = 0,      // 逐原子
+    Residues,       // 每残基一个球（质心，半径取回转半径加平均范德华半径）
+    Surface,        // 残基球的高斯表面，经 MeshSimplifier 简化成 LOD 链
+    Blob            // 整条链一个球
+};
+
+// 介观尺度结构（病毒、细胞器，上亿原子）的层次 LOD：原子 -> 残基 -> 链。
+// build 预先算好残基球、链球和每条链的简化表面；select 每帧按链到相机的距离
+// 估计各表示在屏幕上的大小，挑出足够细的最粗表示：
+//   原子直径投影 >= atomPixels 时画原子，残基球投影 >= residuePixels 时画残基，
+//   链投影 >= blobPixels 时画表面，否则画链球。
+// 已经在用的更细表示只有投影缩小到阈值的 (1 - hysteresis) 以下才换粗，缩放时不来回跳。
+// 总图元数（球数 + 三角形数）超过 maxPrimitives 时从屏幕上最小的链开始逐级变粗，帧时间与缩放无关。
+// 给了 FrustumCuller 时视锥外的链不计入图元数，也不出现在 visibleChains 中；
+// 给了 OcclusionCuller 时被遮挡的链同样处理。
+// 链球与链包围盒是相对 anchor()（原子包围盒的中心，双精度）的 float 坐标：链球用这个锚点画，
+// 剔除器用带锚点的 setCamera / beginFrame，select 的距离也在这个坐标系里算，链球几埃的误差看不出来。
+// 残基球与链表面要放大到埃级去看，相对各自链的 chainAnchor(c)（链的双精度质心）存放：
+// 残基球按 residueBatches 分段交给 SphereImpostor，表面用 chainAnchor(c).modelView(camera)，
+// 相距 1e5 埃的链也都只有链内的小坐标
+class StructureLod {
+public:
+    struct ChainInfo {
+        uint32_t firstAtom = 0;
+        uint32_t atomCount = 0;
+        uint32_t firstResidue = 0;
+        uint32_t residueCount = 0;
+        float center[3] = { 0.0f, 0.0f, 0.0f };     // 包围球，相对 anchor()
+        float radius = 0.0f;
+        float residueDiameter = 0.0f;               // 残基球的平均直径
+    };
+
+    struct Selection {
+        LodLevel level = LodLevel::Blob;
+        uint32_t surfaceLevel = 0;                  // level 为 Surface 时用的 MeshLod 级
+        float pixels = 0.0f;                        // 链包围球直径的投影（像素）
+        bool visible = true;                        // 在视锥内
+    };
+private:
+    RenderAnchor anchor_;
+    std::vector<ChainInfo> chains_;
+    std::vector<RenderAnchor> chainAnchors_;        // 按链下标，残基球与链表面的参考点
+    std::vector<SphereInstance> residueSpheres_;    // 按残基下标，相对所在链的锚点
+    std::vector<SphereInstance> chainBlobs_;        // 按链下标
+    std::vector<MeshLod> surfaces_;                 // 按链下标，相对链的锚点，顶点 atomIds 为残基下标
+    AabbArray chainBounds_;                         // 链包围球的外接盒，供视锥剔除
+    std::vector<uint32_t> inFrustum_;
+    std::vector<uint32_t> unoccluded_;
+    std::vector<Selection> selection_;
+    std::vector<uint32_t> visible_[4];              // 按 LodLevel 分组的链下标
+
+    float atomPixels_ = 3.0f;
+    float residuePixels_ = 3.0f;
+    float blobPixels_ = 8.0f;
+    float hysteresis_ = 0.15f;
+    float surfacePixelError_ = 1.0f;
+    size_t maxPrimitives_ = 20000000;
+    float surfaceSpacing_ = 2.0f;
+    bool buildSurfaces_ = true;
+
+    size_t primitives_ = 0;
+    double buildMs_ = 0.0;
+    double selectMs_ = 0.0;
+
+    size_t primitiveCount(size_t chain, const Selection& s) const;
+public:
+    StructureLod() {
+
+    }
+
+    // 各表示切换的投影大小阈值（像素）
+    void setPixelThresholds(float atomPixels, float residuePixels, float blobPixels) {
+        atomPixels_ = atomPixels;
+        residuePixels_ = residuePixels;
+        blobPixels_ = blobPixels;
+    }
+    void setHysteresis(float fraction) {
+        hysteresis_ = fraction;
+    }
+    // 表面级的选择：简化误差投影不超过该像素数
+    void setSurfacePixelError(float pixels) {
+        surfacePixelError_ = pixels;
+    }
+    // 可见图元数上限
+    void setMaxPrimitives(size_t count) {
+        maxPrimitives_ = count;
+    }
+    // 链表面的格距（埃）；setBuildSurfaces(false) 时不生成表面，Surface 级退化为链球
+    void setSurfaceSpacing(float spacing) {
+        surfaceSpacing_ = spacing;
+    }
+    void setBuildSurfaces(bool enabled) {
+        buildSurfaces_ = enabled;
+    }
+
+    // 预计算残基球、链球与链表面。颜色取元素颜色的平均
+    void build(const AtomTable& atoms);
+    // 为每条链选表示。fovY 为纵向视角（弧度），viewportHeight 为视口高度（像素）；
+    // culler 不为空时先做视锥剔除（调用方已调用过 setCamera(camera, projection, anchor())）；
+    // occlusion 不为空时再剔除被挡住的链（调用方已用 beginFrame(camera, projection, anchor()) 开始本帧，
+    // 加好遮挡体并调用过 buildPyramid）。
+    // 链表面不能作为遮挡体：高斯表面本来就比原子的并大，QEM 简化后的级又会偏离 errors[l]，
+    // 画成原子或更细一级的链透过缝隙可见的部分会被错误剔除。遮挡体应当是确实被原子填满的实心代理
+    // （OcclusionCuller::addSphereOccluder 传填满的半径）
+    void select(const Camera& camera, float fovY, float viewportHeight, FrustumCuller* culler = nullptr,
+        OcclusionCuller* occlusion = nullptr);
+
+    const RenderAnchor& anchor() const {
+        return anchor_;
+    }
+    size_t chainCount() const {
+        return chains_.size();
+    }
+    const ChainInfo& chain(size_t c) const {
+        return chains_[c];
+    }
+    const RenderAnchor& chainAnchor(size_t c) const {
+        return chainAnchors_[c];
+    }
+    const std::vector<SphereInstance>& residueSpheres() const {
+        return residueSpheres_;
+    }
+    const std::vector<SphereInstance>& chainBlobs() const {
+        return chainBlobs_;
+    }
+    const MeshLod& surface(size_t c) const {
+        return surfaces_[c];
+    }
+    const Selection& selection(size_t c) const {
+        return selection_[c];
+    }
+    const AabbArray& chainBounds() const {
+        return chainBounds_;
+    }
+    // 最近一次 select 中使用 level 表示的可见链
+    const std::vector<uint32_t>& visibleChains(LodLevel level) const {
+        return visible_[size_t(level)];
+    }
+    // 最近一次 select 中画残基球的链，每条一段（残基下标范围与链的锚点），
+    // 与 residueSpheres() 一起交给 SphereImpostor::setInstances / setBatches
+    void residueBatches(std::vector<SphereBatch>& batches) const;
+    // 最近一次 select 的总图元数
+    size_t lastPrimitives() const {
+        return primitives_;
+    }
+    double lastBuildMs() const {
+        return buildMs_;
+    }
+    double lastSelectMs() const {
+        return selectMs_;
+    }
+};
@@ -0,0 +1,67 @@
+﻿// TrajectoryReader v 1.0
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "RandomAccessFile.h"
+
+// 一帧坐标：SoA 存放，单位埃，顺序与 AtomTable 的原子一致。
+// 反复读帧时复用同一个对象，数组只在原子数变化时重新分配
+struct TrajectoryFrame {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    float box[9] = {};          // 盒子向量（行主序，埃），没有盒子时为 0
+    int64_t step = 0;
+    float time = 0.0f;          // ps
+    size_t index = size_t(-1);  // 帧号，未读取时为 -1
+
+    void resize(size_t atomCount) {
+        x.resize(atomCount);
+        y.resize(atomCount);
+        z.resize(atomCount);
+    }
+    size_t atomCount() const {
+        return x.size();
+    }
+};
+
+// 轨迹读取接口：打开时建立帧索引，之后可以按帧号随机读取。
+// 每帧在文件中占一段连续字节（frameExtent），读取与解码（decodeFrame）分开，
+// 这样既可以同步读取，也可以由异步 I/O（见 FramePrefetcher）读好原始字节后再解码。
+// frameExtent / decodeFrame / readFrame 都必须是线程安全的
+class TrajectoryReader {
+protected:
+    RandomAccessFile file_;
+    std::string error_;
+public:
+    virtual ~TrajectoryReader() {
+
+    }
+
+    virtual bool open(const std::string& path) = 0;
+    virtual void close() = 0;
+
+    virtual size_t frameCount() const = 0;
+    virtual size_t atomCount() const = 0;
+
+    // 第 index 帧原始数据的偏移和长度
+    virtual bool frameExtent(size_t index, uint64_t& offset, size_t& size) const = 0;
+    // 从原始字节解码第 index 帧
+    virtual bool decodeFrame(size_t index, const uint8_t* data, size_t size, TrajectoryFrame& out) const = 0;
+
+    // 同步读取并解码第 index 帧
+    bool readFrame(size_t index, TrajectoryFrame& out) const;
+    // 在线程池上并行读取 [first, first + count) 帧到 out[0..count)
+    bool readFrames(size_t first, size_t count, TrajectoryFrame* out) const;
+
+    const RandomAccessFile& file() const {
+        return file_;
+    }
+    // open 失败时的原因
+    const std::string& lastError() const {
+        return error_;
+    }
+};
@@ -0,0 +1,36 @@
+﻿// TrrReader v 1.0
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TrajectoryReader.h"
+
+// GROMACS TRR 轨迹读取（XDR 大端，单精度或双精度）。
+// TRR 的帧可以只含速度或力，打开时沿帧头跳读一遍，只为含坐标的帧建立索引。
+// 坐标由 nm 换算为埃
+class TrrReader : public TrajectoryReader {
+private:
+    struct FrameEntry {
+        uint64_t offset;
+        uint64_t size;          // 读到坐标数组末尾为止，速度和力不读
+    };
+    std::vector<FrameEntry> frames_;
+    size_t atomCount_ = 0;
+public:
+    TrrReader() {
+
+    }
+
+    bool open(const std::string& path) override;
+    void close() override;
+
+    size_t frameCount() const override {
+        return frames_.size();
+    }
+    size_t atomCount() const override {
+        return atomCount_;
+    }
+
+    bool frameExtent(size_t index, uint64_t& offset, size_t& size) const override;
+    bool decodeFrame(size_t index, const uint8_t* data, size_t size, TrajectoryFrame& out) const override;
+};
@@ -0,0 +1,50 @@
+﻿// VertexFormat v 1.1
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Mesh.h"
+
+// 压缩顶点，16 字节。Mesh 的 float 布局为位置 12 + 法线 12 + atomId 4 = 28 字节，压缩后为其 1/1.75：
+//   位置：unorm16x3，相对网格 AABB 归一化，每轴误差不超过 extent / 131070；
+//   法线：八面体编码后 snorm16x2，取量化后误差最小的格点，角度误差小于 0.01 度；
+//   atomId：原样保留。颜色不进顶点，着色器按 atomId 从 AtomBuffers 的颜色纹理缓冲读取（与 BondImpostor 相同），
+//   换配色不必重新打包上传，拾取也能从顶点回到原子。
+// 位置后的 2 字节不是数据，只让法线和 atomId 保持 4 字节对齐（GL 属性读取的常见要求），着色器不读取。
+// 再小就要丢东西：按 4 字节对齐，下一档是 12 字节（2.33 倍），只能把法线降到 snorm8x2（误差约 0.6 度，
+// 高光上可见）或把 atomId 降到 16 位（大组装体远超 65535 个原子），所以停在 16 字节。
+// 打包用 glm 的 packUnorm4x16 / packSnorm2x16，与 GLSL 的归一化读取一致
+struct PackedVertex {
+    uint16_t position[3];
+    uint16_t reserved;
+    uint32_t normal;
+    uint32_t atomId;
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay tightly packed");
+
+struct PackedMesh {
+    std::vector<PackedVertex> vertices;
+    std::vector<uint32_t> indices;
+    float origin[3] = { 0.0f, 0.0f, 0.0f };     // 位置 = origin + unorm * extent（着色器 uniform）
+    float extent[3] = { 0.0f, 0.0f, 0.0f };
+
+    size_t vertexBytes() const {
+        return vertices.size() * sizeof(PackedVertex);
+    }
+};
+
+// 单位向量的八面体编码（snorm16x2）与解码
+uint32_t encodeOctahedral(const glm::vec3& normal);
+glm::vec3 decodeOctahedral(uint32_t packed);
+
+// 打包网格，atomIds 原样保留
+void packMesh(const Mesh& mesh, PackedMesh& out);
+// 解码回 float 布局，用于检查误差或 CPU 端处理
+void unpackMesh(const PackedMesh& packed, Mesh& out);
+glm::vec3 unpackPosition(const PackedMesh& packed, size_t vertex);
+
+// 需要 GL 上下文：按 PackedVertex 布局为当前绑定的 GL_ARRAY_BUFFER 设置属性（见 shaders/packed_mesh.vert）
+void setPackedVertexAttribs(unsigned int positionAttrib, unsigned int normalAttrib, unsigned int atomIdAttrib);
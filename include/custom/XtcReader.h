@@ -0,0 +1,39 @@
+﻿// XtcReader v 1.0
+#pragma once
+
+#include <string>
+#include <vector>
+#include "TrajectoryReader.h"
+
+// GROMACS XTC 轨迹读取。
+// 打开时沿帧头跳读一遍建立帧偏移索引（只读每帧约 92 字节的头），
+// 并写到旁路文件 <path>.idx；下次打开时只要文件大小和原子数一致就直接加载索引。
+// 每帧的 xdr3dfcoord 压缩数据由 decodeFrame 独立解码，可以多线程并行。
+// 坐标由 nm 换算为埃
+class XtcReader : public TrajectoryReader {
+private:
+    std::vector<uint64_t> offsets_;     // 每帧的起始偏移，末尾额外存放文件大小
+    size_t atomCount_ = 0;
+
+    bool buildIndex();
+    bool loadIndex(const std::string& path);
+    void saveIndex(const std::string& path) const;
+public:
+    XtcReader() {
+
+    }
+
+    bool open(const std::string& path) override;
+    void close() override;
+
+    size_t frameCount() const override {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+    size_t atomCount() const override {
+        return atomCount_;
+    }
+
+    bool frameExtent(size_t index, uint64_t& offset, size_t& size) const override;
+    bool decodeFrame(size_t index, const uint8_t* data, size_t size, TrajectoryFrame& out) const override;
+};
+
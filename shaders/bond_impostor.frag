@@ -0,0 +1,56 @@
+#version 330 core
+// 从相机（视空间原点）沿 vPoint 方向与有限圆柱（含平底端面）求交，
+// 写出真实深度；交点在键中点之前取第一个原子的颜色，之后取第二个
+
+in vec3 vPoint;
+flat in vec3 vA;
+flat in vec3 vB;
+flat in vec4 vColorA;
+flat in vec4 vColorB;
+
+uniform mat4 uProjection;
+uniform float uRadius;
+
+out vec4 fragColor;
+
+void main() {
+    vec3 ray = normalize(vPoint);
+    vec3 ba = vB - vA;
+    vec3 oc = -vA;
+    float baba = dot(ba, ba);
+    float bard = dot(ba, ray);
+    float baoc = dot(ba, oc);
+    float k2 = baba - bard * bard;
+    float k1 = baba * dot(oc, ray) - baoc * bard;
+    float k0 = baba * dot(oc, oc) - baoc * baoc - uRadius * uRadius * baba;
+    float h = k1 * k1 - k2 * k0;
+    if (h < 0.0) discard;
+    h = sqrt(h);
+
+    // 侧面
+    float t = (-k1 - h) / k2;
+    float y = baoc + t * bard;
+    vec3 normal;
+    if (y > 0.0 && y < baba) {
+        normal = (oc + t * ray - ba * (y / baba)) / uRadius;
+    }
+    else {
+        // 端面
+        float cap = y < 0.0 ? 0.0 : baba;
+        t = (cap - baoc) / bard;
+        if (abs(k1 + k2 * t) >= h) discard;
+        y = cap;
+        normal = ba * sign(y - 0.5 * baba) * inversesqrt(baba);
+    }
+    if (t <= 0.0) discard;
+    vec3 hit = ray * t;
+
+    vec4 clip = uProjection * vec4(hit, 1.0);
+    float ndcDepth = clip.z / clip.w;
+    gl_FragDepth = 0.5 * (gl_DepthRange.diff * ndcDepth + gl_DepthRange.near + gl_DepthRange.far);
+
+    vec4 color = y < 0.5 * baba ? vColorA : vColorB;
+    float diffuse = abs(dot(normal, -ray));
+    float specular = pow(max(2.0 * diffuse * diffuse - 1.0, 0.0), 32.0);
+    fragColor = vec4(color.rgb * (0.25 + 0.75 * diffuse) + vec3(0.3) * specular, color.a);
+}
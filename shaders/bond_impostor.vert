@@ -0,0 +1,54 @@
+#version 330 core
+// 键的圆柱冒名顶替体：每个实例只有两个原子下标，端点与颜色从纹理缓冲读取，
+// 画一个沿键轴、横截面边长为直径的长方体，恰好包住圆柱；求交在片段着色器中完成。
+// 端点是相对所在块锚点的坐标，加上块偏移后乘 uModelView（Camera::getRenderView）变换到视空间，
+// 键两端的原子可以在不同的块里
+
+layout(location = 0) in vec3 aCorner;   // x、y 属于 [-1, 1]，z 属于 [0, 1]
+layout(location = 1) in uvec2 aBond;
+
+uniform samplerBuffer uPositions;       // xyz 相对所在块锚点的坐标，w 范德华半径
+uniform samplerBuffer uColors;          // RGBA8
+uniform usamplerBuffer uAtomBlocks;     // 原子所在块
+uniform samplerBuffer uBlockOffsets;    // xyz 块锚点相对渲染原点的偏移
+uniform mat4 uModelView;
+uniform mat4 uProjection;
+uniform float uRadius;
+
+out vec3 vPoint;                        // 长方体表面上的点（视空间），即视线方向
+flat out vec3 vA;
+flat out vec3 vB;
+flat out vec4 vColorA;
+flat out vec4 vColorB;
+
+// 原子相对渲染原点的坐标
+vec3 atomPosition(int atom) {
+    return texelFetch(uPositions, atom).xyz + texelFetch(uBlockOffsets, int(texelFetch(uAtomBlocks, atom).r)).xyz;
+}
+
+void main() {
+    int ia = int(aBond.x);
+    int ib = int(aBond.y);
+    vec3 a = (uModelView * vec4(atomPosition(ia), 1.0)).xyz;
+    vec3 b = (uModelView * vec4(atomPosition(ib), 1.0)).xyz;
+    vA = a;
+    vB = b;
+    vColorA = texelFetch(uColors, ia);
+    vColorB = texelFetch(uColors, ib);
+
+    vec3 axis = b - a;
+    float length2 = dot(axis, axis);
+    if (length2 < 1e-12) {
+        // 两端重合：整个实例丢到裁剪空间外
+        vPoint = a;
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    vec3 w = axis * inversesqrt(length2);
+    vec3 helper = abs(w.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 u = normalize(cross(helper, w));
+    vec3 v = cross(w, u);
+    vec3 p = a + (u * aCorner.x + v * aCorner.y) * uRadius + axis * aCorner.z;
+    vPoint = p;
+    gl_Position = uProjection * vec4(p, 1.0);
+}
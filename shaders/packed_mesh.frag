@@ -0,0 +1,16 @@
+#version 330 core
+
+in vec3 vPoint;
+in vec3 vNormal;
+in vec4 vColor;
+
+out vec4 fragColor;
+
+void main() {
+    vec3 ray = normalize(vPoint);
+    vec3 normal = normalize(vNormal);
+    // 头灯：光源与相机重合
+    float diffuse = max(dot(normal, -ray), 0.0);
+    float specular = pow(max(2.0 * diffuse * diffuse - 1.0, 0.0), 32.0);
+    fragColor = vec4(vColor.rgb * (0.25 + 0.75 * diffuse) + vec3(0.3) * specular, vColor.a);
+}
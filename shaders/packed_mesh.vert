@@ -0,0 +1,35 @@
+#version 330 core
+// 压缩顶点格式（VertexFormat.h）的网格：位置按 AABB 反量化，法线做八面体解码，颜色按 atomId 从纹理缓冲读取。
+// 位置相对网格所属对象的锚点，uModelView 取 RenderAnchor::modelView(camera)
+
+layout(location = 0) in vec3 aPosition;    // unorm16x3
+layout(location = 1) in vec2 aNormal;      // snorm16x2，八面体编码
+layout(location = 2) in uint aAtomId;
+
+uniform samplerBuffer uColors;             // RGBA8，AtomBuffers 的颜色
+uniform vec3 uOrigin;
+uniform vec3 uExtent;
+uniform mat4 uModelView;
+uniform mat4 uProjection;
+
+out vec3 vPoint;                           // 视空间
+out vec3 vNormal;
+out vec4 vColor;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    vec3 p = uOrigin + aPosition.xyz * uExtent;
+    vec4 view = uModelView * vec4(p, 1.0);
+    vPoint = view.xyz;
+    // 模型视图矩阵是刚体变换，法线直接用左上 3x3
+    vNormal = mat3(uModelView) * decodeOctahedral(aNormal);
+    vColor = texelFetch(uColors, int(aAtomId));
+    gl_Position = uProjection * view;
+}
@@ -0,0 +1,30 @@
+#version 330 core
+// 从相机（视空间原点）沿 vPoint 方向对球求交，写出真实的深度与法线
+
+in vec3 vPoint;
+flat in vec3 vCenter;
+flat in float vRadius;
+flat in vec4 vColor;
+
+uniform mat4 uProjection;
+
+out vec4 fragColor;
+
+void main() {
+    vec3 ray = normalize(vPoint);
+    float b = dot(ray, vCenter);
+    float c = dot(vCenter, vCenter) - vRadius * vRadius;
+    float disc = b * b - c;
+    if (disc < 0.0) discard;
+    vec3 hit = ray * (b - sqrt(disc));
+    vec3 normal = (hit - vCenter) / vRadius;
+
+    vec4 clip = uProjection * vec4(hit, 1.0);
+    float ndcDepth = clip.z / clip.w;
+    gl_FragDepth = 0.5 * (gl_DepthRange.diff * ndcDepth + gl_DepthRange.near + gl_DepthRange.far);
+
+    // 头灯：光源与相机重合
+    float diffuse = max(dot(normal, -ray), 0.0);
+    float specular = pow(max(2.0 * diffuse * diffuse - 1.0, 0.0), 32.0);
+    fragColor = vec4(vColor.rgb * (0.25 + 0.75 * diffuse) + vec3(0.3) * specular, vColor.a);
+}
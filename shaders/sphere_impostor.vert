@@ -0,0 +1,57 @@
+#version 330 core
+// 原子球冒名顶替体：每个实例一个四边形，垂直于相机到球心的方向，
+// 大小恰好覆盖球在透视投影下的轮廓；求交在片段着色器中完成。
+// uFromAtoms 为真时实例号即原子下标，球心、半径和颜色从 AtomBuffers 的纹理缓冲读取，
+// 球心相对所在块的锚点，加上块偏移后是相对渲染原点的坐标，uModelView 为 Camera::getRenderView；
+// 否则来自实例属性，球心相对这一批的锚点，uModelView 为该锚点的 modelView。GPU 上只有小数值
+
+layout(location = 0) in vec2 aCorner;
+layout(location = 1) in vec4 aSphere;   // xyz 球心（相对锚点），w 半径
+layout(location = 2) in vec4 aColor;
+
+uniform samplerBuffer uPositions;       // xyz 相对所在块锚点的坐标，w 半径
+uniform samplerBuffer uColors;          // RGBA8
+uniform usamplerBuffer uAtomBlocks;     // 原子所在块
+uniform samplerBuffer uBlockOffsets;    // xyz 块锚点相对渲染原点的偏移
+uniform bool uFromAtoms;
+uniform mat4 uModelView;
+uniform mat4 uProjection;
+uniform float uRadiusScale;
+
+out vec3 vPoint;                        // 四边形上的点（视空间），即视线方向
+flat out vec3 vCenter;
+flat out float vRadius;
+flat out vec4 vColor;
+
+void main() {
+    vec4 sphere = aSphere;
+    vec4 color = aColor;
+    if (uFromAtoms) {
+        sphere = texelFetch(uPositions, gl_InstanceID);
+        sphere.xyz += texelFetch(uBlockOffsets, int(texelFetch(uAtomBlocks, gl_InstanceID).r)).xyz;
+        color = texelFetch(uColors, gl_InstanceID);
+    }
+    vec3 center = (uModelView * vec4(sphere.xyz, 1.0)).xyz;
+    float radius = sphere.w * uRadiusScale;
+    vCenter = center;
+    vRadius = radius;
+    vColor = color;
+
+    float d2 = dot(center, center);
+    float r2 = radius * radius;
+    if (d2 <= r2) {
+        // 相机在球内：整个实例丢到裁剪空间外
+        vPoint = center;
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+    // 视锥与球相切，切点圆在过球心平面上的半径为 r * d / sqrt(d^2 - r^2)
+    vec3 dir = center * inversesqrt(d2);
+    vec3 helper = abs(dir.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(helper, dir));
+    vec3 up = cross(dir, right);
+    float extent = radius * sqrt(d2 / (d2 - r2));
+    vec3 p = center + (right * aCorner.x + up * aCorner.y) * extent;
+    vPoint = p;
+    gl_Position = uProjection * vec4(p, 1.0);
+}
@@ -0,0 +1,251 @@
+﻿// AtomBuffers v 1.3
+#include <glad/glad.h>
+#include "AtomBuffers.h"
+#include "Element.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+    // 分块的格子边长（埃）
+    const double kBlockSize = 2048.0;
+
+    // 格子坐标每维 21 位（带符号偏移），覆盖 +-2e9 埃
+    uint64_t cellKey(double x, double y, double z) {
+        const int64_t bias = int64_t(1) << 20;
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        const uint64_t cx = uint64_t(int64_t(std::floor(x / kBlockSize)) + bias) & mask;
+        const uint64_t cy = uint64_t(int64_t(std::floor(y / kBlockSize)) + bias) & mask;
+        const uint64_t cz = uint64_t(int64_t(std::floor(z / kBlockSize)) + bias) & mask;
+        return (cx << 42) | (cy << 21) | cz;
+    }
+
+    glm::dvec3 cellCenter(uint64_t key) {
+        const int64_t bias = int64_t(1) << 20;
+        const uint64_t mask = (uint64_t(1) << 21) - 1;
+        const double cx = double(int64_t((key >> 42) & mask) - bias);
+        const double cy = double(int64_t((key >> 21) & mask) - bias);
+        const double cz = double(int64_t(key & mask) - bias);
+        return (glm::dvec3(cx, cy, cz) + 0.5) * kBlockSize;
+    }
+}
+
+void AtomBuffers::pack(const AtomTable& atoms) {
+    size_t n = atoms.atomCount();
+    positions_.resize(4 * n);
+    colors_.resize(n);
+    atomBlocks_.resize(n);
+
+    // 分块：格子坐标并行算，编号串行分配（相邻原子通常在同一格，先和上一个比较）
+    std::vector<uint64_t> keys(n);
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) keys[i] = cellKey(atoms.x[i], atoms.y[i], atoms.z[i]);
+    }, 16384);
+    blocks_.clear();
+    std::unordered_map<uint64_t, uint32_t> blockOf;
+    uint64_t previousKey = 0;
+    uint32_t previousBlock = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i == 0 || keys[i] != previousKey) {
+            auto inserted = blockOf.insert(std::make_pair(keys[i], uint32_t(blocks_.size())));
+            if (inserted.second) blocks_.push_back(RenderAnchor(cellCenter(keys[i])));
+            previousKey = keys[i];
+            previousBlock = inserted.first->second;
+        }
+        atomBlocks_[i] = previousBlock;
+    }
+
+    float radius[256];
+    uint32_t color[256];
+    for (int e = 0; e < 256; ++e) {
+        radius[e] = vdwRadius(uint8_t(e));
+        color[e] = elementColor(uint8_t(e));
+    }
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) {
+            float* p = &positions_[4 * i];
+            const glm::dvec3& anchor = blocks_[atomBlocks_[i]].world;
+            uint8_t e = atoms.element[i];
+            p[0] = float(double(atoms.x[i]) - anchor.x);
+            p[1] = float(double(atoms.y[i]) - anchor.y);
+            p[2] = float(double(atoms.z[i]) - anchor.z);
+            p[3] = radius[e];
+            colors_[i] = color[e];
+        }
+    }, 4096);
+    positionsDirty_.clear();
+    colorsDirty_.clear();
+    positionsDirty_.mark(0, n, n);
+    colorsDirty_.mark(0, n, n);
+    blocksDirty_ = true;
+    blockOffsets_.assign(4 * blocks_.size(), 0.0f);
+    offsetsVersion_ = 0xFFFFFFFFu;
+}
+
+void AtomBuffers::updatePositions(const float* x, const float* y, const float* z, size_t begin, size_t end) {
+    end = std::min(end, atomCount());
+    if (begin >= end) return;
+    parallelFor(begin, end, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) {
+            float* p = &positions_[4 * i];
+            const glm::dvec3& anchor = blocks_[atomBlocks_[i]].world;
+            p[0] = float(double(x[i]) - anchor.x);
+            p[1] = float(double(y[i]) - anchor.y);
+            p[2] = float(double(z[i]) - anchor.z);
+        }
+    }, 4096);
+    positionsDirty_.mark(begin, end, atomCount());
+}
+
+void AtomBuffers::updateBlockOffsets(const Camera& camera) {
+    if (offsetsVersion_ == camera.originVersion()) return;
+    for (size_t b = 0; b < blocks_.size(); ++b) {
+        const glm::vec3 offset = camera.toRender(blocks_[b].world);
+        blockOffsets_[4 * b] = offset.x;
+        blockOffsets_[4 * b + 1] = offset.y;
+        blockOffsets_[4 * b + 2] = offset.z;
+    }
+    offsetsVersion_ = camera.originVersion();
+    if (offsetBuffer_ == 0) return;
+    glBindBuffer(GL_TEXTURE_BUFFER, offsetBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(blockOffsets_.size() * sizeof(float)), blockOffsets_.data(),
+        GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void AtomBuffers::setColor(size_t atom, uint32_t color) {
+    if (atom >= colors_.size()) return;
+    colors_[atom] = color;
+    colorsDirty_.mark(atom, atom + 1, atomCount());
+}
+
+void AtomBuffers::setRadius(size_t atom, float radius) {
+    if (atom >= colors_.size()) return;
+    positions_[4 * atom + 3] = radius;
+    positionsDirty_.mark(atom, atom + 1, atomCount());
+}
+
+void AtomBuffers::createGL() {
+    destroyGL();
+    glGenBuffers(1, &positionBuffer_);
+    glGenBuffers(1, &colorBuffer_);
+    glGenTextures(1, &positionTexture_);
+    glGenTextures(1, &colorTexture_);
+    glGenBuffers(1, &blockBuffer_);
+    glGenBuffers(1, &offsetBuffer_);
+    glGenTextures(1, &blockTexture_);
+    glGenTextures(1, &offsetTexture_);
+
+    // 纹理与缓冲的关联只需建立一次，之后 glBufferData 换存储也不影响
+    glBindBuffer(GL_TEXTURE_BUFFER, positionBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, positionTexture_);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, positionBuffer_);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, colorBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, colorTexture_);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA8, colorBuffer_);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, blockBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STATIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, blockTexture_);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, blockBuffer_);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, offsetBuffer_);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, offsetTexture_);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, offsetBuffer_);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    positionCapacity_ = 0;
+    colorCapacity_ = 0;
+    positionsDirty_.mark(0, atomCount(), atomCount());
+    colorsDirty_.mark(0, atomCount(), atomCount());
+    blocksDirty_ = true;
+    offsetsVersion_ = 0xFFFFFFFFu;
+}
+
+void AtomBuffers::destroyGL() {
+    if (positionTexture_ != 0) glDeleteTextures(1, &positionTexture_);
+    if (colorTexture_ != 0) glDeleteTextures(1, &colorTexture_);
+    if (positionBuffer_ != 0) glDeleteBuffers(1, &positionBuffer_);
+    if (colorBuffer_ != 0) glDeleteBuffers(1, &colorBuffer_);
+    if (blockTexture_ != 0) glDeleteTextures(1, &blockTexture_);
+    if (offsetTexture_ != 0) glDeleteTextures(1, &offsetTexture_);
+    if (blockBuffer_ != 0) glDeleteBuffers(1, &blockBuffer_);
+    if (offsetBuffer_ != 0) glDeleteBuffers(1, &offsetBuffer_);
+    positionTexture_ = 0;
+    colorTexture_ = 0;
+    positionBuffer_ = 0;
+    colorBuffer_ = 0;
+    blockTexture_ = 0;
+    offsetTexture_ = 0;
+    blockBuffer_ = 0;
+    offsetBuffer_ = 0;
+    positionCapacity_ = 0;
+    colorCapacity_ = 0;
+}
+
+void AtomBuffers::uploadRanges(unsigned int buffer, DirtyRanges& dirty, size_t& capacity, const void* data,
+    size_t elementSize, unsigned int usage) {
+    size_t n = atomCount();
+    if (dirty.empty() && n <= capacity) return;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if (n > capacity || dirty.count() * 2 > n) {
+        // 整体重传用 glBufferData：驱动换一块新存储，不等待上一帧对旧数据的读取
+        capacity = std::max(n, capacity);
+        glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(capacity * elementSize), nullptr, GLenum(usage));
+        if (n > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, GLsizeiptr(n * elementSize), bytes);
+        uploadBytes_ += n * elementSize;
+        uploadCalls_ += 2;
+    }
+    else {
+        for (const DirtyRanges::Range& r : dirty.ranges()) {
+            size_t size = size_t(r.end - r.begin) * elementSize;
+            glBufferSubData(GL_TEXTURE_BUFFER, GLintptr(r.begin * elementSize), GLsizeiptr(size),
+                bytes + r.begin * elementSize);
+            uploadBytes_ += size;
+            ++uploadCalls_;
+        }
+    }
+    dirty.clear();
+}
+
+void AtomBuffers::upload() {
+    uploadBytes_ = 0;
+    uploadCalls_ = 0;
+    if (positionBuffer_ == 0) return;
+    uploadRanges(positionBuffer_, positionsDirty_, positionCapacity_, positions_.data(), 4 * sizeof(float),
+        GL_DYNAMIC_DRAW);
+    uploadRanges(colorBuffer_, colorsDirty_, colorCapacity_, colors_.data(), sizeof(uint32_t), GL_STATIC_DRAW);
+    if (blocksDirty_) {
+        // 分块只在 pack 时变，整体重传
+        glBindBuffer(GL_TEXTURE_BUFFER, blockBuffer_);
+        glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(atomBlocks_.size() * sizeof(uint32_t)), atomBlocks_.data(),
+            GL_STATIC_DRAW);
+        uploadBytes_ += atomBlocks_.size() * sizeof(uint32_t);
+        ++uploadCalls_;
+        blocksDirty_ = false;
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void AtomBuffers::bind(unsigned int positionUnit, unsigned int colorUnit) const {
+    glActiveTexture(GL_TEXTURE0 + positionUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, positionTexture_);
+    glActiveTexture(GL_TEXTURE0 + colorUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, colorTexture_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void AtomBuffers::bindBlocks(unsigned int blockUnit, unsigned int offsetUnit) const {
+    glActiveTexture(GL_TEXTURE0 + blockUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, blockTexture_);
+    glActiveTexture(GL_TEXTURE0 + offsetUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, offsetTexture_);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,89 @@
+﻿// AtomTable v 1.0
+#include "AtomTable.h"
+#include <algorithm>
+#include <unordered_map>
+
+void buildResidues(AtomTable& table, const int32_t* seq, const char* insertion, const uint32_t* residueName,
+    const uint32_t* chainName, const uint32_t* chainKey) {
+    table.residues.clear();
+    table.chains.clear();
+    size_t count = table.atomCount();
+    for (size_t a = 0; a < count; ++a) {
+        bool newChain = a == 0 || chainKey[a] != chainKey[a - 1];
+        bool newResidue = newChain || seq[a] != seq[a - 1] || insertion[a] != insertion[a - 1] ||
+            residueName[a] != residueName[a - 1];
+        if (newChain) {
+            Chain chain;
+            chain.id = chainName[a];
+            chain.firstResidue = static_cast<uint32_t>(table.residues.size());
+            table.chains.push_back(chain);
+        }
+        if (newResidue) {
+            Residue r;
+            r.name = residueName[a];
+            r.seq = seq[a];
+            r.insertion = insertion[a];
+            r.chain = static_cast<int32_t>(table.chains.size() - 1);
+            r.firstAtom = static_cast<uint32_t>(a);
+            table.residues.push_back(r);
+            table.chains.back().residueCount++;
+        }
+        table.residues.back().atomCount++;
+        table.residueIndex[a] = static_cast<int32_t>(table.residues.size() - 1);
+        table.chainIndex[a] = static_cast<int32_t>(table.chains.size() - 1);
+    }
+}
+
+void applySecondaryStructure(AtomTable& table, const std::vector<SecondaryStructureRange>& ranges) {
+    if (ranges.empty()) return;
+
+    // (链, 序号) -> 第一个匹配残基；插入码在其后顺序查找
+    std::unordered_map<uint64_t, uint32_t> lookup;
+    lookup.reserve(table.residues.size());
+    for (size_t i = 0; i < table.residues.size(); ++i) {
+        const Residue& r = table.residues[i];
+        uint64_t key = (uint64_t(table.chains[size_t(r.chain)].id) << 32) | uint32_t(r.seq);
+        lookup.emplace(key, uint32_t(i));
+    }
+
+    auto find = [&](uint32_t chain, int32_t seq, char insertion) -> int64_t {
+        auto it = lookup.find((uint64_t(chain) << 32) | uint32_t(seq));
+        if (it == lookup.end()) return -1;
+        for (size_t i = it->second; i < table.residues.size(); ++i) {
+            const Residue& r = table.residues[i];
+            if (r.seq != seq || table.chains[size_t(r.chain)].id != chain) break;
+            if (r.insertion == insertion) return int64_t(i);
+        }
+        return -1;
+    };
+
+    for (const SecondaryStructureRange& s : ranges) {
+        int64_t b = find(s.chain, s.beginSeq, s.beginInsertion);
+        int64_t e = find(s.chain, s.endSeq, s.endInsertion);
+        if (b < 0 || e < b) continue;
+        for (int64_t i = b; i <= e; ++i) {
+            table.residues[size_t(i)].ss = s.type;
+        }
+    }
+}
+
+bool atomBounds(const AtomTable& table, float lo[3], float hi[3]) {
+    const size_t count = table.atomCount();
+    for (int d = 0; d < 3; ++d) {
+        lo[d] = 0.0f;
+        hi[d] = 0.0f;
+    }
+    if (count == 0) return false;
+    lo[0] = hi[0] = table.x[0];
+    lo[1] = hi[1] = table.y[0];
+    lo[2] = hi[2] = table.z[0];
+    for (size_t a = 1; a < count; ++a) {
+        lo[0] = std::min(lo[0], table.x[a]);
+        hi[0] = std::max(hi[0], table.x[a]);
+        lo[1] = std::min(lo[1], table.y[a]);
+        hi[1] = std::max(hi[1], table.y[a]);
+        lo[2] = std::min(lo[2], table.z[a]);
+        hi[2] = std::max(hi[2], table.z[a]);
+    }
+    return true;
+}
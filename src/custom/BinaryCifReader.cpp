@@ -0,0 +1,541 @@
+﻿// BinaryCifReader v 1.0
+#include "BinaryCifReader.h"
+#include "BinaryCodec.h"
+#include "Element.h"
+#include "FastNumber.h"
+#include "Parallel.h"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    typedef MsgPackDocument::Ref Ref;
+
+    // ByteArray 的类型码
+    enum ByteType {
+        Int8 = 1, Int16 = 2, Int32 = 3, Uint8 = 4, Uint16 = 5, Uint32 = 6, Float32 = 32, Float64 = 33
+    };
+
+    size_t byteTypeSize(int type) {
+        switch (type) {
+        case Int8: case Uint8: return 1;
+        case Int16: case Uint16: return 2;
+        case Int32: case Uint32: case Float32: return 4;
+        case Float64: return 8;
+        default: return 0;
+        }
+    }
+
+    // 解码链的中间状态：ByteArray 之后先保留原始字节，
+    // 以便紧随其后的 IntegerPacking 直接在 int8/int16 上做向量化解包
+    struct DecodeState {
+        enum class Kind { Raw, Int, Float, String };
+        Kind kind = Kind::Raw;
+        const uint8_t* raw = nullptr;
+        size_t rawSize = 0;
+        int rawType = 0;
+        std::vector<int32_t> ints;
+        std::vector<float> floats;
+        std::vector<std::string_view> strings;
+    };
+
+    template <typename T>
+    void convertRaw(const uint8_t* p, size_t count, int32_t* out) {
+        for (size_t i = 0; i < count; ++i) {
+            T v;
+            std::memcpy(&v, p + i * sizeof(T), sizeof(T));
+            out[i] = static_cast<int32_t>(v);
+        }
+    }
+
+    bool toInts(DecodeState& s) {
+        if (s.kind == DecodeState::Kind::Int) return true;
+        if (s.kind != DecodeState::Kind::Raw) return false;
+        size_t width = byteTypeSize(s.rawType);
+        if (width == 0) return false;
+        size_t count = s.rawSize / width;
+        s.ints.resize(count);
+        switch (s.rawType) {
+        case Int8: convertRaw<int8_t>(s.raw, count, s.ints.data()); break;
+        case Uint8: convertRaw<uint8_t>(s.raw, count, s.ints.data()); break;
+        case Int16: convertRaw<int16_t>(s.raw, count, s.ints.data()); break;
+        case Uint16: convertRaw<uint16_t>(s.raw, count, s.ints.data()); break;
+        case Int32: case Uint32: std::memcpy(s.ints.data(), s.raw, count * 4); break;
+        default: return false;
+        }
+        s.kind = DecodeState::Kind::Int;
+        return true;
+    }
+
+    bool toFloats(DecodeState& s) {
+        if (s.kind == DecodeState::Kind::Float) return true;
+        if (s.kind == DecodeState::Kind::Raw && (s.rawType == Float32 || s.rawType == Float64)) {
+            size_t width = byteTypeSize(s.rawType);
+            size_t count = s.rawSize / width;
+            s.floats.resize(count);
+            if (s.rawType == Float32) {
+                std::memcpy(s.floats.data(), s.raw, count * 4);
+            }
+            else {
+                for (size_t i = 0; i < count; ++i) {
+                    double d;
+                    std::memcpy(&d, s.raw + i * 8, 8);
+                    s.floats[i] = static_cast<float>(d);
+                }
+            }
+            s.kind = DecodeState::Kind::Float;
+            return true;
+        }
+        if (!toInts(s)) return false;
+        s.floats.assign(s.ints.begin(), s.ints.end());
+        s.kind = DecodeState::Kind::Float;
+        return true;
+    }
+
+    bool decodeChain(const uint8_t* bytes, size_t size, Ref encodings, size_t maxCount, DecodeState& s);
+
+    // srcSize 来自文件，不可信：超过 maxCount（类别行数）的直接判为损坏，不按它分配内存
+    bool readSrcSize(Ref e, size_t maxCount, size_t& srcSize) {
+        int64_t v = e["srcSize"].asInt();
+        if (v < 0 || uint64_t(v) > maxCount) return false;
+        srcSize = size_t(v);
+        return true;
+    }
+
+    bool integerPacking(Ref e, size_t maxCount, DecodeState& s) {
+        int byteCount = int(e["byteCount"].asInt());
+        bool isUnsigned = e["isUnsigned"].asBool();
+        size_t srcSize;
+        if (!readSrcSize(e, maxCount, srcSize)) return false;
+        std::vector<int32_t> out(srcSize);
+        size_t written = 0;
+
+        if (s.kind == DecodeState::Kind::Raw && byteCount == 1 && (s.rawType == Int8 || s.rawType == Uint8)) {
+            if (isUnsigned) written = unpackUint8(s.raw, s.rawSize, out.data(), srcSize);
+            else written = unpackInt8(reinterpret_cast<const int8_t*>(s.raw), s.rawSize, out.data(), srcSize);
+        }
+        else if (s.kind == DecodeState::Kind::Raw && byteCount == 2 && (s.rawType == Int16 || s.rawType == Uint16)) {
+            size_t count = s.rawSize / 2;
+            // 消息包中的二进制块不保证 2 字节对齐
+            std::vector<uint16_t> aligned(count);
+            std::memcpy(aligned.data(), s.raw, count * 2);
+            if (isUnsigned) written = unpackUint16(aligned.data(), count, out.data(), srcSize);
+            else written = unpackInt16(reinterpret_cast<const int16_t*>(aligned.data()), count, out.data(), srcSize);
+        }
+        else {
+            if (!toInts(s)) return false;
+            int32_t upper = isUnsigned ? (byteCount == 1 ? 0xFF : 0xFFFF) : (byteCount == 1 ? 0x7F : 0x7FFF);
+            int32_t lower = isUnsigned ? 0 : -upper - 1;
+            size_t i = 0;
+            while (i < s.ints.size() && written < srcSize) {
+                int32_t v = 0;
+                int32_t t = s.ints[i];
+                while ((t == upper || (!isUnsigned && t == lower)) && i + 1 < s.ints.size()) {
+                    v += t;
+                    t = s.ints[++i];
+                }
+                out[written++] = v + t;
+                ++i;
+            }
+        }
+        out.resize(written);
+        s.ints.swap(out);
+        s.kind = DecodeState::Kind::Int;
+        return true;
+    }
+
+    bool stringArray(Ref e, size_t maxCount, DecodeState& s) {
+        if (s.kind != DecodeState::Kind::Raw) return false;
+        DecodeState indices;
+        if (!decodeChain(s.raw, s.rawSize, e["dataEncoding"], maxCount, indices) || !toInts(indices)) return false;
+        std::string_view text = e["stringData"].asString();
+        // 字符串表最多每个字节一项，再加一个空串
+        Ref offsetsBin = e["offsets"];
+        DecodeState offsets;
+        if (!decodeChain(offsetsBin.bytes(), offsetsBin.byteCount(), e["offsetEncoding"], text.size() + 2, offsets) ||
+            !toInts(offsets)) {
+            return false;
+        }
+
+        s.strings.clear();
+        for (size_t i = 0; i + 1 < offsets.ints.size(); ++i) {
+            size_t b = size_t(offsets.ints[i]);
+            size_t en = size_t(offsets.ints[i + 1]);
+            s.strings.push_back(b <= en && en <= text.size() ? text.substr(b, en - b) : std::string_view());
+        }
+        s.ints.swap(indices.ints);
+        s.kind = DecodeState::Kind::String;
+        return true;
+    }
+
+    // 按编码列表从后往前依次解码
+    bool decodeChain(const uint8_t* bytes, size_t size, Ref encodings, size_t maxCount, DecodeState& s) {
+        s.kind = DecodeState::Kind::Raw;
+        s.raw = bytes;
+        s.rawSize = size;
+        s.rawType = 0;
+
+        std::vector<Ref> list;
+        for (Ref e = encodings.first(); list.size() < encodings.size(); e = e.nextSibling()) list.push_back(e);
+
+        for (size_t k = list.size(); k-- > 0;) {
+            Ref e = list[k];
+            std::string_view kind = e["kind"].asString();
+            if (kind == "ByteArray") {
+                if (s.kind != DecodeState::Kind::Raw) return false;
+                s.rawType = int(e["type"].asInt());
+                if (byteTypeSize(s.rawType) == 0) return false;
+            }
+            else if (kind == "IntegerPacking") {
+                if (!integerPacking(e, maxCount, s)) return false;
+            }
+            else if (kind == "Delta") {
+                if (!toInts(s)) return false;
+                deltaDecode(s.ints.data(), s.ints.size(), int32_t(e["origin"].asInt()));
+            }
+            else if (kind == "RunLength") {
+                if (!toInts(s)) return false;
+                size_t srcSize;
+                if (!readSrcSize(e, maxCount, srcSize)) return false;
+                std::vector<int32_t> out(srcSize);
+                out.resize(runLengthDecode(s.ints.data(), s.ints.size() / 2, out.data(), srcSize));
+                s.ints.swap(out);
+            }
+            else if (kind == "FixedPoint") {
+                if (!toInts(s)) return false;
+                s.floats.resize(s.ints.size());
+                fixedPointDecode(s.ints.data(), s.ints.size(), float(e["factor"].asDouble(1.0)), s.floats.data());
+                s.kind = DecodeState::Kind::Float;
+            }
+            else if (kind == "IntervalQuantization") {
+                if (!toInts(s)) return false;
+                s.floats.resize(s.ints.size());
+                intervalDecode(s.ints.data(), s.ints.size(), float(e["min"].asDouble()), float(e["max"].asDouble()),
+                    int32_t(e["numSteps"].asInt()), s.floats.data());
+                s.kind = DecodeState::Kind::Float;
+            }
+            else if (kind == "StringArray") {
+                if (!stringArray(e, maxCount, s)) return false;
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool decodeData(Ref data, size_t maxCount, BinaryCifColumn& out, bool intsOnly) {
+        DecodeState s;
+        Ref bin = data["data"];
+        if (!decodeChain(bin.bytes(), bin.byteCount(), data["encoding"], maxCount, s)) return false;
+
+        if (s.kind == DecodeState::Kind::Raw) {
+            bool isFloat = s.rawType == Float32 || s.rawType == Float64;
+            if (isFloat && !intsOnly) {
+                toFloats(s);
+            }
+            else if (!toInts(s)) {
+                return false;
+            }
+        }
+        switch (s.kind) {
+        case DecodeState::Kind::Int:
+            out.kind = BinaryCifColumn::Kind::Int;
+            out.ints.swap(s.ints);
+            break;
+        case DecodeState::Kind::Float:
+            if (intsOnly) {
+                out.kind = BinaryCifColumn::Kind::Int;
+                out.ints.assign(s.floats.begin(), s.floats.end());
+            }
+            else {
+                out.kind = BinaryCifColumn::Kind::Float;
+                out.floats.swap(s.floats);
+            }
+            break;
+        case DecodeState::Kind::String:
+            out.kind = BinaryCifColumn::Kind::String;
+            out.ints.swap(s.ints);
+            out.strings.swap(s.strings);
+            break;
+        default:
+            return false;
+        }
+        return true;
+    }
+
+    std::string_view stripUnderscore(std::string_view name) {
+        return (!name.empty() && name[0] == '_') ? name.substr(1) : name;
+    }
+
+    inline uint32_t packValue(std::string_view v) {
+        if (v == "." || v == "?") return 0;
+        return packName4(v.data(), v.size());
+    }
+
+    inline char insertionCode(std::string_view v) {
+        return (v.empty() || v == "." || v == "?") ? ' ' : v[0];
+    }
+
+    // 字符串列：对字符串表的每一项预先计算一次，逐原子只做查表
+    std::vector<uint32_t> packedTable(const BinaryCifColumn& c) {
+        std::vector<uint32_t> table(c.strings.size());
+        for (size_t i = 0; i < c.strings.size(); ++i) table[i] = packValue(c.strings[i]);
+        return table;
+    }
+
+    inline uint32_t packedAt(const BinaryCifColumn& c, const std::vector<uint32_t>& table, size_t row) {
+        if (c.kind == BinaryCifColumn::Kind::String) {
+            int32_t i = c.ints[row];
+            return (c.present(row) && i >= 0 && size_t(i) < table.size()) ? table[size_t(i)] : 0;
+        }
+        if (c.kind == BinaryCifColumn::Kind::Empty || !c.present(row)) return 0;
+        // 数字形式的链名、残基名
+        char buf[12];
+        int n = std::snprintf(buf, sizeof(buf), "%d", c.intAt(row));
+        return packName4(buf, size_t(n > 0 ? n : 0));
+    }
+}
+
+std::string_view BinaryCifColumn::stringAt(size_t row) const {
+    if (kind != Kind::String || !present(row)) return std::string_view();
+    int32_t i = ints[row];
+    return (i >= 0 && size_t(i) < strings.size()) ? strings[size_t(i)] : std::string_view();
+}
+
+int32_t BinaryCifColumn::intAt(size_t row) const {
+    switch (kind) {
+    case Kind::Int: return ints[row];
+    case Kind::Float: return int32_t(floats[row]);
+    case Kind::String: {
+        std::string_view v = stringAt(row);
+        return parseIntField(v.data(), v.data() + v.size());
+    }
+    default: return 0;
+    }
+}
+
+float BinaryCifColumn::floatAt(size_t row) const {
+    switch (kind) {
+    case Kind::Int: return float(ints[row]);
+    case Kind::Float: return floats[row];
+    case Kind::String: {
+        std::string_view v = stringAt(row);
+        return parseFloatField(v.data(), v.data() + v.size());
+    }
+    default: return 0.0f;
+    }
+}
+
+bool BinaryCifReader::open(const std::string& path) {
+    if (!file_.open(path)) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    return parse(file_.data(), file_.size());
+}
+
+bool BinaryCifReader::parse(const char* data, size_t size) {
+    error_.clear();
+    block_ = Ref();
+    inputSize_ = size;
+    if (!doc_.parse(reinterpret_cast<const uint8_t*>(data), size)) {
+        error_ = "malformed MessagePack";
+        return false;
+    }
+    Ref blocks = doc_.root()["dataBlocks"];
+    if (blocks.size() == 0) {
+        error_ = "no data blocks";
+        return false;
+    }
+    block_ = blocks[0];
+    return true;
+}
+
+Ref BinaryCifReader::findCategory(std::string_view name) const {
+    Ref categories = block_["categories"];
+    name = stripUnderscore(name);
+    Ref c = categories.first();
+    for (size_t i = 0; i < categories.size(); ++i, c = c.nextSibling()) {
+        if (stripUnderscore(c["name"].asString()) == name) return c;
+    }
+    return Ref();
+}
+
+Ref BinaryCifReader::findColumn(std::string_view category, std::string_view column) const {
+    Ref columns = findCategory(category)["columns"];
+    Ref c = columns.first();
+    for (size_t i = 0; i < columns.size(); ++i, c = c.nextSibling()) {
+        if (c["name"].asString() == column) return c;
+    }
+    return Ref();
+}
+
+bool BinaryCifReader::hasCategory(std::string_view name) const {
+    return findCategory(name).valid();
+}
+
+size_t BinaryCifReader::rowCount(std::string_view category) const {
+    int64_t rows = findCategory(category)["rowCount"].asInt();
+    return rows > 0 ? size_t(rows) : 0;
+}
+
+bool BinaryCifReader::decodeColumn(std::string_view category, std::string_view column, BinaryCifColumn& out) const {
+    out = BinaryCifColumn();
+    Ref col = findColumn(category, column);
+    if (!col.valid()) return false;
+    // 行数同样来自文件：真实文件里每行至少占一个字节，超过输入大小的判为损坏
+    size_t rows = rowCount(category);
+    if (rows > inputSize_) return false;
+    if (!decodeData(col["data"], rows, out, false) || out.size() != rows) {
+        out = BinaryCifColumn();
+        return false;
+    }
+
+    Ref mask = col["mask"];
+    if (mask.valid() && !mask.isNil()) {
+        BinaryCifColumn m;
+        if (decodeData(mask, rows, m, true)) out.mask.swap(m.ints);
+        if (out.mask.size() != out.size()) out.mask.clear();
+    }
+    return true;
+}
+
+bool BinaryCifReader::loadAtomSite(AtomTable& out) {
+    out.clear();
+    if (!hasCategory("_atom_site")) {
+        error_ = "missing _atom_site";
+        return false;
+    }
+
+    enum {
+        Group, Type, AuthAtom, LabelAtom, Alt, AuthComp, LabelComp, AuthAsym, LabelAsym,
+        AuthSeq, LabelSeq, Ins, X, Y, Z, Model, ColumnCount
+    };
+    static const char* const kNames[ColumnCount] = {
+        "group_PDB", "type_symbol", "auth_atom_id", "label_atom_id", "label_alt_id", "auth_comp_id",
+        "label_comp_id", "auth_asym_id", "label_asym_id", "auth_seq_id", "label_seq_id",
+        "pdbx_PDB_ins_code", "Cartn_x", "Cartn_y", "Cartn_z", "pdbx_PDB_model_num"
+    };
+
+    // 各列互相独立，并行解码
+    BinaryCifColumn cols[ColumnCount];
+    bool found[ColumnCount];
+    ThreadPool::instance().run(ColumnCount, [&](size_t i) {
+        found[i] = decodeColumn("_atom_site", kNames[i], cols[i]);
+    });
+    if (!found[X] || !found[Y] || !found[Z]) {
+        error_ = "_atom_site has no Cartn_x/y/z";
+        return false;
+    }
+    size_t rows = cols[X].size();
+    for (int i = 0; i < ColumnCount; ++i) {
+        if (found[i] && cols[i].size() != rows) found[i] = false;
+    }
+    // 元素列按字符串表下标查表，必须是字符串列
+    if (found[Type] && cols[Type].kind != BinaryCifColumn::Kind::String) found[Type] = false;
+    auto pick = [&](int a, int b) -> const BinaryCifColumn& { return found[a] ? cols[a] : cols[b]; };
+    const BinaryCifColumn& atomCol = pick(AuthAtom, LabelAtom);
+    const BinaryCifColumn& compCol = pick(AuthComp, LabelComp);
+    const BinaryCifColumn& authChainCol = pick(AuthAsym, LabelAsym);
+    const BinaryCifColumn& labelChainCol = pick(LabelAsym, AuthAsym);
+    const BinaryCifColumn& seqCol = pick(AuthSeq, LabelSeq);
+
+    std::vector<uint32_t> atomTable = packedTable(atomCol);
+    std::vector<uint32_t> compTable = packedTable(compCol);
+    std::vector<uint32_t> authChainTable = packedTable(authChainCol);
+    std::vector<uint32_t> labelChainTable = packedTable(labelChainCol);
+    std::vector<uint8_t> elementTable(cols[Type].strings.size());
+    for (size_t i = 0; i < elementTable.size(); ++i) {
+        elementTable[i] = elementFromSymbol(cols[Type].strings[i].data(), cols[Type].strings[i].size());
+    }
+
+    // 只保留第一个模型与主备用位置
+    int32_t firstModel = (found[Model] && rows > 0) ? cols[Model].intAt(0) : 0;
+    std::vector<uint32_t> kept;
+    kept.reserve(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        if (found[Model] && cols[Model].intAt(r) != firstModel) continue;
+        if (found[Alt] && cols[Alt].present(r)) {
+            std::string_view alt = cols[Alt].stringAt(r);
+            if (!alt.empty() && alt != "A" && alt != "1") continue;
+        }
+        kept.push_back(uint32_t(r));
+    }
+
+    size_t count = kept.size();
+    out.resizeAtoms(count);
+    std::vector<int32_t> seq(count);
+    std::vector<char> insertion(count);
+    std::vector<uint32_t> comp(count), authChain(count), labelChain(count);
+    parallelFor(0, count, [&](size_t b, size_t e) {
+        for (size_t o = b; o < e; ++o) {
+            size_t r = kept[o];
+            out.x[o] = cols[X].floatAt(r);
+            out.y[o] = cols[Y].floatAt(r);
+            out.z[o] = cols[Z].floatAt(r);
+            int32_t t = found[Type] ? cols[Type].ints[r] : -1;
+            out.element[o] = (t >= 0 && size_t(t) < elementTable.size()) ? elementTable[size_t(t)] : 0;
+            out.name[o] = packedAt(atomCol, atomTable, r);
+            out.flags[o] = (found[Group] && cols[Group].stringAt(r) == "HETATM") ? AtomHetero : 0;
+            seq[o] = seqCol.kind != BinaryCifColumn::Kind::Empty ? seqCol.intAt(r) : 0;
+            insertion[o] = found[Ins] ? insertionCode(cols[Ins].stringAt(r)) : ' ';
+            comp[o] = packedAt(compCol, compTable, r);
+            authChain[o] = packedAt(authChainCol, authChainTable, r);
+            labelChain[o] = packedAt(labelChainCol, labelChainTable, r);
+        }
+    }, 8192);
+
+    buildResidues(out, seq.data(), insertion.data(), comp.data(), authChain.data(), labelChain.data());
+
+    if (count == 0) {
+        error_ = "_atom_site is empty";
+        return false;
+    }
+    return true;
+}
+
+void BinaryCifReader::loadSecondaryStructure(AtomTable& out) {
+    std::vector<SecondaryStructureRange> ranges;
+
+    auto collect = [&](const char* category, bool helix) {
+        if (!hasCategory(category)) return;
+        BinaryCifColumn type, begChain, begSeq, begIns, endSeq, endIns;
+        bool hasType = helix && decodeColumn(category, "conf_type_id", type);
+        if (!decodeColumn(category, "beg_auth_asym_id", begChain) ||
+            !decodeColumn(category, "beg_auth_seq_id", begSeq) ||
+            !decodeColumn(category, "end_auth_seq_id", endSeq)) {
+            return;
+        }
+        bool hasBegIns = decodeColumn(category, "pdbx_beg_PDB_ins_code", begIns);
+        bool hasEndIns = decodeColumn(category, "pdbx_end_PDB_ins_code", endIns);
+        // 各列行数必须一致，否则按行下标读会越界
+        const size_t rows = begSeq.size();
+        if (begChain.size() != rows || endSeq.size() != rows) return;
+        hasType = hasType && type.size() == rows;
+        hasBegIns = hasBegIns && begIns.size() == rows;
+        hasEndIns = hasEndIns && endIns.size() == rows;
+        std::vector<uint32_t> chainTable = packedTable(begChain);
+
+        for (size_t r = 0; r < rows; ++r) {
+            SecondaryStructureRange s;
+            s.type = SecondaryStructure::Strand;
+            if (helix) {
+                std::string_view t = hasType ? type.stringAt(r) : std::string_view("HELX_P");
+                if (t.compare(0, 4, "TURN") == 0) s.type = SecondaryStructure::Turn;
+                else if (t == "HELX_RH_3T_P") s.type = SecondaryStructure::Helix310;
+                else if (t == "HELX_RH_PI_P") s.type = SecondaryStructure::PiHelix;
+                else if (t.compare(0, 4, "STRN") == 0) s.type = SecondaryStructure::Strand;
+                else s.type = SecondaryStructure::AlphaHelix;
+            }
+            s.chain = packedAt(begChain, chainTable, r);
+            s.beginSeq = begSeq.intAt(r);
+            s.beginInsertion = hasBegIns ? insertionCode(begIns.stringAt(r)) : ' ';
+            s.endSeq = endSeq.intAt(r);
+            s.endInsertion = hasEndIns ? insertionCode(endIns.stringAt(r)) : ' ';
+            ranges.push_back(s);
+        }
+    };
+    collect("_struct_conf", true);
+    collect("_struct_sheet_range", false);
+    applySecondaryStructure(out, ranges);
+}
@@ -0,0 +1,253 @@
+﻿// BinaryCodec v 1.0
+#include "BinaryCodec.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // 标量解包：从 src[i] 开始解出一个值，返回消耗后的位置
+    template <typename T>
+    inline size_t unpackOne(const T* src, size_t i, size_t count, T upper, T lower, bool isUnsigned, int32_t& value) {
+        int32_t v = 0;
+        T t = src[i];
+        while (t == upper || (!isUnsigned && t == lower)) {
+            v += t;
+            if (++i >= count) {
+                value = v;
+                return i;
+            }
+            t = src[i];
+        }
+        value = v + t;
+        return i + 1;
+    }
+
+    template <typename T>
+    size_t unpackScalar(const T* src, size_t count, int32_t* out, size_t outCapacity, T upper, T lower, bool isUnsigned) {
+        size_t i = 0;
+        size_t j = 0;
+        while (i < count && j < outCapacity) {
+            i = unpackOne(src, i, count, upper, lower, isUnsigned, out[j]);
+            ++j;
+        }
+        return j;
+    }
+}
+
+size_t unpackInt8(const int8_t* src, size_t count, int32_t* out, size_t outCapacity) {
+    size_t i = 0;
+    size_t j = 0;
+#if THC_SSE2
+    // 16 个值中没有上/下限时直接符号扩展写出，否则这一段退回标量
+    const __m128i upper = _mm_set1_epi8(127);
+    const __m128i lower = _mm_set1_epi8(-128);
+    while (i + 16 <= count && j + 16 <= outCapacity) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i limit = _mm_or_si128(_mm_cmpeq_epi8(v, upper), _mm_cmpeq_epi8(v, lower));
+        if (_mm_movemask_epi8(limit) != 0) {
+            size_t stop = i + 16;
+            while (i < stop && i < count && j < outCapacity) {
+                i = unpackOne<int8_t>(src, i, count, 127, -128, false, out[j]);
+                ++j;
+            }
+            continue;
+        }
+        __m128i sign = _mm_cmplt_epi8(v, _mm_setzero_si128());
+        __m128i lo16 = _mm_unpacklo_epi8(v, sign);
+        __m128i hi16 = _mm_unpackhi_epi8(v, sign);
+        __m128i s0 = _mm_srai_epi16(lo16, 15);
+        __m128i s1 = _mm_srai_epi16(hi16, 15);
+        __m128i* o = reinterpret_cast<__m128i*>(out + j);
+        _mm_storeu_si128(o + 0, _mm_unpacklo_epi16(lo16, s0));
+        _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(lo16, s0));
+        _mm_storeu_si128(o + 2, _mm_unpacklo_epi16(hi16, s1));
+        _mm_storeu_si128(o + 3, _mm_unpackhi_epi16(hi16, s1));
+        i += 16;
+        j += 16;
+    }
+#endif
+    return j + unpackScalar<int8_t>(src + i, count - i, out + j, outCapacity - j, 127, -128, false);
+}
+
+size_t unpackUint8(const uint8_t* src, size_t count, int32_t* out, size_t outCapacity) {
+    size_t i = 0;
+    size_t j = 0;
+#if THC_SSE2
+    const __m128i upper = _mm_set1_epi8(char(0xFF));
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 16 <= count && j + 16 <= outCapacity) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, upper)) != 0) {
+            size_t stop = i + 16;
+            while (i < stop && i < count && j < outCapacity) {
+                i = unpackOne<uint8_t>(src, i, count, 0xFF, 0, true, out[j]);
+                ++j;
+            }
+            continue;
+        }
+        __m128i lo16 = _mm_unpacklo_epi8(v, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(v, zero);
+        __m128i* o = reinterpret_cast<__m128i*>(out + j);
+        _mm_storeu_si128(o + 0, _mm_unpacklo_epi16(lo16, zero));
+        _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(lo16, zero));
+        _mm_storeu_si128(o + 2, _mm_unpacklo_epi16(hi16, zero));
+        _mm_storeu_si128(o + 3, _mm_unpackhi_epi16(hi16, zero));
+        i += 16;
+        j += 16;
+    }
+#endif
+    return j + unpackScalar<uint8_t>(src + i, count - i, out + j, outCapacity - j, 0xFF, 0, true);
+}
+
+size_t unpackInt16(const int16_t* src, size_t count, int32_t* out, size_t outCapacity) {
+    size_t i = 0;
+    size_t j = 0;
+#if THC_SSE2
+    const __m128i upper = _mm_set1_epi16(32767);
+    const __m128i lower = _mm_set1_epi16(-32768);
+    while (i + 8 <= count && j + 8 <= outCapacity) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i limit = _mm_or_si128(_mm_cmpeq_epi16(v, upper), _mm_cmpeq_epi16(v, lower));
+        if (_mm_movemask_epi8(limit) != 0) {
+            size_t stop = i + 8;
+            while (i < stop && i < count && j < outCapacity) {
+                i = unpackOne<int16_t>(src, i, count, 32767, -32768, false, out[j]);
+                ++j;
+            }
+            continue;
+        }
+        __m128i sign = _mm_srai_epi16(v, 15);
+        __m128i* o = reinterpret_cast<__m128i*>(out + j);
+        _mm_storeu_si128(o + 0, _mm_unpacklo_epi16(v, sign));
+        _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(v, sign));
+        i += 8;
+        j += 8;
+    }
+#endif
+    return j + unpackScalar<int16_t>(src + i, count - i, out + j, outCapacity - j, 32767, -32768, false);
+}
+
+size_t unpackUint16(const uint16_t* src, size_t count, int32_t* out, size_t outCapacity) {
+    size_t i = 0;
+    size_t j = 0;
+#if THC_SSE2
+    const __m128i upper = _mm_set1_epi16(-1);
+    const __m128i zero = _mm_setzero_si128();
+    while (i + 8 <= count && j + 8 <= outCapacity) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(v, upper)) != 0) {
+            size_t stop = i + 8;
+            while (i < stop && i < count && j < outCapacity) {
+                i = unpackOne<uint16_t>(src, i, count, 0xFFFF, 0, true, out[j]);
+                ++j;
+            }
+            continue;
+        }
+        __m128i* o = reinterpret_cast<__m128i*>(out + j);
+        _mm_storeu_si128(o + 0, _mm_unpacklo_epi16(v, zero));
+        _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(v, zero));
+        i += 8;
+        j += 8;
+    }
+#endif
+    return j + unpackScalar<uint16_t>(src + i, count - i, out + j, outCapacity - j, 0xFFFF, 0, true);
+}
+
+void deltaDecode(int32_t* data, size_t count, int32_t origin) {
+    size_t i = 0;
+    int32_t carry = origin;
+#if THC_SSE2
+    // 寄存器内前缀和：两次移位相加得到 4 路前缀和，再加上前一组的末值
+    __m128i c = _mm_set1_epi32(origin);
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), v);
+        c = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    carry = _mm_cvtsi128_si32(c);
+#endif
+    for (; i < count; ++i) {
+        carry += data[i];
+        data[i] = carry;
+    }
+}
+
+size_t runLengthSize(const int32_t* pairs, size_t pairCount) {
+    size_t total = 0;
+    for (size_t i = 0; i < pairCount; ++i) {
+        if (pairs[2 * i + 1] > 0) total += size_t(pairs[2 * i + 1]);
+    }
+    return total;
+}
+
+size_t runLengthDecode(const int32_t* pairs, size_t pairCount, int32_t* out, size_t outCapacity) {
+    size_t j = 0;
+    for (size_t i = 0; i < pairCount && j < outCapacity; ++i) {
+        int32_t value = pairs[2 * i];
+        size_t n = pairs[2 * i + 1] > 0 ? size_t(pairs[2 * i + 1]) : 0;
+        n = std::min(n, outCapacity - j);
+        std::fill_n(out + j, n, value);
+        j += n;
+    }
+    return j;
+}
+
+void fixedPointDecode(const int32_t* src, size_t count, float factor, float* out) {
+    size_t i = 0;
+#if THC_SSE2
+    const __m128 f = _mm_set1_ps(factor);
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(out + i, _mm_div_ps(_mm_cvtepi32_ps(v), f));
+    }
+#endif
+    for (; i < count; ++i) out[i] = float(src[i]) / factor;
+}
+
+void intervalDecode(const int32_t* src, size_t count, float min, float max, int32_t steps, float* out) {
+    float delta = steps > 1 ? (max - min) / float(steps - 1) : 0.0f;
+    size_t i = 0;
+#if THC_SSE2
+    const __m128 d = _mm_set1_ps(delta);
+    const __m128 m = _mm_set1_ps(min);
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_ps(out + i, _mm_add_ps(m, _mm_mul_ps(d, _mm_cvtepi32_ps(v))));
+    }
+#endif
+    for (; i < count; ++i) out[i] = min + delta * float(src[i]);
+}
+
+void byteSwap16(const uint8_t* src, size_t count, int16_t* out) {
+    size_t i = 0;
+#if THC_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = int16_t(uint16_t((src[2 * i] << 8) | src[2 * i + 1]));
+    }
+}
+
+void byteSwap32(const uint8_t* src, size_t count, int32_t* out) {
+    size_t i = 0;
+#if THC_SSE2
+    // SSE2 没有字节重排指令：先交换 16 位内的字节，再交换两个 16 位半字
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* p = src + 4 * i;
+        out[i] = int32_t((uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]);
+    }
+}
@@ -0,0 +1,111 @@
+﻿// BondImpostor v 1.1
+#include <glad/glad.h>
+#include "BondImpostor.h"
+
+namespace {
+    // 单位长方体（x、y 属于 [-1, 1]，z 属于 [0, 1]）的 14 顶点三角形带，
+    // 顶点着色器把 x、y 缩放为半径，z 沿键轴从第一个原子到第二个原子
+    const float kBoxStrip[14 * 3] = {
+        -1.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f,
+        -1.0f, -1.0f, 1.0f,
+        1.0f, -1.0f, 1.0f,
+        1.0f, -1.0f, 0.0f,
+        1.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 0.0f,
+        -1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f, 0.0f,
+        -1.0f, -1.0f, 1.0f,
+        -1.0f, -1.0f, 0.0f,
+        1.0f, -1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f,
+        1.0f, 1.0f, 0.0f
+    };
+
+    const GLuint kCornerAttrib = 0;
+    const GLuint kBondAttrib = 1;       // uvec2：两个原子下标
+    const int kPositionUnit = 0;
+    const int kColorUnit = 1;
+    const int kBlockUnit = 2;
+    const int kOffsetUnit = 3;
+}
+
+void BondImpostor::setBonds(const BondTable& bonds) {
+    bondPairs(bonds, pairs_);
+    pairsDirty_ = true;
+}
+
+void BondImpostor::setBonds(const std::vector<uint32_t>& pairs) {
+    pairs_.assign(pairs.begin(), pairs.end() - (pairs.size() & 1));
+    pairsDirty_ = true;
+}
+
+bool BondImpostor::createGL(const std::string& vertexPath, const std::string& fragmentPath) {
+    error_.clear();
+    if (!shader_.loadFiles(vertexPath, fragmentPath)) {
+        error_ = shader_.lastError();
+        return false;
+    }
+    destroyGL();
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &boxBuffer_);
+    glGenBuffers(1, &bondBuffer_);
+    glBindVertexArray(vao_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, boxBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kBoxStrip), kBoxStrip, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(kCornerAttrib);
+    glVertexAttribPointer(kCornerAttrib, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+
+    // 原子下标按整数读取（glVertexAttribIPointer），每条键前进一次
+    glBindBuffer(GL_ARRAY_BUFFER, bondBuffer_);
+    glEnableVertexAttribArray(kBondAttrib);
+    glVertexAttribIPointer(kBondAttrib, 2, GL_UNSIGNED_INT, 2 * sizeof(uint32_t), nullptr);
+    glVertexAttribDivisor(kBondAttrib, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shader_.use();
+    shader_.setInt("uPositions", kPositionUnit);
+    shader_.setInt("uColors", kColorUnit);
+    shader_.setInt("uAtomBlocks", kBlockUnit);
+    shader_.setInt("uBlockOffsets", kOffsetUnit);
+    glUseProgram(0);
+    uploadedCount_ = 0;
+    pairsDirty_ = true;
+    return true;
+}
+
+void BondImpostor::destroyGL() {
+    if (bondBuffer_ != 0) glDeleteBuffers(1, &bondBuffer_);
+    if (boxBuffer_ != 0) glDeleteBuffers(1, &boxBuffer_);
+    if (vao_ != 0) glDeleteVertexArrays(1, &vao_);
+    bondBuffer_ = 0;
+    boxBuffer_ = 0;
+    vao_ = 0;
+    uploadedCount_ = 0;
+}
+
+void BondImpostor::upload() {
+    if (bondBuffer_ == 0 || !pairsDirty_) return;
+    glBindBuffer(GL_ARRAY_BUFFER, bondBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(pairs_.size() * sizeof(uint32_t)), pairs_.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploadedCount_ = bondCount();
+    pairsDirty_ = false;
+}
+
+void BondImpostor::draw(const Camera& camera, const glm::mat4& projection) const {
+    if (vao_ == 0 || uploadedCount_ == 0 || atoms_ == nullptr || !atoms_->isReady()) return;
+    shader_.use();
+    shader_.setMat4("uModelView", camera.getRenderView());
+    shader_.setMat4("uProjection", projection);
+    shader_.setFloat("uRadius", radius_);
+    atoms_->bind(kPositionUnit, kColorUnit);
+    atoms_->bindBlocks(kBlockUnit, kOffsetUnit);
+    glBindVertexArray(vao_);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 14, GLsizei(uploadedCount_));
+    glBindVertexArray(0);
+}
@@ -0,0 +1,92 @@
+﻿// BondPerception v 1.0
+#include "BondPerception.h"
+#include "Element.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    const uint8_t kHydrogen = 1;
+}
+
+void BondPerception::perceive(const AtomTable& atoms, BondTable& out) {
+    auto t0 = std::chrono::steady_clock::now();
+    out.clear();
+    size_t n = atoms.atomCount();
+    out.offsets.assign(n + 1, 0);
+    if (n < 2) {
+        perceiveMs_ = 0.0;
+        return;
+    }
+
+    // 实际出现的最大共价半径决定格子边长
+    bool seen[256] = {};
+    for (size_t i = 0; i < n; ++i) seen[atoms.element[i]] = true;
+    float radius[256];
+    float maxRadius = 0.0f;
+    for (int e = 0; e < 256; ++e) {
+        radius[e] = covalentRadius(uint8_t(e));
+        if (seen[e]) maxRadius = std::max(maxRadius, radius[e]);
+    }
+    float cutoff = std::max(2.0f * maxRadius + tolerance_, 0.5f);
+    grid_.build(atoms.x.data(), atoms.y.data(), atoms.z.data(), n, cutoff);
+
+    // 按格子区间并行搜索，每块把键对写入自己的数组
+    const float minD2 = minDistance_ * minDistance_;
+    const float tol = tolerance_;
+    size_t searchBlocks = std::min<size_t>(grid_.cellCount(), size_t(workerCount()) * 8);
+    std::vector<std::vector<uint32_t>> found(searchBlocks);
+    ThreadPool::instance().run(searchBlocks, [&](size_t b) {
+        std::vector<uint32_t>& pairs = found[b];
+        grid_.forEachPair(cutoff, [&](uint32_t i, uint32_t j, float d2) {
+            uint8_t ei = atoms.element[i];
+            uint8_t ej = atoms.element[j];
+            float limit = radius[ei] + radius[ej] + tol;
+            if (d2 <= limit * limit && d2 >= minD2 && !(ei == kHydrogen && ej == kHydrogen)) {
+                pairs.push_back(std::min(i, j));
+                pairs.push_back(std::max(i, j));
+            }
+        }, b, searchBlocks);
+    });
+
+    // 组装 CSR
+    std::vector<uint32_t>& offsets = out.offsets;
+    size_t pairTotal = 0;
+    for (const std::vector<uint32_t>& pairs : found) {
+        pairTotal += pairs.size();
+        for (size_t k = 0; k < pairs.size(); ++k) offsets[pairs[k] + 1]++;
+    }
+    for (size_t i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+    out.neighbors.resize(pairTotal);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (const std::vector<uint32_t>& pairs : found) {
+            for (size_t k = 0; k < pairs.size(); k += 2) {
+                out.neighbors[fill[pairs[k]]++] = pairs[k + 1];
+                out.neighbors[fill[pairs[k + 1]]++] = pairs[k];
+            }
+        }
+    }
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) {
+            std::sort(out.neighbors.begin() + offsets[i], out.neighbors.begin() + offsets[i + 1]);
+        }
+    });
+
+    perceiveMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void bondPairs(const BondTable& bonds, std::vector<uint32_t>& out) {
+    out.clear();
+    out.reserve(bonds.neighbors.size());
+    size_t n = bonds.offsets.empty() ? 0 : bonds.offsets.size() - 1;
+    for (size_t i = 0; i < n; ++i) {
+        for (uint32_t k = bonds.offsets[i]; k < bonds.offsets[i + 1]; ++k) {
+            uint32_t j = bonds.neighbors[k];
+            if (j > i) {
+                out.push_back(uint32_t(i));
+                out.push_back(j);
+            }
+        }
+    }
+}
@@ -0,0 +1,578 @@
+﻿// Bvh v 1.0
+#include "Bvh.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+    const int kBins = 16;
+    // 节点深度上限，保证遍历栈（kStackSize）够用
+    const int kMaxDepth = Bvh::kStackSize / 2 - 4;
+    // SAH 认为不划分更便宜时，叶子最多放这么多图元
+    const size_t kMaxSahLeaf = 16;
+    // 图元数不少于此数的节点，分桶统计分块并行
+    const size_t kParallelBinCount = 65536;
+
+    struct Bounds {
+        float lo[3];
+        float hi[3];
+
+        void reset() {
+            for (int d = 0; d < 3; ++d) {
+                lo[d] = std::numeric_limits<float>::max();
+                hi[d] = -std::numeric_limits<float>::max();
+            }
+        }
+        void grow(float x0, float y0, float z0, float x1, float y1, float z1) {
+            lo[0] = std::min(lo[0], x0);
+            lo[1] = std::min(lo[1], y0);
+            lo[2] = std::min(lo[2], z0);
+            hi[0] = std::max(hi[0], x1);
+            hi[1] = std::max(hi[1], y1);
+            hi[2] = std::max(hi[2], z1);
+        }
+        void grow(const Bounds& b) {
+            grow(b.lo[0], b.lo[1], b.lo[2], b.hi[0], b.hi[1], b.hi[2]);
+        }
+        // 表面积的一半，空盒为 0
+        float halfArea() const {
+            float dx = hi[0] - lo[0];
+            float dy = hi[1] - lo[1];
+            float dz = hi[2] - lo[2];
+            if (dx < 0.0f || dy < 0.0f || dz < 0.0f) return 0.0f;
+            return dx * dy + dy * dz + dz * dx;
+        }
+    };
+
+    // 构建时的图元：包围盒与图元下标放在一起，划分时整条记录交换，
+    // 分桶与划分都顺序读内存，不必经 order 间接访问 AabbArray
+    struct Ref {
+        float lo[3];
+        float hi[3];
+        uint32_t id;
+    };
+
+    // 桶：图元包围盒的并、质心（这里用 min + max，即两倍质心）的范围与个数
+    struct Bin {
+        Bounds box;
+        Bounds centroid;
+        uint32_t count;
+
+        void reset() {
+            box.reset();
+            centroid.reset();
+            count = 0;
+        }
+    };
+
+    struct BinSetup {
+        int axis;
+        float origin;
+        float scale;
+
+        int binOf(const Ref& r) const {
+            int b = int((r.lo[axis] + r.hi[axis] - origin) * scale);
+            return std::min(std::max(b, 0), kBins - 1);
+        }
+    };
+
+    void measure(const Ref* refs, size_t begin, size_t end, Bounds& box, Bounds& centroid) {
+        box.reset();
+        centroid.reset();
+        for (size_t i = begin; i < end; ++i) {
+            const Ref& r = refs[i];
+            float x0 = r.lo[0], y0 = r.lo[1], z0 = r.lo[2];
+            float x1 = r.hi[0], y1 = r.hi[1], z1 = r.hi[2];
+            box.grow(x0, y0, z0, x1, y1, z1);
+            centroid.grow(x0 + x1, y0 + y1, z0 + z1, x0 + x1, y0 + y1, z0 + z1);
+        }
+    }
+
+    void binRange(const Ref* refs, size_t begin, size_t end, const BinSetup& setup, Bin* bins) {
+        for (int b = 0; b < kBins; ++b) bins[b].reset();
+        for (size_t i = begin; i < end; ++i) {
+            const Ref& r = refs[i];
+            Bin& bin = bins[setup.binOf(r)];
+            float x0 = r.lo[0], y0 = r.lo[1], z0 = r.lo[2];
+            float x1 = r.hi[0], y1 = r.hi[1], z1 = r.hi[2];
+            bin.box.grow(x0, y0, z0, x1, y1, z1);
+            bin.centroid.grow(x0 + x1, y0 + y1, z0 + z1, x0 + x1, y0 + y1, z0 + z1);
+            ++bin.count;
+        }
+    }
+
+    // 大节点分块统计再合并；在池内线程里调用时 run 自动退化为串行
+    void binNode(const Ref* refs, size_t first, size_t count, const BinSetup& setup, Bin* bins) {
+        size_t blocks = count >= kParallelBinCount ? std::min<size_t>(size_t(workerCount()) * 2, count / 16384) : 1;
+        if (blocks <= 1) {
+            binRange(refs, first, first + count, setup, bins);
+            return;
+        }
+        std::vector<Bin> partial(blocks * kBins);
+        size_t step = (count + blocks - 1) / blocks;
+        ThreadPool::instance().run(blocks, [&](size_t b) {
+            size_t b0 = first + b * step;
+            size_t b1 = std::min(first + count, b0 + step);
+            binRange(refs, b0, std::max(b0, b1), setup, &partial[b * kBins]);
+        });
+        for (int k = 0; k < kBins; ++k) {
+            bins[k] = partial[k];
+            for (size_t b = 1; b < blocks; ++b) {
+                const Bin& other = partial[b * kBins + k];
+                bins[k].box.grow(other.box);
+                bins[k].centroid.grow(other.centroid);
+                bins[k].count += other.count;
+            }
+        }
+    }
+
+    BvhNode makeNode(const Bounds& box, size_t first, size_t count) {
+        BvhNode node;
+        for (int d = 0; d < 3; ++d) {
+            node.lo[d] = box.lo[d];
+            node.hi[d] = box.hi[d];
+        }
+        node.first = uint32_t(first);
+        node.count = uint32_t(count);
+        node.left = 0;
+        return node;
+    }
+
+    // 尝试划分 nodes[index]：成功时在 nodes 末尾追加两个子节点，childCentroid 为它们的质心范围
+    bool splitNode(Ref* refs, size_t maxLeaf, std::vector<BvhNode>& nodes,
+        uint32_t index, const Bounds& centroid, int depth, Bounds childCentroid[2]) {
+        const size_t first = nodes[index].first;
+        const size_t count = nodes[index].count;
+        if (count <= maxLeaf || depth >= kMaxDepth) return false;
+
+        int axis = 0;
+        float extent[3];
+        for (int d = 0; d < 3; ++d) extent[d] = centroid.hi[d] - centroid.lo[d];
+        if (extent[1] > extent[axis]) axis = 1;
+        if (extent[2] > extent[axis]) axis = 2;
+
+        Bounds childBox[2];
+        size_t leftCount;
+        if (!(extent[axis] > 0.0f)) {
+            // 质心全部重合：SAH 无从划分，按数量对半分
+            leftCount = count / 2;
+            measure(refs, first, first + leftCount, childBox[0], childCentroid[0]);
+            measure(refs, first + leftCount, first + count, childBox[1], childCentroid[1]);
+        } else {
+            BinSetup setup{ axis, centroid.lo[axis], float(kBins) * (1.0f - 1e-6f) / extent[axis] };
+            Bin bins[kBins];
+            binNode(refs, first, count, setup, bins);
+
+            // 从右往左累计，再从左往右扫描找 SAH 代价最小的分界
+            float rightArea[kBins];
+            uint32_t rightCount[kBins];
+            Bounds acc;
+            acc.reset();
+            uint32_t n = 0;
+            for (int b = kBins - 1; b > 0; --b) {
+                acc.grow(bins[b].box);
+                n += bins[b].count;
+                rightArea[b] = acc.halfArea();
+                rightCount[b] = n;
+            }
+            acc.reset();
+            n = 0;
+            int best = -1;
+            float bestCost = std::numeric_limits<float>::max();
+            for (int b = 0; b < kBins - 1; ++b) {
+                acc.grow(bins[b].box);
+                n += bins[b].count;
+                if (n == 0 || rightCount[b + 1] == 0) continue;
+                float cost = acc.halfArea() * float(n) + rightArea[b + 1] * float(rightCount[b + 1]);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = b;
+                }
+            }
+            if (best < 0) return false;
+            // 遍历代价记 1、求交代价记 1：不划分的代价为图元数
+            Bounds parent;
+            for (int d = 0; d < 3; ++d) {
+                parent.lo[d] = nodes[index].lo[d];
+                parent.hi[d] = nodes[index].hi[d];
+            }
+            float parentArea = std::max(parent.halfArea(), 1e-20f);
+            if (count <= kMaxSahLeaf && 1.0f + bestCost / parentArea >= float(count)) return false;
+
+            Ref* mid = std::partition(refs + first, refs + first + count, [&](const Ref& r) {
+                return setup.binOf(r) <= best;
+            });
+            leftCount = size_t(mid - (refs + first));
+            for (int c = 0; c < 2; ++c) {
+                childBox[c].reset();
+                childCentroid[c].reset();
+            }
+            for (int b = 0; b < kBins; ++b) {
+                int c = b <= best ? 0 : 1;
+                childBox[c].grow(bins[b].box);
+                childCentroid[c].grow(bins[b].centroid);
+            }
+        }
+
+        uint32_t left = uint32_t(nodes.size());
+        nodes[index].left = left;
+        nodes.push_back(makeNode(childBox[0], first, leftCount));
+        nodes.push_back(makeNode(childBox[1], first + leftCount, count - leftCount));
+        return true;
+    }
+
+    // 10 位整数的位之间插入两个 0
+    inline uint32_t expandBits(uint32_t v) {
+        v = (v * 0x00010001u) & 0xFF0000FFu;
+        v = (v * 0x00000101u) & 0x0F00F00Fu;
+        v = (v * 0x00000011u) & 0xC30C30C3u;
+        v = (v * 0x00000005u) & 0x49249249u;
+        return v;
+    }
+
+    inline int highestBit(uint32_t v) {
+        int bit = 31;
+        while ((v >> bit) == 0) --bit;
+        return bit;
+    }
+
+    // refs[0, count) 按质心在 centroid（两倍质心的范围）中的 30 位 Morton 码排序，codes 为排序后的码。
+    // 基数排序三趟，每趟 10 位
+    void sortMorton(Ref* refs, size_t count, const Bounds& centroid, std::vector<uint32_t>& codes) {
+        float origin[3], scale[3];
+        for (int d = 0; d < 3; ++d) {
+            float extent = centroid.hi[d] - centroid.lo[d];
+            origin[d] = centroid.lo[d];
+            scale[d] = extent > 0.0f ? 1023.0f / extent : 0.0f;
+        }
+        std::vector<uint32_t> key(count), index(count), keyTmp(count), indexTmp(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t q[3];
+            for (int d = 0; d < 3; ++d) {
+                float t = (refs[i].lo[d] + refs[i].hi[d] - origin[d]) * scale[d];
+                q[d] = uint32_t(std::min(std::max(t, 0.0f), 1023.0f));
+            }
+            key[i] = (expandBits(q[0]) << 2) | (expandBits(q[1]) << 1) | expandBits(q[2]);
+            index[i] = uint32_t(i);
+        }
+        for (int shift = 0; shift < 30; shift += 10) {
+            uint32_t histogram[1025] = {};
+            for (size_t i = 0; i < count; ++i) ++histogram[((key[i] >> shift) & 1023u) + 1];
+            for (int b = 0; b < 1024; ++b) histogram[b + 1] += histogram[b];
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t slot = histogram[(key[i] >> shift) & 1023u]++;
+                keyTmp[slot] = key[i];
+                indexTmp[slot] = index[i];
+            }
+            key.swap(keyTmp);
+            index.swap(indexTmp);
+        }
+        std::vector<Ref> sorted(count);
+        for (size_t i = 0; i < count; ++i) sorted[i] = refs[index[i]];
+        std::copy(sorted.begin(), sorted.end(), refs);
+        codes.swap(key);
+    }
+
+    // LBVH：图元已按 Morton 码排序，nodes[index] 在码的最高不同位处划分（码全相同时对半分），
+    // 子节点追加在 nodes 末尾。只建拓扑，包围盒由 boundNodes 自底向上填
+    void buildMorton(const uint32_t* codes, size_t maxLeaf, std::vector<BvhNode>& nodes, uint32_t index, int depth) {
+        const size_t first = nodes[index].first;
+        const size_t count = nodes[index].count;
+        if (count <= maxLeaf || depth >= kMaxDepth) return;
+        const size_t last = first + count - 1;
+        size_t leftCount = count / 2;
+        if (codes[first] != codes[last]) {
+            // 第一个该位为 1 的位置
+            const uint32_t bit = 1u << highestBit(codes[first] ^ codes[last]);
+            leftCount = size_t(std::partition_point(codes + first, codes + last + 1, [bit](uint32_t c) {
+                return (c & bit) == 0;
+            }) - (codes + first));
+        }
+        Bounds empty;
+        empty.reset();
+        uint32_t left = uint32_t(nodes.size());
+        nodes[index].left = left;
+        nodes.push_back(makeNode(empty, first, leftCount));
+        nodes.push_back(makeNode(empty, first + leftCount, count - leftCount));
+        buildMorton(codes, maxLeaf, nodes, left, depth + 1);
+        buildMorton(codes, maxLeaf, nodes, left + 1, depth + 1);
+    }
+
+    // 子节点总在父节点之后：倒序扫一遍，叶子合并图元，内部节点合并两个子节点
+    void boundNodes(const Ref* refs, std::vector<BvhNode>& nodes) {
+        for (size_t i = nodes.size(); i-- > 0;) {
+            BvhNode& node = nodes[i];
+            Bounds box;
+            box.reset();
+            if (node.left == 0) {
+                for (uint32_t k = node.first; k < node.first + node.count; ++k) {
+                    box.grow(refs[k].lo[0], refs[k].lo[1], refs[k].lo[2], refs[k].hi[0], refs[k].hi[1], refs[k].hi[2]);
+                }
+            } else {
+                const BvhNode& a = nodes[node.left];
+                const BvhNode& b = nodes[node.left + 1];
+                box.grow(a.lo[0], a.lo[1], a.lo[2], a.hi[0], a.hi[1], a.hi[2]);
+                box.grow(b.lo[0], b.lo[1], b.lo[2], b.hi[0], b.hi[1], b.hi[2]);
+            }
+            for (int d = 0; d < 3; ++d) {
+                node.lo[d] = box.lo[d];
+                node.hi[d] = box.hi[d];
+            }
+        }
+    }
+}
+
+void Bvh::buildNodes() {
+    const size_t n = boxes_.size();
+    nodes_.clear();
+    spans_.clear();
+    order_.resize(n);
+    slots_.resize(n);
+    if (n == 0) return;
+    const size_t maxLeaf = std::max<size_t>(maxLeafSize_, 1);
+    std::vector<Ref> refs(n);
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) {
+            refs[i] = Ref{ { boxes_.minX[i], boxes_.minY[i], boxes_.minZ[i] },
+                { boxes_.maxX[i], boxes_.maxY[i], boxes_.maxZ[i] }, uint32_t(i) };
+        }
+    }, 16384);
+
+    // 根的包围盒分块并行统计
+    Bounds box, centroid;
+    {
+        size_t blocks = std::max<size_t>(1, std::min<size_t>(size_t(workerCount()) * 2, n / 16384));
+        std::vector<Bounds> partBox(blocks), partCentroid(blocks);
+        size_t step = (n + blocks - 1) / blocks;
+        ThreadPool::instance().run(blocks, [&](size_t b) {
+            size_t b0 = std::min(n, b * step);
+            size_t b1 = std::min(n, b0 + step);
+            measure(refs.data(), b0, b1, partBox[b], partCentroid[b]);
+        });
+        box = partBox[0];
+        centroid = partCentroid[0];
+        for (size_t b = 1; b < blocks; ++b) {
+            box.grow(partBox[b]);
+            centroid.grow(partCentroid[b]);
+        }
+    }
+    nodes_.reserve(2 * (n / maxLeaf) + 1);
+    nodes_.push_back(makeNode(box, 0, n));
+
+    // 大节点在本线程逐层划分（分桶并行），小于 subtreeSize 的子树留给后面并行构建
+    struct Pending {
+        uint32_t node;
+        int depth;
+        Bounds centroid;
+    };
+    const size_t subtreeSize = std::max<size_t>(4096, n / (size_t(workerCount()) * 8));
+    std::vector<Pending> queue;
+    std::vector<Pending> deferred;
+    queue.push_back(Pending{ 0, 0, centroid });
+    while (!queue.empty()) {
+        Pending p = queue.back();
+        queue.pop_back();
+        if (nodes_[p.node].count <= subtreeSize) {
+            deferred.push_back(p);
+            continue;
+        }
+        Bounds childCentroid[2];
+        if (!splitNode(refs.data(), maxLeaf, nodes_, p.node, p.centroid, p.depth, childCentroid)) continue;
+        uint32_t left = nodes_[p.node].left;
+        queue.push_back(Pending{ left, p.depth + 1, childCentroid[0] });
+        queue.push_back(Pending{ left + 1, p.depth + 1, childCentroid[1] });
+    }
+
+    // 各子树在自己的数组里构建（0 号为子树根），图元区间互不重叠，可以并行排序、划分 refs
+    std::vector<std::vector<BvhNode>> locals(deferred.size());
+    ThreadPool::instance().run(deferred.size(), [&](size_t i) {
+        std::vector<BvhNode>& local = locals[i];
+        const BvhNode& root = nodes_[deferred[i].node];
+        Ref* range = refs.data() + root.first;
+        std::vector<uint32_t> codes;
+        sortMorton(range, root.count, deferred[i].centroid, codes);
+        Bounds empty;
+        empty.reset();
+        local.push_back(makeNode(empty, 0, root.count));
+        buildMorton(codes.data(), maxLeaf, local, 0, deferred[i].depth);
+        boundNodes(range, local);
+        // 局部的图元区间从 0 开始，换回全局
+        for (BvhNode& node : local) node.first += root.first;
+    });
+    // 拼接：子树的第 j 个节点（j >= 1）放到 base + j - 1，子节点仍然排在父节点之后
+    spans_.push_back(uint32_t(nodes_.size()));
+    for (size_t i = 0; i < deferred.size(); ++i) {
+        const std::vector<BvhNode>& local = locals[i];
+        const uint32_t base = uint32_t(nodes_.size());
+        auto remap = [base](BvhNode node) {
+            if (node.left != 0) node.left = base + node.left - 1;
+            return node;
+        };
+        nodes_[deferred[i].node] = remap(local[0]);
+        for (size_t j = 1; j < local.size(); ++j) nodes_.push_back(remap(local[j]));
+        spans_.push_back(uint32_t(nodes_.size()));
+    }
+
+    // 图元包围盒换成叶子顺序，叶子的图元在内存中连续
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t k = b0; k < b1; ++k) {
+            const Ref& r = refs[k];
+            order_[k] = r.id;
+            slots_[r.id] = uint32_t(k);
+            boxes_.set(k, r.lo, r.hi);
+        }
+    }, 16384);
+}
+
+void Bvh::build(const AabbArray& boxes) {
+    auto t0 = std::chrono::steady_clock::now();
+    boxes_ = boxes;
+    buildNodes();
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Bvh::build(const float* x, const float* y, const float* z, const float* radius, size_t n) {
+    auto t0 = std::chrono::steady_clock::now();
+    boxes_.resize(n);
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) {
+            float c[3] = { x[i], y[i], z[i] };
+            boxes_.setSphere(i, c, radius ? radius[i] : 0.0f);
+        }
+    }, 16384);
+    buildNodes();
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Bvh::refitRange(size_t begin, size_t end) {
+    // 先取出裸指针：写节点的 float 可能与 vector 内部指针别名，编译器否则每次都要重新读
+    BvhNode* nodes = nodes_.data();
+    const float* minX = boxes_.minX.data();
+    const float* minY = boxes_.minY.data();
+    const float* minZ = boxes_.minZ.data();
+    const float* maxX = boxes_.maxX.data();
+    const float* maxY = boxes_.maxY.data();
+    const float* maxZ = boxes_.maxZ.data();
+    for (size_t i = end; i-- > begin;) {
+        BvhNode& node = nodes[i];
+        float lo[3], hi[3];
+        if (node.left == 0) {
+            // 叶子至少有一个图元，图元包围盒按叶子顺序连续
+            const uint32_t k0 = node.first;
+            lo[0] = minX[k0];
+            lo[1] = minY[k0];
+            lo[2] = minZ[k0];
+            hi[0] = maxX[k0];
+            hi[1] = maxY[k0];
+            hi[2] = maxZ[k0];
+            for (uint32_t k = k0 + 1; k < k0 + node.count; ++k) {
+                lo[0] = std::min(lo[0], minX[k]);
+                lo[1] = std::min(lo[1], minY[k]);
+                lo[2] = std::min(lo[2], minZ[k]);
+                hi[0] = std::max(hi[0], maxX[k]);
+                hi[1] = std::max(hi[1], maxY[k]);
+                hi[2] = std::max(hi[2], maxZ[k]);
+            }
+        } else {
+            const BvhNode& a = nodes[node.left];
+            const BvhNode& b = nodes[node.left + 1];
+            for (int d = 0; d < 3; ++d) {
+                lo[d] = std::min(a.lo[d], b.lo[d]);
+                hi[d] = std::max(a.hi[d], b.hi[d]);
+            }
+        }
+        for (int d = 0; d < 3; ++d) {
+            node.lo[d] = lo[d];
+            node.hi[d] = hi[d];
+        }
+    }
+}
+
+void Bvh::refitNodes() {
+    if (nodes_.empty()) return;
+    // 子树区间互不依赖，可以并行；顶层节点（含各子树的根）都在第一段区间之前
+    size_t spanCount = spans_.empty() ? 0 : spans_.size() - 1;
+    ThreadPool::instance().run(spanCount, [&](size_t i) {
+        refitRange(spans_[i], spans_[i + 1]);
+    });
+    refitRange(0, spans_.empty() ? nodes_.size() : spans_[0]);
+}
+
+void Bvh::refit(const AabbArray& boxes) {
+    if (boxes.size() != boxes_.size() || nodes_.empty()) {
+        build(boxes);
+        return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    parallelFor(0, order_.size(), [&](size_t b0, size_t b1) {
+        for (size_t k = b0; k < b1; ++k) {
+            const uint32_t p = order_[k];
+            boxes_.minX[k] = boxes.minX[p];
+            boxes_.minY[k] = boxes.minY[p];
+            boxes_.minZ[k] = boxes.minZ[p];
+            boxes_.maxX[k] = boxes.maxX[p];
+            boxes_.maxY[k] = boxes.maxY[p];
+            boxes_.maxZ[k] = boxes.maxZ[p];
+        }
+    }, 16384);
+    refitNodes();
+    refitMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Bvh::refit(const float* x, const float* y, const float* z, const float* radius, size_t n) {
+    if (n != boxes_.size() || nodes_.empty()) {
+        build(x, y, z, radius, n);
+        return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    const uint32_t* order = order_.data();
+    float* minX = boxes_.minX.data();
+    float* minY = boxes_.minY.data();
+    float* minZ = boxes_.minZ.data();
+    float* maxX = boxes_.maxX.data();
+    float* maxY = boxes_.maxY.data();
+    float* maxZ = boxes_.maxZ.data();
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t k = b0; k < b1; ++k) {
+            const uint32_t p = order[k];
+            const float r = radius ? radius[p] : 0.0f;
+            minX[k] = x[p] - r;
+            minY[k] = y[p] - r;
+            minZ[k] = z[p] - r;
+            maxX[k] = x[p] + r;
+            maxY[k] = y[p] + r;
+            maxZ[k] = z[p] + r;
+        }
+    }, 16384);
+    refitNodes();
+    refitMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Bvh::cull(const FrustumCuller& culler, std::vector<uint32_t>& visible) const {
+    if (nodes_.empty()) return;
+    uint32_t stack[kStackSize];
+    uint32_t batch[kCullBatch];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const BvhNode& node = nodes_[stack[--top]];
+        CullResult result = culler.classify(node.lo, node.hi);
+        if (result == CullResult::Outside) continue;
+        if (result == CullResult::Inside) {
+            visible.insert(visible.end(), order_.begin() + node.first, order_.begin() + node.first + node.count);
+            continue;
+        }
+        // 与视锥边界相交的小子树不再往下分：图元包围盒按叶子顺序连续，整段做 SIMD 批量测试
+        if (node.left != 0 && node.count > kCullBatch) {
+            stack[top++] = node.left;
+            stack[top++] = node.left + 1;
+            continue;
+        }
+        for (size_t b0 = node.first; b0 < size_t(node.first) + node.count; b0 += kCullBatch) {
+            size_t b1 = std::min<size_t>(size_t(node.first) + node.count, b0 + kCullBatch);
+            size_t count = culler.testRange(boxes_, b0, b1, batch);
+            for (size_t i = 0; i < count; ++i) visible.push_back(order_[batch[i]]);
+        }
+    }
+}
@@ -1,8 +1,9 @@
-﻿// Camera.cpp v 1.2
+﻿// Camera.cpp v 1.3
 #include "Camera.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <cmath>
 
 glm::vec3 Camera::getRight() const {
     // Right = Cross(Front, Up)
@@ -14,7 +15,24 @@ glm::vec3 Camera::getRight() const {
 }
 
 glm::mat4 Camera::getView() const {
-    return glm::lookAt(pos_, pos_ + front_, up_);
+    // 平移部分在双精度下算好再转 float，比直接用 float 位置少一次舍入
+    const glm::dvec3 front(front_);
+    return glm::mat4(glm::lookAt(pos_, pos_ + front, glm::dvec3(up_)));
+}
+
+glm::mat4 Camera::getRenderView() const {
+    const glm::vec3 pos = getRenderPos();
+    return glm::lookAt(pos, pos + front_, up_);
+}
+
+bool Camera::updateOrigin() {
+    if (!(rebaseDistance_ > 0.0)) return false;
+    const glm::dvec3 d = pos_ - origin_;
+    if (std::abs(d.x) <= rebaseDistance_ && std::abs(d.y) <= rebaseDistance_ && std::abs(d.z) <= rebaseDistance_) return false;
+    // 对齐到格子，来回小幅移动不会反复换原点
+    origin_ = glm::floor(pos_ / rebaseDistance_ + 0.5) * rebaseDistance_;
+    ++originVersion_;
+    return true;
 }
 
 Camera::~Camera()
@@ -0,0 +1,468 @@
+﻿// CartoonBuilder v 1.0
+#include "CartoonBuilder.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <glm/glm.hpp>
+
+namespace {
+    // 相邻 Cα 超过此距离视为断链（缺失残基）
+    const float kMaxCaDistance = 4.2f;
+    // 每个环形截面的点数
+    const int kRoundPoints = 8;
+    const int kHelixPoints = 12;
+
+    // 截面：环上的点（宽度方向、厚度方向坐标）与法线，按逆时针排列；
+    // edges 为沿骨架连成四边形的相邻点对（平滑截面首尾相接，矩形只连同一条边上的点）
+    struct ProfileShape {
+        std::vector<glm::vec2> points;
+        std::vector<glm::vec2> normals;
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+    };
+
+    void makeEllipse(ProfileShape& shape, float a, float b, int count) {
+        for (int j = 0; j < count; ++j) {
+            float angle = 6.28318531f * float(j) / float(count);
+            float c = std::cos(angle);
+            float s = std::sin(angle);
+            shape.points.push_back(glm::vec2(a * c, b * s));
+            shape.normals.push_back(glm::normalize(glm::vec2(c / a, s / b)));
+            shape.edges.push_back(std::make_pair(uint32_t(j), uint32_t((j + 1) % count)));
+        }
+    }
+
+    // 矩形每条边两个顶点，法线按面分开，棱角保持锐利
+    void makeRectangle(ProfileShape& shape, float a, float b) {
+        const glm::vec2 corners[5] = { { a, -b }, { a, b }, { -a, b }, { -a, -b }, { a, -b } };
+        const glm::vec2 normals[4] = { { 1.0f, 0.0f }, { 0.0f, 1.0f }, { -1.0f, 0.0f }, { 0.0f, -1.0f } };
+        for (int side = 0; side < 4; ++side) {
+            uint32_t first = uint32_t(shape.points.size());
+            shape.points.push_back(corners[side]);
+            shape.points.push_back(corners[side + 1]);
+            shape.normals.push_back(normals[side]);
+            shape.normals.push_back(normals[side]);
+            shape.edges.push_back(std::make_pair(first, first + 1));
+        }
+    }
+
+    // 均匀 Catmull-Rom 样条在 [p1, p2] 上的位置与导数
+    void catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t,
+        glm::vec3& position, glm::vec3& tangent) {
+        glm::vec3 a = 2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3;
+        glm::vec3 b = -p0 + 3.0f * p1 - 3.0f * p2 + p3;
+        glm::vec3 c = p2 - p0;
+        position = 0.5f * (2.0f * p1 + c * t + a * (t * t) + b * (t * t * t));
+        tangent = 0.5f * (c + 2.0f * a * t + 3.0f * b * (t * t));
+    }
+
+    // 与 t 垂直的任意单位向量
+    glm::vec3 anyPerpendicular(const glm::vec3& t) {
+        glm::vec3 helper = std::fabs(t.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return glm::normalize(glm::cross(t, helper));
+    }
+
+    struct Sample {
+        float u;                // 片段内的样条参数，整数处为残基的 Cα
+        float widthScale;       // 宽度方向的缩放（折叠片箭头）
+    };
+}
+
+void CartoonBuilder::setSubdivisions(int subdivisions) {
+    subdivisions_ = std::max(1, std::min(subdivisions, 64));
+    for (Segment& s : segments_) s.dirty = true;
+}
+
+void CartoonBuilder::prepare(const AtomTable& atoms) {
+    const uint32_t kN = packName4("N", 1);
+    const uint32_t kCA = packName4("CA", 2);
+    const uint32_t kC = packName4("C", 1);
+    const uint32_t kO = packName4("O", 1);
+
+    residues_.clear();
+    traceStart_.clear();
+    profile_.clear();
+    int32_t lastChain = -1;
+    uint32_t lastCa = kNoAtom;
+    for (size_t r = 0; r < atoms.residues.size(); ++r) {
+        const Residue& res = atoms.residues[r];
+        // N、C 也要有，排除名为 CA 的钙离子
+        int64_t found[4] = { -1, -1, -1, -1 };
+        for (uint32_t a = res.firstAtom; a < res.firstAtom + res.atomCount; ++a) {
+            uint32_t name = atoms.name[a];
+            int slot = name == kN ? 0 : name == kCA ? 1 : name == kC ? 2 : name == kO ? 3 : -1;
+            if (slot >= 0 && found[slot] < 0) found[slot] = a;
+        }
+        if (found[0] < 0 || found[1] < 0 || found[2] < 0) continue;
+        TraceResidue t;
+        t.residue = uint32_t(r);
+        t.ca = uint32_t(found[1]);
+        t.o = found[3] >= 0 ? uint32_t(found[3]) : kNoAtom;
+        bool breakHere = residues_.empty() || res.chain != lastChain;
+        if (!breakHere) {
+            float dx = atoms.x[t.ca] - atoms.x[lastCa];
+            float dy = atoms.y[t.ca] - atoms.y[lastCa];
+            float dz = atoms.z[t.ca] - atoms.z[lastCa];
+            breakHere = dx * dx + dy * dy + dz * dz > kMaxCaDistance * kMaxCaDistance;
+        }
+        if (breakHere) traceStart_.push_back(uint32_t(residues_.size()));
+        residues_.push_back(t);
+        profile_.push_back(Profile::Coil);
+        lastChain = res.chain;
+        lastCa = t.ca;
+    }
+    traceStart_.push_back(uint32_t(residues_.size()));
+
+    control_.assign(6 * residues_.size(), 0.0f);
+    changedPrefix_.assign(residues_.size() + 1, 0);
+    hasFrame_ = false;
+    segments_.clear();
+
+    std::vector<SecondaryStructure> ss(atoms.residues.size());
+    for (size_t r = 0; r < atoms.residues.size(); ++r) ss[r] = atoms.residues[r].ss;
+    setSecondaryStructure(ss);
+    // 全部为 Coil 时 setSecondaryStructure 不会分段
+    if (segments_.empty()) splitSegments();
+}
+
+void CartoonBuilder::setSecondaryStructure(const std::vector<SecondaryStructure>& ss) {
+    bool changed = false;
+    for (size_t k = 0; k < residues_.size(); ++k) {
+        uint32_t r = residues_[k].residue;
+        SecondaryStructure s = r < ss.size() ? ss[r] : SecondaryStructure::Coil;
+        Profile p = Profile::Coil;
+        if (s == SecondaryStructure::AlphaHelix || s == SecondaryStructure::Helix310 || s == SecondaryStructure::PiHelix) {
+            p = Profile::Helix;
+        }
+        else if (s == SecondaryStructure::Strand) {
+            p = Profile::Sheet;
+        }
+        changed = changed || p != profile_[k];
+        profile_[k] = p;
+    }
+    if (changed) splitSegments();
+}
+
+uint8_t CartoonBuilder::segmentContext(uint32_t begin, uint32_t end, uint32_t traceBegin, uint32_t traceEnd) const {
+    const int64_t around[4] = { int64_t(begin) - 2, int64_t(begin) - 1, int64_t(end), int64_t(end) + 1 };
+    uint8_t context = 0;
+    for (int k = 0; k < 4; ++k) {
+        bool inside = around[k] >= int64_t(traceBegin) && around[k] < int64_t(traceEnd);
+        context = uint8_t(context << 2) | (inside ? uint8_t(profile_[size_t(around[k])]) : uint8_t(3));
+    }
+    return context;
+}
+
+void CartoonBuilder::splitSegments() {
+    // 新的分段中与旧分段完全相同（区间、截面、相邻截面）的段沿用旧网格
+    std::vector<Segment> old;
+    old.swap(segments_);
+    size_t next = 0;
+    for (size_t t = 0; t + 1 < traceStart_.size(); ++t) {
+        uint32_t t0 = traceStart_[t];
+        uint32_t t1 = traceStart_[t + 1];
+        uint32_t begin = t0;
+        while (begin < t1) {
+            uint32_t end = begin + 1;
+            while (end < t1 && profile_[end] == profile_[begin]) ++end;
+            Segment s;
+            s.begin = begin;
+            s.end = end;
+            s.traceBegin = t0;
+            s.traceEnd = t1;
+            s.profile = profile_[begin];
+            s.context = segmentContext(begin, end, t0, t1);
+            s.dirty = true;
+            s.vertexBegin = kNoAtom;
+            s.indexBegin = kNoAtom;
+            while (next < old.size() && old[next].begin < begin) ++next;
+            if (next < old.size()) {
+                Segment& o = old[next];
+                if (o.begin == begin && o.end == end && o.traceEnd == t1 && o.profile == s.profile &&
+                    o.context == s.context) {
+                    s.dirty = o.dirty;
+                    s.mesh = std::move(o.mesh);
+                    s.vertexBegin = o.vertexBegin;
+                    s.indexBegin = o.indexBegin;
+                }
+            }
+            segments_.push_back(std::move(s));
+            begin = end;
+        }
+    }
+}
+
+void CartoonBuilder::buildSegment(Segment& s, const float* x, const float* y, const float* z) const {
+    Mesh& mesh = s.mesh;
+    mesh.clear();
+    const uint32_t t0 = s.traceBegin;
+    const int m = int(s.traceEnd - t0);
+    if (m < 2) return;
+    const int sb = int(s.begin - t0);
+    const int se = int(s.end - t0);
+
+    // 本段用到的残基窗口 [w0, w1)（片段内下标）：控制点与宽度方向
+    const int w0 = std::max(0, sb - 2);
+    const int w1 = std::min(m, se + 2);
+    auto atomPos = [&](uint32_t a) {
+        return glm::vec3(x[a], y[a], z[a]);
+    };
+    auto caPos = [&](int k) {
+        return atomPos(residues_[t0 + k].ca);
+    };
+    std::vector<glm::vec3> points(size_t(w1 - w0));
+    std::vector<glm::vec3> sides(size_t(w1 - w0));
+    for (int k = w0; k < w1; ++k) {
+        glm::vec3 p = caPos(k);
+        // 折叠片的 Cα 轨迹呈锯齿状，取相邻残基的加权平均拉直
+        if (profile_[t0 + k] == Profile::Sheet && k > 0 && k + 1 < m) p = 0.25f * (caPos(k - 1) + 2.0f * caPos(k) + caPos(k + 1));
+        points[k - w0] = p;
+
+        const TraceResidue& r = residues_[t0 + k];
+        glm::vec3 side(0.0f);
+        if (r.o != kNoAtom) {
+            side = atomPos(r.o) - caPos(k);
+        }
+        else if (k > 0 && k + 1 < m) {
+            side = glm::cross(caPos(k + 1) - caPos(k), caPos(k - 1) - caPos(k));
+        }
+        // 相邻残基的 C=O 大致反向（折叠片上严格交替），翻转成同一侧
+        if (k > w0 && glm::dot(side, sides[k - 1 - w0]) < 0.0f) side = -side;
+        sides[k - w0] = side;
+    }
+    // 片段两端之外的控制点按直线外推
+    auto point = [&](int k) {
+        if (k < 0) return 2.0f * points[0 - w0] - points[1 - w0];
+        if (k >= m) return 2.0f * points[m - 1 - w0] - points[m - 2 - w0];
+        return points[k - w0];
+    };
+
+    // 采样：段占据相邻残基之间的中点到中点，片段两端取到端点残基
+    float u0 = sb == 0 ? 0.0f : float(sb) - 0.5f;
+    float u1 = se == m ? float(m - 1) : float(se) - 0.5f;
+    int baseCount = std::max(2, int(std::ceil((u1 - u0) * float(subdivisions_))) + 1);
+    std::vector<Sample> samples;
+    samples.reserve(size_t(baseCount) + 2);
+    ProfileShape shape;
+    if (s.profile == Profile::Sheet) {
+        // 最后一个残基画成箭头：箭头根部重复一圈截面，两圈之间形成台阶
+        makeRectangle(shape, 0.5f * sheetWidth_, 0.5f * sheetThickness_);
+        float ua = std::max(u0, u1 - 1.0f);
+        float arrow = arrowWidth_ / sheetWidth_;
+        float tip = 2.0f * coilRadius_ / sheetWidth_;
+        for (int i = 0; i < baseCount; ++i) {
+            float u = u0 + (u1 - u0) * float(i) / float(baseCount - 1);
+            if (u < ua) samples.push_back(Sample{ u, 1.0f });
+        }
+        samples.push_back(Sample{ ua, 1.0f });
+        samples.push_back(Sample{ ua, arrow });
+        for (int i = 0; i < baseCount; ++i) {
+            float u = u0 + (u1 - u0) * float(i) / float(baseCount - 1);
+            if (u > ua) samples.push_back(Sample{ u, arrow + (tip - arrow) * (u - ua) / (u1 - ua) });
+        }
+    }
+    else {
+        if (s.profile == Profile::Helix) makeEllipse(shape, 0.5f * helixWidth_, 0.5f * helixThickness_, kHelixPoints);
+        else makeEllipse(shape, coilRadius_, coilRadius_, kRoundPoints);
+        for (int i = 0; i < baseCount; ++i) samples.push_back(Sample{ u0 + (u1 - u0) * float(i) / float(baseCount - 1), 1.0f });
+    }
+
+    const uint32_t ringSize = uint32_t(shape.points.size());
+    const uint32_t rings = uint32_t(samples.size());
+    const uint32_t capBase = rings * ringSize;
+    mesh.resizeVertices(capBase + 2 * (ringSize + 1));
+    mesh.indices.resize(size_t(rings - 1) * shape.edges.size() * 6 + 2 * size_t(ringSize) * 3);
+    float* position = mesh.positions.data();
+    float* normal = mesh.normals.data();
+    uint32_t* atomId = mesh.atomIds.data();
+    auto emit = [&](uint32_t v, const glm::vec3& p, const glm::vec3& nrm, uint32_t atom) {
+        position[3 * v] = p.x;
+        position[3 * v + 1] = p.y;
+        position[3 * v + 2] = p.z;
+        normal[3 * v] = nrm.x;
+        normal[3 * v + 1] = nrm.y;
+        normal[3 * v + 2] = nrm.z;
+        atomId[v] = atom;
+    };
+
+    glm::vec3 firstTangent(0.0f);
+    glm::vec3 lastTangent(0.0f);
+    glm::vec3 prevTangent(1.0f, 0.0f, 0.0f);
+    glm::vec3 prevSide(0.0f);
+    for (uint32_t i = 0; i < rings; ++i) {
+        float u = samples[i].u;
+        int k = std::min(int(std::floor(u)), m - 2);
+        float f = u - float(k);
+        glm::vec3 p;
+        glm::vec3 tangent;
+        catmullRom(point(k - 1), point(k), point(k + 1), point(k + 2), f, p, tangent);
+        float tl = glm::length(tangent);
+        glm::vec3 t = tl > 1e-6f ? tangent / tl : prevTangent;
+
+        // 宽度方向：相邻残基的 C=O 方向插值后与切线正交化
+        glm::vec3 side = sides[k - w0] * (1.0f - f) + sides[k + 1 - w0] * f;
+        side -= t * glm::dot(side, t);
+        float sl = glm::length(side);
+        if (sl > 1e-4f) {
+            side /= sl;
+        }
+        else {
+            side = prevSide - t * glm::dot(prevSide, t);
+            side = glm::length(side) > 1e-4f ? glm::normalize(side) : anyPerpendicular(t);
+        }
+        glm::vec3 binormal = glm::cross(t, side);
+
+        uint32_t atom = residues_[t0 + std::min(m - 1, std::max(0, int(u + 0.5f)))].ca;
+        float scale = samples[i].widthScale;
+        for (uint32_t j = 0; j < ringSize; ++j) {
+            const glm::vec2& q = shape.points[j];
+            const glm::vec2& qn = shape.normals[j];
+            emit(i * ringSize + j, p + side * (q.x * scale) + binormal * q.y,
+                glm::normalize(side * qn.x + binormal * qn.y), atom);
+        }
+        if (i == 0) firstTangent = t;
+        lastTangent = t;
+        prevTangent = t;
+        prevSide = side;
+    }
+
+    // 侧面：相邻两圈截面之间每对相邻点一个四边形
+    uint32_t* index = mesh.indices.data();
+    for (uint32_t i = 0; i + 1 < rings; ++i) {
+        uint32_t r0 = i * ringSize;
+        uint32_t r1 = r0 + ringSize;
+        for (const std::pair<uint32_t, uint32_t>& e : shape.edges) {
+            uint32_t a = r0 + e.first;
+            uint32_t b = r0 + e.second;
+            uint32_t c = r1 + e.first;
+            uint32_t d = r1 + e.second;
+            index[0] = a;
+            index[1] = b;
+            index[2] = c;
+            index[3] = b;
+            index[4] = d;
+            index[5] = c;
+            index += 6;
+        }
+    }
+
+    // 两端封口：截面中心加一圈法线沿切线的顶点
+    for (int end = 0; end < 2; ++end) {
+        uint32_t ring = end == 0 ? 0 : (rings - 1) * ringSize;
+        glm::vec3 capNormal = end == 0 ? -firstTangent : lastTangent;
+        uint32_t center = capBase + uint32_t(end) * (ringSize + 1);
+        glm::vec3 c(0.0f);
+        for (uint32_t j = 0; j < ringSize; ++j) {
+            glm::vec3 p(position[3 * (ring + j)], position[3 * (ring + j) + 1], position[3 * (ring + j) + 2]);
+            c += p;
+            emit(center + 1 + j, p, capNormal, atomId[ring + j]);
+        }
+        emit(center, c / float(ringSize), capNormal, atomId[ring]);
+        for (uint32_t j = 0; j < ringSize; ++j) {
+            uint32_t a = center + 1 + j;
+            uint32_t b = center + 1 + (j + 1) % ringSize;
+            index[0] = center;
+            index[1] = end == 0 ? b : a;
+            index[2] = end == 0 ? a : b;
+            index += 3;
+        }
+    }
+}
+
+void CartoonBuilder::assemble(const std::vector<uint32_t>& rebuilt) {
+    // 重新计算各段在合并网格中的位置，有任何一段移动或总数变化就整体重排
+    uint32_t vertexTotal = 0;
+    uint32_t indexTotal = 0;
+    bool moved = false;
+    for (Segment& s : segments_) {
+        moved = moved || s.vertexBegin != vertexTotal || s.indexBegin != indexTotal;
+        s.vertexBegin = vertexTotal;
+        s.indexBegin = indexTotal;
+        vertexTotal += uint32_t(s.mesh.vertexCount());
+        indexTotal += uint32_t(s.mesh.indices.size());
+    }
+    layoutChanged_ = moved || mesh_.vertexCount() != vertexTotal || mesh_.indices.size() != indexTotal;
+
+    auto copySegment = [&](const Segment& s) {
+        const Mesh& part = s.mesh;
+        size_t nv = part.vertexCount();
+        if (nv > 0) {
+            std::memcpy(&mesh_.positions[3 * size_t(s.vertexBegin)], part.positions.data(), 3 * nv * sizeof(float));
+            std::memcpy(&mesh_.normals[3 * size_t(s.vertexBegin)], part.normals.data(), 3 * nv * sizeof(float));
+            std::memcpy(&mesh_.atomIds[s.vertexBegin], part.atomIds.data(), nv * sizeof(uint32_t));
+        }
+        uint32_t* out = mesh_.indices.data() + s.indexBegin;
+        for (size_t k = 0; k < part.indices.size(); ++k) out[k] = part.indices[k] + s.vertexBegin;
+    };
+
+    changed_.clear();
+    if (layoutChanged_) {
+        mesh_.resizeVertices(vertexTotal);
+        mesh_.indices.resize(indexTotal);
+        ThreadPool::instance().run(segments_.size(), [&](size_t k) {
+            copySegment(segments_[k]);
+        });
+        if (vertexTotal > 0) changed_.push_back(Range{ 0, vertexTotal, 0, indexTotal });
+        return;
+    }
+    ThreadPool::instance().run(rebuilt.size(), [&](size_t k) {
+        copySegment(segments_[rebuilt[k]]);
+    });
+    // rebuilt 按段的顺序排列，段在合并网格中也按此顺序存放
+    for (uint32_t k : rebuilt) {
+        const Segment& s = segments_[k];
+        uint32_t nv = uint32_t(s.mesh.vertexCount());
+        uint32_t ni = uint32_t(s.mesh.indices.size());
+        if (!changed_.empty() && changed_.back().vertexBegin + changed_.back().vertexCount == s.vertexBegin) {
+            changed_.back().vertexCount += nv;
+            changed_.back().indexCount += ni;
+        }
+        else {
+            changed_.push_back(Range{ s.vertexBegin, nv, s.indexBegin, ni });
+        }
+    }
+}
+
+void CartoonBuilder::build(const float* x, const float* y, const float* z) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t n = residues_.size();
+
+    // 与上一帧比较每个残基的 Cα、O 坐标
+    bool all = !hasFrame_;
+    changedPrefix_.resize(n + 1);
+    changedPrefix_[0] = 0;
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t k = b0; k < b1; ++k) {
+            const TraceResidue& r = residues_[k];
+            uint32_t o = r.o != kNoAtom ? r.o : r.ca;
+            float v[6] = { x[r.ca], y[r.ca], z[r.ca], x[o], y[o], z[o] };
+            float* c = &control_[6 * k];
+            bool changed = all || std::memcmp(c, v, sizeof(v)) != 0;
+            if (changed) std::memcpy(c, v, sizeof(v));
+            changedPrefix_[k + 1] = changed ? 1 : 0;
+        }
+    }, 4096);
+    for (size_t k = 0; k < n; ++k) changedPrefix_[k + 1] += changedPrefix_[k];
+    hasFrame_ = true;
+
+    // 段的控制点窗口是前后各两个残基，窗口内折叠片拉直和缺 O 时的宽度方向又要读相邻残基，
+    // 所以段的网格取决于 [begin - 3, end + 3) 的坐标（限制在片段内）
+    std::vector<uint32_t> rebuilt;
+    for (size_t k = 0; k < segments_.size(); ++k) {
+        Segment& s = segments_[k];
+        uint32_t lo = std::max(s.traceBegin, s.begin >= 3 ? s.begin - 3 : 0u);
+        uint32_t hi = std::min(s.traceEnd, s.end + 3);
+        if (s.dirty || changedPrefix_[hi] != changedPrefix_[lo]) rebuilt.push_back(uint32_t(k));
+    }
+    ThreadPool::instance().run(rebuilt.size(), [&](size_t k) {
+        Segment& s = segments_[rebuilt[k]];
+        buildSegment(s, x, y, z);
+        s.dirty = false;
+    });
+    assemble(rebuilt);
+
+    rebuiltSegments_ = rebuilt.size();
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
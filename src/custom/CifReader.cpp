@@ -0,0 +1,563 @@
+﻿// CifReader v 1.0
+#include "CifReader.h"
+#include "Element.h"
+#include "FastNumber.h"
+#include "Parallel.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const size_t kParallelTokenizeBytes = 1 << 20;
+
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // 对 64 字节做分类：返回空白掩码，special 输出引号、';'、'#' 的掩码
+    inline uint64_t classify64(const char* p, uint64_t& special) {
+#if THC_SSE2
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i lf = _mm_set1_epi8('\n');
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i squote = _mm_set1_epi8('\'');
+        const __m128i dquote = _mm_set1_epi8('"');
+        const __m128i semi = _mm_set1_epi8(';');
+        const __m128i hash = _mm_set1_epi8('#');
+        uint64_t ws = 0;
+        special = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+            __m128i w = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+            __m128i s = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, squote), _mm_cmpeq_epi8(v, dquote)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, semi), _mm_cmpeq_epi8(v, hash)));
+            ws |= uint64_t(uint32_t(_mm_movemask_epi8(w))) << (16 * i);
+            special |= uint64_t(uint32_t(_mm_movemask_epi8(s))) << (16 * i);
+        }
+        return ws;
+#else
+        uint64_t ws = 0;
+        special = 0;
+        for (int i = 0; i < 64; ++i) {
+            char c = p[i];
+            if (isSpace(c)) ws |= uint64_t(1) << i;
+            if (c == '\'' || c == '"' || c == ';' || c == '#') special |= uint64_t(1) << i;
+        }
+        return ws;
+#endif
+    }
+
+    // 把 [begin, end) 切分为词元，偏移相对于 base。
+    // 每次处理 64 字节：由空白掩码一次求出所有词元的起止位置，
+    // 只有以引号、行首 ';' 或 '#' 开头的词元才回退到逐字节扫描
+    void tokenizeRange(const char* data, size_t begin, size_t end, size_t base, std::vector<CifToken>& out) {
+        // 输出按块扩容后直接按下标写入，最后再截到实际长度，避免逐个 push_back
+        size_t used = out.size();
+        auto emit = [&](size_t b, size_t e, bool quoted) {
+            CifToken& t = out[used++];
+            t.offset = static_cast<uint32_t>(b - base);
+            t.length = static_cast<uint32_t>(e - b) | (quoted ? CifCategory::kQuotedBit : 0);
+        };
+
+        char pad[64];
+        size_t pos = begin;
+        bool prevSpace = true;
+        bool inToken = false;
+        size_t tokenStart = 0;
+        while (pos < end) {
+            // 一个 64 字节块最多产生 33 个词元
+            if (out.size() - used < 64) out.resize(std::max<size_t>(out.size() * 2, used + 4096));
+            size_t n = std::min<size_t>(64, end - pos);
+            const char* block = data + pos;
+            if (n < 64) {
+                std::memcpy(pad, block, n);
+                std::memset(pad + n, ' ', 64 - n);
+                block = pad;
+            }
+            uint64_t special;
+            uint64_t ws = classify64(block, special);
+            uint64_t nonWs = ~ws;
+            uint64_t starts = nonWs & ((ws << 1) | (prevSpace ? 1u : 0u));
+            uint64_t ends = ws & ((nonWs << 1) | (prevSpace ? 0u : 1u));
+            if (n < 64) {
+                uint64_t limit = (uint64_t(1) << n) - 1;
+                starts &= limit;
+                ends &= limit;
+            }
+
+            if ((starts & special) == 0) {
+                // 常见情况：块内没有特殊词元，起止位置严格交替，直接配对。
+                // 不在词元内时，第一个起点之前的终点没有对应的词元
+                if (!inToken) {
+                    uint64_t first = starts & (0 - starts);
+                    ends &= ~(first - 1);
+                }
+                else if (ends != 0) {
+                    emit(tokenStart, pos + countTrailingZeros64(ends), false);
+                    ends &= ends - 1;
+                    inToken = false;
+                }
+                while (starts != 0 && ends != 0) {
+                    emit(pos + countTrailingZeros64(starts), pos + countTrailingZeros64(ends), false);
+                    starts &= starts - 1;
+                    ends &= ends - 1;
+                }
+                if (starts != 0) {
+                    tokenStart = pos + countTrailingZeros64(starts);
+                    inToken = true;
+                }
+                prevSpace = ((ws >> (n - 1)) & 1) != 0;
+                pos += n;
+                continue;
+            }
+
+            bool restart = false;
+            uint64_t events = starts | ends;
+            while (events != 0) {
+                unsigned bit = countTrailingZeros64(events);
+                events &= events - 1;
+                size_t at = pos + bit;
+                if ((ends >> bit) & 1) {
+                    if (inToken) {
+                        emit(tokenStart, at, false);
+                        inToken = false;
+                    }
+                    continue;
+                }
+
+                if ((special >> bit) & 1) {
+                    char c = data[at];
+                    size_t next = 0;
+                    if (c == '#') {
+                        // 注释直到行尾
+                        const void* nl = std::memchr(data + at, '\n', end - at);
+                        next = nl ? size_t(static_cast<const char*>(nl) - data) : end;
+                    }
+                    else if (c == ';' && (at == 0 || data[at - 1] == '\n')) {
+                        // 多行文本字段，以行首的 ';' 结束
+                        size_t q = at + 1;
+                        for (;;) {
+                            const void* nl = std::memchr(data + q, '\n', end - q);
+                            if (nl == nullptr) {
+                                q = end;
+                                break;
+                            }
+                            q = size_t(static_cast<const char*>(nl) - data);
+                            if (q + 1 < end && data[q + 1] == ';') break;
+                            ++q;
+                        }
+                        emit(at + 1, q, true);
+                        next = std::min(end, q + 2);
+                    }
+                    else if (c == '\'' || c == '"') {
+                        // 引号字符串在“引号后跟空白”处结束
+                        size_t q = at + 1;
+                        while (q < end && !(data[q] == c && (q + 1 >= end || isSpace(data[q + 1])))) ++q;
+                        emit(at + 1, q, true);
+                        next = std::min(end, q + 1);
+                    }
+                    if (next != 0) {
+                        pos = next;
+                        prevSpace = false;
+                        restart = true;
+                        break;
+                    }
+                }
+                tokenStart = at;
+                inToken = true;
+            }
+            if (restart) continue;
+            prevSpace = ((ws >> (n - 1)) & 1) != 0;
+            pos += n;
+        }
+        if (out.size() == used) out.resize(used + 1);
+        if (inToken) emit(tokenStart, end, false);
+        out.resize(used);
+    }
+
+    inline bool startsWith(const char* p, const char* e, const char* prefix) {
+        size_t n = std::strlen(prefix);
+        return size_t(e - p) >= n && std::memcmp(p, prefix, n) == 0;
+    }
+
+    inline std::string_view tokenView(const char* base, const CifToken& t) {
+        return std::string_view(base + t.offset, t.length & ~CifCategory::kQuotedBit);
+    }
+
+    inline bool isTag(const char* base, const CifToken& t) {
+        return (t.length & CifCategory::kQuotedBit) == 0 && base[t.offset] == '_';
+    }
+
+    inline uint32_t packToken(std::string_view v) {
+        if (v == "." || v == "?") return 0;
+        return packName4(v.data(), v.size());
+    }
+
+    inline char insertionCode(std::string_view v) {
+        return (v.empty() || v == "." || v == "?") ? ' ' : v[0];
+    }
+}
+
+int CifCategory::columnIndex(std::string_view item) const {
+    for (size_t i = 0; i < items_.size(); ++i) {
+        if (items_[i] == item) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+float CifCategory::floatValue(size_t row, int column) const {
+    std::string_view v = value(row, column);
+    return parseFloatField(v.data(), v.data() + v.size());
+}
+
+int32_t CifCategory::intValue(size_t row, int column) const {
+    std::string_view v = value(row, column);
+    return parseIntField(v.data(), v.data() + v.size());
+}
+
+bool CifReader::open(const std::string& path) {
+    if (!file_.open(path)) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    return parse(file_.data(), file_.size());
+}
+
+bool CifReader::parse(const char* data, size_t size) {
+    error_.clear();
+    data_ = data;
+    size_ = size;
+    categories_.clear();
+    buildIndex();
+    if (categories_.empty()) {
+        error_ = "no categories found";
+        return false;
+    }
+    return true;
+}
+
+// 行级扫描：只看每行首字符即可确定类别边界，数据行本身不分词
+void CifReader::buildIndex() {
+    enum class Mode { None, LoopTags, LoopValues, KeyValue };
+    Mode mode = Mode::None;
+    bool inText = false;
+    bool seenData = false;
+    CategoryEntry* current = nullptr;
+
+    const char* p = data_;
+    const char* end = data_ + size_;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        const char* next = eol ? eol + 1 : end;
+        if (eol == nullptr) eol = end;
+
+        if (inText) {
+            if (*p == ';') inText = false;
+            if (current) current->end = size_t(next - data_);
+            p = next;
+            continue;
+        }
+
+        const char* s = p;
+        while (s < eol && (*s == ' ' || *s == '\t')) ++s;
+        if (s == eol || *s == '#' || *s == '\r') {
+            p = next;
+            continue;
+        }
+
+        if (*p == ';') {
+            inText = true;
+            if (current) {
+                // loop_ 的第一个值也可能是文本字段
+                if (mode == Mode::LoopTags) {
+                    mode = Mode::LoopValues;
+                    current->valuesBegin = size_t(p - data_);
+                }
+                current->hasTextField = true;
+                current->end = size_t(next - data_);
+            }
+            p = next;
+            continue;
+        }
+
+        if (*s == '_') {
+            const char* dot = s;
+            while (dot < eol && *dot != '.' && !isSpace(*dot)) ++dot;
+            std::string_view name(s, size_t(dot - s));
+            if (mode == Mode::LoopTags && current) {
+                if (current->name.empty()) current->name = name;
+            }
+            else if (!(mode == Mode::KeyValue && current && current->name == name)) {
+                categories_.emplace_back();
+                current = &categories_.back();
+                current->name = name;
+                current->begin = size_t(p - data_);
+                mode = Mode::KeyValue;
+            }
+            current->end = size_t(next - data_);
+            p = next;
+            continue;
+        }
+
+        if (startsWith(s, eol, "loop_")) {
+            categories_.emplace_back();
+            current = &categories_.back();
+            current->begin = size_t(p - data_);
+            current->loop = true;
+            current->end = size_t(next - data_);
+            mode = Mode::LoopTags;
+            p = next;
+            continue;
+        }
+
+        if (startsWith(s, eol, "data_")) {
+            if (seenData) break;
+            seenData = true;
+            mode = Mode::None;
+            current = nullptr;
+            p = next;
+            continue;
+        }
+
+        if (current) {
+            if (mode == Mode::LoopTags) {
+                mode = Mode::LoopValues;
+                current->valuesBegin = size_t(p - data_);
+            }
+            current->end = size_t(next - data_);
+        }
+        p = next;
+    }
+
+    // 去掉没有任何条目的 loop_
+    categories_.erase(std::remove_if(categories_.begin(), categories_.end(),
+        [](const CategoryEntry& e) { return e.name.empty(); }), categories_.end());
+}
+
+CifReader::CategoryEntry* CifReader::findEntry(std::string_view name) {
+    for (CategoryEntry& e : categories_) {
+        if (e.name == name) return &e;
+    }
+    return nullptr;
+}
+
+bool CifReader::hasCategory(std::string_view name) const {
+    for (const CategoryEntry& e : categories_) {
+        if (e.name == name) return true;
+    }
+    return false;
+}
+
+std::vector<std::string_view> CifReader::categoryNames() const {
+    std::vector<std::string_view> names;
+    names.reserve(categories_.size());
+    for (const CategoryEntry& e : categories_) names.push_back(e.name);
+    return names;
+}
+
+void CifReader::materialize(CategoryEntry& entry) {
+    std::unique_ptr<CifCategory> cat(new CifCategory());
+    const char* base = data_ + entry.begin;
+    cat->base_ = base;
+    size_t prefix = entry.name.size() + 1;
+
+    if (!entry.loop) {
+        // 键值对形式：tag value tag value ...
+        std::vector<CifToken> tokens;
+        tokenizeRange(data_, entry.begin, entry.end, entry.begin, tokens);
+        for (size_t i = 0; i + 1 < tokens.size(); i += 2) {
+            std::string_view tag = tokenView(base, tokens[i]);
+            cat->items_.push_back(tag.size() > prefix ? tag.substr(prefix) : std::string_view());
+            cat->values_.push_back(tokens[i + 1]);
+        }
+        cat->columns_ = cat->items_.size();
+        entry.data = std::move(cat);
+        return;
+    }
+
+    // loop_：先处理表头，再切分数据区
+    size_t valuesBegin = entry.valuesBegin != 0 ? entry.valuesBegin : entry.end;
+    std::vector<CifToken> header;
+    tokenizeRange(data_, entry.begin, valuesBegin, entry.begin, header);
+    for (const CifToken& t : header) {
+        if (!isTag(base, t)) continue;
+        std::string_view tag = tokenView(base, t);
+        cat->items_.push_back(tag.size() > prefix ? tag.substr(prefix) : std::string_view());
+    }
+    cat->columns_ = cat->items_.size();
+
+    size_t bytes = entry.end - valuesBegin;
+    if (entry.hasTextField || bytes < kParallelTokenizeBytes) {
+        cat->values_.reserve(bytes / 6);
+        tokenizeRange(data_, valuesBegin, entry.end, entry.begin, cat->values_);
+    }
+    else {
+        // 没有多行文本字段时，数据区可以按行切开并行分词
+        size_t pieces = std::min<size_t>(bytes / kParallelTokenizeBytes + 1, size_t(workerCount()) * 4);
+        std::vector<size_t> bounds(pieces + 1);
+        bounds[0] = valuesBegin;
+        bounds[pieces] = entry.end;
+        for (size_t i = 1; i < pieces; ++i) {
+            size_t target = std::max(bounds[i - 1], valuesBegin + bytes * i / pieces);
+            const void* nl = std::memchr(data_ + target, '\n', entry.end - target);
+            bounds[i] = nl ? size_t(static_cast<const char*>(nl) - data_) + 1 : entry.end;
+        }
+        std::vector<std::vector<CifToken>> parts(pieces);
+        ThreadPool::instance().run(pieces, [&](size_t i) {
+            parts[i].reserve((bounds[i + 1] - bounds[i]) / 6);
+            tokenizeRange(data_, bounds[i], bounds[i + 1], entry.begin, parts[i]);
+        });
+        size_t total = 0;
+        for (const auto& part : parts) total += part.size();
+        cat->values_.reserve(total);
+        for (const auto& part : parts) cat->values_.insert(cat->values_.end(), part.begin(), part.end());
+    }
+
+    // 截去不完整的最后一行
+    if (cat->columns_ != 0) {
+        cat->values_.resize(cat->values_.size() - cat->values_.size() % cat->columns_);
+    }
+    entry.data = std::move(cat);
+}
+
+const CifCategory* CifReader::category(std::string_view name) {
+    CategoryEntry* entry = findEntry(name);
+    if (entry == nullptr) return nullptr;
+    if (!entry->data) materialize(*entry);
+    return entry->data.get();
+}
+
+void CifReader::releaseCategory(std::string_view name) {
+    CategoryEntry* entry = findEntry(name);
+    if (entry) entry->data.reset();
+}
+
+bool CifReader::loadAtomSite(AtomTable& out) {
+    out.clear();
+    const CifCategory* atoms = category("_atom_site");
+    if (atoms == nullptr) {
+        error_ = "missing _atom_site";
+        return false;
+    }
+
+    auto pick = [&](const char* a, const char* b) {
+        int i = atoms->columnIndex(a);
+        return (i < 0 && b != nullptr) ? atoms->columnIndex(b) : i;
+    };
+    int colGroup = pick("group_PDB", nullptr);
+    int colType = pick("type_symbol", nullptr);
+    int colAtom = pick("auth_atom_id", "label_atom_id");
+    int colAlt = pick("label_alt_id", nullptr);
+    int colComp = pick("auth_comp_id", "label_comp_id");
+    int colAuthChain = pick("auth_asym_id", "label_asym_id");
+    int colLabelChain = pick("label_asym_id", "auth_asym_id");
+    int colSeq = pick("auth_seq_id", "label_seq_id");
+    int colIns = pick("pdbx_PDB_ins_code", nullptr);
+    int colX = pick("Cartn_x", nullptr);
+    int colY = pick("Cartn_y", nullptr);
+    int colZ = pick("Cartn_z", nullptr);
+    int colModel = pick("pdbx_PDB_model_num", nullptr);
+    if (colX < 0 || colY < 0 || colZ < 0) {
+        error_ = "_atom_site has no Cartn_x/y/z";
+        return false;
+    }
+
+    size_t rows = atoms->rowCount();
+    int32_t firstModel = (colModel >= 0 && rows > 0) ? atoms->intValue(0, colModel) : 0;
+    auto keep = [&](size_t r) {
+        if (colModel >= 0 && atoms->intValue(r, colModel) != firstModel) return false;
+        if (colAlt >= 0 && !atoms->isNull(r, colAlt)) {
+            std::string_view alt = atoms->value(r, colAlt);
+            return alt == "A" || alt == "1";
+        }
+        return true;
+    };
+
+    // 第一遍：每块统计保留的行数
+    const size_t grain = 16384;
+    size_t blocks = (rows + grain - 1) / grain;
+    std::vector<size_t> offsets(blocks + 1, 0);
+    ThreadPool::instance().run(blocks, [&](size_t b) {
+        size_t n = 0;
+        for (size_t r = b * grain, e = std::min(rows, r + grain); r < e; ++r) {
+            if (keep(r)) ++n;
+        }
+        offsets[b + 1] = n;
+    });
+    for (size_t b = 0; b < blocks; ++b) offsets[b + 1] += offsets[b];
+    size_t count = offsets[blocks];
+    out.resizeAtoms(count);
+
+    // 第二遍：并行写入原子数组，残基键暂存到临时数组
+    std::vector<int32_t> seq(count);
+    std::vector<char> insertion(count);
+    std::vector<uint32_t> comp(count), authChain(count), labelChain(count);
+    ThreadPool::instance().run(blocks, [&](size_t b) {
+        size_t o = offsets[b];
+        for (size_t r = b * grain, e = std::min(rows, r + grain); r < e; ++r) {
+            if (!keep(r)) continue;
+            out.x[o] = atoms->floatValue(r, colX);
+            out.y[o] = atoms->floatValue(r, colY);
+            out.z[o] = atoms->floatValue(r, colZ);
+            std::string_view type = colType >= 0 ? atoms->value(r, colType) : std::string_view();
+            out.element[o] = elementFromSymbol(type.data(), type.size());
+            out.name[o] = colAtom >= 0 ? packToken(atoms->value(r, colAtom)) : 0;
+            out.flags[o] = (colGroup >= 0 && atoms->value(r, colGroup) == "HETATM") ? AtomHetero : 0;
+            seq[o] = colSeq >= 0 ? atoms->intValue(r, colSeq) : 0;
+            insertion[o] = colIns >= 0 ? insertionCode(atoms->value(r, colIns)) : ' ';
+            comp[o] = colComp >= 0 ? packToken(atoms->value(r, colComp)) : 0;
+            authChain[o] = colAuthChain >= 0 ? packToken(atoms->value(r, colAuthChain)) : 0;
+            labelChain[o] = colLabelChain >= 0 ? packToken(atoms->value(r, colLabelChain)) : 0;
+            ++o;
+        }
+    });
+
+    // 残基与链：label_asym_id 变化即新链（相当于 PDB 的 TER），链名使用 auth_asym_id
+    buildResidues(out, seq.data(), insertion.data(), comp.data(), authChain.data(), labelChain.data());
+
+    if (count == 0) {
+        error_ = "_atom_site is empty";
+        return false;
+    }
+    return true;
+}
+
+void CifReader::loadSecondaryStructure(AtomTable& out) {
+    std::vector<SecondaryStructureRange> ranges;
+
+    auto collect = [&](const char* name, bool helix) {
+        const CifCategory* cat = category(name);
+        if (cat == nullptr) return;
+        int colType = cat->columnIndex("conf_type_id");
+        int colBegChain = cat->columnIndex("beg_auth_asym_id");
+        int colBegSeq = cat->columnIndex("beg_auth_seq_id");
+        int colBegIns = cat->columnIndex("pdbx_beg_PDB_ins_code");
+        int colEndSeq = cat->columnIndex("end_auth_seq_id");
+        int colEndIns = cat->columnIndex("pdbx_end_PDB_ins_code");
+        if (colBegChain < 0 || colBegSeq < 0 || colEndSeq < 0) return;
+
+        for (size_t r = 0; r < cat->rowCount(); ++r) {
+            SecondaryStructureRange s;
+            s.type = SecondaryStructure::Strand;
+            if (helix) {
+                std::string_view type = colType >= 0 ? cat->value(r, colType) : std::string_view("HELX_P");
+                if (type.compare(0, 4, "TURN") == 0) s.type = SecondaryStructure::Turn;
+                else if (type == "HELX_RH_3T_P") s.type = SecondaryStructure::Helix310;
+                else if (type == "HELX_RH_PI_P") s.type = SecondaryStructure::PiHelix;
+                else if (type.compare(0, 4, "STRN") == 0) s.type = SecondaryStructure::Strand;
+                else s.type = SecondaryStructure::AlphaHelix;
+            }
+            s.chain = packToken(cat->value(r, colBegChain));
+            s.beginSeq = cat->intValue(r, colBegSeq);
+            s.beginInsertion = colBegIns >= 0 ? insertionCode(cat->value(r, colBegIns)) : ' ';
+            s.endSeq = cat->intValue(r, colEndSeq);
+            s.endInsertion = colEndIns >= 0 ? insertionCode(cat->value(r, colEndIns)) : ' ';
+            ranges.push_back(s);
+        }
+    };
+    collect("_struct_conf", true);
+    collect("_struct_sheet_range", false);
+    applySecondaryStructure(out, ranges);
+}
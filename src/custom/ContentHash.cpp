@@ -0,0 +1,107 @@
+﻿// ContentHash v 1.0
+#include "ContentHash.h"
+#include "Parallel.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+    const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+    const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+    const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+    const size_t kBlockBytes = 4u << 20;
+
+    inline uint64_t rotl(uint64_t v, int r) {
+        return (v << r) | (v >> (64 - r));
+    }
+
+    inline uint64_t read64(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+
+    inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    inline uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+        acc ^= round(0, value);
+        return acc * kPrime1 + kPrime4;
+    }
+}
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else {
+        h = seed + kPrime5;
+    }
+    h += uint64_t(size);
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= uint64_t(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= uint64_t(*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t hashContent(const void* data, size_t size) {
+    if (size <= kBlockBytes) return hashBytes(data, size, 0);
+
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    size_t blocks = (size + kBlockBytes - 1) / kBlockBytes;
+    std::vector<uint64_t> hashes(blocks);
+    ThreadPool::instance().run(blocks, [&](size_t b) {
+        size_t offset = b * kBlockBytes;
+        size_t n = size - offset < kBlockBytes ? size - offset : kBlockBytes;
+        hashes[b] = hashBytes(p + offset, n, uint64_t(b));
+    });
+    return hashBytes(hashes.data(), hashes.size() * sizeof(uint64_t), uint64_t(size));
+}
@@ -0,0 +1,195 @@
+﻿// DcdReader v 1.0
+#include "DcdReader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // AKMA 时间单位换算为 ps
+    const float kAkmaToPs = 0.04888821f;
+
+    inline uint32_t swap32(uint32_t v) {
+        return (v >> 24) | ((v >> 8) & 0xFF00u) | ((v << 8) & 0xFF0000u) | (v << 24);
+    }
+
+    inline uint32_t readU32(const uint8_t* p, bool swap) {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return swap ? swap32(v) : v;
+    }
+
+    inline float readF32(const uint8_t* p, bool swap) {
+        uint32_t v = readU32(p, swap);
+        float f;
+        std::memcpy(&f, &v, 4);
+        return f;
+    }
+
+    inline double readF64(const uint8_t* p, bool swap) {
+        uint64_t lo = readU32(p, swap);
+        uint64_t hi = readU32(p + 4, swap);
+        uint64_t v = swap ? (lo << 32) | hi : (hi << 32) | lo;
+        double d;
+        std::memcpy(&d, &v, 8);
+        return d;
+    }
+
+    // 一条 Fortran 记录：前后各一个长度标记，返回记录体长度，不合法时返回 -1
+    int64_t recordLength(const RandomAccessFile& file, uint64_t offset, bool swap) {
+        uint8_t marker[4];
+        if (!file.readAt(offset, marker, 4)) return -1;
+        uint32_t n = readU32(marker, swap);
+        uint8_t tail[4];
+        if (!file.readAt(offset + 4 + n, tail, 4) || readU32(tail, swap) != n) return -1;
+        return int64_t(n);
+    }
+
+    // 晶胞记录 A, gamma, B, beta, alpha, C 转为盒子向量。
+    // NAMD 写角度的余弦，CHARMM 写角度（度）
+    void cellToBox(const double cell[6], float box[9]) {
+        double a = cell[0], b = cell[2], c = cell[5];
+        double cosAngle[3] = { cell[4], cell[3], cell[1] };     // alpha, beta, gamma
+        for (int k = 0; k < 3; ++k) {
+            if (std::fabs(cosAngle[k]) > 1.0) cosAngle[k] = std::cos(cosAngle[k] * 3.14159265358979323846 / 180.0);
+        }
+        double sinGamma = std::sqrt(std::max(0.0, 1.0 - cosAngle[2] * cosAngle[2]));
+        double cx = c * cosAngle[1];
+        double cy = sinGamma > 0.0 ? c * (cosAngle[0] - cosAngle[1] * cosAngle[2]) / sinGamma : 0.0;
+        double cz = std::sqrt(std::max(0.0, c * c - cx * cx - cy * cy));
+        float values[9] = { float(a), 0.0f, 0.0f,
+            float(b * cosAngle[2]), float(b * sinGamma), 0.0f,
+            float(cx), float(cy), float(cz) };
+        std::memcpy(box, values, sizeof(values));
+    }
+}
+
+bool DcdReader::open(const std::string& path) {
+    close();
+    error_.clear();
+    if (!file_.open(path)) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+
+    // 第一条记录固定 84 字节："CORD" + 20 个控制字
+    uint8_t head[92];
+    if (!file_.readAt(0, head, sizeof(head))) {
+        error_ = "file too short for DCD header";
+        close();
+        return false;
+    }
+    uint32_t first;
+    std::memcpy(&first, head, 4);
+    if (first == 84) swap_ = false;
+    else if (swap32(first) == 84) swap_ = true;
+    else {
+        error_ = "not a DCD file";
+        close();
+        return false;
+    }
+    if (std::memcmp(head + 4, "CORD", 4) != 0 || readU32(head + 88, swap_) != 84) {
+        error_ = "not a DCD file";
+        close();
+        return false;
+    }
+
+    const uint8_t* icntrl = head + 8;
+    bool charmm = readU32(icntrl + 4 * 19, swap_) != 0;
+    uint32_t fixedAtoms = readU32(icntrl + 4 * 8, swap_);
+    firstStep_ = int32_t(readU32(icntrl + 4, swap_));
+    stepInterval_ = int32_t(readU32(icntrl + 8, swap_));
+    if (stepInterval_ == 0) stepInterval_ = 1;
+    // CHARMM 格式的时间步长是 float，X-PLOR 格式是占两个控制字的 double
+    double delta = charmm ? double(readF32(icntrl + 4 * 9, swap_)) : readF64(icntrl + 4 * 9, swap_);
+    timeStep_ = float(delta) * kAkmaToPs;
+    hasCell_ = charmm && readU32(icntrl + 4 * 10, swap_) != 0;
+    bool has4d = charmm && readU32(icntrl + 4 * 11, swap_) != 0;
+    if (fixedAtoms != 0) {
+        error_ = "DCD files with fixed atoms are not supported";
+        close();
+        return false;
+    }
+
+    // 标题记录长度不定，原子数记录固定 4 字节
+    uint64_t offset = 92;
+    int64_t titleLength = recordLength(file_, offset, swap_);
+    if (titleLength < 0) {
+        error_ = "malformed DCD title";
+        close();
+        return false;
+    }
+    offset += 8 + uint64_t(titleLength);
+    uint8_t natoms[12];
+    if (!file_.readAt(offset, natoms, sizeof(natoms)) || readU32(natoms, swap_) != 4 || readU32(natoms + 8, swap_) != 4) {
+        error_ = "malformed DCD atom count";
+        close();
+        return false;
+    }
+    atomCount_ = readU32(natoms + 4, swap_);
+    headerSize_ = offset + 12;
+
+    uint64_t axis = 8 + 4 * uint64_t(atomCount_);
+    frameSize_ = (hasCell_ ? 56 : 0) + axis * (has4d ? 4 : 3);
+    frameCount_ = size_t(atomCount_ == 0 || file_.size() < headerSize_ ? 0 : (file_.size() - headerSize_) / frameSize_);
+    if (frameCount_ == 0) {
+        error_ = "no DCD frames";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void DcdReader::close() {
+    file_.close();
+    atomCount_ = 0;
+    frameCount_ = 0;
+    headerSize_ = 0;
+    frameSize_ = 0;
+    swap_ = false;
+    hasCell_ = false;
+}
+
+bool DcdReader::frameExtent(size_t index, uint64_t& offset, size_t& size) const {
+    if (index >= frameCount_) return false;
+    offset = headerSize_ + uint64_t(index) * frameSize_;
+    // 四维坐标记录不需要读取
+    size = size_t((hasCell_ ? 56 : 0) + 3 * (8 + 4 * uint64_t(atomCount_)));
+    return true;
+}
+
+bool DcdReader::decodeFrame(size_t index, const uint8_t* data, size_t size, TrajectoryFrame& out) const {
+    size_t expected = size_t((hasCell_ ? 56 : 0) + 3 * (8 + 4 * uint64_t(atomCount_)));
+    if (index >= frameCount_ || size < expected) return false;
+
+    const uint8_t* p = data;
+    if (hasCell_) {
+        if (readU32(p, swap_) != 48) return false;
+        double cell[6];
+        for (int k = 0; k < 6; ++k) cell[k] = readF64(p + 4 + 8 * k, swap_);
+        cellToBox(cell, out.box);
+        p += 56;
+    }
+    else {
+        std::memset(out.box, 0, sizeof(out.box));
+    }
+
+    out.resize(atomCount_);
+    float* axes[3] = { out.x.data(), out.y.data(), out.z.data() };
+    uint32_t bytes = uint32_t(4 * atomCount_);
+    for (int k = 0; k < 3; ++k) {
+        if (readU32(p, swap_) != bytes || readU32(p + 4 + bytes, swap_) != bytes) return false;
+        const uint8_t* c = p + 4;
+        if (!swap_) {
+            std::memcpy(axes[k], c, bytes);
+        }
+        else {
+            for (size_t a = 0; a < atomCount_; ++a) axes[k][a] = readF32(c + 4 * a, true);
+        }
+        p += 8 + bytes;
+    }
+
+    out.step = firstStep_ + int64_t(index) * stepInterval_;
+    out.time = float(out.step) * timeStep_;
+    out.index = index;
+    return true;
+}
@@ -0,0 +1,34 @@
+﻿// DirtyRanges v 1.0
+#include "DirtyRanges.h"
+#include <algorithm>
+
+void DirtyRanges::mark(size_t begin, size_t end, size_t limit) {
+    end = std::min(end, limit);
+    if (begin >= end) return;
+    uint32_t b = uint32_t(begin);
+    uint32_t e = uint32_t(end);
+    uint32_t gap = kMergeGap;
+
+    // 第一个可能与新区间合并的区间：end + gap >= b
+    auto first = std::lower_bound(ranges_.begin(), ranges_.end(), b, [gap](const Range& r, uint32_t v) {
+        return r.end + gap < v;
+    });
+    auto last = first;
+    while (last != ranges_.end() && last->begin <= e + gap) {
+        b = std::min(b, last->begin);
+        e = std::max(e, last->end);
+        ++last;
+    }
+    if (first == last) {
+        ranges_.insert(first, Range{ b, e });
+        return;
+    }
+    *first = Range{ b, e };
+    ranges_.erase(first + 1, last);
+}
+
+size_t DirtyRanges::count() const {
+    size_t total = 0;
+    for (const Range& r : ranges_) total += r.end - r.begin;
+    return total;
+}
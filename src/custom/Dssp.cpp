@@ -0,0 +1,532 @@
+﻿// Dssp v 1.0
+#include "Dssp.h"
+#include "Parallel.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+
+namespace {
+    const float kCouplingConstant = -27.888f;   // -332 * 0.42 * 0.2
+    const float kMinHBondEnergy = -9.9f;
+    const float kMaxHBondEnergy = -0.5f;
+    const float kMinimalDistance = 0.5f;
+    const float kMinimalCADistance = 9.0f;
+    const float kMaxPeptideBondLength = 2.5f;
+
+    enum HelixFlag : uint8_t {
+        HelixNone = 0,
+        HelixStart,
+        HelixEnd,
+        HelixStartAndEnd,
+        HelixMiddle
+    };
+
+    enum class BridgeType : uint8_t {
+        None,
+        Parallel,
+        AntiParallel
+    };
+
+    struct Bridge {
+        uint32_t i;
+        uint32_t j;
+        BridgeType type;
+    };
+
+    // 梯子：连续的 β 桥，i、j 为两条链上的残基位置
+    struct Ladder {
+        BridgeType type;
+        int32_t chainI;
+        std::deque<uint32_t> i;
+        std::deque<uint32_t> j;
+    };
+
+    inline float distance(const float* a, const float* b) {
+        float dx = a[0] - b[0];
+        float dy = a[1] - b[1];
+        float dz = a[2] - b[2];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    inline void copy3(float* dst, const float* x, const float* y, const float* z, uint32_t atom) {
+        dst[0] = x[atom];
+        dst[1] = y[atom];
+        dst[2] = z[atom];
+    }
+
+    inline bool isHelixStart(const std::vector<uint8_t>& flags, size_t residue, int stride) {
+        uint8_t f = flags[residue * 3 + (stride - 3)];
+        return f == HelixStart || f == HelixStartAndEnd;
+    }
+}
+
+void Dssp::prepare(const AtomTable& atoms) {
+    const uint32_t kN = packName4("N", 1);
+    const uint32_t kCA = packName4("CA", 2);
+    const uint32_t kC = packName4("C", 1);
+    const uint32_t kO = packName4("O", 1);
+    const uint32_t kPro = packName4("PRO", 3);
+
+    backbone_.clear();
+    chainStart_.clear();
+    residueCount_ = atoms.residues.size();
+    for (size_t r = 0; r < atoms.residues.size(); ++r) {
+        const Residue& res = atoms.residues[r];
+        // 有多个构象时取第一次出现的原子
+        int64_t found[4] = { -1, -1, -1, -1 };
+        for (uint32_t a = res.firstAtom; a < res.firstAtom + res.atomCount; ++a) {
+            uint32_t name = atoms.name[a];
+            int slot = name == kN ? 0 : name == kCA ? 1 : name == kC ? 2 : name == kO ? 3 : -1;
+            if (slot >= 0 && found[slot] < 0) found[slot] = a;
+        }
+        if (found[0] < 0 || found[1] < 0 || found[2] < 0 || found[3] < 0) continue;
+        Backbone b;
+        b.residue = uint32_t(r);
+        b.n = uint32_t(found[0]);
+        b.ca = uint32_t(found[1]);
+        b.c = uint32_t(found[2]);
+        b.o = uint32_t(found[3]);
+        b.chain = res.chain;
+        b.proline = res.name == kPro;
+        if (backbone_.empty() || backbone_.back().chain != b.chain) chainStart_.push_back(uint32_t(backbone_.size()));
+        backbone_.push_back(b);
+    }
+    chainStart_.push_back(uint32_t(backbone_.size()));
+    gridReady_ = false;
+}
+
+void Dssp::loadFrame(const float* x, const float* y, const float* z) {
+    size_t n = backbone_.size();
+    frame_.resize(n);
+    segment_.resize(n);
+    caX_.resize(n);
+    caY_.resize(n);
+    caZ_.resize(n);
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t k = b0; k < b1; ++k) {
+            const Backbone& b = backbone_[k];
+            BackboneFrame& f = frame_[k];
+            copy3(f.n, x, y, z, b.n);
+            copy3(f.ca, x, y, z, b.ca);
+            copy3(f.c, x, y, z, b.c);
+            copy3(f.o, x, y, z, b.o);
+            caX_[k] = f.ca[0];
+            caY_[k] = f.ca[1];
+            caZ_[k] = f.ca[2];
+            // 能量是 C=O 电势在 N、H 两点之差，|E| <= 27.888 * 2 * |NH| * |CO| / (R - |NH| - |CO|)^3，
+            // R 为 N…O 距离，|NH| <= 1。R 超过下面的距离时 |E| < 0.5，不可能成键，
+            // 跳过不影响结果（按本帧实际的 C=O 键长计算，变形的结构同样成立）
+            float co = distance(f.c, f.o);
+            float reach = 1.0f + co + std::cbrt(2.0f * kCouplingConstant * co / kMaxHBondEnergy);
+            f.reach2 = reach * reach;
+        }
+    });
+
+    // 不同链或 C(i-1)-N(i) 超过肽键长度视为断链
+    uint32_t seg = 0;
+    for (size_t k = 0; k < n; ++k) {
+        if (k > 0 && (backbone_[k].chain != backbone_[k - 1].chain ||
+            distance(frame_[k - 1].c, frame_[k].n) > kMaxPeptideBondLength)) {
+            ++seg;
+        }
+        segment_[k] = seg;
+    }
+
+    // 酰胺氢：N 沿前一残基 O→C 方向 1 Å；链首或断链后取 N 本身（能量恒为 0，不会成键）
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t k = b0; k < b1; ++k) {
+            BackboneFrame& f = frame_[k];
+            if (k > 0 && segment_[k] == segment_[k - 1]) {
+                const BackboneFrame& p = frame_[k - 1];
+                float d[3] = { p.c[0] - p.o[0], p.c[1] - p.o[1], p.c[2] - p.o[2] };
+                float len = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+                float inv = len > 0.0f ? 1.0f / len : 0.0f;
+                for (int a = 0; a < 3; ++a) f.h[a] = f.n[a] + d[a] * inv;
+            }
+            else {
+                for (int a = 0; a < 3; ++a) f.h[a] = f.n[a];
+            }
+        }
+    });
+}
+
+void Dssp::computeHBonds() {
+    size_t n = backbone_.size();
+    if (!gridReady_ || caGrid_.atomCount() != n) {
+        caGrid_.build(caX_.data(), caY_.data(), caZ_.data(), n, kMinimalCADistance);
+        gridReady_ = true;
+    }
+    else {
+        caGrid_.update(caX_.data(), caY_.data(), caZ_.data());
+    }
+
+    // 与 mkdssp 相同：Cα 距离小于 9 Å 才计算，受体紧挨在供体前面时不计算。
+    // 每对残基只枚举一次，两个方向都算；按格子区间并行，各块先收集 N…O 距离在 reach 之内的组合，
+    // 再成批计算能量，只留下低于 -0.5 的候选，较弱的氢键永远不会通过 testBond，也挤不掉更强的
+    const float minCA2 = kMinimalCADistance * kMinimalCADistance;
+    size_t blocks = std::min<size_t>(caGrid_.cellCount(), size_t(workerCount()) * 8);
+    candidates_.resize(blocks);
+    ThreadPool::instance().run(blocks, [&](size_t b) {
+        std::vector<HBondCandidate>& out = candidates_[b];
+        size_t count = 0;
+        out.resize(std::max<size_t>(out.size(), 256));
+        // 不分支地追加：先写到末尾，够近才让计数加一
+        auto tryBond = [&](uint32_t d, uint32_t a) {
+            const BackboneFrame& donor = frame_[d];
+            const BackboneFrame& acceptor = frame_[a];
+            float ox = donor.n[0] - acceptor.o[0];
+            float oy = donor.n[1] - acceptor.o[1];
+            float oz = donor.n[2] - acceptor.o[2];
+            out[count] = HBondCandidate{ d, a, 0.0f };
+            count += size_t(ox * ox + oy * oy + oz * oz <= acceptor.reach2) & size_t(a + 1 != d) &
+                size_t(!backbone_[d].proline);
+        };
+        caGrid_.forEachPair(kMinimalCADistance, [&](uint32_t i, uint32_t j, float d2) {
+            if (d2 >= minCA2) return;
+            if (count + 2 > out.size()) out.resize(2 * out.size());
+            tryBond(i, j);
+            tryBond(j, i);
+        }, b, blocks);
+        out.resize(count);
+        evaluateHBonds(out);
+    });
+
+    // 每个供体保留能量最低的两个受体。能量相同时下标小的优先，
+    // 与 mkdssp 按下标顺序逐个比较的结果相同，与收集顺序无关
+    acceptors_.assign(2 * n, HBond{ -1, 0.0f });
+    auto better = [](float e, uint32_t a, const HBond& h) {
+        return e < h.energy || (e == h.energy && h.partner >= 0 && int32_t(a) < h.partner);
+    };
+    for (const std::vector<HBondCandidate>& block : candidates_) {
+        for (const HBondCandidate& c : block) {
+            HBond* best = &acceptors_[2 * c.donor];
+            if (better(c.energy, c.acceptor, best[0])) {
+                best[1] = best[0];
+                best[0] = HBond{ int32_t(c.acceptor), c.energy };
+            }
+            else if (better(c.energy, c.acceptor, best[1])) {
+                best[1] = HBond{ int32_t(c.acceptor), c.energy };
+            }
+        }
+    }
+}
+
+void Dssp::evaluateHBonds(std::vector<HBondCandidate>& list) const {
+    size_t kept = 0;
+    auto finish = [&](const HBondCandidate& c, float e) {
+        // 与 DSSP 输出一致，保留三位小数
+        e = std::round(e * 1000.0f) / 1000.0f;
+        e = std::max(e, kMinHBondEnergy);
+        if (e < kMaxHBondEnergy) list[kept++] = HBondCandidate{ c.donor, c.acceptor, e };
+    };
+    size_t k = 0;
+#if THC_SSE2
+    // 每次 4 个：开方与除法按 IEEE 正确舍入，运算顺序与下面的标量版相同，结果逐位一致
+    const __m128 coupling = _mm_set1_ps(kCouplingConstant);
+    const __m128 minimal = _mm_set1_ps(kMinimalDistance);
+    for (; k + 4 <= list.size(); k += 4) {
+        HBondCandidate lane[4];
+        alignas(16) float h[3][4], n[3][4], o[3][4], c[3][4];
+        for (int l = 0; l < 4; ++l) {
+            lane[l] = list[k + l];
+            const BackboneFrame& donor = frame_[lane[l].donor];
+            const BackboneFrame& acceptor = frame_[lane[l].acceptor];
+            for (int a = 0; a < 3; ++a) {
+                h[a][l] = donor.h[a];
+                n[a][l] = donor.n[a];
+                o[a][l] = acceptor.o[a];
+                c[a][l] = acceptor.c[a];
+            }
+        }
+        auto distance4 = [](const float (*p)[4], const float (*q)[4]) {
+            __m128 dx = _mm_sub_ps(_mm_load_ps(p[0]), _mm_load_ps(q[0]));
+            __m128 dy = _mm_sub_ps(_mm_load_ps(p[1]), _mm_load_ps(q[1]));
+            __m128 dz = _mm_sub_ps(_mm_load_ps(p[2]), _mm_load_ps(q[2]));
+            return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        };
+        __m128 dHO = distance4(h, o);
+        __m128 dHC = distance4(h, c);
+        __m128 dNC = distance4(n, c);
+        __m128 dNO = distance4(n, o);
+        __m128 e = _mm_sub_ps(_mm_div_ps(coupling, dHO), _mm_div_ps(coupling, dHC));
+        e = _mm_sub_ps(_mm_add_ps(e, _mm_div_ps(coupling, dNC)), _mm_div_ps(coupling, dNO));
+        __m128 close = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(dHO, minimal), _mm_cmplt_ps(dHC, minimal)),
+            _mm_or_ps(_mm_cmplt_ps(dNC, minimal), _mm_cmplt_ps(dNO, minimal)));
+        int closeMask = _mm_movemask_ps(close);
+        alignas(16) float energy[4];
+        _mm_store_ps(energy, e);
+        for (int l = 0; l < 4; ++l) finish(lane[l], (closeMask >> l) & 1 ? kMinHBondEnergy : energy[l]);
+    }
+#endif
+    for (; k < list.size(); ++k) {
+        const HBondCandidate c = list[k];
+        const BackboneFrame& donor = frame_[c.donor];
+        const BackboneFrame& acceptor = frame_[c.acceptor];
+        float dHO = distance(donor.h, acceptor.o);
+        float dHC = distance(donor.h, acceptor.c);
+        float dNC = distance(donor.n, acceptor.c);
+        float dNO = distance(donor.n, acceptor.o);
+        float e;
+        if (dHO < kMinimalDistance || dHC < kMinimalDistance || dNC < kMinimalDistance || dNO < kMinimalDistance) {
+            e = kMinHBondEnergy;
+        }
+        else {
+            e = kCouplingConstant / dHO - kCouplingConstant / dHC + kCouplingConstant / dNC - kCouplingConstant / dNO;
+        }
+        finish(c, e);
+    }
+    list.resize(kept);
+}
+
+void Dssp::computeSheets() {
+    size_t n = backbone_.size();
+    if (n < 5) return;
+
+    // 桥的每种判据都含有 i 一侧（i 或 i+1）作为供体的一个氢键，
+    // 所以候选 j 只需从这两个残基的受体中推出，不必两两枚举
+    auto testBridge = [&](uint32_t i, uint32_t j) {
+        uint32_t a = i - 1, b = i, c = i + 1;
+        uint32_t d = j - 1, e = j, f = j + 1;
+        if (!noChainBreak(a, c) || !noChainBreak(d, f)) return BridgeType::None;
+        if ((testBond(c, e) && testBond(e, a)) || (testBond(f, b) && testBond(b, d))) return BridgeType::Parallel;
+        if ((testBond(c, d) && testBond(f, a)) || (testBond(e, b) && testBond(b, e))) return BridgeType::AntiParallel;
+        return BridgeType::None;
+    };
+
+    size_t blockCount = std::min<size_t>(n, size_t(workerCount()) * 4);
+    size_t step = (n + blockCount - 1) / blockCount;
+    std::vector<std::vector<Bridge>> found(blockCount);
+    ThreadPool::instance().run(blockCount, [&](size_t block) {
+        size_t i0 = std::max<size_t>(1, block * step);
+        size_t i1 = std::min(n, (block + 1) * step);
+        std::vector<Bridge>& out = found[block];
+        for (size_t i = i0; i < i1 && i + 4 < n; ++i) {
+            uint32_t candidates[8];
+            int count = 0;
+            for (size_t donor = i; donor <= i + 1; ++donor) {
+                for (int s = 0; s < 2; ++s) {
+                    const HBond& h = acceptors_[2 * donor + s];
+                    if (h.partner < 0) continue;
+                    candidates[count++] = uint32_t(h.partner);
+                    candidates[count++] = uint32_t(h.partner) + 1;
+                }
+            }
+            // 最多 8 个，插入排序（std::sort 在这里会让 GCC 误报 -Warray-bounds）
+            for (int k = 1; k < count; ++k) {
+                uint32_t v = candidates[k];
+                int m = k;
+                for (; m > 0 && candidates[m - 1] > v; --m) candidates[m] = candidates[m - 1];
+                candidates[m] = v;
+            }
+            uint32_t last = ~0u;
+            for (int k = 0; k < count; ++k) {
+                uint32_t j = candidates[k];
+                if (j == last || j < i + 3 || j + 1 >= n) continue;
+                last = j;
+                BridgeType type = testBridge(uint32_t(i), j);
+                if (type != BridgeType::None) out.push_back(Bridge{ uint32_t(i), j, type });
+            }
+        }
+    });
+
+    // 按 (i, j) 顺序把桥接成梯子；只有上一个 i 刚延长过的梯子还能继续延长
+    std::vector<Ladder> ladders;
+    std::vector<size_t> active;
+    std::vector<size_t> nextActive;
+    uint32_t currentI = ~0u;
+    for (const std::vector<Bridge>& block : found) {
+        for (const Bridge& br : block) {
+            if (br.i != currentI) {
+                nextActive.clear();
+                for (size_t l : active) {
+                    if (ladders[l].i.back() + 1 == br.i) nextActive.push_back(l);
+                }
+                active.swap(nextActive);
+                currentI = br.i;
+            }
+            bool extended = false;
+            for (size_t l : active) {
+                Ladder& ladder = ladders[l];
+                if (ladder.type != br.type || ladder.i.back() + 1 != br.i) continue;
+                if (br.type == BridgeType::Parallel && ladder.j.back() + 1 == br.j) {
+                    ladder.i.push_back(br.i);
+                    ladder.j.push_back(br.j);
+                    extended = true;
+                    break;
+                }
+                if (br.type == BridgeType::AntiParallel && ladder.j.front() - 1 == br.j) {
+                    ladder.i.push_back(br.i);
+                    ladder.j.push_front(br.j);
+                    extended = true;
+                    break;
+                }
+            }
+            if (!extended) {
+                Ladder ladder;
+                ladder.type = br.type;
+                ladder.chainI = backbone_[br.i].chain;
+                ladder.i.push_back(br.i);
+                ladder.j.push_back(br.j);
+                active.push_back(ladders.size());
+                ladders.push_back(std::move(ladder));
+            }
+        }
+    }
+
+    // β 凸起：同类型、间隔很小的两个梯子合并。无符号减法的回绕与 mkdssp 相同
+    std::stable_sort(ladders.begin(), ladders.end(), [](const Ladder& l1, const Ladder& l2) {
+        return l1.chainI < l2.chainI || (l1.chainI == l2.chainI && l1.i.front() < l2.i.front());
+    });
+    for (size_t a = 0; a < ladders.size(); ++a) {
+        for (size_t b = a + 1; b < ladders.size(); ++b) {
+            uint32_t ibi = ladders[a].i.front();
+            uint32_t iei = ladders[a].i.back();
+            uint32_t jbi = ladders[a].j.front();
+            uint32_t jei = ladders[a].j.back();
+            uint32_t ibj = ladders[b].i.front();
+            uint32_t iej = ladders[b].i.back();
+            uint32_t jbj = ladders[b].j.front();
+            uint32_t jej = ladders[b].j.back();
+
+            if (ladders[a].type != ladders[b].type ||
+                backbone_[std::min(ibi, ibj)].chain != backbone_[std::max(iei, iej)].chain ||
+                backbone_[std::min(jbi, jbj)].chain != backbone_[std::max(jei, jej)].chain ||
+                ibj - iei >= 6 || (iei >= ibj && ibi <= iej)) {
+                continue;
+            }
+
+            bool bulge;
+            if (ladders[a].type == BridgeType::Parallel) bulge = (jbj - jei < 6 && ibj - iei < 3) || jbj - jei < 3;
+            else bulge = (jbi - jej < 6 && ibj - iei < 3) || jbi - jej < 3;
+
+            if (bulge) {
+                Ladder& target = ladders[a];
+                Ladder& source = ladders[b];
+                target.i.insert(target.i.end(), source.i.begin(), source.i.end());
+                if (target.type == BridgeType::Parallel) target.j.insert(target.j.end(), source.j.begin(), source.j.end());
+                else target.j.insert(target.j.begin(), source.j.begin(), source.j.end());
+                ladders.erase(ladders.begin() + b);
+                --b;
+            }
+        }
+    }
+
+    for (const Ladder& ladder : ladders) {
+        SecondaryStructure ss = ladder.i.size() > 1 ? SecondaryStructure::Strand : SecondaryStructure::Bridge;
+        for (uint32_t r = ladder.i.front(); r <= ladder.i.back(); ++r) {
+            if (ss_[r] != SecondaryStructure::Strand) ss_[r] = ss;
+        }
+        for (uint32_t r = ladder.j.front(); r <= ladder.j.back(); ++r) {
+            if (ss_[r] != SecondaryStructure::Strand) ss_[r] = ss;
+        }
+    }
+}
+
+void Dssp::computeHelices() {
+    size_t n = backbone_.size();
+    size_t chains = chainStart_.size() - 1;
+    helixFlags_.assign(3 * n, HelixNone);
+    bend_.assign(n, 0);
+
+    // 螺旋起止标记：n 转角的两端在同一无断链片段内，必然属于同一条链，各链互不干扰
+    ThreadPool::instance().run(chains, [&](size_t ch) {
+        size_t b = chainStart_[ch];
+        size_t e = chainStart_[ch + 1];
+        for (int stride = 3; stride <= 5; ++stride) {
+            int slot = stride - 3;
+            for (size_t i = b; i < e && i + stride < n; ++i) {
+                if (!noChainBreak(i, i + stride) || !testBond(i + stride, i)) continue;
+                helixFlags_[(i + stride) * 3 + slot] = HelixEnd;
+                for (size_t j = i + 1; j < i + stride; ++j) {
+                    if (helixFlags_[j * 3 + slot] == HelixNone) helixFlags_[j * 3 + slot] = HelixMiddle;
+                }
+                uint8_t& start = helixFlags_[i * 3 + slot];
+                start = start == HelixEnd ? HelixStartAndEnd : HelixStart;
+            }
+        }
+        // 弯折：Cα(i-2)→Cα(i) 与 Cα(i)→Cα(i+2) 夹角大于 70°
+        for (size_t i = std::max<size_t>(b, 2); i < e && i + 2 < n; ++i) {
+            if (!noChainBreak(i - 2, i + 2)) continue;
+            const float* p0 = frame_[i - 2].ca;
+            const float* p1 = frame_[i].ca;
+            const float* p2 = frame_[i + 2].ca;
+            float u[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float v[3] = { p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2] };
+            float uu = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+            float vv = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+            if (uu <= 0.0f || vv <= 0.0f) continue;
+            float cosKappa = (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]) / std::sqrt(uu * vv);
+            bend_[i] = cosKappa < 0.34202014f;      // cos 70°
+        }
+    });
+
+    // 指认：相邻两个残基都是 n 转角起点时形成螺旋，优先级 H > G > I（或 π 优先）> T > S。
+    // 读 i-1 的标记可能跨链，但标记已经全部算完，只读不写
+    ThreadPool::instance().run(chains, [&](size_t ch) {
+        size_t b = std::max<size_t>(chainStart_[ch], 1);
+        size_t e = chainStart_[ch + 1];
+        for (size_t i = b; i < e && i + 4 < n; ++i) {
+            if (isHelixStart(helixFlags_, i, 4) && isHelixStart(helixFlags_, i - 1, 4)) {
+                for (size_t j = i; j <= i + 3; ++j) ss_[j] = SecondaryStructure::AlphaHelix;
+            }
+        }
+        for (size_t i = b; i < e && i + 3 < n; ++i) {
+            if (isHelixStart(helixFlags_, i, 3) && isHelixStart(helixFlags_, i - 1, 3)) {
+                bool empty = true;
+                for (size_t j = i; empty && j <= i + 2; ++j) {
+                    empty = ss_[j] == SecondaryStructure::Coil || ss_[j] == SecondaryStructure::Helix310;
+                }
+                if (empty) {
+                    for (size_t j = i; j <= i + 2; ++j) ss_[j] = SecondaryStructure::Helix310;
+                }
+            }
+        }
+        for (size_t i = b; i < e && i + 5 < n; ++i) {
+            if (isHelixStart(helixFlags_, i, 5) && isHelixStart(helixFlags_, i - 1, 5)) {
+                bool empty = true;
+                for (size_t j = i; empty && j <= i + 4; ++j) {
+                    empty = ss_[j] == SecondaryStructure::Coil || ss_[j] == SecondaryStructure::PiHelix ||
+                        (preferPiHelices_ && ss_[j] == SecondaryStructure::AlphaHelix);
+                }
+                if (empty) {
+                    for (size_t j = i; j <= i + 4; ++j) ss_[j] = SecondaryStructure::PiHelix;
+                }
+            }
+        }
+        for (size_t i = b; i < e && i + 1 < n; ++i) {
+            if (ss_[i] != SecondaryStructure::Coil) continue;
+            bool isTurn = false;
+            for (int stride = 3; stride <= 5 && !isTurn; ++stride) {
+                for (int k = 1; k < stride && !isTurn; ++k) {
+                    isTurn = i >= size_t(k) && isHelixStart(helixFlags_, i - k, stride);
+                }
+            }
+            if (isTurn) ss_[i] = SecondaryStructure::Turn;
+            else if (bend_[i]) ss_[i] = SecondaryStructure::Bend;
+        }
+    });
+}
+
+void Dssp::assign(const float* x, const float* y, const float* z, std::vector<SecondaryStructure>& out) {
+    auto t0 = std::chrono::steady_clock::now();
+    out.assign(residueCount_, SecondaryStructure::Coil);
+    size_t n = backbone_.size();
+    if (n > 0) {
+        loadFrame(x, y, z);
+        computeHBonds();
+        ss_.assign(n, SecondaryStructure::Coil);
+        computeSheets();
+        computeHelices();
+        for (size_t k = 0; k < n; ++k) out[backbone_[k].residue] = ss_[k];
+    }
+    assignMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Dssp::assign(AtomTable& atoms) {
+    prepare(atoms);
+    std::vector<SecondaryStructure> ss;
+    assign(atoms.x.data(), atoms.y.data(), atoms.z.data(), ss);
+    for (size_t r = 0; r < atoms.residues.size(); ++r) atoms.residues[r].ss = ss[r];
+}
@@ -0,0 +1,156 @@
+﻿// Element v 1.0
+#include "Element.h"
+#include <array>
+
+namespace {
+    struct ElementInfo {
+        uint8_t number;
+        const char* symbol;
+        float covalent;   // Cordero 2008
+        float vdw;        // Bondi / Alvarez
+        uint32_t rgb;     // Jmol 配色 0xRRGGBB
+    };
+
+    const ElementInfo kElements[] = {
+        { 0, "X",  0.77f, 1.70f, 0xFF1493 },
+        { 1, "H",  0.31f, 1.10f, 0xFFFFFF },
+        { 2, "He", 0.28f, 1.40f, 0xD9FFFF },
+        { 3, "Li", 1.28f, 1.82f, 0xCC80FF },
+        { 4, "Be", 0.96f, 1.53f, 0xC2FF00 },
+        { 5, "B",  0.84f, 1.92f, 0xFFB5B5 },
+        { 6, "C",  0.76f, 1.70f, 0x909090 },
+        { 7, "N",  0.71f, 1.55f, 0x3050F8 },
+        { 8, "O",  0.66f, 1.52f, 0xFF0D0D },
+        { 9, "F",  0.57f, 1.47f, 0x90E050 },
+        { 10, "Ne", 0.58f, 1.54f, 0xB3E3F5 },
+        { 11, "Na", 1.66f, 2.27f, 0xAB5CF2 },
+        { 12, "Mg", 1.41f, 1.73f, 0x8AFF00 },
+        { 13, "Al", 1.21f, 1.84f, 0xBFA6A6 },
+        { 14, "Si", 1.11f, 2.10f, 0xF0C8A0 },
+        { 15, "P",  1.07f, 1.80f, 0xFF8000 },
+        { 16, "S",  1.05f, 1.80f, 0xFFFF30 },
+        { 17, "Cl", 1.02f, 1.75f, 0x1FF01F },
+        { 18, "Ar", 1.06f, 1.88f, 0x80D1E3 },
+        { 19, "K",  2.03f, 2.75f, 0x8F40D4 },
+        { 20, "Ca", 1.76f, 2.31f, 0x3DFF00 },
+        { 21, "Sc", 1.70f, 2.11f, 0xE6E6E6 },
+        { 22, "Ti", 1.60f, 2.00f, 0xBFC2C7 },
+        { 23, "V",  1.53f, 2.00f, 0xA6A6AB },
+        { 24, "Cr", 1.39f, 2.00f, 0x8A99C7 },
+        { 25, "Mn", 1.39f, 2.00f, 0x9C7AC7 },
+        { 26, "Fe", 1.32f, 2.00f, 0xE06633 },
+        { 27, "Co", 1.26f, 2.00f, 0xF090A0 },
+        { 28, "Ni", 1.24f, 1.63f, 0x50D050 },
+        { 29, "Cu", 1.32f, 1.40f, 0xC88033 },
+        { 30, "Zn", 1.22f, 1.39f, 0x7D80B0 },
+        { 31, "Ga", 1.22f, 1.87f, 0xC28F8F },
+        { 32, "Ge", 1.20f, 2.11f, 0x668F8F },
+        { 33, "As", 1.19f, 1.85f, 0xBD80E3 },
+        { 34, "Se", 1.20f, 1.90f, 0xFFA100 },
+        { 35, "Br", 1.20f, 1.85f, 0xA62929 },
+        { 36, "Kr", 1.16f, 2.02f, 0x5CB8D1 },
+        { 37, "Rb", 2.20f, 3.03f, 0x702EB0 },
+        { 38, "Sr", 1.95f, 2.49f, 0x00FF00 },
+        { 39, "Y",  1.90f, 2.00f, 0x94FFFF },
+        { 40, "Zr", 1.75f, 2.00f, 0x94E0E0 },
+        { 41, "Nb", 1.64f, 2.00f, 0x73C2C9 },
+        { 42, "Mo", 1.54f, 2.00f, 0x54B5B5 },
+        { 43, "Tc", 1.47f, 2.00f, 0x3B9E9E },
+        { 44, "Ru", 1.46f, 2.00f, 0x248F8F },
+        { 45, "Rh", 1.42f, 2.00f, 0x0A7D8C },
+        { 46, "Pd", 1.39f, 1.63f, 0x006985 },
+        { 47, "Ag", 1.45f, 1.72f, 0xC0C0C0 },
+        { 48, "Cd", 1.44f, 1.58f, 0xFFD98F },
+        { 49, "In", 1.42f, 1.93f, 0xA67573 },
+        { 50, "Sn", 1.39f, 2.17f, 0x668080 },
+        { 51, "Sb", 1.39f, 2.06f, 0x9E63B5 },
+        { 52, "Te", 1.38f, 2.06f, 0xD47A00 },
+        { 53, "I",  1.39f, 1.98f, 0x940094 },
+        { 54, "Xe", 1.40f, 2.16f, 0x429EB0 },
+        { 55, "Cs", 2.44f, 3.43f, 0x57178F },
+        { 56, "Ba", 2.15f, 2.68f, 0x00C900 },
+        { 74, "W",  1.62f, 2.00f, 0x2194D6 },
+        { 77, "Ir", 1.41f, 2.00f, 0x175487 },
+        { 78, "Pt", 1.36f, 1.75f, 0xD0D0E0 },
+        { 79, "Au", 1.36f, 1.66f, 0xFFD123 },
+        { 80, "Hg", 1.32f, 1.55f, 0xB8B8D0 },
+        { 82, "Pb", 1.46f, 2.02f, 0x575961 },
+        { 83, "Bi", 1.48f, 2.07f, 0x9E4FB5 },
+        { 92, "U",  1.96f, 1.86f, 0x008FFF },
+    };
+    const size_t kElementCount = sizeof(kElements) / sizeof(kElements[0]);
+
+    char upper(char c) {
+        return (c >= 'a' && c <= 'z') ? char(c - 'a' + 'A') : c;
+    }
+
+    // 两字母符号 -> 表中下标的直接查找表，下标为 (c0 - 'A') * 27 + (c1 ? c1 - 'A' : 26)
+    struct Lookup {
+        std::array<uint8_t, 27 * 27> symbolToIndex{};
+        std::array<uint8_t, 256> numberToIndex{};
+        Lookup() {
+            for (size_t i = 1; i < kElementCount; ++i) {
+                const char* s = kElements[i].symbol;
+                int c0 = upper(s[0]) - 'A';
+                int c1 = s[1] ? upper(s[1]) - 'A' : 26;
+                symbolToIndex[size_t(c0 * 27 + c1)] = uint8_t(i);
+                numberToIndex[kElements[i].number] = uint8_t(i);
+            }
+        }
+    };
+
+    const Lookup& lookup() {
+        static const Lookup table;
+        return table;
+    }
+
+    const ElementInfo& info(uint8_t element) {
+        return kElements[lookup().numberToIndex[element]];
+    }
+}
+
+uint8_t elementFromSymbol(const char* symbol, size_t length) {
+    const char* p = symbol;
+    const char* e = symbol + length;
+    while (p < e && (*p == ' ' || *p == '\t')) ++p;
+    while (e > p && (e[-1] == ' ' || e[-1] == '\t')) --e;
+    if (e - p < 1 || e - p > 2) return 0;
+
+    char c0 = upper(p[0]);
+    char c1 = (e - p == 2) ? upper(p[1]) : 0;
+    if (c0 < 'A' || c0 > 'Z') return 0;
+    if (c1 != 0 && (c1 < 'A' || c1 > 'Z')) return 0;
+    uint8_t index = lookup().symbolToIndex[size_t((c0 - 'A') * 27 + (c1 ? c1 - 'A' : 26))];
+    return kElements[index].number;
+}
+
+const char* elementSymbol(uint8_t element) {
+    return info(element).symbol;
+}
+
+float covalentRadius(uint8_t element) {
+    return info(element).covalent;
+}
+
+float vdwRadius(uint8_t element) {
+    return info(element).vdw;
+}
+
+uint32_t elementColor(uint8_t element) {
+    uint32_t rgb = info(element).rgb;
+    uint32_t r = (rgb >> 16) & 0xFF;
+    uint32_t g = (rgb >> 8) & 0xFF;
+    uint32_t b = rgb & 0xFF;
+    return 0xFF000000u | (b << 16) | (g << 8) | r;
+}
+
+float maxCovalentRadius() {
+    static const float value = []() {
+        float m = 0.0f;
+        for (size_t i = 0; i < kElementCount; ++i) {
+            if (kElements[i].covalent > m) m = kElements[i].covalent;
+        }
+        return m;
+    }();
+    return value;
+}
@@ -0,0 +1,208 @@
+﻿// FrameCache v 1.0
+#include "FrameCache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const uint64_t kNever = ~uint64_t(0);
+}
+
+FrameCache::FrameCache(const TrajectoryReader& reader, size_t byteBudget, float fullFraction)
+    : reader_(reader) {
+    setBudget(byteBudget, fullFraction);
+}
+
+void FrameCache::setBudget(size_t byteBudget, float fullFraction) {
+    fullFraction = std::min(std::max(fullFraction, 0.0f), 1.0f);
+    budget_ = byteBudget;
+    fullBudget_ = size_t(double(byteBudget) * fullFraction);
+    enforceBudget();
+}
+
+void FrameCache::setPlayback(int step, size_t loopBegin, size_t loopEnd) {
+    step_ = step;
+    loopBegin_ = loopBegin;
+    loopEnd_ = loopEnd;
+}
+
+void FrameCache::clear() {
+    full_.clear();
+    quantized_.clear();
+    lookup_.clear();
+    fullBytes_ = 0;
+    quantizedBytes_ = 0;
+    stats_.residentFrames = 0;
+    stats_.residentBytes = 0;
+}
+
+void FrameCache::resetStats() {
+    size_t frames = stats_.residentFrames;
+    size_t bytes = stats_.residentBytes;
+    stats_ = FrameCacheStats();
+    stats_.residentFrames = frames;
+    stats_.residentBytes = bytes;
+}
+
+uint64_t FrameCache::nextUse(size_t index) const {
+    if (step_ == 0) {
+        // 暂停/拖动：按与播放头的距离
+        return index > playhead_ ? index - playhead_ : playhead_ - index;
+    }
+    int64_t stride = step_ > 0 ? step_ : -int64_t(step_);
+    int64_t delta = step_ > 0 ? int64_t(index) - int64_t(playhead_) : int64_t(playhead_) - int64_t(index);
+    bool looping = loopEnd_ > loopBegin_;
+    if (looping) {
+        // 循环区间外的帧不会再用到
+        if (index < loopBegin_ || index >= loopEnd_ || playhead_ < loopBegin_ || playhead_ >= loopEnd_) return kNever;
+        int64_t length = int64_t(loopEnd_ - loopBegin_);
+        delta = ((delta % length) + length) % length;
+    }
+    // 已经播过的帧（不循环时）或跳帧播放不会落到的帧
+    if (delta < 0 || delta % stride != 0) return kNever;
+    return uint64_t(delta / stride);
+}
+
+FrameCache::EntryList::iterator FrameCache::pickVictim(EntryList& list) {
+    EntryList::iterator victim = std::prev(list.end());
+    if (policy_ == FrameEvictionPolicy::Lru) return victim;
+    // 从表尾往前找最晚才会用到的帧，同样用不到时取最久未用的
+    uint64_t farthest = nextUse(victim->index);
+    for (EntryList::iterator it = victim; farthest != kNever && it != list.begin();) {
+        --it;
+        uint64_t use = nextUse(it->index);
+        if (use > farthest) {
+            farthest = use;
+            victim = it;
+        }
+    }
+    return victim;
+}
+
+void FrameCache::quantize(const float* const axes[3], size_t n, Entry& e) {
+    std::vector<uint16_t> packed(3 * n);
+    for (int k = 0; k < 3; ++k) {
+        const float* v = axes[k];
+        float lo = n > 0 ? v[0] : 0.0f;
+        float hi = lo;
+        for (size_t i = 1; i < n; ++i) {
+            lo = std::min(lo, v[i]);
+            hi = std::max(hi, v[i]);
+        }
+        float extent = hi - lo;
+        e.origin[k] = lo;
+        e.scale[k] = extent > 0.0f ? extent / 65535.0f : 1.0f;
+        float inv = 1.0f / e.scale[k];
+        uint16_t* q = packed.data() + k * n;
+        for (size_t i = 0; i < n; ++i) {
+            q[i] = uint16_t(std::min((v[i] - lo) * inv + 0.5f, 65535.0f));
+        }
+    }
+    e.packed.swap(packed);
+    std::vector<float>().swap(e.full);
+    e.tier = Tier::Quantized;
+}
+
+void FrameCache::expand(const Entry& e, TrajectoryFrame& out) {
+    if (e.tier == Tier::Full) {
+        size_t n = e.full.size() / 3;
+        out.x.assign(e.full.begin(), e.full.begin() + n);
+        out.y.assign(e.full.begin() + n, e.full.begin() + 2 * n);
+        out.z.assign(e.full.begin() + 2 * n, e.full.end());
+    }
+    else {
+        size_t n = e.packed.size() / 3;
+        out.resize(n);
+        float* axes[3] = { out.x.data(), out.y.data(), out.z.data() };
+        for (int k = 0; k < 3; ++k) {
+            const uint16_t* q = e.packed.data() + k * n;
+            float o = e.origin[k];
+            float s = e.scale[k];
+            for (size_t i = 0; i < n; ++i) axes[k][i] = o + float(q[i]) * s;
+        }
+    }
+    std::memcpy(out.box, e.box, sizeof(out.box));
+    out.step = e.step;
+    out.time = e.time;
+    out.index = e.index;
+}
+
+void FrameCache::demote(EntryList::iterator it) {
+    size_t n = it->full.size() / 3;
+    const float* axes[3] = { it->full.data(), it->full.data() + n, it->full.data() + 2 * n };
+    fullBytes_ -= it->bytes();
+    quantize(axes, n, *it);
+    quantizedBytes_ += it->bytes();
+    quantized_.splice(quantized_.begin(), full_, it);
+    ++stats_.demotions;
+}
+
+void FrameCache::enforceBudget() {
+    while (!full_.empty() && fullBytes_ > fullBudget_) {
+        demote(pickVictim(full_));
+    }
+    while (fullBytes_ + quantizedBytes_ > budget_ && !(full_.empty() && quantized_.empty())) {
+        EntryList& list = quantized_.empty() ? full_ : quantized_;
+        EntryList::iterator victim = pickVictim(list);
+        size_t bytes = victim->bytes();
+        if (&list == &full_) fullBytes_ -= bytes;
+        else quantizedBytes_ -= bytes;
+        lookup_.erase(victim->index);
+        list.erase(victim);
+        ++stats_.evictions;
+    }
+    stats_.residentFrames = lookup_.size();
+    stats_.residentBytes = fullBytes_ + quantizedBytes_;
+}
+
+void FrameCache::store(const TrajectoryFrame& frame) {
+    Entry e;
+    e.index = frame.index;
+    size_t n = frame.atomCount();
+    std::memcpy(e.box, frame.box, sizeof(e.box));
+    e.step = frame.step;
+    e.time = frame.time;
+
+    bool quantizedOnly = fullBudget_ == 0;
+    if (quantizedOnly) {
+        const float* axes[3] = { frame.x.data(), frame.y.data(), frame.z.data() };
+        quantize(axes, n, e);
+        if (e.bytes() > budget_) return;
+        quantizedBytes_ += e.bytes();
+        quantized_.push_front(std::move(e));
+        lookup_[frame.index] = quantized_.begin();
+    }
+    else {
+        e.full.resize(3 * n);
+        std::copy(frame.x.begin(), frame.x.end(), e.full.begin());
+        std::copy(frame.y.begin(), frame.y.end(), e.full.begin() + n);
+        std::copy(frame.z.begin(), frame.z.end(), e.full.begin() + 2 * n);
+        if (e.bytes() > budget_) return;
+        fullBytes_ += e.bytes();
+        full_.push_front(std::move(e));
+        lookup_[frame.index] = full_.begin();
+    }
+    enforceBudget();
+}
+
+bool FrameCache::get(size_t index, TrajectoryFrame& out) {
+    playhead_ = index;
+    auto found = lookup_.find(index);
+    if (found != lookup_.end()) {
+        EntryList::iterator it = found->second;
+        if (it->tier == Tier::Full) {
+            ++stats_.hits;
+            full_.splice(full_.begin(), full_, it);
+        }
+        else {
+            ++stats_.quantizedHits;
+            quantized_.splice(quantized_.begin(), quantized_, it);
+        }
+        expand(*it, out);
+        return true;
+    }
+
+    ++stats_.misses;
+    if (!reader_.readFrame(index, out)) return false;
+    store(out);
+    return true;
+}
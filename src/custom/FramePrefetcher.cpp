@@ -0,0 +1,219 @@
+﻿// FramePrefetcher v 1.0
+#include "FramePrefetcher.h"
+#include <algorithm>
+
+namespace {
+    const size_t kNone = size_t(-1);
+}
+
+FramePrefetcher::FramePrefetcher(const TrajectoryReader& reader, size_t ringSize)
+    : reader_(reader) {
+    ringSize = std::max<size_t>(ringSize, 4);
+    slots_.resize(ringSize);
+    depth_ = ringSize - 2;
+#ifndef _WIN32
+    useRing_ = ring_.init(unsigned(depth_));
+#endif
+    thread_ = std::thread(&FramePrefetcher::prefetchLoop, this);
+}
+
+FramePrefetcher::~FramePrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void FramePrefetcher::setPlayback(int step, bool loop) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        step_ = step;
+        loop_ = loop;
+    }
+    wake_.notify_all();
+}
+
+size_t FramePrefetcher::wantedFrame(size_t k) const {
+    size_t frames = reader_.frameCount();
+    if (frames == 0) return kNone;
+    int64_t offset;
+    if (step_ != 0) {
+        offset = int64_t(step_) * int64_t(k);
+    }
+    else {
+        // 暂停或拖动时不知道下一步往哪边，两侧交替预取：+1 -1 +2 -2 ...
+        int64_t half = int64_t((k + 1) / 2);
+        offset = (k % 2 == 1) ? half : -half;
+    }
+    int64_t index = int64_t(playhead_) + offset;
+    if (loop_) {
+        index %= int64_t(frames);
+        if (index < 0) index += int64_t(frames);
+    }
+    if (index < 0 || index >= int64_t(frames)) return kNone;
+    return size_t(index);
+}
+
+bool FramePrefetcher::isWanted(size_t index) const {
+    if (index == playhead_) return true;
+    for (size_t k = 1; k <= depth_; ++k) {
+        if (wantedFrame(k) == index) return true;
+    }
+    return false;
+}
+
+size_t FramePrefetcher::findSlot(size_t index) const {
+    for (size_t s = 0; s < slots_.size(); ++s) {
+        if (slots_[s].state != SlotState::Empty && slots_[s].index == index) return s;
+    }
+    return kNone;
+}
+
+size_t FramePrefetcher::pickVictim() const {
+    size_t fallback = kNone;
+    for (size_t s = 0; s < slots_.size(); ++s) {
+        const Slot& slot = slots_[s];
+        if (s == pinned_ || slot.state == SlotState::Loading) continue;
+        if (slot.state == SlotState::Empty) return s;
+        if (fallback == kNone && !isWanted(slot.index)) fallback = s;
+    }
+    return fallback;
+}
+
+void FramePrefetcher::finishSlot(size_t slot, bool ok) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_[slot].state = ok ? SlotState::Ready : SlotState::Empty;
+    }
+    ready_.notify_all();
+}
+
+const TrajectoryFrame* FramePrefetcher::acquire(size_t index) {
+    if (index >= reader_.frameCount()) return nullptr;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    playhead_ = index;
+    pinned_ = kNone;
+    wake_.notify_one();
+
+    size_t s = findSlot(index);
+    if (s != kNone) {
+        // 正在读取：等它完成，比重新同步读一遍快
+        ready_.wait(lock, [&] {
+            return slots_[s].state != SlotState::Loading || slots_[s].index != index;
+        });
+        if (slots_[s].state == SlotState::Ready && slots_[s].index == index) {
+            ++hits_;
+            pinned_ = s;
+            return &slots_[s].frame;
+        }
+    }
+
+    ++misses_;
+    s = pickVictim();
+    if (s == kNone) return nullptr;
+    Slot& slot = slots_[s];
+    slot.index = index;
+    slot.state = SlotState::Loading;
+    lock.unlock();
+
+    bool ok = reader_.readFrame(index, slot.frame);
+
+    lock.lock();
+    slot.state = ok ? SlotState::Ready : SlotState::Empty;
+    if (!ok) return nullptr;
+    pinned_ = s;
+    return &slot.frame;
+}
+
+void FramePrefetcher::loadBatch(const std::vector<size_t>& batch) {
+    const RandomAccessFile& file = reader_.file();
+    std::vector<size_t> sync;
+    size_t queued = 0;
+
+    for (size_t s : batch) {
+        Slot& slot = slots_[s];
+        uint64_t offset = 0;
+        size_t size = 0;
+        if (!reader_.frameExtent(slot.index, offset, size)) {
+            finishSlot(s, false);
+            continue;
+        }
+        if (slot.raw.size() < size) slot.raw.resize(size);
+#ifndef _WIN32
+        if (useRing_ && ring_.queueRead(file.descriptor(), slot.raw.data(), size, offset, uint64_t(s))) {
+            ++queued;
+            continue;
+        }
+#endif
+        sync.push_back(s);
+    }
+
+    // 先提交异步请求，内核读盘的同时这里处理同步部分和已完成的帧
+    if (queued > 0 && !ring_.submit()) {
+        useRing_ = false;
+    }
+    for (size_t s : sync) {
+        Slot& slot = slots_[s];
+        finishSlot(s, reader_.readFrame(slot.index, slot.frame));
+    }
+
+    while (queued > 0) {
+        uint64_t tag = 0;
+        int result = 0;
+        if (!ring_.wait(tag, result)) {
+            // 队列失效：剩下的请求不会再有完成事件，全部改为同步读取
+            useRing_ = false;
+            for (size_t s : batch) {
+                if (slots_[s].state == SlotState::Loading) {
+                    finishSlot(s, reader_.readFrame(slots_[s].index, slots_[s].frame));
+                }
+            }
+            return;
+        }
+        --queued;
+        size_t s = size_t(tag);
+        Slot& slot = slots_[s];
+        uint64_t offset = 0;
+        size_t size = 0;
+        reader_.frameExtent(slot.index, offset, size);
+        bool ok;
+        if (result == int(size)) {
+            ok = reader_.decodeFrame(slot.index, slot.raw.data(), size, slot.frame);
+        }
+        else {
+            // 老内核不支持 IORING_OP_READ（-EINVAL）或读得不完整：之后都走同步路径
+            if (result < 0) useRing_ = false;
+            ok = reader_.readFrame(slot.index, slot.frame);
+        }
+        finishSlot(s, ok);
+    }
+}
+
+void FramePrefetcher::prefetchLoop() {
+    std::vector<size_t> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        batch.clear();
+        for (size_t k = 1; k <= depth_; ++k) {
+            size_t index = wantedFrame(k);
+            // 暂停时两侧交替，一侧越界后另一侧还要继续预取
+            if (index == kNone) continue;
+            if (findSlot(index) != kNone) continue;
+            size_t s = pickVictim();
+            if (s == kNone) break;
+            slots_[s].index = index;
+            slots_[s].state = SlotState::Loading;
+            batch.push_back(s);
+        }
+        if (batch.empty()) {
+            wake_.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        loadBatch(batch);
+        lock.lock();
+    }
+}
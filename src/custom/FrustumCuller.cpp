@@ -0,0 +1,194 @@
+﻿// FrustumCuller v 1.0
+#include "FrustumCuller.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if THC_AVX
+#include <immintrin.h>
+#endif
+
+namespace {
+    const size_t kChunk = 1024;
+
+    // 一个平面的 p 顶点分量所在的数组
+    struct PlaneRefs {
+        const float* x;
+        const float* y;
+        const float* z;
+        float nx, ny, nz, d;
+    };
+
+    void selectCorners(const FrustumCuller::Plane* planes, const AabbArray& boxes, PlaneRefs refs[6]) {
+        for (int p = 0; p < 6; ++p) {
+            const FrustumCuller::Plane& pl = planes[p];
+            refs[p].x = pl.nx >= 0.0f ? boxes.maxX.data() : boxes.minX.data();
+            refs[p].y = pl.ny >= 0.0f ? boxes.maxY.data() : boxes.minY.data();
+            refs[p].z = pl.nz >= 0.0f ? boxes.maxZ.data() : boxes.minZ.data();
+            refs[p].nx = pl.nx;
+            refs[p].ny = pl.ny;
+            refs[p].nz = pl.nz;
+            refs[p].d = pl.d;
+        }
+    }
+
+    size_t cullScalar(const PlaneRefs* refs, size_t begin, size_t end, uint32_t* out) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i) {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; ++p) {
+                const PlaneRefs& r = refs[p];
+                inside = r.nx * r.x[i] + r.ny * r.y[i] + r.nz * r.z[i] + r.d >= 0.0f;
+            }
+            if (inside) out[count++] = uint32_t(i);
+        }
+        return count;
+    }
+
+    // 把 mask 中为 1 的位（可见）对应的下标写出
+    inline size_t emitMask(unsigned mask, size_t base, uint32_t* out, size_t count) {
+        while (mask != 0) {
+            out[count++] = uint32_t(base + countTrailingZeros64(mask));
+            mask &= mask - 1;
+        }
+        return count;
+    }
+
+#if THC_SSE2
+    inline __m128 planeDistance4(const PlaneRefs& r, size_t i) {
+        __m128 v = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r.nx), _mm_loadu_ps(r.x + i)),
+            _mm_mul_ps(_mm_set1_ps(r.ny), _mm_loadu_ps(r.y + i)));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(r.nz), _mm_loadu_ps(r.z + i)));
+        return _mm_add_ps(v, _mm_set1_ps(r.d));
+    }
+
+    size_t cullSse(const PlaneRefs* refs, size_t begin, size_t end, uint32_t* out) {
+        const __m128 zero = _mm_setzero_ps();
+        size_t count = 0;
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            __m128 outA = zero;
+            __m128 outB = zero;
+            for (int p = 0; p < 6; ++p) {
+                outA = _mm_or_ps(outA, _mm_cmplt_ps(planeDistance4(refs[p], i), zero));
+                outB = _mm_or_ps(outB, _mm_cmplt_ps(planeDistance4(refs[p], i + 4), zero));
+                if ((_mm_movemask_ps(outA) & _mm_movemask_ps(outB)) == 0xF) break;
+            }
+            unsigned mask = ~unsigned(_mm_movemask_ps(outA) | (_mm_movemask_ps(outB) << 4)) & 0xFFu;
+            count = emitMask(mask, i, out, count);
+        }
+        return count + cullScalar(refs, i, end, out + count);
+    }
+#endif
+
+#if THC_AVX
+    THC_TARGET_AVX size_t cullAvx(const PlaneRefs* refs, size_t begin, size_t end, uint32_t* out) {
+        const __m256 zero = _mm256_setzero_ps();
+        size_t count = 0;
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            __m256 outside = zero;
+            for (int p = 0; p < 6; ++p) {
+                const PlaneRefs& r = refs[p];
+                __m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(r.nx), _mm256_loadu_ps(r.x + i)),
+                    _mm256_mul_ps(_mm256_set1_ps(r.ny), _mm256_loadu_ps(r.y + i)));
+                v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(r.nz), _mm256_loadu_ps(r.z + i)));
+                v = _mm256_add_ps(v, _mm256_set1_ps(r.d));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(v, zero, _CMP_LT_OQ));
+                if (_mm256_movemask_ps(outside) == 0xFF) break;
+            }
+            unsigned mask = ~unsigned(_mm256_movemask_ps(outside)) & 0xFFu;
+            count = emitMask(mask, i, out, count);
+        }
+        return count + cullScalar(refs, i, end, out + count);
+    }
+#endif
+}
+
+FrustumCuller::FrustumCuller() {
+    useAvx_ = cpuHasAvx();
+}
+
+void FrustumCuller::setUseAvx(bool enabled) {
+    useAvx_ = enabled && cpuHasAvx();
+}
+
+void FrustumCuller::setMatrices(const glm::mat4& projection, const glm::mat4& view) {
+    // glm 按列存储：m[col][row]，第 i 行为 (m[0][i], m[1][i], m[2][i], m[3][i])
+    const glm::mat4 m = projection * view;
+    auto row = [&](int i) {
+        return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    };
+    const glm::vec4 w = row(3);
+    const glm::vec4 rows[6] = {
+        w + row(0), w - row(0),     // 左、右
+        w + row(1), w - row(1),     // 下、上
+        w + row(2), w - row(2)      // 近、远
+    };
+    for (int p = 0; p < 6; ++p) {
+        float len = glm::length(glm::vec3(rows[p]));
+        if (len <= 0.0f) len = 1.0f;
+        planes_[p] = Plane{ rows[p].x / len, rows[p].y / len, rows[p].z / len, rows[p].w / len };
+    }
+}
+
+size_t FrustumCuller::testRange(const AabbArray& boxes, size_t begin, size_t end, uint32_t* out) const {
+    end = std::min(end, boxes.size());
+    if (begin >= end) return 0;
+    PlaneRefs refs[6];
+    selectCorners(planes_, boxes, refs);
+#if THC_AVX
+    if (useAvx_) return cullAvx(refs, begin, end, out);
+#endif
+#if THC_SSE2
+    return cullSse(refs, begin, end, out);
+#else
+    return cullScalar(refs, begin, end, out);
+#endif
+}
+
+size_t FrustumCuller::cull(const AabbArray& boxes, size_t begin, size_t end, std::vector<uint32_t>& visible) {
+    auto t0 = std::chrono::steady_clock::now();
+    end = std::min(end, boxes.size());
+    size_t count = 0;
+    // 分段写到栈上的缓冲再追加，免得先把输出数组按盒子数清零
+    uint32_t buffer[kChunk];
+    for (size_t b0 = begin; b0 < end; b0 += kChunk) {
+        size_t n = testRange(boxes, b0, std::min(end, b0 + kChunk), buffer);
+        visible.insert(visible.end(), buffer, buffer + n);
+        count += n;
+    }
+    tested_ = begin < end ? end - begin : 0;
+    visible_ = count;
+    cullMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return count;
+}
+
+CullResult FrustumCuller::classify(const float lo[3], const float hi[3]) const {
+    CullResult result = CullResult::Inside;
+    for (int p = 0; p < 6; ++p) {
+        const Plane& pl = planes_[p];
+        // p 顶点在外则整个盒子在外；n 顶点（反方向的角）在外则与平面相交
+        float px = pl.nx >= 0.0f ? hi[0] : lo[0];
+        float py = pl.ny >= 0.0f ? hi[1] : lo[1];
+        float pz = pl.nz >= 0.0f ? hi[2] : lo[2];
+        if (pl.nx * px + pl.ny * py + pl.nz * pz + pl.d < 0.0f) return CullResult::Outside;
+        float nx = pl.nx >= 0.0f ? lo[0] : hi[0];
+        float ny = pl.ny >= 0.0f ? lo[1] : hi[1];
+        float nz = pl.nz >= 0.0f ? lo[2] : hi[2];
+        if (pl.nx * nx + pl.ny * ny + pl.nz * nz + pl.d < 0.0f) result = CullResult::Intersect;
+    }
+    return result;
+}
+
+bool FrustumCuller::visible(const float lo[3], const float hi[3]) const {
+    for (int p = 0; p < 6; ++p) {
+        const Plane& pl = planes_[p];
+        float px = pl.nx >= 0.0f ? hi[0] : lo[0];
+        float py = pl.ny >= 0.0f ? hi[1] : lo[1];
+        float pz = pl.nz >= 0.0f ? hi[2] : lo[2];
+        if (pl.nx * px + pl.ny * py + pl.nz * pz + pl.d < 0.0f) return false;
+    }
+    return true;
+}
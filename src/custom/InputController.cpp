@@ -9,13 +9,13 @@ void InputController::processKeyboardInput(GLFWwindow* window, float deltaTime)
         glfwSetWindowShouldClose(window, true);
 
     // 计算当前帧的移动速度
-    float velocity = cameraSpeed_ * deltaTime;
+    double velocity = double(cameraSpeed_) * double(deltaTime);
 
-    // 获取当前摄像机状态
-    glm::vec3 pos = controlledCamera_.getPos();
-    glm::vec3 front = controlledCamera_.getFront();
-    glm::vec3 right = controlledCamera_.getRight();
-    glm::vec3 up = controlledCamera_.getUp();
+    // 获取当前摄像机状态（位置用双精度累加，远离世界原点时小步移动不会被舍掉）
+    glm::dvec3 pos = controlledCamera_.getWorldPos();
+    glm::dvec3 front = glm::dvec3(controlledCamera_.getFront());
+    glm::dvec3 right = glm::dvec3(controlledCamera_.getRight());
+    glm::dvec3 up = glm::dvec3(controlledCamera_.getUp());
 
     // W 键: 前进
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
@@ -45,7 +45,20 @@ void InputController::processKeyboardInput(GLFWwindow* window, float deltaTime)
     }
 
     // 将计算后的新位置设置回 Camera 实例
-    controlledCamera_.setPos(pos);
+    controlledCamera_.setWorldPos(pos);
+
+    // ] / [ 键: 调整等值面（MarchingCubes 只改 iso 时复用块摘要，可以逐帧提取）
+    float isoStep = isoRate_ * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS)
+    {
+        isoLevel_ += isoStep;
+        isoChanged_ = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS)
+    {
+        isoLevel_ -= isoStep;
+        isoChanged_ = true;
+    }
 }
 
 void InputController::processMouseInput(GLFWwindow* window)
@@ -58,12 +71,15 @@ void InputController::processMouseInput(GLFWwindow* window)
         lastX_ = static_cast<float>(xpos);
         lastY_ = static_cast<float>(ypos);
         firstMouse_ = false;
+        cursorMoved_ = true;
     }
 
     // 1. 计算偏移量
     float xoffset = static_cast<float>(xpos) - lastX_;
     float yoffset = lastY_ - static_cast<float>(ypos); // 注意：y坐标是从下往上算的，所以要反过来
 
+    if (xoffset != 0.0f || yoffset != 0.0f) cursorMoved_ = true;
+
     lastX_ = static_cast<float>(xpos);
     lastY_ = static_cast<float>(ypos);
 
@@ -0,0 +1,186 @@
+﻿// IoRing v 1.0
+#include "IoRing.h"
+
+#if THC_IO_URING
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    int ioUringSetup(unsigned entries, io_uring_params* p) {
+        return int(syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return int(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+
+    inline unsigned loadAcquire(const unsigned* p) {
+        return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    inline void storeRelease(unsigned* p, unsigned v) {
+        __atomic_store_n(p, v, __ATOMIC_RELEASE);
+    }
+
+    template <typename T>
+    inline T* at(void* base, unsigned offset) {
+        return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+    }
+}
+
+bool IoRing::init(unsigned entries) {
+    close();
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = ioUringSetup(entries, &params);
+    if (fd < 0) return false;
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        if (cqRingSize_ > sqRingSize_) sqRingSize_ = cqRingSize_;
+        cqRingSize_ = sqRingSize_;
+    }
+
+    void* sq = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    void* cq = sq;
+    if (!singleMap) {
+        cq = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) {
+            munmap(sq, sqRingSize_);
+            ::close(fd);
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (cq != sq) munmap(cq, cqRingSize_);
+        munmap(sq, sqRingSize_);
+        ::close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    entries_ = params.sq_entries;
+    sqRing_ = sq;
+    cqRing_ = cq;
+    sqes_ = sqes;
+    sqHead_ = at<unsigned>(sq, params.sq_off.head);
+    sqTail_ = at<unsigned>(sq, params.sq_off.tail);
+    sqMask_ = at<unsigned>(sq, params.sq_off.ring_mask);
+    sqArray_ = at<unsigned>(sq, params.sq_off.array);
+    cqHead_ = at<unsigned>(cq, params.cq_off.head);
+    cqTail_ = at<unsigned>(cq, params.cq_off.tail);
+    cqMask_ = at<unsigned>(cq, params.cq_off.ring_mask);
+    cqes_ = at<void>(cq, params.cq_off.cqes);
+    return true;
+}
+
+void IoRing::close() {
+    if (fd_ < 0) return;
+    if (sqes_ != nullptr) munmap(sqes_, sqesSize_);
+    if (cqRing_ != nullptr && cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+    if (sqRing_ != nullptr) munmap(sqRing_, sqRingSize_);
+    ::close(fd_);
+    fd_ = -1;
+    entries_ = 0;
+    pending_ = 0;
+    inFlight_ = 0;
+    sqRing_ = cqRing_ = sqes_ = cqes_ = nullptr;
+    sqHead_ = sqTail_ = sqMask_ = sqArray_ = nullptr;
+    cqHead_ = cqTail_ = cqMask_ = nullptr;
+}
+
+bool IoRing::queueRead(int fd, void* dst, size_t size, uint64_t offset, uint64_t tag) {
+    if (fd_ < 0 || inFlight_ + pending_ >= entries_ || size > 0x7FFFF000u) return false;
+    unsigned tail = *sqTail_;
+    if (tail - loadAcquire(sqHead_) >= entries_) return false;
+
+    unsigned index = tail & *sqMask_;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    // IORING_OP_READ 需要 5.6 及以上内核，更老的内核在完成事件里返回 -EINVAL，由调用者退回 pread
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(dst);
+    sqe->len = unsigned(size);
+    sqe->off = offset;
+    sqe->user_data = tag;
+    sqArray_[index] = index;
+    storeRelease(sqTail_, tail + 1);
+    ++pending_;
+    return true;
+}
+
+bool IoRing::submit() {
+    if (fd_ < 0) return false;
+    while (pending_ > 0) {
+        int n = ioUringEnter(fd_, pending_, 0, 0);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return false;
+        }
+        if (n == 0) return false;
+        pending_ -= unsigned(n);
+        inFlight_ += unsigned(n);
+    }
+    return true;
+}
+
+bool IoRing::wait(uint64_t& tag, int& result) {
+    if (fd_ < 0) return false;
+    if (pending_ > 0 && !submit()) return false;
+    if (inFlight_ == 0) return false;
+    for (;;) {
+        unsigned head = *cqHead_;
+        if (head != loadAcquire(cqTail_)) {
+            const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(cqes_) + (head & *cqMask_);
+            tag = cqe->user_data;
+            result = cqe->res;
+            storeRelease(cqHead_, head + 1);
+            --inFlight_;
+            return true;
+        }
+        if (ioUringEnter(fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return false;
+    }
+}
+
+IoRing::~IoRing() {
+    close();
+}
+
+#else
+
+bool IoRing::init(unsigned) {
+    return false;
+}
+
+void IoRing::close() {
+}
+
+bool IoRing::queueRead(int, void*, size_t, uint64_t, uint64_t) {
+    return false;
+}
+
+bool IoRing::submit() {
+    return false;
+}
+
+bool IoRing::wait(uint64_t&, int&) {
+    return false;
+}
+
+IoRing::~IoRing() {
+}
+
+#endif
@@ -0,0 +1,374 @@
+﻿// MarchingCubes v 1.0
+#include "MarchingCubes.h"
+#include "Parallel.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    // 三角形下标中表示“上一层块底平面顶点”的标记位
+    const uint32_t kExternal = 0x80000000u;
+    // 每种情况最多 5 个三角形
+    const int kMaxCaseIndices = 15;
+    // 一次分类的格子数（格点数加一后不超过 64 位）
+    const int kClassifyRun = 63;
+
+    // 格子的 12 条边（角点编号：bit0 = x，bit1 = y，bit2 = z），第 e 条边沿 e / 4 轴
+    const int kCellEdges[12][2] = {
+        { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+        { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+    };
+
+    struct CaseTable {
+        uint8_t count[256];                     // 每种情况的下标数
+        uint8_t edges[256][kMaxCaseIndices];    // 三角形顶点所在的格边
+    };
+
+    // 生成 256 种情况的三角形。每个面沿边界（从外面看逆时针）走，每段连续的内部角点
+    // 从离开它的格边连到进入它的格边；相邻两个面经过公共格边的方向相反，
+    // 线段在格子表面上首尾相接成环，环按扇形三角化。
+    // 二义面（对角两个内部角点）总是把内部角点分开，只取决于面上四个角点，相邻格子一致
+    CaseTable buildCaseTable() {
+        CaseTable table = {};
+        int edgeOf[8][8] = {};
+        for (int e = 0; e < 12; ++e) {
+            edgeOf[kCellEdges[e][0]][kCellEdges[e][1]] = e;
+            edgeOf[kCellEdges[e][1]][kCellEdges[e][0]] = e;
+        }
+        // 每条格边所在的两个面（面 = 轴 * 2 + 侧）
+        int faceMask[12];
+        for (int e = 0; e < 12; ++e) {
+            int a = kCellEdges[e][0];
+            faceMask[e] = 0;
+            for (int d = 0; d < 3; ++d) {
+                if (d != e / 4) faceMask[e] |= 1 << (d * 2 + ((a >> d) & 1));
+            }
+        }
+        // 另外两个轴 (u, v) 上按 (0,0) (1,0) (1,1) (0,1) 排列是绕 +axis 逆时针，负侧的面反过来
+        const int uv[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+        int faces[6][4];
+        for (int axis = 0; axis < 3; ++axis) {
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+            for (int side = 0; side < 2; ++side) {
+                for (int t = 0; t < 4; ++t) {
+                    int s = side == 1 ? t : 3 - t;
+                    faces[axis * 2 + side][t] = (side << axis) | (uv[s][0] << u) | (uv[s][1] << v);
+                }
+            }
+        }
+        for (int c = 0; c < 256; ++c) {
+            auto inside = [c](int corner) {
+                return ((c >> corner) & 1) != 0;
+            };
+            int next[12];
+            std::fill(next, next + 12, -1);
+            for (const auto& face : faces) {
+                for (int t = 0; t < 4; ++t) {
+                    if (!inside(face[t]) || inside(face[(t + 1) & 3])) continue;
+                    int r = t;
+                    while (inside(face[(r + 3) & 3])) r = (r + 3) & 3;
+                    next[edgeOf[face[t]][face[(t + 1) & 3]]] = edgeOf[face[(r + 3) & 3]][face[r]];
+                }
+            }
+            bool used[12] = {};
+            int count = 0;
+            for (int e = 0; e < 12; ++e) {
+                if (next[e] < 0 || used[e]) continue;
+                int loop[12];
+                int n = 0;
+                for (int f = e; !used[f]; f = next[f]) {
+                    used[f] = true;
+                    loop[n++] = f;
+                }
+                // 割耳三角化，对角线不能落在格子的面上（否则与相邻格子的三角形重叠，边不再流形）；
+                // 环的方向绕着内部角点，反过来三角形才朝外
+                while (n >= 3) {
+                    int ear = 0;
+                    for (int t = 0; t < n && n > 3; ++t) {
+                        if ((faceMask[loop[(t + n - 1) % n]] & faceMask[loop[(t + 1) % n]]) == 0) {
+                            ear = t;
+                            break;
+                        }
+                    }
+                    table.edges[c][count++] = uint8_t(loop[(ear + n - 1) % n]);
+                    table.edges[c][count++] = uint8_t(loop[(ear + 1) % n]);
+                    table.edges[c][count++] = uint8_t(loop[ear]);
+                    std::copy(loop + ear + 1, loop + n, loop + ear);
+                    --n;
+                }
+            }
+            table.count[c] = uint8_t(count);
+        }
+        return table;
+    }
+
+    const CaseTable& caseTable() {
+        static const CaseTable table = buildCaseTable();
+        return table;
+    }
+
+    // row[0 .. count) 中小于 iso 的格点的位（count <= 64）
+    uint64_t belowBits(const float* row, int count, float iso) {
+        uint64_t bits = 0;
+        int i = 0;
+#if THC_SSE2
+        const __m128 viso = _mm_set1_ps(iso);
+        for (; i + 4 <= count; i += 4) {
+            bits |= uint64_t(_mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(row + i), viso))) << i;
+        }
+#endif
+        for (; i < count; ++i) bits |= uint64_t(row[i] < iso ? 1 : 0) << i;
+        return bits;
+    }
+
+    // 格点 (i, j, k) 处的梯度：中心差分，边界处单侧差分
+    void gradient(const ScalarGrid& g, int i, int j, int k, float* out) {
+        const float* v = g.values.data();
+        const size_t p = g.index(i, j, k);
+        auto diff = [&](int c, int n, size_t stride) {
+            float lo = c > 0 ? v[p - stride] : v[p];
+            float hi = c + 1 < n ? v[p + stride] : v[p];
+            return (hi - lo) / float((c > 0 ? 1 : 0) + (c + 1 < n ? 1 : 0));
+        };
+        out[0] = diff(i, g.nx, 1);
+        out[1] = diff(j, g.ny, size_t(g.nx));
+        out[2] = diff(k, g.nz, size_t(g.nx) * g.ny);
+    }
+}
+
+void MarchingCubes::setGrid(const ScalarGrid& grid) {
+    grid_ = &grid;
+    if (grid.nx < 2 || grid.ny < 2 || grid.nz < 2) {
+        blocks_[0] = blocks_[1] = blocks_[2] = 0;
+        blockMin_.clear();
+        blockMax_.clear();
+        return;
+    }
+    const int n[3] = { grid.nx, grid.ny, grid.nz };
+    for (int d = 0; d < 3; ++d) blocks_[d] = (n[d] - 1 + kBlock - 1) / kBlock;
+    const size_t blockLayer = size_t(blocks_[0]) * blocks_[1];
+    blockMin_.resize(blockLayer * blocks_[2]);
+    blockMax_.resize(blockLayer * blocks_[2]);
+
+    // 块 b 覆盖格点 [8b, 8b + 8]（含两端），相邻块共享一层格点；按块层并行，每层只写自己的摘要
+    parallelFor(0, size_t(blocks_[2]), [&](size_t b0, size_t b1) {
+        std::vector<float> rowMin(size_t(blocks_[0]), 0.0f);
+        std::vector<float> rowMax(size_t(blocks_[0]), 0.0f);
+        for (size_t bk = b0; bk < b1; ++bk) {
+            float* layerMin = &blockMin_[bk * blockLayer];
+            float* layerMax = &blockMax_[bk * blockLayer];
+            std::fill(layerMin, layerMin + blockLayer, std::numeric_limits<float>::infinity());
+            std::fill(layerMax, layerMax + blockLayer, -std::numeric_limits<float>::infinity());
+            int kEnd = std::min(int(bk + 1) * kBlock, grid.nz - 1);
+            for (int k = int(bk) * kBlock; k <= kEnd; ++k) {
+                for (int j = 0; j < grid.ny; ++j) {
+                    const float* row = grid.values.data() + grid.index(0, j, k);
+                    for (int bi = 0; bi < blocks_[0]; ++bi) {
+                        int iEnd = std::min((bi + 1) * kBlock, grid.nx - 1);
+                        float lo = row[bi * kBlock];
+                        float hi = lo;
+                        for (int i = bi * kBlock + 1; i <= iEnd; ++i) {
+                            lo = std::min(lo, row[i]);
+                            hi = std::max(hi, row[i]);
+                        }
+                        rowMin[bi] = lo;
+                        rowMax[bi] = hi;
+                    }
+                    // 第 j 行属于块行 j / 8，块边界上的行同时属于上一块行
+                    int bjLast = std::min(j / kBlock, blocks_[1] - 1);
+                    int bjFirst = j % kBlock == 0 && j > 0 ? j / kBlock - 1 : bjLast;
+                    for (int bj = bjFirst; bj <= bjLast; ++bj) {
+                        float* bmin = layerMin + size_t(bj) * blocks_[0];
+                        float* bmax = layerMax + size_t(bj) * blocks_[0];
+                        for (int bi = 0; bi < blocks_[0]; ++bi) {
+                            bmin[bi] = std::min(bmin[bi], rowMin[bi]);
+                            bmax[bi] = std::max(bmax[bi], rowMax[bi]);
+                        }
+                    }
+                }
+            }
+        }
+    }, 1);
+}
+
+void MarchingCubes::processSlab(float iso, int k0, int k1, bool first, Slab& slab) const {
+    const ScalarGrid& g = *grid_;
+    const int nx = g.nx;
+    const int cx = g.nx - 1;
+    const int cy = g.ny - 1;
+    const size_t plane = size_t(nx) * g.ny;
+    const float* values = g.values.data();
+    const CaseTable& table = caseTable();
+    const float normalSign = insideHigh_ ? -1.0f : 1.0f;
+    slab.positions.clear();
+    slab.normals.clear();
+    slab.indices.clear();
+    for (std::vector<uint32_t>& cache : slab.edgeCache) cache.assign(plane, 0);
+
+    // 缓存里的顶点号只有不小于 base 才属于当前平面：平面 p 的 x、y 边顶点在第 p - 1、p 层生成，
+    // 同一份缓存里更早的平面 p - 2 的顶点号都更小，所以不用逐层清空
+    uint32_t prevBase = 0;
+    uint32_t layerBase = 0;
+    auto vertexAt = [&](int axis, int i, int j, int k, int layer) -> uint32_t {
+        const size_t slot = size_t(j) * nx + i;
+        uint32_t* cache;
+        uint32_t base;
+        if (axis == 2) {
+            cache = slab.edgeCache[4].data();
+            base = layerBase;
+        }
+        else {
+            // 层块底平面的顶点归下面的层块
+            if (k == k0 && !first) return kExternal | uint32_t(size_t(axis) * plane + slot);
+            cache = slab.edgeCache[axis * 2 + (k & 1)].data();
+            base = k == layer ? prevBase : layerBase;
+        }
+        uint32_t stored = cache[slot];
+        if (stored > base) return stored - 1;
+
+        uint32_t id = uint32_t(slab.positions.size() / 3);
+        cache[slot] = id + 1;
+        const int step[3] = { axis == 0, axis == 1, axis == 2 };
+        size_t pa = g.index(i, j, k);
+        size_t pb = g.index(i + step[0], j + step[1], k + step[2]);
+        float t = (iso - values[pa]) / (values[pb] - values[pa]);
+        if (!(t >= 0.0f)) t = 0.0f;
+        if (t > 1.0f) t = 1.0f;
+        slab.positions.push_back(g.origin[0] + g.spacing * (float(i) + float(step[0]) * t));
+        slab.positions.push_back(g.origin[1] + g.spacing * (float(j) + float(step[1]) * t));
+        slab.positions.push_back(g.origin[2] + g.spacing * (float(k) + float(step[2]) * t));
+        float ga[3];
+        float gb[3];
+        gradient(g, i, j, k, ga);
+        gradient(g, i + step[0], j + step[1], k + step[2], gb);
+        float n[3];
+        for (int d = 0; d < 3; ++d) n[d] = ga[d] + (gb[d] - ga[d]) * t;
+        float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float scale = len > 0.0f ? normalSign / len : 0.0f;
+        slab.normals.push_back(n[0] * scale);
+        slab.normals.push_back(n[1] * scale);
+        slab.normals.push_back(len > 0.0f ? n[2] * scale : 1.0f);
+        return id;
+    };
+
+    const size_t blockLayer = size_t(blocks_[0]) * blocks_[1];
+    for (int k = k0; k < k1; ++k) {
+        prevBase = layerBase;
+        layerBase = uint32_t(slab.positions.size() / 3);
+        const float* p0 = values + size_t(k) * plane;
+        const float* p1 = p0 + plane;
+        const size_t layerBlocks = size_t(k / kBlock) * blockLayer;
+        for (int bj = 0; bj < blocks_[1]; ++bj) {
+            const float* bmin = &blockMin_[layerBlocks + size_t(bj) * blocks_[0]];
+            const float* bmax = &blockMax_[layerBlocks + size_t(bj) * blocks_[0]];
+            for (int bi = 0; bi < blocks_[0];) {
+                if (!(bmin[bi] < iso && bmax[bi] >= iso)) {
+                    ++bi;
+                    continue;
+                }
+                // 相邻的跨越等值面的块合成一段一起分类
+                int be = bi + 1;
+                while (be < blocks_[0] && bmin[be] < iso && bmax[be] >= iso) ++be;
+                const int i0 = bi * kBlock;
+                const int i1 = std::min(be * kBlock, cx);
+                const int j1 = std::min((bj + 1) * kBlock, cy);
+                for (int j = bj * kBlock; j < j1; ++j) {
+                    const float* rows[4] = { p0 + size_t(j) * nx, p0 + size_t(j + 1) * nx,
+                        p1 + size_t(j) * nx, p1 + size_t(j + 1) * nx };
+                    for (int c0 = i0; c0 < i1; c0 += kClassifyRun) {
+                        const int m = std::min(kClassifyRun, i1 - c0);
+                        const uint64_t pointMask = ~uint64_t(0) >> (kClassifyRun - m);
+                        uint64_t bits[4];
+                        for (int r = 0; r < 4; ++r) {
+                            bits[r] = belowBits(rows[r] + c0, m + 1, iso);
+                            if (insideHigh_) bits[r] = ~bits[r] & pointMask;
+                        }
+                        // 格子 t 的八个角点是四行的第 t、t + 1 个格点：有内有外才需要处理
+                        uint64_t any = bits[0] | bits[1] | bits[2] | bits[3];
+                        uint64_t all = bits[0] & bits[1] & bits[2] & bits[3];
+                        uint64_t mixed = (any | (any >> 1)) & ~(all & (all >> 1)) & ((uint64_t(1) << m) - 1);
+                        while (mixed != 0) {
+                            int t = countTrailingZeros64(mixed);
+                            mixed &= mixed - 1;
+                            int cubeCase = int((bits[0] >> t) & 3) | int((bits[1] >> t) & 3) << 2 |
+                                int((bits[2] >> t) & 3) << 4 | int((bits[3] >> t) & 3) << 6;
+                            const int i = c0 + t;
+                            const uint8_t* edges = table.edges[cubeCase];
+                            for (int e = 0; e < table.count[cubeCase]; ++e) {
+                                int corner = kCellEdges[edges[e]][0];
+                                slab.indices.push_back(vertexAt(edges[e] / 4, i + (corner & 1),
+                                    j + ((corner >> 1) & 1), k + (corner >> 2), k));
+                            }
+                        }
+                    }
+                }
+                bi = be;
+            }
+        }
+    }
+    slab.topBase = layerBase;
+}
+
+void MarchingCubes::extract(float iso, Mesh& out) {
+    auto t0 = std::chrono::steady_clock::now();
+    out.clear();
+    activeBlocks_ = 0;
+    extractMs_ = 0.0;
+    if (grid_ == nullptr || blockMin_.empty()) return;
+    const ScalarGrid& g = *grid_;
+    for (size_t b = 0; b < blockMin_.size(); ++b) {
+        if (blockMin_[b] < iso && blockMax_[b] >= iso) ++activeBlocks_;
+    }
+    if (activeBlocks_ == 0) return;
+
+    const int layers = g.nz - 1;
+    const size_t slabCount = std::min<size_t>(size_t(layers), size_t(workerCount()) * 4);
+    slabs_.resize(slabCount);
+    auto slabBegin = [&](size_t s) {
+        return int(size_t(layers) * s / slabCount);
+    };
+    ThreadPool::instance().run(slabCount, [&](size_t s) {
+        processSlab(iso, slabBegin(s), slabBegin(s + 1), s == 0, slabs_[s]);
+    });
+
+    uint32_t vertexTotal = 0;
+    size_t indexTotal = 0;
+    for (Slab& slab : slabs_) {
+        slab.vertexBase = vertexTotal;
+        slab.indexBase = indexTotal;
+        vertexTotal += uint32_t(slab.positions.size() / 3);
+        indexTotal += slab.indices.size();
+    }
+    out.resizeVertices(vertexTotal);
+    out.indices.resize(indexTotal);
+    const size_t plane = size_t(g.nx) * g.ny;
+    ThreadPool::instance().run(slabCount, [&](size_t s) {
+        const Slab& slab = slabs_[s];
+        size_t nv = slab.positions.size();
+        if (nv > 0) {
+            std::memcpy(&out.positions[3 * size_t(slab.vertexBase)], slab.positions.data(), nv * sizeof(float));
+            std::memcpy(&out.normals[3 * size_t(slab.vertexBase)], slab.normals.data(), nv * sizeof(float));
+        }
+        std::fill(out.atomIds.begin() + slab.vertexBase, out.atomIds.begin() + slab.vertexBase + nv / 3, 0u);
+        // 底平面的引用换成下面层块顶平面缓存里的顶点
+        const Slab* below = s > 0 ? &slabs_[s - 1] : nullptr;
+        const int parity = slabBegin(s) & 1;
+        uint32_t* dst = out.indices.data() + slab.indexBase;
+        for (uint32_t v : slab.indices) {
+            if ((v & kExternal) == 0) {
+                *dst++ = v + slab.vertexBase;
+                continue;
+            }
+            uint32_t ref = v & ~kExternal;
+            size_t axis = ref / plane;
+            uint32_t stored = below->edgeCache[axis * 2 + parity][ref - axis * plane];
+            *dst++ = stored > below->topBase ? below->vertexBase + stored - 1 : below->vertexBase;
+        }
+    });
+    extractMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
@@ -0,0 +1,473 @@
+﻿// MeshOptimizer v 1.0
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if THC_ASSIMP
+#include <assimp/scene.h>
+#endif
+
+namespace {
+    const uint32_t kNone = 0xffffffffu;
+    // 法线锥最宽的三角形与轴夹角的余弦低于该值时不做锥剔除（锥太宽，剔除率很低）
+    const float kMinConeDot = 0.1f;
+
+    // FIFO 缓存的时间戳模拟：time - stamp > size 表示已被挤出；返回是否未命中
+    inline bool touch(std::vector<uint32_t>& stamp, uint32_t& time, unsigned size, uint32_t v) {
+        if (time - stamp[v] > size) {
+            stamp[v] = time++;
+            return true;
+        }
+        return false;
+    }
+
+    // 三角形法线（未归一化，长度为面积的两倍）
+    void triangleNormal(const float* positions, const uint32_t* tri, float n[3]) {
+        const float* a = positions + 3 * size_t(tri[0]);
+        const float* b = positions + 3 * size_t(tri[1]);
+        const float* c = positions + 3 * size_t(tri[2]);
+        float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    template <typename T>
+    void permute(std::vector<T>& data, const std::vector<uint32_t>& remap, size_t stride) {
+        if (data.size() != remap.size() * stride) return;
+        std::vector<T> out(data.size());
+        for (size_t v = 0; v < remap.size(); ++v) {
+            for (size_t k = 0; k < stride; ++k) out[remap[v] * stride + k] = data[v * stride + k];
+        }
+        data.swap(out);
+    }
+
+#if THC_ASSIMP
+    void generateNormals(Mesh& mesh, size_t firstVertex, size_t firstIndex) {
+        for (size_t v = firstVertex; v < mesh.vertexCount(); ++v) {
+            for (int d = 0; d < 3; ++d) mesh.normals[3 * v + d] = 0.0f;
+        }
+        for (size_t i = firstIndex; i < mesh.indices.size(); i += 3) {
+            float n[3];
+            triangleNormal(mesh.positions.data(), mesh.indices.data() + i, n);
+            for (int k = 0; k < 3; ++k) {
+                for (int d = 0; d < 3; ++d) mesh.normals[3 * size_t(mesh.indices[i + k]) + d] += n[d];
+            }
+        }
+        for (size_t v = firstVertex; v < mesh.vertexCount(); ++v) {
+            float* n = &mesh.normals[3 * v];
+            float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (len > 0.0f) {
+                for (int d = 0; d < 3; ++d) n[d] /= len;
+            } else {
+                n[0] = 0.0f;
+                n[1] = 0.0f;
+                n[2] = 1.0f;
+            }
+        }
+    }
+
+    // 把 src 追加到 out；transform 为空时不变换
+    bool appendAssimp(const aiMesh& src, uint32_t meshIndex, const aiMatrix4x4* transform, Mesh& out) {
+        if (src.mVertices == nullptr) return false;
+        const size_t base = out.vertexCount();
+        const size_t firstIndex = out.indices.size();
+        out.resizeVertices(base + src.mNumVertices);
+        aiMatrix3x3 normalMatrix;
+        if (transform) {
+            normalMatrix = aiMatrix3x3(*transform);
+            normalMatrix.Inverse().Transpose();
+        }
+        for (unsigned v = 0; v < src.mNumVertices; ++v) {
+            aiVector3D p = src.mVertices[v];
+            if (transform) p = (*transform) * p;
+            float* dst = &out.positions[3 * (base + v)];
+            dst[0] = p.x;
+            dst[1] = p.y;
+            dst[2] = p.z;
+            out.atomIds[base + v] = meshIndex;
+            if (src.mNormals) {
+                aiVector3D n = src.mNormals[v];
+                if (transform) n = normalMatrix * n;
+                n.Normalize();
+                float* dn = &out.normals[3 * (base + v)];
+                dn[0] = n.x;
+                dn[1] = n.y;
+                dn[2] = n.z;
+            }
+        }
+        // 点、线图元与多边形都跳过（导入时应带 aiProcess_Triangulate）
+        for (unsigned f = 0; f < src.mNumFaces; ++f) {
+            const aiFace& face = src.mFaces[f];
+            if (face.mNumIndices != 3) continue;
+            for (int k = 0; k < 3; ++k) {
+                if (face.mIndices[k] >= src.mNumVertices) return false;
+                out.indices.push_back(uint32_t(base + face.mIndices[k]));
+            }
+        }
+        if (src.mNormals == nullptr) generateNormals(out, base, firstIndex);
+        return true;
+    }
+
+    bool appendNode(const aiScene& scene, const aiNode& node, const aiMatrix4x4& parent, Mesh& out) {
+        aiMatrix4x4 transform = parent * node.mTransformation;
+        for (unsigned i = 0; i < node.mNumMeshes; ++i) {
+            unsigned meshIndex = node.mMeshes[i];
+            if (meshIndex >= scene.mNumMeshes) return false;
+            if (!appendAssimp(*scene.mMeshes[meshIndex], meshIndex, &transform, out)) return false;
+        }
+        for (unsigned i = 0; i < node.mNumChildren; ++i) {
+            if (!appendNode(scene, *node.mChildren[i], transform, out)) return false;
+        }
+        return true;
+    }
+#endif
+}
+
+bool Meshlet::backfacing(const float eye[3]) const {
+    if (coneCutoff >= 1.0f) return false;
+    float d[3] = { coneApex[0] - eye[0], coneApex[1] - eye[1], coneApex[2] - eye[2] };
+    float len = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    return d[0] * coneAxis[0] + d[1] * coneAxis[1] + d[2] * coneAxis[2] >= coneCutoff * len;
+}
+
+VertexCacheStats MeshOptimizer::analyze(const Mesh& mesh, unsigned cacheSize) {
+    VertexCacheStats stats;
+    const size_t triCount = mesh.triangleCount();
+    if (triCount == 0) return stats;
+    std::vector<uint32_t> stamp(mesh.vertexCount(), 0);
+    std::vector<uint8_t> used(mesh.vertexCount(), 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0;
+    size_t unique = 0;
+    for (size_t i = 0; i < 3 * triCount; ++i) {
+        uint32_t v = mesh.indices[i];
+        if (touch(stamp, time, cacheSize, v)) ++misses;
+        if (!used[v]) {
+            used[v] = 1;
+            ++unique;
+        }
+    }
+    stats.acmr = float(double(misses) / double(triCount));
+    stats.atvr = float(double(misses) / double(unique));
+    return stats;
+}
+
+// Tipsify：从当前扇心 f 发出它所有未输出的三角形，再在新进缓存的顶点里挑下一个扇心：
+// 还留在缓存里（考虑发出剩余三角形会压入的 2 * live 个顶点）且最早进缓存的优先；
+// 都不行时从死端栈里回溯最近用过的顶点，再不行按顶点号往后找
+void MeshOptimizer::optimizeVertexCache(Mesh& mesh) const {
+    const size_t vertexCount = mesh.vertexCount();
+    const size_t triCount = mesh.triangleCount();
+    if (triCount == 0) return;
+    const uint32_t* indices = mesh.indices.data();
+
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t i = 0; i < 3 * triCount; ++i) ++live[indices[i]];
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<uint32_t> adjacency(3 * triCount);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < 3 * triCount; ++i) adjacency[fill[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    std::vector<uint8_t> emitted(triCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    deadEnd.reserve(3 * triCount);
+    result.reserve(3 * triCount);
+    const unsigned size = cacheSize_;
+    uint32_t time = size + 1;
+    size_t cursor = 0;
+    while (cursor < vertexCount && live[cursor] == 0) ++cursor;
+    uint32_t fan = cursor < vertexCount ? uint32_t(cursor) : kNone;
+
+    while (fan != kNone) {
+        candidates.clear();
+        for (uint32_t a = offsets[fan]; a < offsets[fan + 1]; ++a) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[3 * size_t(t) + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                touch(stamp, time, size, v);
+            }
+        }
+
+        fan = kNone;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t priority = 0;
+            int64_t age = int64_t(time) - int64_t(stamp[v]);
+            if (age + 2 * int64_t(live[v]) <= int64_t(size)) priority = age;
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fan = v;
+            }
+        }
+        if (fan != kNone) continue;
+        while (!deadEnd.empty()) {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) {
+                fan = v;
+                break;
+            }
+        }
+        if (fan != kNone) continue;
+        while (cursor < vertexCount && live[cursor] == 0) ++cursor;
+        if (cursor < vertexCount) fan = uint32_t(cursor);
+    }
+    mesh.indices.swap(result);
+}
+
+// Sander 等：缓存重排结果里三个顶点都未命中的三角形处缓存已经重启，在那里切开不损失命中；
+// 每段再从冷缓存开始模拟，累计 ACMR 降到整段 ACMR 的 threshold 倍以内时切开。
+// 各簇按 (簇中心 - 网格中心) · 簇平均法线 从大到小排序：外侧、朝外的面先画，挡住后面的片元
+void MeshOptimizer::optimizeOverdraw(Mesh& mesh) const {
+    const size_t vertexCount = mesh.vertexCount();
+    const size_t triCount = mesh.triangleCount();
+    if (triCount == 0) return;
+    const uint32_t* indices = mesh.indices.data();
+    const float* positions = mesh.positions.data();
+    const unsigned size = cacheSize_;
+
+    std::vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t time = size + 1;
+    std::vector<uint32_t> hard;
+    std::vector<uint8_t> misses(triCount);
+    for (size_t t = 0; t < triCount; ++t) {
+        int m = 0;
+        for (int k = 0; k < 3; ++k) m += touch(stamp, time, size, indices[3 * t + k]) ? 1 : 0;
+        misses[t] = uint8_t(m);
+        if (m == 3 || t == 0) hard.push_back(uint32_t(t));
+    }
+    hard.push_back(uint32_t(triCount));
+
+    std::vector<uint32_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); ++h) {
+        const size_t begin = hard[h];
+        const size_t end = hard[h + 1];
+        size_t total = 0;
+        for (size_t t = begin; t < end; ++t) total += misses[t];
+        const double threshold = double(total) / double(end - begin) * overdrawThreshold_;
+        clusters.push_back(uint32_t(begin));
+        // 时间戳跳过 size + 1 使缓存里的顶点全部失效
+        time += size + 1;
+        size_t start = begin;
+        size_t count = 0;
+        for (size_t t = begin; t < end; ++t) {
+            for (int k = 0; k < 3; ++k) count += touch(stamp, time, size, indices[3 * t + k]) ? 1 : 0;
+            if (t + 1 < end && double(count) <= threshold * double(t + 1 - start)) {
+                clusters.push_back(uint32_t(t + 1));
+                time += size + 1;
+                start = t + 1;
+                count = 0;
+            }
+        }
+    }
+    clusters.push_back(uint32_t(triCount));
+    const size_t clusterCount = clusters.size() - 1;
+    if (clusterCount < 2) return;
+
+    double meshCenter[3] = { 0.0, 0.0, 0.0 };
+    for (size_t i = 0; i < 3 * triCount; ++i) {
+        for (int d = 0; d < 3; ++d) meshCenter[d] += positions[3 * size_t(indices[i]) + d];
+    }
+    for (int d = 0; d < 3; ++d) meshCenter[d] /= double(3 * triCount);
+
+    std::vector<float> keys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        double center[3] = { 0.0, 0.0, 0.0 };
+        double normal[3] = { 0.0, 0.0, 0.0 };
+        double area = 0.0;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const uint32_t* tri = indices + 3 * t;
+            float n[3];
+            triangleNormal(positions, tri, n);
+            double a = std::sqrt(double(n[0]) * n[0] + double(n[1]) * n[1] + double(n[2]) * n[2]);
+            for (int d = 0; d < 3; ++d) {
+                double mid = (positions[3 * size_t(tri[0]) + d] + positions[3 * size_t(tri[1]) + d] +
+                    positions[3 * size_t(tri[2]) + d]) / 3.0;
+                center[d] += mid * a;
+                normal[d] += n[d];
+            }
+            area += a;
+        }
+        double len = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area <= 0.0 || len <= 0.0) {
+            keys[c] = 0.0f;
+            continue;
+        }
+        double key = 0.0;
+        for (int d = 0; d < 3; ++d) key += (center[d] / area - meshCenter[d]) * normal[d] / len;
+        keys[c] = float(key);
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) order[c] = uint32_t(c);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return keys[a] > keys[b];
+    });
+    std::vector<uint32_t> result;
+    result.reserve(3 * triCount);
+    for (uint32_t c : order) {
+        result.insert(result.end(), mesh.indices.begin() + 3 * size_t(clusters[c]),
+            mesh.indices.begin() + 3 * size_t(clusters[c + 1]));
+    }
+    mesh.indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(Mesh& mesh) const {
+    const size_t vertexCount = mesh.vertexCount();
+    if (vertexCount == 0) return;
+    std::vector<uint32_t> remap(vertexCount, kNone);
+    uint32_t next = 0;
+    for (uint32_t& v : mesh.indices) {
+        if (remap[v] == kNone) remap[v] = next++;
+        v = remap[v];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] == kNone) remap[v] = next++;
+    }
+    permute(mesh.positions, remap, 3);
+    permute(mesh.normals, remap, 3);
+    permute(mesh.atomIds, remap, 1);
+}
+
+void MeshOptimizer::buildMeshlets(const Mesh& mesh, MeshletSet& out) const {
+    out.meshlets.clear();
+    out.vertices.clear();
+    out.triangles.clear();
+    const size_t triCount = mesh.triangleCount();
+    if (triCount == 0) return;
+    const size_t maxVertices = std::max<size_t>(3, std::min<size_t>(maxMeshletVertices_, 255));
+    const size_t maxTriangles = std::max<size_t>(1, maxMeshletTriangles_);
+    const uint32_t* indices = mesh.indices.data();
+    const float* positions = mesh.positions.data();
+    std::vector<uint32_t> local(mesh.vertexCount(), kNone);
+
+    Meshlet current;
+    auto finish = [&]() {
+        if (current.triangleCount == 0) return;
+        const uint32_t* verts = out.vertices.data() + current.vertexOffset;
+        const uint8_t* tris = out.triangles.data() + current.triangleOffset;
+        float lo[3] = { positions[3 * size_t(verts[0])], positions[3 * size_t(verts[0]) + 1], positions[3 * size_t(verts[0]) + 2] };
+        float hi[3] = { lo[0], lo[1], lo[2] };
+        for (uint32_t i = 0; i < current.vertexCount; ++i) {
+            const float* p = positions + 3 * size_t(verts[i]);
+            for (int d = 0; d < 3; ++d) {
+                lo[d] = std::min(lo[d], p[d]);
+                hi[d] = std::max(hi[d], p[d]);
+            }
+        }
+        float r2 = 0.0f;
+        for (int d = 0; d < 3; ++d) current.center[d] = 0.5f * (lo[d] + hi[d]);
+        for (uint32_t i = 0; i < current.vertexCount; ++i) {
+            const float* p = positions + 3 * size_t(verts[i]);
+            float dx = p[0] - current.center[0];
+            float dy = p[1] - current.center[1];
+            float dz = p[2] - current.center[2];
+            r2 = std::max(r2, dx * dx + dy * dy + dz * dz);
+        }
+        current.radius = std::sqrt(r2);
+
+        // 法线锥：轴取单位面法线之和的方向，半角由离轴最远的面法线决定；
+        // 锥顶沿轴后退到所有三角形平面的背面，从锥顶发出的视线判定即对整个 meshlet 保守
+        std::vector<float> normals(3 * size_t(current.triangleCount), 0.0f);
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < current.triangleCount; ++t) {
+            uint32_t tri[3] = { verts[tris[3 * t]], verts[tris[3 * t + 1]], verts[tris[3 * t + 2]] };
+            float* n = &normals[3 * size_t(t)];
+            triangleNormal(positions, tri, n);
+            float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (len <= 0.0f) continue;
+            for (int d = 0; d < 3; ++d) {
+                n[d] /= len;
+                axis[d] += n[d];
+            }
+        }
+        float axisLen = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        for (int d = 0; d < 3; ++d) current.coneApex[d] = current.center[d];
+        current.coneCutoff = 1.0f;
+        if (axisLen > 0.0f) {
+            for (int d = 0; d < 3; ++d) current.coneAxis[d] = axis[d] / axisLen;
+            float minDot = 1.0f;
+            float maxT = 0.0f;
+            for (uint32_t t = 0; t < current.triangleCount; ++t) {
+                const float* n = &normals[3 * size_t(t)];
+                float dn = n[0] * current.coneAxis[0] + n[1] * current.coneAxis[1] + n[2] * current.coneAxis[2];
+                if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f) continue;
+                minDot = std::min(minDot, dn);
+                if (dn <= 0.0f) continue;
+                const float* p = positions + 3 * size_t(verts[tris[3 * t]]);
+                float dc = (current.center[0] - p[0]) * n[0] + (current.center[1] - p[1]) * n[1] +
+                    (current.center[2] - p[2]) * n[2];
+                maxT = std::max(maxT, dc / dn);
+            }
+            if (minDot >= kMinConeDot) {
+                for (int d = 0; d < 3; ++d) current.coneApex[d] = current.center[d] - current.coneAxis[d] * maxT;
+                current.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+            }
+        }
+        out.meshlets.push_back(current);
+        for (uint32_t i = 0; i < current.vertexCount; ++i) local[verts[i]] = kNone;
+        current = Meshlet();
+        current.vertexOffset = uint32_t(out.vertices.size());
+        current.triangleOffset = uint32_t(out.triangles.size());
+    };
+
+    for (size_t t = 0; t < triCount; ++t) {
+        const uint32_t* tri = indices + 3 * t;
+        uint32_t fresh = 0;
+        for (int k = 0; k < 3; ++k) {
+            bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (local[tri[k]] == kNone && !repeated) ++fresh;
+        }
+        if (current.vertexCount + fresh > maxVertices || current.triangleCount + 1 > maxTriangles) finish();
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            if (local[v] == kNone) {
+                local[v] = current.vertexCount++;
+                out.vertices.push_back(v);
+            }
+            out.triangles.push_back(uint8_t(local[v]));
+        }
+        ++current.triangleCount;
+    }
+    finish();
+}
+
+void MeshOptimizer::optimize(Mesh& mesh, MeshletSet* meshlets) {
+    auto t0 = std::chrono::steady_clock::now();
+    before_ = analyze(mesh, cacheSize_);
+    optimizeVertexCache(mesh);
+    optimizeOverdraw(mesh);
+    optimizeVertexFetch(mesh);
+    after_ = analyze(mesh, cacheSize_);
+    if (meshlets) buildMeshlets(mesh, *meshlets);
+    optimizeMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+#if THC_ASSIMP
+bool MeshOptimizer::fromAssimp(const aiMesh& src, uint32_t meshIndex, Mesh& out) {
+    out.clear();
+    return appendAssimp(src, meshIndex, nullptr, out);
+}
+
+bool MeshOptimizer::fromAssimp(const aiScene& scene, Mesh& out) {
+    out.clear();
+    if (scene.mRootNode == nullptr) return false;
+    return appendNode(scene, *scene.mRootNode, aiMatrix4x4(), out);
+}
+#endif
@@ -0,0 +1,552 @@
+﻿// MeshSimplifier v 1.0
+#include "MeshSimplifier.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace {
+    // 开放边界约束平面的权重（相对三角形平面）
+    const double kBoundaryWeight = 10.0;
+    // 折叠后三角形法线与原法线夹角的余弦低于该值视为翻转
+    const double kFlipCos = 0.2;
+    // 簇格子总数上限
+    const size_t kMaxClusterCells = size_t(1) << 22;
+    const uint32_t kNone = 0xffffffffu;
+
+    // 对称 4x4 二次型 (n, d)(n, d)^T 的和，weight 为累计的面积
+    struct Quadric {
+        double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+        double b2 = 0.0, bc = 0.0, bd = 0.0;
+        double c2 = 0.0, cd = 0.0;
+        double d2 = 0.0;
+        double weight = 0.0;
+
+        void addPlane(double a, double b, double c, double d, double w) {
+            a2 += w * a * a;
+            ab += w * a * b;
+            ac += w * a * c;
+            ad += w * a * d;
+            b2 += w * b * b;
+            bc += w * b * c;
+            bd += w * b * d;
+            c2 += w * c * c;
+            cd += w * c * d;
+            d2 += w * d * d;
+        }
+        void add(const Quadric& q) {
+            a2 += q.a2;
+            ab += q.ab;
+            ac += q.ac;
+            ad += q.ad;
+            b2 += q.b2;
+            bc += q.bc;
+            bd += q.bd;
+            c2 += q.c2;
+            cd += q.cd;
+            d2 += q.d2;
+            weight += q.weight;
+        }
+        // 点到各平面距离平方的加权和
+        double eval(const float* p) const {
+            double x = p[0];
+            double y = p[1];
+            double z = p[2];
+            return a2 * x * x + b2 * y * y + c2 * z * z + d2 +
+                2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+        }
+    };
+
+    struct Collapse {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t fromStamp;
+        uint32_t toStamp;
+
+        // priority_queue 取最大，代价小的优先
+        bool operator<(const Collapse& other) const {
+            return cost > other.cost;
+        }
+    };
+
+    void triangleNormal(const float* a, const float* b, const float* c, double* n) {
+        double u[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+        double v[3] = { double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2] };
+        n[0] = u[1] * v[2] - u[2] * v[1];
+        n[1] = u[2] * v[0] - u[0] * v[2];
+        n[2] = u[0] * v[1] - u[1] * v[0];
+    }
+
+    // 点 p 到三角形 abc 的距离（Ericson, Real-Time Collision Detection 5.1.5）
+    float pointTriangleDistance(const float* p, const float* a, const float* b, const float* c) {
+        glm::vec3 vp(p[0], p[1], p[2]), va(a[0], a[1], a[2]), vb(b[0], b[1], b[2]), vc(c[0], c[1], c[2]);
+        glm::vec3 ab = vb - va, ac = vc - va, ap = vp - va;
+        float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return glm::length(ap);
+        glm::vec3 bp = vp - vb;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return glm::length(bp);
+        float wc = d1 * d4 - d3 * d2;
+        if (wc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return glm::length(vp - (va + ab * (d1 / (d1 - d3))));
+        glm::vec3 cp = vp - vc;
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return glm::length(cp);
+        float wb = d5 * d2 - d1 * d6;
+        if (wb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return glm::length(vp - (va + ac * (d2 / (d2 - d6))));
+        float wa = d3 * d6 - d5 * d4;
+        if (wa <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+            return glm::length(vp - (vb + (vc - vb) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+        }
+        float denom = 1.0f / (wa + wb + wc);
+        return glm::length(vp - (va + ab * (wb * denom) + ac * (wc * denom)));
+    }
+
+    // 簇内简化：tris 为簇内三角形（全局三角形号），locked 的顶点不动。
+    // 剩下的三角形（全局顶点号）追加到 out，返回被删顶点到简化后表面的最大距离估计
+    float simplifyCluster(const Mesh& mesh, const uint32_t* tris, size_t triCount, const std::vector<uint8_t>& locked,
+        size_t target, float normalWeight, std::vector<uint32_t>& out) {
+        // 局部顶点号：簇内出现的全局顶点排序去重
+        std::vector<uint32_t> verts;
+        verts.reserve(triCount * 3);
+        for (size_t t = 0; t < triCount; ++t) {
+            const uint32_t* tri = &mesh.indices[3 * size_t(tris[t])];
+            verts.insert(verts.end(), tri, tri + 3);
+        }
+        std::sort(verts.begin(), verts.end());
+        verts.erase(std::unique(verts.begin(), verts.end()), verts.end());
+        const size_t nv = verts.size();
+        std::vector<uint32_t> corners(3 * triCount);
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                uint32_t g = mesh.indices[3 * size_t(tris[t]) + c];
+                corners[3 * t + c] = uint32_t(std::lower_bound(verts.begin(), verts.end(), g) - verts.begin());
+            }
+        }
+        auto pos = [&](uint32_t v) {
+            return &mesh.positions[3 * size_t(verts[v])];
+        };
+        auto nrm = [&](uint32_t v) {
+            return &mesh.normals[3 * size_t(verts[v])];
+        };
+
+        std::vector<Quadric> quadric(nv);
+        std::vector<std::vector<uint32_t>> vertexTris(nv);
+        std::vector<uint8_t> removed(triCount, 0);
+        std::vector<uint8_t> fixed(nv, 0);
+        for (size_t v = 0; v < nv; ++v) fixed[v] = locked[verts[v]];
+        std::vector<std::pair<uint64_t, uint32_t>> edges;
+        edges.reserve(3 * triCount);
+        for (size_t t = 0; t < triCount; ++t) {
+            const uint32_t* c = &corners[3 * t];
+            double n[3];
+            triangleNormal(pos(c[0]), pos(c[1]), pos(c[2]), n);
+            double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                vertexTris[c[k]].push_back(uint32_t(t));
+                uint32_t a = c[k];
+                uint32_t b = c[(k + 1) % 3];
+                edges.emplace_back(uint64_t(std::min(a, b)) << 32 | std::max(a, b), uint32_t(t));
+            }
+            if (len <= 0.0) continue;
+            const float* p = pos(c[0]);
+            double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]) / len;
+            for (int k = 0; k < 3; ++k) {
+                quadric[c[k]].addPlane(n[0] / len, n[1] / len, n[2] / len, d, 0.5 * len);
+                quadric[c[k]].weight += 0.5 * len;
+            }
+        }
+
+        // 开放边界：只被一个三角形用到的边。边界顶点只能沿边界折叠，
+        // boundary 记录每个边界顶点在边界上的两个邻居；分叉的边界顶点锁定
+        std::vector<uint32_t> boundary(2 * nv, kNone);
+        std::sort(edges.begin(), edges.end());
+        for (size_t e = 0; e < edges.size();) {
+            size_t f = e + 1;
+            while (f < edges.size() && edges[f].first == edges[e].first) ++f;
+            if (f - e == 1) {
+                uint32_t a = uint32_t(edges[e].first >> 32);
+                uint32_t b = uint32_t(edges[e].first & 0xffffffffu);
+                const uint32_t* c = &corners[3 * size_t(edges[e].second)];
+                double n[3];
+                triangleNormal(pos(c[0]), pos(c[1]), pos(c[2]), n);
+                const float* pa = pos(a);
+                const float* pb = pos(b);
+                double ev[3] = { double(pb[0]) - pa[0], double(pb[1]) - pa[1], double(pb[2]) - pa[2] };
+                double m[3] = { ev[1] * n[2] - ev[2] * n[1], ev[2] * n[0] - ev[0] * n[2], ev[0] * n[1] - ev[1] * n[0] };
+                double mlen = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+                if (mlen > 0.0) {
+                    double w = kBoundaryWeight * (ev[0] * ev[0] + ev[1] * ev[1] + ev[2] * ev[2]);
+                    double d = -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]) / mlen;
+                    quadric[a].addPlane(m[0] / mlen, m[1] / mlen, m[2] / mlen, d, w);
+                    quadric[b].addPlane(m[0] / mlen, m[1] / mlen, m[2] / mlen, d, w);
+                }
+                for (uint32_t v : { a, b }) {
+                    uint32_t other = v == a ? b : a;
+                    if (boundary[2 * v] == kNone) boundary[2 * v] = other;
+                    else if (boundary[2 * v + 1] == kNone) boundary[2 * v + 1] = other;
+                    else fixed[v] = 1;
+                }
+            }
+            e = f;
+        }
+        auto onBoundary = [&](uint32_t v) {
+            return boundary[2 * v] != kNone;
+        };
+
+        std::vector<uint32_t> stamp(nv, 0);
+        std::vector<uint8_t> dead(nv, 0);
+        // drift[w]：已折叠到 w 的原始顶点到当前表面的距离估计。
+        // 把 u 折叠到 v 时，取 pu 到 v 的新三角形扇的距离加上 drift[u]
+        std::vector<float> drift(nv, 0.0f);
+        std::priority_queue<Collapse> heap;
+        auto push = [&](uint32_t u, uint32_t v) {
+            if (fixed[u]) return;
+            if (onBoundary(u) && boundary[2 * u] != v && boundary[2 * u + 1] != v) return;
+            const float* pu = pos(u);
+            const float* pv = pos(v);
+            double cost = quadric[u].eval(pv) + quadric[v].eval(pv);
+            if (normalWeight > 0.0f) {
+                const float* nu = nrm(u);
+                const float* nv2 = nrm(v);
+                double dn = 0.0;
+                double dp = 0.0;
+                for (int d = 0; d < 3; ++d) {
+                    dn += double(nu[d] - nv2[d]) * (nu[d] - nv2[d]);
+                    dp += double(pu[d] - pv[d]) * (pu[d] - pv[d]);
+                }
+                cost += normalWeight * quadric[u].weight * dp * dn;
+            }
+            heap.push({ cost, u, v, stamp[u], stamp[v] });
+        };
+        for (size_t t = 0; t < triCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = corners[3 * t + k];
+                uint32_t b = corners[3 * t + (k + 1) % 3];
+                push(a, b);
+                push(b, a);
+            }
+        }
+
+        auto neighbors = [&](uint32_t v, std::vector<uint32_t>& list) {
+            list.clear();
+            for (uint32_t t : vertexTris[v]) {
+                if (removed[t]) continue;
+                for (int k = 0; k < 3; ++k) {
+                    if (corners[3 * size_t(t) + k] != v) list.push_back(corners[3 * size_t(t) + k]);
+                }
+            }
+            std::sort(list.begin(), list.end());
+            list.erase(std::unique(list.begin(), list.end()), list.end());
+        };
+
+        size_t alive = triCount;
+        float maxError = 0.0f;
+        std::vector<uint32_t> ringU;
+        std::vector<uint32_t> ringV;
+        while (alive > target && !heap.empty()) {
+            Collapse step = heap.top();
+            heap.pop();
+            const uint32_t u = step.from;
+            const uint32_t v = step.to;
+            if (dead[u] || dead[v] || step.fromStamp != stamp[u] || step.toStamp != stamp[v]) continue;
+
+            // link 条件：u、v 的公共邻居恰好是共边三角形的第三个顶点，否则折叠后不再是流形
+            size_t shared = 0;
+            for (uint32_t t : vertexTris[u]) {
+                if (removed[t]) continue;
+                const uint32_t* c = &corners[3 * size_t(t)];
+                if (c[0] == v || c[1] == v || c[2] == v) ++shared;
+            }
+            if (shared == 0) continue;
+            neighbors(u, ringU);
+            neighbors(v, ringV);
+            size_t common = 0;
+            for (size_t i = 0, j = 0; i < ringU.size() && j < ringV.size();) {
+                if (ringU[i] < ringV[j]) ++i;
+                else if (ringU[i] > ringV[j]) ++j;
+                else {
+                    ++common;
+                    ++i;
+                    ++j;
+                }
+            }
+            if (common != shared) continue;
+            // 锁定的 v 还连着其他簇的三角形，簇内看不到它的全部邻居：
+            // u 的锁定邻居若不在 v 的簇内邻居中，可能是簇外的公共邻居，保守地不折叠
+            if (fixed[v]) {
+                bool unknown = false;
+                for (uint32_t w : ringU) {
+                    if (w != v && fixed[w] && !std::binary_search(ringV.begin(), ringV.end(), w)) {
+                        unknown = true;
+                        break;
+                    }
+                }
+                if (unknown) continue;
+            }
+
+            // u 移到 v 后其余三角形不能翻转或退化
+            bool valid = true;
+            for (uint32_t t : vertexTris[u]) {
+                if (removed[t]) continue;
+                const uint32_t* c = &corners[3 * size_t(t)];
+                if (c[0] == v || c[1] == v || c[2] == v) continue;
+                const float* p[3];
+                const float* q[3];
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = pos(c[k]);
+                    q[k] = c[k] == u ? pos(v) : p[k];
+                }
+                double before[3];
+                double after[3];
+                triangleNormal(p[0], p[1], p[2], before);
+                triangleNormal(q[0], q[1], q[2], after);
+                double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                double lb = std::sqrt(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]);
+                double la = std::sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+                if (la <= 1e-12 * (lb + 1e-30) || dot < kFlipCos * lb * la) {
+                    valid = false;
+                    break;
+                }
+            }
+            if (!valid) continue;
+
+            for (uint32_t t : vertexTris[u]) {
+                if (removed[t]) continue;
+                uint32_t* c = &corners[3 * size_t(t)];
+                if (c[0] == v || c[1] == v || c[2] == v) {
+                    removed[t] = 1;
+                    --alive;
+                    continue;
+                }
+                for (int k = 0; k < 3; ++k) {
+                    if (c[k] == u) c[k] = v;
+                }
+                vertexTris[v].push_back(t);
+            }
+            // 沿边界折叠：u 在边界上的另一个邻居改接到 v
+            if (onBoundary(u)) {
+                uint32_t w = boundary[2 * u] == v ? boundary[2 * u + 1] : boundary[2 * u];
+                for (int k = 0; k < 2; ++k) {
+                    if (boundary[2 * v + k] == u) boundary[2 * v + k] = w;
+                    if (w != kNone && boundary[2 * w + k] == u) boundary[2 * w + k] = v;
+                }
+            }
+            float fan = std::numeric_limits<float>::max();
+            for (uint32_t t : vertexTris[v]) {
+                if (removed[t]) continue;
+                const uint32_t* c = &corners[3 * size_t(t)];
+                fan = std::min(fan, pointTriangleDistance(pos(u), pos(c[0]), pos(c[1]), pos(c[2])));
+            }
+            if (fan == std::numeric_limits<float>::max()) fan = 0.0f;
+            float error = drift[u] + fan;
+            drift[v] = std::max(drift[v], error);
+            maxError = std::max(maxError, error);
+            quadric[v].add(quadric[u]);
+            dead[u] = 1;
+            vertexTris[u].clear();
+            ++stamp[v];
+            neighbors(v, ringV);
+            for (uint32_t w : ringV) {
+                push(v, w);
+                push(w, v);
+            }
+        }
+
+        for (size_t t = 0; t < triCount; ++t) {
+            if (removed[t]) continue;
+            for (int k = 0; k < 3; ++k) out.push_back(verts[corners[3 * t + k]]);
+        }
+        return maxError;
+    }
+}
+
+size_t MeshLod::selectLevel(const glm::mat4& view, float fovY, float viewportHeight, float pixelError) const {
+    if (levels.empty()) return 0;
+    // 视空间中相机看向 -z，取包围球最近处的深度
+    glm::vec4 c = view * glm::vec4(center[0], center[1], center[2], 1.0f);
+    float distance = -c.z - radius;
+    if (distance <= 0.0f) return 0;
+    float pixelsPerUnit = viewportHeight / (2.0f * distance * std::tan(0.5f * fovY));
+    size_t level = 0;
+    for (size_t l = 1; l < errors.size() && l < levels.size(); ++l) {
+        if (errors[l] * pixelsPerUnit > pixelError) break;
+        level = l;
+    }
+    return level;
+}
+
+float MeshSimplifier::simplifyLevel(const Mesh& in, float ratio, bool shifted, Mesh& out) const {
+    out.clear();
+    const size_t triCount = in.triangleCount();
+    const size_t vertexCount = in.vertexCount();
+    if (triCount == 0) return 0.0f;
+
+    float lo[3] = { in.positions[0], in.positions[1], in.positions[2] };
+    float hi[3] = { lo[0], lo[1], lo[2] };
+    for (size_t v = 1; v < vertexCount; ++v) {
+        for (int d = 0; d < 3; ++d) {
+            lo[d] = std::min(lo[d], in.positions[3 * v + d]);
+            hi[d] = std::max(hi[d], in.positions[3 * v + d]);
+        }
+    }
+    double area = 0.0;
+    for (size_t t = 0; t < triCount; ++t) {
+        double n[3];
+        const uint32_t* c = &in.indices[3 * t];
+        triangleNormal(&in.positions[3 * size_t(c[0])], &in.positions[3 * size_t(c[1])], &in.positions[3 * size_t(c[2])], n);
+        area += 0.5 * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    }
+
+    // 簇格子边长按表面积估计，使每个非空格子里约有 clusterTriangles_ 个三角形
+    double clusterCount = std::max(1.0, double(triCount) / double(std::max<size_t>(clusterTriangles_, 1)));
+    float extent = std::max(hi[0] - lo[0], std::max(hi[1] - lo[1], hi[2] - lo[2]));
+    float cell = float(std::sqrt(area / clusterCount));
+    if (!(cell > 0.0f)) cell = std::max(extent, 1e-6f);
+    int dims[3];
+    for (;;) {
+        size_t total = 1;
+        for (int d = 0; d < 3; ++d) {
+            dims[d] = int((hi[d] - lo[d]) / cell) + 2;
+            total *= size_t(dims[d]);
+        }
+        if (total <= kMaxClusterCells) break;
+        cell *= 1.25f;
+    }
+    float origin[3];
+    for (int d = 0; d < 3; ++d) origin[d] = lo[d] - (shifted ? 0.5f * cell : 0.0f);
+
+    // 三角形按重心所在格子计数排序
+    std::vector<uint32_t> cellOf(triCount);
+    parallelFor(0, triCount, [&](size_t b0, size_t b1) {
+        for (size_t t = b0; t < b1; ++t) {
+            const uint32_t* c = &in.indices[3 * t];
+            int g[3];
+            for (int d = 0; d < 3; ++d) {
+                float m = (in.positions[3 * size_t(c[0]) + d] + in.positions[3 * size_t(c[1]) + d] +
+                    in.positions[3 * size_t(c[2]) + d]) / 3.0f;
+                g[d] = std::min(dims[d] - 1, std::max(0, int((m - origin[d]) / cell)));
+            }
+            cellOf[t] = uint32_t((size_t(g[2]) * dims[1] + g[1]) * dims[0] + g[0]);
+        }
+    }, 1 << 14);
+    const size_t cellCount = size_t(dims[0]) * dims[1] * dims[2];
+    std::vector<uint32_t> cellStart(cellCount + 1, 0);
+    for (size_t t = 0; t < triCount; ++t) cellStart[cellOf[t] + 1]++;
+    for (size_t c = 0; c < cellCount; ++c) cellStart[c + 1] += cellStart[c];
+    std::vector<uint32_t> order(triCount);
+    {
+        std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+        for (size_t t = 0; t < triCount; ++t) order[fill[cellOf[t]]++] = uint32_t(t);
+    }
+
+    // 被不同簇的三角形用到的顶点锁定
+    std::vector<uint32_t> owner(vertexCount, kNone);
+    std::vector<uint8_t> locked(vertexCount, 0);
+    for (size_t t = 0; t < triCount; ++t) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = in.indices[3 * t + k];
+            if (owner[v] == kNone) owner[v] = cellOf[t];
+            else if (owner[v] != cellOf[t]) locked[v] = 1;
+        }
+    }
+    std::vector<uint32_t> clusters;
+    for (size_t c = 0; c < cellCount; ++c) {
+        if (cellStart[c + 1] > cellStart[c]) clusters.push_back(uint32_t(c));
+    }
+
+    std::vector<std::vector<uint32_t>> outIndices(clusters.size());
+    std::vector<float> errors(clusters.size(), 0.0f);
+    ThreadPool::instance().run(clusters.size(), [&](size_t i) {
+        uint32_t c = clusters[i];
+        size_t count = cellStart[c + 1] - cellStart[c];
+        size_t target = size_t(double(count) * ratio);
+        errors[i] = simplifyCluster(in, &order[cellStart[c]], count, locked, target, normalWeight_, outIndices[i]);
+    });
+
+    // 压缩：只保留用到的顶点，按首次出现的顺序编号
+    std::vector<uint32_t> remap(vertexCount, kNone);
+    uint32_t used = 0;
+    size_t indexCount = 0;
+    for (const std::vector<uint32_t>& list : outIndices) {
+        indexCount += list.size();
+        for (uint32_t v : list) {
+            if (remap[v] == kNone) remap[v] = used++;
+        }
+    }
+    out.resizeVertices(used);
+    out.indices.reserve(indexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        uint32_t r = remap[v];
+        if (r == kNone) continue;
+        for (int d = 0; d < 3; ++d) {
+            out.positions[3 * size_t(r) + d] = in.positions[3 * v + d];
+            out.normals[3 * size_t(r) + d] = in.normals[3 * v + d];
+        }
+        out.atomIds[r] = in.atomIds[v];
+    }
+    for (const std::vector<uint32_t>& list : outIndices) {
+        for (uint32_t v : list) out.indices.push_back(remap[v]);
+    }
+    return errors.empty() ? 0.0f : *std::max_element(errors.begin(), errors.end());
+}
+
+float MeshSimplifier::simplify(const Mesh& in, float ratio, Mesh& out) const {
+    // 簇边界锁定，一遍可能达不到目标；格子交替错开再做，直到没有进展
+    const size_t target = size_t(double(in.triangleCount()) * ratio);
+    float error = simplifyLevel(in, ratio, false, out);
+    for (int pass = 1; out.triangleCount() > target; ++pass) {
+        size_t before = out.triangleCount();
+        Mesh next;
+        float r = float(double(target) / double(before));
+        float passError = simplifyLevel(out, r, pass % 2 == 1, next);
+        if (next.triangleCount() * 20 > before * 19) break;
+        error += passError;
+        out = std::move(next);
+    }
+    return error;
+}
+
+void MeshSimplifier::build(Mesh mesh, MeshLod& out) {
+    auto t0 = std::chrono::steady_clock::now();
+    out.levels.clear();
+    out.errors.clear();
+    out.radius = 0.0f;
+    const size_t vertexCount = mesh.vertexCount();
+    if (vertexCount > 0) {
+        float lo[3] = { mesh.positions[0], mesh.positions[1], mesh.positions[2] };
+        float hi[3] = { lo[0], lo[1], lo[2] };
+        for (size_t v = 1; v < vertexCount; ++v) {
+            for (int d = 0; d < 3; ++d) {
+                lo[d] = std::min(lo[d], mesh.positions[3 * v + d]);
+                hi[d] = std::max(hi[d], mesh.positions[3 * v + d]);
+            }
+        }
+        float r2 = 0.0f;
+        for (int d = 0; d < 3; ++d) out.center[d] = 0.5f * (lo[d] + hi[d]);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            float dx = mesh.positions[3 * v] - out.center[0];
+            float dy = mesh.positions[3 * v + 1] - out.center[1];
+            float dz = mesh.positions[3 * v + 2] - out.center[2];
+            r2 = std::max(r2, dx * dx + dy * dy + dz * dz);
+        }
+        out.radius = std::sqrt(r2);
+    }
+    out.levels.push_back(std::move(mesh));
+    out.errors.push_back(0.0f);
+
+    // 每一级的误差累加在上一级之上，作为相对原始网格的误差
+    while (out.levels.size() < maxLevels_) {
+        const Mesh& prev = out.levels.back();
+        size_t before = prev.triangleCount();
+        if (before <= minTriangles_) break;
+        Mesh next;
+        float error = simplifyLevel(prev, levelRatio_, out.levels.size() % 2 == 0, next);
+        if (next.triangleCount() * 20 > before * 19) break;
+        out.errors.push_back(out.errors.back() + error);
+        out.levels.push_back(std::move(next));
+    }
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
@@ -0,0 +1,337 @@
+﻿// MmtfReader v 1.0
+#include "MmtfReader.h"
+#include "BinaryCodec.h"
+#include "Element.h"
+#include "Parallel.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+    typedef MsgPackDocument::Ref Ref;
+
+    const size_t kHeaderSize = 12;
+
+    inline int32_t readInt32BE(const uint8_t* p) {
+        return int32_t((uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]);
+    }
+
+    // 二进制字段头：codec、解码后长度、参数（均为大端 int32）
+    struct Field {
+        int32_t codec = 0;
+        size_t length = 0;
+        int32_t param = 0;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // 头中的长度来自文件，不可信：超过 maxLength（该字段应有的元素数）的判为损坏，不按它分配内存
+    bool readField(Ref r, size_t maxLength, Field& f) {
+        if (r.type() != MsgPackDocument::Type::Binary || r.byteCount() < kHeaderSize) return false;
+        const uint8_t* p = r.bytes();
+        f.codec = readInt32BE(p);
+        f.length = size_t(uint32_t(readInt32BE(p + 4)));
+        if (f.length > maxLength) return false;
+        f.param = readInt32BE(p + 8);
+        f.data = p + kHeaderSize;
+        f.size = r.byteCount() - kHeaderSize;
+        return true;
+    }
+
+    // 旧版文件里部分字段是普通数组
+    bool readArray(Ref r, size_t maxLength, std::vector<int32_t>& out) {
+        if (r.type() != MsgPackDocument::Type::Array || r.size() > maxLength) return false;
+        out.resize(r.size());
+        Ref e = r.first();
+        for (size_t i = 0; i < out.size(); ++i, e = e.nextSibling()) out[i] = int32_t(e.asInt());
+        return true;
+    }
+
+    std::vector<int32_t> runLength(const Field& f) {
+        std::vector<int32_t> pairs(f.size / 4);
+        byteSwap32(f.data, pairs.size(), pairs.data());
+        std::vector<int32_t> out(f.length);
+        out.resize(runLengthDecode(pairs.data(), pairs.size() / 2, out.data(), f.length));
+        return out;
+    }
+
+    std::vector<int32_t> recursiveInt16(const Field& f) {
+        std::vector<int16_t> packed(f.size / 2);
+        byteSwap16(f.data, packed.size(), packed.data());
+        std::vector<int32_t> out(f.length);
+        out.resize(unpackInt16(packed.data(), packed.size(), out.data(), f.length));
+        return out;
+    }
+
+    bool decodeInts(Ref r, size_t maxLength, std::vector<int32_t>& out) {
+        Field f;
+        if (r.type() != MsgPackDocument::Type::Binary) return readArray(r, maxLength, out);
+        if (!readField(r, maxLength, f)) return false;
+        switch (f.codec) {
+        case 2:
+            out.resize(f.size);
+            for (size_t i = 0; i < f.size; ++i) out[i] = int8_t(f.data[i]);
+            return true;
+        case 3: {
+            std::vector<int16_t> v(f.size / 2);
+            byteSwap16(f.data, v.size(), v.data());
+            out.assign(v.begin(), v.end());
+            return true;
+        }
+        case 4:
+            out.resize(f.size / 4);
+            byteSwap32(f.data, out.size(), out.data());
+            return true;
+        case 7:
+            out = runLength(f);
+            return true;
+        case 8:
+            out = runLength(f);
+            deltaDecode(out.data(), out.size(), 0);
+            return true;
+        case 14:
+            out = recursiveInt16(f);
+            return true;
+        case 15:
+            out.resize(f.length);
+            out.resize(unpackInt8(reinterpret_cast<const int8_t*>(f.data), f.size, out.data(), f.length));
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool decodeFloats(Ref r, size_t maxLength, std::vector<float>& out) {
+        Field f;
+        if (!readField(r, maxLength, f)) return false;
+        float divisor = f.param != 0 ? float(f.param) : 1.0f;
+        std::vector<int32_t> ints;
+        switch (f.codec) {
+        case 1: {
+            std::vector<int32_t> bits(f.size / 4);
+            byteSwap32(f.data, bits.size(), bits.data());
+            out.resize(bits.size());
+            std::memcpy(out.data(), bits.data(), bits.size() * 4);
+            return true;
+        }
+        case 9:
+            ints = runLength(f);
+            break;
+        case 10:
+            ints = recursiveInt16(f);
+            deltaDecode(ints.data(), ints.size(), 0);
+            break;
+        case 11: {
+            std::vector<int16_t> v(f.size / 2);
+            byteSwap16(f.data, v.size(), v.data());
+            ints.assign(v.begin(), v.end());
+            break;
+        }
+        case 12:
+            ints = recursiveInt16(f);
+            break;
+        case 13:
+            ints.resize(f.length);
+            ints.resize(unpackInt8(reinterpret_cast<const int8_t*>(f.data), f.size, ints.data(), f.length));
+            break;
+        default:
+            return false;
+        }
+        out.resize(ints.size());
+        fixedPointDecode(ints.data(), ints.size(), divisor, out.data());
+        return true;
+    }
+
+    // codec 6：游程编码的字符（插入码、备用位置），0 表示空
+    bool decodeChars(Ref r, size_t maxLength, std::vector<char>& out) {
+        Field f;
+        if (!readField(r, maxLength, f) || f.codec != 6) return false;
+        std::vector<int32_t> v = runLength(f);
+        out.resize(v.size());
+        for (size_t i = 0; i < v.size(); ++i) out[i] = v[i] == 0 ? ' ' : char(v[i]);
+        return true;
+    }
+
+    // codec 5：定长字符串（链名），直接打包成 packName4
+    bool decodeStrings(Ref r, size_t maxLength, std::vector<uint32_t>& out) {
+        Field f;
+        if (!readField(r, maxLength, f) || f.codec != 5 || f.param <= 0) return false;
+        size_t width = size_t(f.param);
+        out.resize(f.size / width);
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = packName4(reinterpret_cast<const char*>(f.data + i * width), width);
+        }
+        return true;
+    }
+
+    // MMTF 的 DSSP 编码：0 pi, 1 bend, 2 alpha, 3 extended, 4 3-10, 5 bridge, 6 turn, 7 coil
+    SecondaryStructure secondaryFromMmtf(int32_t code) {
+        switch (code) {
+        case 0: return SecondaryStructure::PiHelix;
+        case 1: return SecondaryStructure::Bend;
+        case 2: return SecondaryStructure::AlphaHelix;
+        case 3: return SecondaryStructure::Strand;
+        case 4: return SecondaryStructure::Helix310;
+        case 5: return SecondaryStructure::Bridge;
+        case 6: return SecondaryStructure::Turn;
+        default: return SecondaryStructure::Coil;
+        }
+    }
+
+    // groupList 中的一种残基类型
+    struct GroupType {
+        uint32_t name = 0;
+        std::vector<uint32_t> atomNames;
+        std::vector<uint8_t> elements;
+        bool hetero = false;
+    };
+}
+
+bool MmtfReader::open(const std::string& path) {
+    if (!file_.open(path)) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    return parse(file_.data(), file_.size());
+}
+
+bool MmtfReader::parse(const char* data, size_t size) {
+    error_.clear();
+    inputSize_ = size;
+    if (!doc_.parse(reinterpret_cast<const uint8_t*>(data), size) ||
+        doc_.root().type() != MsgPackDocument::Type::Map) {
+        error_ = "malformed MessagePack";
+        return false;
+    }
+    return true;
+}
+
+bool MmtfReader::loadStructure(AtomTable& out) {
+    out.clear();
+    Ref root = doc_.root();
+    if (!root.valid()) {
+        error_ = "no document";
+        return false;
+    }
+
+    // 各字段的长度上限：numAtoms / numGroups / numChains，它们本身不能超过输入的字节数
+    // （真实文件里每个原子、残基至少占一个字节），没有时退回输入大小
+    auto declared = [&](const char* key) {
+        int64_t v = root[key].asInt(-1);
+        return v >= 0 && uint64_t(v) <= inputSize_ ? size_t(v) : inputSize_;
+    };
+    const size_t maxAtoms = declared("numAtoms");
+    const size_t maxGroups = declared("numGroups");
+    const size_t maxChains = declared("numChains");
+    const size_t maxModels = declared("numModels");
+
+    // 各字段互相独立，并行解码
+    std::vector<float> coords[3];
+    std::vector<int32_t> groupTypes, groupIds, secStruct, groupsPerChain, chainsPerModel;
+    std::vector<char> insCodes, altLocs;
+    std::vector<uint32_t> chainNames;
+    bool ok[10] = {};
+    ThreadPool::instance().run(10, [&](size_t i) {
+        switch (i) {
+        case 0: ok[i] = decodeFloats(root["xCoordList"], maxAtoms, coords[0]); break;
+        case 1: ok[i] = decodeFloats(root["yCoordList"], maxAtoms, coords[1]); break;
+        case 2: ok[i] = decodeFloats(root["zCoordList"], maxAtoms, coords[2]); break;
+        case 3: ok[i] = decodeInts(root["groupTypeList"], maxGroups, groupTypes); break;
+        case 4: ok[i] = decodeInts(root["groupIdList"], maxGroups, groupIds); break;
+        case 5: ok[i] = decodeInts(root["secStructList"], maxGroups, secStruct); break;
+        case 6: ok[i] = decodeChars(root["insCodeList"], maxGroups, insCodes); break;
+        case 7: ok[i] = decodeChars(root["altLocList"], maxAtoms, altLocs); break;
+        case 8: ok[i] = decodeStrings(root["chainNameList"], maxChains, chainNames) ||
+            decodeStrings(root["chainIdList"], maxChains, chainNames); break;
+        case 9: ok[i] = readArray(root["groupsPerChain"], maxChains, groupsPerChain) &&
+            readArray(root["chainsPerModel"], maxModels, chainsPerModel); break;
+        default: break;
+        }
+    });
+    if (!ok[0] || !ok[1] || !ok[2] || !ok[3] || !ok[9]) {
+        error_ = "missing required MMTF fields";
+        return false;
+    }
+
+    // 残基类型表：原子名、元素只按类型解析一次
+    Ref groupList = root["groupList"];
+    std::vector<GroupType> types(groupList.size());
+    Ref g = groupList.first();
+    for (size_t t = 0; t < types.size(); ++t, g = g.nextSibling()) {
+        std::string_view name = g["groupName"].asString();
+        types[t].name = packName4(name.data(), name.size());
+        std::string_view chemType = g["chemCompType"].asString();
+        types[t].hetero = chemType.find("PEPTIDE") == std::string_view::npos &&
+            chemType.find("DNA") == std::string_view::npos && chemType.find("RNA") == std::string_view::npos;
+        Ref names = g["atomNameList"];
+        Ref elements = g["elementList"];
+        Ref n = names.first();
+        Ref e = elements.first();
+        for (size_t a = 0; a < names.size(); ++a, n = n.nextSibling(), e = e.nextSibling()) {
+            std::string_view an = n.asString();
+            std::string_view en = a < elements.size() ? e.asString() : std::string_view();
+            types[t].atomNames.push_back(packName4(an.data(), an.size()));
+            types[t].elements.push_back(elementFromSymbol(en.data(), en.size()));
+        }
+    }
+
+    size_t atomTotal = coords[0].size();
+    size_t chainCount = chainsPerModel.empty() ? 0 : size_t(chainsPerModel[0]);
+    if (coords[1].size() != atomTotal || coords[2].size() != atomTotal || chainCount > groupsPerChain.size()) {
+        error_ = "inconsistent MMTF arrays";
+        return false;
+    }
+
+    out.x.reserve(atomTotal);
+    size_t atom = 0;
+    size_t group = 0;
+    for (size_t c = 0; c < chainCount; ++c) {
+        Chain chain;
+        chain.id = c < chainNames.size() ? chainNames[c] : 0;
+        chain.firstResidue = static_cast<uint32_t>(out.residues.size());
+        out.chains.push_back(chain);
+
+        for (int32_t k = 0; k < groupsPerChain[c]; ++k, ++group) {
+            if (group >= groupTypes.size() || size_t(groupTypes[group]) >= types.size()) {
+                error_ = "group index out of range";
+                return false;
+            }
+            const GroupType& type = types[size_t(groupTypes[group])];
+            Residue r;
+            r.name = type.name;
+            r.seq = group < groupIds.size() ? groupIds[group] : 0;
+            r.insertion = group < insCodes.size() ? insCodes[group] : ' ';
+            r.ss = group < secStruct.size() ? secondaryFromMmtf(secStruct[group]) : SecondaryStructure::Coil;
+            r.chain = static_cast<int32_t>(out.chains.size() - 1);
+            r.firstAtom = static_cast<uint32_t>(out.x.size());
+
+            for (size_t a = 0; a < type.atomNames.size(); ++a, ++atom) {
+                if (atom >= atomTotal) {
+                    error_ = "atom index out of range";
+                    return false;
+                }
+                char alt = atom < altLocs.size() ? altLocs[atom] : ' ';
+                if (alt != ' ' && alt != 'A' && alt != '1') continue;
+                out.x.push_back(coords[0][atom]);
+                out.y.push_back(coords[1][atom]);
+                out.z.push_back(coords[2][atom]);
+                out.element.push_back(type.elements[a]);
+                out.name.push_back(type.atomNames[a]);
+                out.flags.push_back(type.hetero ? AtomHetero : 0);
+                out.residueIndex.push_back(static_cast<int32_t>(out.residues.size()));
+                out.chainIndex.push_back(r.chain);
+                r.atomCount++;
+            }
+            if (r.atomCount > 0) {
+                out.residues.push_back(r);
+                out.chains.back().residueCount++;
+            }
+        }
+        if (out.chains.back().residueCount == 0) out.chains.pop_back();
+    }
+
+    if (out.atomCount() == 0) {
+        error_ = "no atoms in first model";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,524 @@
+﻿// MolecularSurface v 1.0
+#include "MolecularSurface.h"
+#include "Element.h"
+#include "Parallel.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+    const float kInfinity = std::numeric_limits<float>::infinity();
+    // y、z 方向距离变换一次处理的相邻列数（按缓存行读取）
+    const int kColumnBatch = 16;
+    // 原子分桶的小块边长（格点数）
+    const int kTile = 8;
+    // 高斯球的截断半径（以 s * r 为单位）：截断处的密度为 exp(-6.9) ≈ 1e-3
+    const float kGaussianCutoff = 2.63f;
+
+    // 向下、向上取整到 int（不依赖 SSE4.1 的 roundss，避免每行两次 libm 调用）
+    inline int floorInt(float v) {
+        int t = int(v);
+        return float(t) > v ? t - 1 : t;
+    }
+    inline int ceilInt(float v) {
+        int t = int(v);
+        return float(t) < v ? t + 1 : t;
+    }
+
+    // 一维平方距离变换（Felzenszwalb-Huttenlocher）：d[q] = min_p((q - p)^2 + f[p])，
+    // f 为无穷大的点不是种子，整行没有种子时输出全为无穷大
+    void distance1d(const float* f, float* d, int n, int* v, double* bound) {
+        int k = -1;
+        for (int q = 0; q < n; ++q) {
+            if (f[q] == kInfinity) continue;
+            double s = 0.0;
+            while (k >= 0) {
+                int p = v[k];
+                s = ((double(f[q]) + double(q) * q) - (double(f[p]) + double(p) * p)) / (2.0 * (q - p));
+                if (s > bound[k]) break;
+                --k;
+            }
+            ++k;
+            v[k] = q;
+            bound[k] = k == 0 ? -1e300 : s;
+            bound[k + 1] = 1e300;
+        }
+        if (k < 0) {
+            std::fill(d, d + n, kInfinity);
+            return;
+        }
+        int j = 0;
+        for (int q = 0; q < n; ++q) {
+            while (bound[j + 1] < double(q)) ++j;
+            float t = float(q - v[j]);
+            d[q] = t * t + f[v[j]];
+        }
+    }
+
+    // 沿步长为 stride 的列做距离变换，一次处理 columns 个相邻列（首列地址 base）
+    void distanceColumns(float* base, size_t stride, int n, int columns, std::vector<float>& buffer,
+        std::vector<float>& out, std::vector<int>& v, std::vector<double>& bound) {
+        buffer.resize(size_t(n) * kColumnBatch);
+        for (int k = 0; k < n; ++k) {
+            const float* src = base + size_t(k) * stride;
+            for (int c = 0; c < columns; ++c) buffer[size_t(c) * n + k] = src[c];
+        }
+        for (int c = 0; c < columns; ++c) {
+            distance1d(&buffer[size_t(c) * n], out.data(), n, v.data(), bound.data());
+            std::copy(out.begin(), out.begin() + n, buffer.begin() + size_t(c) * n);
+        }
+        for (int k = 0; k < n; ++k) {
+            float* dst = base + size_t(k) * stride;
+            for (int c = 0; c < columns; ++c) dst[c] = buffer[size_t(c) * n + k];
+        }
+    }
+
+    // 2^x，x <= 0：整数部分直接拼指数位，小数部分用 [0, 1) 上的四次多项式（相对误差约 3e-6）
+    const float kExp2Poly[5] = { 1.0000026f, 6.9300383e-1f, 2.4144275e-1f, 5.2011464e-2f, 1.3534167e-2f };
+
+    inline float fastExp2(float v) {
+        v = std::max(v, -126.0f);
+        int n = floorInt(v);
+        float f = v - float(n);
+        float p = kExp2Poly[0] + f * (kExp2Poly[1] + f * (kExp2Poly[2] + f * (kExp2Poly[3] + f * kExp2Poly[4])));
+        uint32_t bits = uint32_t(n + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+#if THC_SSE2
+    inline __m128 fastExp2(__m128 v) {
+        v = _mm_max_ps(v, _mm_set1_ps(-126.0f));
+        __m128i n = _mm_cvttps_epi32(v);
+        __m128 fn = _mm_cvtepi32_ps(n);
+        // 截断是向零取整，负的非整数再减 1（比较结果为 -1）
+        __m128 adjust = _mm_cmpgt_ps(fn, v);
+        n = _mm_add_epi32(n, _mm_castps_si128(adjust));
+        fn = _mm_sub_ps(fn, _mm_and_ps(adjust, _mm_set1_ps(1.0f)));
+        __m128 f = _mm_sub_ps(v, fn);
+        __m128 p = _mm_set1_ps(kExp2Poly[4]);
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2Poly[3]));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2Poly[2]));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2Poly[1]));
+        p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2Poly[0]));
+        __m128i bits = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+        return _mm_mul_ps(p, _mm_castsi128_ps(bits));
+    }
+#endif
+
+    // 高斯球在三个方向上可分离：2^(-d^2 * k) = 2^(-dx^2 * k) * 2^(-dy^2 * k) * 2^(-dz^2 * k)。
+    // 填一个方向的表：第 t 个格点 d2[t] = (start + t * h - c)^2，e[t] = 2^(-d2[t] * k)；
+    // count 补到 4 的倍数，补位的 d2 为无穷大、e 为 0，在截断判断中总被排除
+    void gaussianTable(float start, float h, float c, float k, int count, float* e, float* d2) {
+        const int padded = (count + 3) & ~3;
+        int t = 0;
+#if THC_SSE2
+        const __m128 step = _mm_set1_ps(4.0f * h);
+        const __m128 vk = _mm_set1_ps(-k);
+        __m128 d = _mm_setr_ps(start - c, start + h - c, start + 2.0f * h - c, start + 3.0f * h - c);
+        for (; t + 3 < count; t += 4) {
+            __m128 dd = _mm_mul_ps(d, d);
+            _mm_storeu_ps(d2 + t, dd);
+            _mm_storeu_ps(e + t, fastExp2(_mm_mul_ps(dd, vk)));
+            d = _mm_add_ps(d, step);
+        }
+#endif
+        for (; t < count; ++t) {
+            float d1 = start + float(t) * h - c;
+            d2[t] = d1 * d1;
+            e[t] = fastExp2(-d2[t] * k);
+        }
+        for (; t < padded; ++t) {
+            d2[t] = kInfinity;
+            e[t] = 0.0f;
+        }
+    }
+
+    // 一行格点 row[0 .. count) 减去 w * e[t]，只算 d2[t] <= limit 的格点（球形截断）。
+    // SSE 按 4 个一组比较后掩码，不逐格分支；available 为 row 之后还属于本行的格点数，
+    // 够 4 个时最后一组连同补位一起算（补位减 0），不走标量尾部
+    void gaussianRun(float* row, int count, int available, const float* e, const float* d2, float w, float limit) {
+        int t = 0;
+#if THC_SSE2
+        const int vectorEnd = std::min((count + 3) & ~3, available);
+        const __m128 vw = _mm_set1_ps(w);
+        const __m128 vlimit = _mm_set1_ps(limit);
+        for (; t + 4 <= vectorEnd; t += 4) {
+            __m128 inside = _mm_cmple_ps(_mm_loadu_ps(d2 + t), vlimit);
+            __m128 g = _mm_and_ps(inside, _mm_mul_ps(vw, _mm_loadu_ps(e + t)));
+            _mm_storeu_ps(row + t, _mm_sub_ps(_mm_loadu_ps(row + t), g));
+        }
+#endif
+        for (; t < count; ++t) {
+            if (d2[t] <= limit) row[t] -= w * e[t];
+        }
+    }
+
+    // 一行格点 row[i0 .. i1] 的 SAS 距离：min(row[i], ((x0 + i * h - cx)^2 + dyz2 - R^2) / 2R)。
+    // 与 |p - c| - R 符号、零点相同，表面附近一阶相等（偏差为 (|p - c| - R)^2 / 2R），不用开方
+    void splatRow(float* row, int i0, int i1, float x0, float h, float cx, float dyz2, float reach) {
+        const float inv2r = 0.5f / reach;
+        const float offset = dyz2 - reach * reach;
+        int i = i0;
+#if THC_SSE2
+        const __m128 step = _mm_set1_ps(4.0f * h);
+        const __m128 voffset = _mm_set1_ps(offset);
+        const __m128 vinv2r = _mm_set1_ps(inv2r);
+        __m128 dx = _mm_setr_ps(x0 + float(i) * h - cx, x0 + float(i + 1) * h - cx,
+            x0 + float(i + 2) * h - cx, x0 + float(i + 3) * h - cx);
+        for (; i + 3 <= i1; i += 4) {
+            __m128 d = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dx, dx), voffset), vinv2r);
+            _mm_storeu_ps(row + i, _mm_min_ps(_mm_loadu_ps(row + i), d));
+            dx = _mm_add_ps(dx, step);
+        }
+#endif
+        for (; i <= i1; ++i) {
+            float dx1 = x0 + float(i) * h - cx;
+            row[i] = std::min(row[i], (dx1 * dx1 + offset) * inv2r);
+        }
+    }
+}
+
+void MolecularSurface::setupGrid(const float* x, const float* y, const float* z, size_t n, float reach) {
+    float lo[3] = { x[0], y[0], z[0] };
+    float hi[3] = { x[0], y[0], z[0] };
+    for (size_t i = 1; i < n; ++i) {
+        lo[0] = std::min(lo[0], x[i]);
+        lo[1] = std::min(lo[1], y[i]);
+        lo[2] = std::min(lo[2], z[i]);
+        hi[0] = std::max(hi[0], x[i]);
+        hi[1] = std::max(hi[1], y[i]);
+        hi[2] = std::max(hi[2], z[i]);
+    }
+    // 四周留出 reach 加三个格距，边界格点一定在表面之外
+    float h = std::max(spacing_, 0.05f);
+    int dims[3];
+    for (;;) {
+        float pad = reach + 3.0f * h;
+        size_t total = 1;
+        for (int k = 0; k < 3; ++k) {
+            dims[k] = int(std::ceil((hi[k] - lo[k] + 2.0f * pad) / h)) + 1;
+            field_.origin[k] = lo[k] - pad;
+            total *= size_t(dims[k]);
+        }
+        if (total <= maxGridPoints_) break;
+        h *= std::max(1.01f, float(std::cbrt(double(total) / double(maxGridPoints_))));
+    }
+    field_.spacing = h;
+    field_.resize(dims[0], dims[1], dims[2]);
+}
+
+void MolecularSurface::bucketAtoms(const float* x, const float* y, const float* z, size_t n) {
+    // 原子按球心所在的 kTile^3 格点小块分桶（小块按 z、y、x 顺序）：
+    // 每个层块只看影响范围与它重叠的原子，相继处理的原子写同一片格点，能留在 L2 中
+    const float h = field_.spacing;
+    const float* origin = field_.origin;
+    const int nx = field_.nx;
+    const int ny = field_.ny;
+    const int nz = field_.nz;
+    tiles_[0] = (nx + kTile - 1) / kTile;
+    tiles_[1] = (ny + kTile - 1) / kTile;
+    tiles_[2] = (nz + kTile - 1) / kTile;
+    const size_t tileCount = size_t(tiles_[0]) * tiles_[1] * tiles_[2];
+    tileStart_.assign(tileCount + 1, 0);
+    auto tileOf = [&](size_t a) {
+        int i = std::min(nx - 1, std::max(0, int((x[a] - origin[0]) / h))) / kTile;
+        int j = std::min(ny - 1, std::max(0, int((y[a] - origin[1]) / h))) / kTile;
+        int k = std::min(nz - 1, std::max(0, int((z[a] - origin[2]) / h))) / kTile;
+        return (size_t(k) * tiles_[1] + size_t(j)) * tiles_[0] + size_t(i);
+    };
+    for (size_t a = 0; a < n; ++a) tileStart_[tileOf(a) + 1]++;
+    for (size_t t = 0; t < tileCount; ++t) tileStart_[t + 1] += tileStart_[t];
+    tileAtoms_.resize(n);
+    std::vector<uint32_t> fill(tileStart_.begin(), tileStart_.end() - 1);
+    for (size_t a = 0; a < n; ++a) tileAtoms_[fill[tileOf(a)]++] = uint32_t(a);
+}
+
+template <class Outer, class RowFn>
+void MolecularSurface::splatAtoms(const float* x, const float* y, const float* z, float maxOuter,
+    Outer outerOf, RowFn rowFn) {
+    const float h = field_.spacing;
+    const int ny = field_.ny;
+    const int nx = field_.nx;
+    const int nz = field_.nz;
+    const float* origin = field_.origin;
+    const size_t tileLayer = size_t(tiles_[0]) * tiles_[1];
+    const int reachPlanes = int(std::ceil(maxOuter / h)) + 1;
+    // 每个任务只写自己的 z 层，不需要原子操作
+    size_t slabCount = std::min<size_t>(size_t(nz), size_t(workerCount()) * 8);
+    ThreadPool::instance().run(slabCount, [&](size_t s) {
+        int k0 = int(size_t(nz) * s / slabCount);
+        int k1 = int(size_t(nz) * (s + 1) / slabCount);
+        int first = std::max(0, k0 - reachPlanes) / kTile;
+        int last = std::min(tiles_[2], (k1 + reachPlanes + kTile - 1) / kTile);
+        for (uint32_t a = tileStart_[size_t(first) * tileLayer]; a < tileStart_[size_t(last) * tileLayer]; ++a) {
+            uint32_t atom = tileAtoms_[a];
+            float cx = x[atom];
+            float cy = y[atom];
+            float cz = z[atom];
+            float outer = outerOf(atom);
+            float outer2 = outer * outer;
+            int kb = std::max(k0, ceilInt((cz - outer - origin[2]) / h));
+            int ke = std::min(k1 - 1, floorInt((cz + outer - origin[2]) / h));
+            for (int k = kb; k <= ke; ++k) {
+                float dz = origin[2] + float(k) * h - cz;
+                float remZ = outer2 - dz * dz;
+                if (remZ < 0.0f) continue;
+                float ry = std::sqrt(remZ);
+                int jb = std::max(0, ceilInt((cy - ry - origin[1]) / h));
+                int je = std::min(ny - 1, floorInt((cy + ry - origin[1]) / h));
+                for (int j = jb; j <= je; ++j) {
+                    float dy = origin[1] + float(j) * h - cy;
+                    float remY = remZ - dy * dy;
+                    if (remY < 0.0f) continue;
+                    float rx = std::sqrt(remY);
+                    int ib = std::max(0, ceilInt((cx - rx - origin[0]) / h));
+                    int ie = std::min(nx - 1, floorInt((cx + rx - origin[0]) / h));
+                    if (ib > ie) continue;
+                    rowFn(field_.values.data() + field_.index(0, j, k), ib, ie, dy * dy + dz * dz, atom);
+                }
+            }
+        }
+    });
+}
+
+void MolecularSurface::splatGaussians(const float* x, const float* y, const float* z, float maxOuter) {
+    const float h = field_.spacing;
+    const int ny = field_.ny;
+    const int nx = field_.nx;
+    const int nz = field_.nz;
+    const float* origin = field_.origin;
+    const float scale = gaussianScale_;
+    const float log2e = 1.44269504f;
+    const size_t tileLayer = size_t(tiles_[0]) * tiles_[1];
+    const int reachPlanes = int(std::ceil(maxOuter / h)) + 1;
+    // 每个方向的表最多 2 * reachPlanes + 1 个格点，再补到 4 的倍数
+    const size_t tableSize = size_t(2 * reachPlanes + 8);
+    size_t slabCount = std::min<size_t>(size_t(nz), size_t(workerCount()) * 8);
+    ThreadPool::instance().run(slabCount, [&](size_t s) {
+        int k0 = int(size_t(nz) * s / slabCount);
+        int k1 = int(size_t(nz) * (s + 1) / slabCount);
+        int first = std::max(0, k0 - reachPlanes) / kTile;
+        int last = std::min(tiles_[2], (k1 + reachPlanes + kTile - 1) / kTile);
+        std::vector<float> tables(6 * tableSize);
+        float* ex = &tables[0];
+        float* dx2 = &tables[tableSize];
+        float* ey = &tables[2 * tableSize];
+        float* dy2 = &tables[3 * tableSize];
+        float* ez = &tables[4 * tableSize];
+        float* dz2 = &tables[5 * tableSize];
+        for (uint32_t a = tileStart_[size_t(first) * tileLayer]; a < tileStart_[size_t(last) * tileLayer]; ++a) {
+            uint32_t atom = tileAtoms_[a];
+            float cx = x[atom];
+            float cy = y[atom];
+            float cz = z[atom];
+            float sr = scale * radius_[atom];
+            float k = log2e / (sr * sr);
+            float outer = kGaussianCutoff * sr;
+            float outer2 = outer * outer;
+            int kb = std::max(k0, ceilInt((cz - outer - origin[2]) / h));
+            int ke = std::min(k1 - 1, floorInt((cz + outer - origin[2]) / h));
+            int jb = std::max(0, ceilInt((cy - outer - origin[1]) / h));
+            int je = std::min(ny - 1, floorInt((cy + outer - origin[1]) / h));
+            int ib = std::max(0, ceilInt((cx - outer - origin[0]) / h));
+            int ie = std::min(nx - 1, floorInt((cx + outer - origin[0]) / h));
+            if (kb > ke || jb > je || ib > ie) continue;
+            // 截断球的外接盒上三张一维表，每格只剩乘法、比较和减法
+            gaussianTable(origin[0] + float(ib) * h, h, cx, k, ie - ib + 1, ex, dx2);
+            gaussianTable(origin[1] + float(jb) * h, h, cy, k, je - jb + 1, ey, dy2);
+            gaussianTable(origin[2] + float(kb) * h, h, cz, k, ke - kb + 1, ez, dz2);
+            for (int kk = kb; kk <= ke; ++kk) {
+                float remZ = outer2 - dz2[kk - kb];
+                if (remZ < 0.0f) continue;
+                for (int j = jb; j <= je; ++j) {
+                    float remY = remZ - dy2[j - jb];
+                    if (remY < 0.0f) continue;
+                    gaussianRun(field_.values.data() + field_.index(ib, j, kk), ie - ib + 1, nx - ib, ex, dx2,
+                        ez[kk - kb] * ey[j - jb], remY);
+                }
+            }
+        }
+    });
+}
+
+void MolecularSurface::computeAccessibleField(const float* x, const float* y, const float* z, size_t n, float band) {
+    const float h = field_.spacing;
+    const float x0 = field_.origin[0];
+    const float probe = probeRadius_;
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < n; ++i) maxRadius = std::max(maxRadius, radius_[i]);
+
+    // 场的初值为 band：只有离 SAS 表面 band 以内的格点需要精确值
+    parallelFor(0, field_.values.size(), [&](size_t b0, size_t b1) {
+        std::fill(field_.values.begin() + b0, field_.values.begin() + b1, band);
+    }, 1 << 16);
+    bucketAtoms(x, y, z, n);
+    splatAtoms(x, y, z, maxRadius + probe + band,
+        [&](uint32_t atom) {
+            return radius_[atom] + probe + band;
+        },
+        [&](float* row, int ib, int ie, float dyz2, uint32_t atom) {
+            splatRow(row, ib, ie, x0, h, x[atom], dyz2, radius_[atom] + probe);
+        });
+}
+
+void MolecularSurface::computeGaussianField(const float* x, const float* y, const float* z, size_t n) {
+    const float scale = gaussianScale_;
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < n; ++i) maxRadius = std::max(maxRadius, radius_[i]);
+
+    // 场 = iso - sum(exp(-d^2 / (s * r)^2))，内部（密度高于 iso）为负
+    parallelFor(0, field_.values.size(), [&](size_t b0, size_t b1) {
+        std::fill(field_.values.begin() + b0, field_.values.begin() + b1, densityIso_);
+    }, 1 << 16);
+    bucketAtoms(x, y, z, n);
+    splatGaussians(x, y, z, kGaussianCutoff * scale * maxRadius);
+}
+
+void MolecularSurface::computeExcludedField() {
+    const int nx = field_.nx;
+    const int ny = field_.ny;
+    const int nz = field_.nz;
+    float* values = field_.values.data();
+    const size_t planeSize = size_t(nx) * ny;
+
+    // SAS 外部为种子（0），内部为无穷大
+    parallelFor(0, field_.values.size(), [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) values[i] = values[i] < 0.0f ? kInfinity : 0.0f;
+    }, 1 << 16);
+
+    int longest = std::max(nx, std::max(ny, nz));
+    auto scratch = [&](std::vector<float>& buffer, std::vector<float>& out, std::vector<int>& v,
+        std::vector<double>& bound) {
+        buffer.resize(size_t(longest) * kColumnBatch);
+        out.resize(size_t(longest));
+        v.resize(size_t(longest));
+        bound.resize(size_t(longest) + 1);
+    };
+
+    // x 方向：行连续
+    parallelFor(0, size_t(ny) * nz, [&](size_t b0, size_t b1) {
+        std::vector<float> buffer, out;
+        std::vector<int> v;
+        std::vector<double> bound;
+        scratch(buffer, out, v, bound);
+        for (size_t r = b0; r < b1; ++r) {
+            float* row = values + r * nx;
+            std::copy(row, row + nx, buffer.begin());
+            distance1d(buffer.data(), row, nx, v.data(), bound.data());
+        }
+    }, 64);
+    // y 方向：每个 z 平面内按列批处理
+    parallelFor(0, size_t(nz), [&](size_t b0, size_t b1) {
+        std::vector<float> buffer, out;
+        std::vector<int> v;
+        std::vector<double> bound;
+        scratch(buffer, out, v, bound);
+        for (size_t k = b0; k < b1; ++k) {
+            for (int i = 0; i < nx; i += kColumnBatch) {
+                distanceColumns(values + k * planeSize + i, size_t(nx), ny, std::min(kColumnBatch, nx - i),
+                    buffer, out, v, bound);
+            }
+        }
+    }, 1);
+    // z 方向：每个 y 行内按列批处理
+    parallelFor(0, size_t(ny), [&](size_t b0, size_t b1) {
+        std::vector<float> buffer, out;
+        std::vector<int> v;
+        std::vector<double> bound;
+        scratch(buffer, out, v, bound);
+        for (size_t j = b0; j < b1; ++j) {
+            for (int i = 0; i < nx; i += kColumnBatch) {
+                distanceColumns(values + j * nx + i, planeSize, nz, std::min(kColumnBatch, nx - i),
+                    buffer, out, v, bound);
+            }
+        }
+    }, 1);
+
+    // 场 = probe - D，外部（D = 0）为 probe
+    const float h = field_.spacing;
+    const float probe = probeRadius_;
+    parallelFor(0, field_.values.size(), [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) values[i] = probe - h * std::sqrt(values[i]);
+    }, 1 << 16);
+}
+
+void MolecularSurface::assignAtoms(const float* x, const float* y, const float* z, size_t n, float search, Mesh& mesh) {
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < n; ++i) maxRadius = std::max(maxRadius, radius_[i]);
+    // 先在较小的半径 near 内找：找到的最小值 best 满足 best + maxRadius <= near 时，
+    // near 以外的原子不可能更近，否则再按完整半径 search 找一次
+    float near = std::min(search, 2.0f * maxRadius + field_.spacing);
+    atomGrid_.build(x, y, z, n, near);
+    size_t vertexCount = mesh.vertexCount();
+    parallelFor(0, vertexCount, [&](size_t b0, size_t b1) {
+        for (size_t v = b0; v < b1; ++v) {
+            const float* p = &mesh.positions[3 * v];
+            float best = kInfinity;
+            uint32_t bestAtom = 0;
+            auto nearest = [&](uint32_t atom, float d2) {
+                float d = std::sqrt(d2) - radius_[atom];
+                if (d < best) {
+                    best = d;
+                    bestAtom = atom;
+                }
+            };
+            atomGrid_.forEachWithin(p[0], p[1], p[2], near, nearest);
+            if (best + maxRadius > near && near < search) {
+                atomGrid_.forEachWithin(p[0], p[1], p[2], search, nearest);
+            }
+            mesh.atomIds[v] = bestAtom;
+        }
+    }, 1024);
+}
+
+void MolecularSurface::build(const float* x, const float* y, const float* z, const float* radius, size_t n,
+    SurfaceKind kind, Mesh& out) {
+    auto t0 = std::chrono::steady_clock::now();
+    out.clear();
+    fieldMs_ = 0.0;
+    extractMs_ = 0.0;
+    if (n == 0) {
+        field_.resize(0, 0, 0);
+        buildMs_ = 0.0;
+        return;
+    }
+    if (radius != radius_.data()) radius_.assign(radius, radius + n);
+    float maxRadius = *std::max_element(radius_.begin(), radius_.end());
+
+    // 表面上的点离最近的原子表面不超过 reach（再加上网格误差）
+    float reach = kind == SurfaceKind::GaussianDensity ? kGaussianCutoff * gaussianScale_ * maxRadius :
+        maxRadius + probeRadius_;
+    setupGrid(x, y, z, n, reach);
+    // SAS 的等值面要用到跨越表面的格子角点上的精确值；SES 只用到内外之分
+    if (kind == SurfaceKind::SolventExcluded) {
+        computeAccessibleField(x, y, z, n, 0.0f);
+        computeExcludedField();
+    }
+    else if (kind == SurfaceKind::GaussianDensity) {
+        computeGaussianField(x, y, z, n);
+    }
+    else {
+        computeAccessibleField(x, y, z, n, 2.0f * field_.spacing);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    contour_.setGrid(field_);
+    contour_.extract(0.0f, out);
+    assignAtoms(x, y, z, n, reach + 2.0f * field_.spacing, out);
+    auto t2 = std::chrono::steady_clock::now();
+    fieldMs_ = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    extractMs_ = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    buildMs_ = std::chrono::duration<double, std::milli>(t2 - t0).count();
+}
+
+void MolecularSurface::build(const AtomTable& atoms, SurfaceKind kind, Mesh& out) {
+    size_t n = atoms.atomCount();
+    radius_.resize(n);
+    for (size_t i = 0; i < n; ++i) radius_[i] = vdwRadius(atoms.element[i]);
+    build(atoms.x.data(), atoms.y.data(), atoms.z.data(), radius_.data(), n, kind, out);
+}
@@ -0,0 +1,214 @@
+﻿// MsgPack v 1.0
+#include "MsgPack.h"
+#include <cstring>
+
+namespace {
+    const unsigned kMaxDepth = 64;
+
+    inline uint64_t readBE(const uint8_t* p, unsigned n) {
+        uint64_t v = 0;
+        for (unsigned i = 0; i < n; ++i) v = (v << 8) | p[i];
+        return v;
+    }
+}
+
+bool MsgPackDocument::parse(const uint8_t* data, size_t size) {
+    nodes_.clear();
+    cur_ = data;
+    end_ = data + size;
+    if (!parseValue(0)) {
+        nodes_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool MsgPackDocument::parseValue(unsigned depth) {
+    if (cur_ >= end_ || depth > kMaxDepth) return false;
+
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+    uint8_t tag = *cur_++;
+    size_t available = size_t(end_ - cur_);
+
+    auto need = [&](size_t n) { return size_t(end_ - cur_) >= n; };
+    auto take = [&](unsigned n) {
+        uint64_t v = readBE(cur_, n);
+        cur_ += n;
+        return v;
+    };
+
+    Type type = Type::Nil;
+    uint64_t length = 0;
+    Node& n0 = nodes_[index];
+
+    if (tag <= 0x7F) {
+        n0.type = Type::UInt;
+        n0.u = tag;
+    }
+    else if (tag >= 0xE0) {
+        n0.type = Type::Int;
+        n0.i = int8_t(tag);
+    }
+    else if ((tag & 0xF0) == 0x80) {
+        type = Type::Map;
+        length = tag & 0x0F;
+    }
+    else if ((tag & 0xF0) == 0x90) {
+        type = Type::Array;
+        length = tag & 0x0F;
+    }
+    else if ((tag & 0xE0) == 0xA0) {
+        type = Type::String;
+        length = tag & 0x1F;
+    }
+    else {
+        switch (tag) {
+        case 0xC0: n0.type = Type::Nil; break;
+        case 0xC2: n0.type = Type::Bool; n0.u = 0; break;
+        case 0xC3: n0.type = Type::Bool; n0.u = 1; break;
+        case 0xC4: case 0xC5: case 0xC6: {
+            unsigned w = 1u << (tag - 0xC4);
+            if (available < w) return false;
+            type = Type::Binary;
+            length = take(w);
+            break;
+        }
+        case 0xC7: case 0xC8: case 0xC9: {
+            unsigned w = 1u << (tag - 0xC7);
+            if (available < w + 1) return false;
+            type = Type::Ext;
+            length = take(w);
+            ++cur_;     // 扩展类型码
+            break;
+        }
+        case 0xCA: {
+            if (available < 4) return false;
+            uint32_t bits = uint32_t(take(4));
+            float f;
+            std::memcpy(&f, &bits, 4);
+            n0.type = Type::Float;
+            n0.f = f;
+            break;
+        }
+        case 0xCB: {
+            if (available < 8) return false;
+            uint64_t bits = take(8);
+            double f;
+            std::memcpy(&f, &bits, 8);
+            n0.type = Type::Float;
+            n0.f = f;
+            break;
+        }
+        case 0xCC: case 0xCD: case 0xCE: case 0xCF: {
+            unsigned w = 1u << (tag - 0xCC);
+            if (available < w) return false;
+            n0.type = Type::UInt;
+            n0.u = take(w);
+            break;
+        }
+        case 0xD0: case 0xD1: case 0xD2: case 0xD3: {
+            unsigned w = 1u << (tag - 0xD0);
+            if (available < w) return false;
+            uint64_t v = take(w);
+            // 符号扩展
+            unsigned shift = 64 - 8 * w;
+            n0.type = Type::Int;
+            n0.i = int64_t(v << shift) >> shift;
+            break;
+        }
+        case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+            type = Type::Ext;
+            length = 1u << (tag - 0xD4);
+            if (available < 1) return false;
+            ++cur_;
+            break;
+        case 0xD9: case 0xDA: case 0xDB: {
+            unsigned w = 1u << (tag - 0xD9);
+            if (available < w) return false;
+            type = Type::String;
+            length = take(w);
+            break;
+        }
+        case 0xDC: case 0xDD: {
+            unsigned w = tag == 0xDC ? 2 : 4;
+            if (available < w) return false;
+            type = Type::Array;
+            length = take(w);
+            break;
+        }
+        case 0xDE: case 0xDF: {
+            unsigned w = tag == 0xDE ? 2 : 4;
+            if (available < w) return false;
+            type = Type::Map;
+            length = take(w);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    if (type == Type::String || type == Type::Binary || type == Type::Ext) {
+        if (!need(length)) return false;
+        Node& n = nodes_[index];
+        n.type = type;
+        n.count = static_cast<uint32_t>(length);
+        n.data = cur_;
+        cur_ += length;
+    }
+    else if (type == Type::Array || type == Type::Map) {
+        nodes_[index].type = type;
+        nodes_[index].count = static_cast<uint32_t>(length);
+        uint64_t children = type == Type::Map ? length * 2 : length;
+        // 每个子节点至少占 1 字节，提前拒绝伪造的长度
+        if (children > uint64_t(end_ - cur_)) return false;
+        for (uint64_t c = 0; c < children; ++c) {
+            if (!parseValue(depth + 1)) return false;
+        }
+    }
+
+    nodes_[index].next = static_cast<uint32_t>(nodes_.size());
+    return true;
+}
+
+int64_t MsgPackDocument::Ref::asInt(int64_t fallback) const {
+    switch (type()) {
+    case Type::Int: return node().i;
+    case Type::UInt: return int64_t(node().u);
+    case Type::Float: return int64_t(node().f);
+    default: return fallback;
+    }
+}
+
+double MsgPackDocument::Ref::asDouble(double fallback) const {
+    switch (type()) {
+    case Type::Int: return double(node().i);
+    case Type::UInt: return double(node().u);
+    case Type::Float: return node().f;
+    default: return fallback;
+    }
+}
+
+std::string_view MsgPackDocument::Ref::asString() const {
+    if (type() != Type::String) return std::string_view();
+    return std::string_view(reinterpret_cast<const char*>(node().data), node().count);
+}
+
+MsgPackDocument::Ref MsgPackDocument::Ref::operator[](size_t i) const {
+    if (type() != Type::Array || i >= node().count) return Ref();
+    Ref r = first();
+    for (size_t k = 0; k < i; ++k) r = r.nextSibling();
+    return r;
+}
+
+MsgPackDocument::Ref MsgPackDocument::Ref::operator[](std::string_view key) const {
+    if (type() != Type::Map) return Ref();
+    Ref k = first();
+    for (size_t i = 0; i < node().count; ++i) {
+        Ref v = k.nextSibling();
+        if (k.asString() == key) return v;
+        k = v.nextSibling();
+    }
+    return Ref();
+}
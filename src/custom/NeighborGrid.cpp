@@ -0,0 +1,264 @@
+﻿// NeighborGrid v 1.0
+#include "NeighborGrid.h"
+#include "Parallel.h"
+#include <atomic>
+#include <utility>
+
+namespace {
+    struct Bounds {
+        float lo[3] = { 1e30f, 1e30f, 1e30f };
+        float hi[3] = { -1e30f, -1e30f, -1e30f };
+    };
+
+    // 把 10 位整数的每一位隔两位展开，用于拼 Morton 码
+    uint32_t spreadBits(uint32_t v) {
+        v &= 0x3ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    // 按八叉树的 Morton 顺序列出 [0, dims) 内的格子，剪掉完全在范围外的子树。
+    // 完全在范围内的子树位置连续，直接用局部 Morton 码填写，不再往下递归
+    struct MortonWalk {
+        const int* dims;
+        uint32_t* cells;
+        uint32_t next = 0;
+
+        void visit(int x0, int y0, int z0, int size) {
+            if (x0 >= dims[0] || y0 >= dims[1] || z0 >= dims[2]) return;
+            if (x0 + size <= dims[0] && y0 + size <= dims[1] && z0 + size <= dims[2] && size <= 1024) {
+                for (int z = 0; z < size; ++z) {
+                    uint32_t mz = spreadBits(uint32_t(z)) << 2;
+                    for (int y = 0; y < size; ++y) {
+                        uint32_t myz = mz | (spreadBits(uint32_t(y)) << 1);
+                        uint32_t linear = uint32_t((size_t(z0 + z) * dims[1] + y0 + y) * dims[0] + x0);
+                        for (int x = 0; x < size; ++x) {
+                            cells[next + (myz | spreadBits(uint32_t(x)))] = linear + uint32_t(x);
+                        }
+                    }
+                }
+                next += uint32_t(size) * uint32_t(size) * uint32_t(size);
+                return;
+            }
+            int h = size / 2;
+            for (int child = 0; child < 8; ++child) {
+                visit(x0 + (child & 1) * h, y0 + ((child >> 1) & 1) * h, z0 + ((child >> 2) & 1) * h, h);
+            }
+        }
+    };
+}
+
+bool NeighborGrid::setupGeometry(const float* x, const float* y, const float* z, size_t n) {
+    const float* axes[3] = { x, y, z };
+    Bounds box;
+    bool open = box_[0] <= 0.0f || box_[1] <= 0.0f || box_[2] <= 0.0f;
+    if (open && n > 0) {
+        unsigned blocks = workerCount() * 4;
+        std::vector<Bounds> partial(blocks);
+        size_t step = (n + blocks - 1) / blocks;
+        ThreadPool::instance().run(blocks, [&](size_t b) {
+            size_t b0 = b * step;
+            size_t b1 = std::min(n, b0 + step);
+            Bounds& bb = partial[b];
+            for (int k = 0; k < 3; ++k) {
+                if (box_[k] > 0.0f) continue;
+                const float* v = axes[k];
+                for (size_t i = b0; i < b1; ++i) {
+                    bb.lo[k] = std::min(bb.lo[k], v[i]);
+                    bb.hi[k] = std::max(bb.hi[k], v[i]);
+                }
+            }
+        });
+        for (unsigned b = 0; b < blocks; ++b) {
+            for (int k = 0; k < 3; ++k) {
+                box.lo[k] = std::min(box.lo[k], partial[b].lo[k]);
+                box.hi[k] = std::max(box.hi[k], partial[b].hi[k]);
+            }
+        }
+    }
+
+    // 非周期方向四周各留半个格子的余量，轨迹中原子小幅移动时 update 不必重建。
+    // 格子数远多于原子数（稀疏的大组装体）时放大格子，只影响速度，不影响结果
+    int dims[3];
+    float cell = cellSize_;
+    for (;;) {
+        size_t total = 1;
+        for (int k = 0; k < 3; ++k) {
+            if (box_[k] > 0.0f) {
+                dims[k] = std::max(1, int(box_[k] / cell));
+                origin_[k] = 0.0f;
+                cellLen_[k] = box_[k] / float(dims[k]);
+            }
+            else {
+                float lo = box.lo[k] <= box.hi[k] ? box.lo[k] : 0.0f;
+                float hi = box.lo[k] <= box.hi[k] ? box.hi[k] : 0.0f;
+                float pad = 0.5f * cell;
+                dims[k] = std::max(1, int((hi - lo + 2.0f * pad) / cell) + 1);
+                origin_[k] = lo - pad;
+                cellLen_[k] = cell;
+                boundsLo_[k] = lo - pad;
+                boundsHi_[k] = origin_[k] + float(dims[k]) * cell;
+            }
+            total *= size_t(dims[k]);
+        }
+        if (total <= 4 * n + 1024) break;
+        cell *= 1.25f;
+    }
+
+    bool changed = false;
+    halfStencil_ = true;
+    for (int k = 0; k < 3; ++k) {
+        invCellLen_[k] = 1.0f / cellLen_[k];
+        changed = changed || dims[k] != dims_[k];
+        dims_[k] = dims[k];
+        if (box_[k] > 0.0f && dims[k] < 3) halfStencil_ = false;
+    }
+    return changed || mortonCells_.size() != cellCount();
+}
+
+void NeighborGrid::computeMortonOrder() {
+    mortonCells_.resize(cellCount());
+    int largest = std::max(dims_[0], std::max(dims_[1], dims_[2]));
+    int size = 1;
+    while (size < largest) size *= 2;
+    MortonWalk walk;
+    walk.dims = dims_;
+    walk.cells = mortonCells_.data();
+    walk.visit(0, 0, 0, size);
+}
+
+bool NeighborGrid::assignCells(const float* x, const float* y, const float* z, bool& changed) {
+    size_t n = atomCount_;
+    nextCellOf_.resize(n);
+    bool compare = cellOf_.size() == n;
+    std::atomic<bool> inside{ true };
+    std::atomic<bool> moved{ !compare };
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        bool blockInside = true;
+        bool blockMoved = false;
+        for (size_t i = b0; i < b1; ++i) {
+            float p[3] = { x[i], y[i], z[i] };
+            for (int k = 0; k < 3; ++k) {
+                if (box_[k] <= 0.0f && !(p[k] >= boundsLo_[k] && p[k] <= boundsHi_[k])) blockInside = false;
+            }
+            uint32_t c = linearCell(cellIndex(p[0], 0), cellIndex(p[1], 1), cellIndex(p[2], 2));
+            nextCellOf_[i] = c;
+            if (compare && cellOf_[i] != c) blockMoved = true;
+        }
+        if (!blockInside) inside.store(false, std::memory_order_relaxed);
+        if (blockMoved) moved.store(true, std::memory_order_relaxed);
+    });
+    changed = moved.load();
+    return inside.load();
+}
+
+void NeighborGrid::sortAtoms(const float* x, const float* y, const float* z) {
+    // 计数排序：先用 end 计数，按 Morton 顺序求前缀和，再把 end 当作填充游标
+    size_t n = atomCount_;
+    cells_.assign(cellCount(), CellRange{ 0, 0 });
+    for (size_t i = 0; i < n; ++i) cells_[cellOf_[i]].end++;
+    uint32_t next = 0;
+    for (uint32_t linear : mortonCells_) {
+        CellRange& c = cells_[linear];
+        uint32_t count = c.end;
+        c.begin = next;
+        c.end = next;
+        next += count;
+    }
+    order_.resize(n);
+    for (size_t i = 0; i < n; ++i) order_[cells_[cellOf_[i]].end++] = uint32_t(i);
+    gatherCoordinates(x, y, z);
+}
+
+void NeighborGrid::gatherCoordinates(const float* x, const float* y, const float* z) {
+    size_t n = atomCount_;
+    sx_.resize(n);
+    sy_.resize(n);
+    sz_.resize(n);
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t s = b0; s < b1; ++s) {
+            uint32_t i = order_[s];
+            sx_[s] = x[i];
+            sy_[s] = y[i];
+            sz_[s] = z[i];
+        }
+    });
+}
+
+void NeighborGrid::build(const float* x, const float* y, const float* z, size_t n, float cellSize,
+    const float* periodicBox) {
+    atomCount_ = n;
+    cellSize_ = std::max(cellSize, 1e-3f);
+    for (int k = 0; k < 3; ++k) box_[k] = periodicBox && periodicBox[k] > 0.0f ? periodicBox[k] : 0.0f;
+    if (setupGeometry(x, y, z, n)) computeMortonOrder();
+    bool changed = false;
+    cellOf_.clear();
+    assignCells(x, y, z, changed);
+    cellOf_.swap(nextCellOf_);
+    sortAtoms(x, y, z);
+}
+
+bool NeighborGrid::update(const float* x, const float* y, const float* z, const float* periodicBox) {
+    float box[3] = { box_[0], box_[1], box_[2] };
+    bool boxChanged = false;
+    if (periodicBox) {
+        for (int k = 0; k < 3; ++k) {
+            float b = periodicBox[k] > 0.0f ? periodicBox[k] : 0.0f;
+            boxChanged = boxChanged || b != box_[k];
+            box[k] = b;
+        }
+    }
+    bool changed = false;
+    if (boxChanged || !assignCells(x, y, z, changed)) {
+        build(x, y, z, atomCount_, cellSize_, box);
+        return false;
+    }
+    if (changed) {
+        cellOf_.swap(nextCellOf_);
+        sortAtoms(x, y, z);
+    }
+    else {
+        // 没有原子换格子：排序不变，只刷新坐标
+        gatherCoordinates(x, y, z);
+    }
+    return true;
+}
+
+size_t NeighborGrid::nearest(float px, float py, float pz, size_t k, uint32_t* index, float* distance2) const {
+    k = std::min(k, atomCount_);
+    if (k == 0) return 0;
+
+    // 半径逐次加倍；半径内已有 k 个原子时，半径外的原子不可能更近
+    std::vector<std::pair<float, uint32_t>> heap;
+    heap.reserve(k);
+    float radius = std::min(cellLen_[0], std::min(cellLen_[1], cellLen_[2]));
+    for (;;) {
+        heap.clear();
+        size_t seen = 0;
+        forEachWithin(px, py, pz, radius, [&](uint32_t i, float d2) {
+            ++seen;
+            if (heap.size() < k) {
+                heap.emplace_back(d2, i);
+                std::push_heap(heap.begin(), heap.end());
+            }
+            else if (d2 < heap.front().first) {
+                std::pop_heap(heap.begin(), heap.end());
+                heap.back() = std::make_pair(d2, i);
+                std::push_heap(heap.begin(), heap.end());
+            }
+        });
+        // 坐标含 NaN 时永远凑不够，半径溢出后停止
+        if (heap.size() >= k || seen >= atomCount_ || !(radius < 1e30f)) break;
+        radius *= 2.0f;
+    }
+
+    std::sort_heap(heap.begin(), heap.end());
+    for (size_t i = 0; i < heap.size(); ++i) {
+        index[i] = heap[i].second;
+        distance2[i] = heap[i].first;
+    }
+    return heap.size();
+}
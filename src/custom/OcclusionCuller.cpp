@@ -0,0 +1,488 @@
+﻿// OcclusionCuller v 1.0
+#include "OcclusionCuller.h"
+#include "Parallel.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // w 小于此数的点视为在视点后面（或贴着视点），不做透视除法
+    const float kMinW = 1e-4f;
+    // 三角形屏幕面积（像素）小于此数时不光栅化
+    const float kMinArea = 1e-6f;
+
+    // 边 a -> b 的边函数 A * x + B * y + C，点在边左侧（按屏幕 y 向下）为正
+    struct Edge {
+        float a, b, c;
+
+        void setup(float ax, float ay, float bx, float by) {
+            a = -(by - ay);
+            b = bx - ax;
+            c = (by - ay) * ax - (bx - ax) * ay;
+        }
+        float at(float x, float y) const {
+            return a * x + b * y + c;
+        }
+    };
+
+    // 屏幕坐标：x 向右，y 向下（第 0 行在顶端），深度为 1 / w；点在视点后面时返回 false
+    bool toScreen(const glm::vec4& c, float width, float height, float& x, float& y, float& d) {
+        if (c.w < kMinW) return false;
+        d = 1.0f / c.w;
+        x = (c.x * d * 0.5f + 0.5f) * width;
+        y = (0.5f - c.y * d * 0.5f) * height;
+        return true;
+    }
+
+    // 多边形的有向面积（屏幕 y 向下，OpenGL 约定的正面为负）。面积或深度平面退化时返回 false；
+    // 网格判断邻接与光栅化用同一个判据，对“哪些三角形画了”的结论一致
+    bool screenArea(const float* x, const float* y, int count, float& area) {
+        area = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            int j = (i + 1) % count;
+            area += x[i] * y[j] - x[j] * y[i];
+        }
+        const int p = 0, q = count / 3, r = 2 * count / 3;
+        const float det = (x[q] - x[p]) * (y[r] - y[p]) - (x[r] - x[p]) * (y[q] - y[p]);
+        return std::fabs(area) >= kMinArea && std::fabs(det) >= kMinArea;
+    }
+
+    // 块高 8 行，最后一行块超出屏幕的行的位视为已覆盖
+    uint32_t outsideRows(int tileY, int height) {
+        const int rows = height - 8 * tileY;
+        return rows >= 8 ? 0u : ~0u << (4 * rows);
+    }
+
+    bool samePosition(const float* a, const float* b) {
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+    }
+}
+
+void OcclusionCuller::setResolution(int width, int height) {
+    width_ = (std::max(width, 4) + 3) & ~3;
+    height_ = std::max(height, 1);
+    levels_.clear();
+    levels_.push_back(Level{ width_, height_, std::vector<float>(size_t(width_) * size_t(height_), 0.0f) });
+    tilesX_ = width_ / kTileWidth;
+    tilesY_ = (height_ + kTileHeight - 1) / kTileHeight;
+    const size_t tiles = size_t(tilesX_) * size_t(tilesY_);
+    tileFar_.assign(tiles, std::numeric_limits<float>::max());
+    tileMask_.assign(tiles, 0);
+    tileBits_.assign(tiles, 0);
+    tileBoundary_.assign(tiles, 0);
+    pyramidReady_ = false;
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& projection, const glm::mat4& view) {
+    viewProjection_ = projection * view;
+    // 视图矩阵的前两行是相机的右、上方向（遮挡体所在的坐标系）
+    cameraRight_ = glm::vec3(view[0][0], view[1][0], view[2][0]);
+    cameraUp_ = glm::vec3(view[0][1], view[1][1], view[2][1]);
+    levels_.resize(1);
+    std::fill(levels_[0].depth.begin(), levels_[0].depth.end(), 0.0f);
+    std::fill(tileFar_.begin(), tileFar_.end(), std::numeric_limits<float>::max());
+    std::fill(tileMask_.begin(), tileMask_.end(), 0u);
+    pyramidReady_ = false;
+    occluderTriangles_ = 0;
+    rasterMs_ = 0.0;
+    pyramidMs_ = 0.0;
+}
+
+void OcclusionCuller::rasterizePolygon(const glm::vec4* corners, int count) {
+    float x[kMaxPolygon], y[kMaxPolygon], d[kMaxPolygon];
+    for (int i = 0; i < count; ++i) {
+        if (!toScreen(corners[i], float(width_), float(height_), x[i], y[i], d[i])) return;
+    }
+    rasterizeScreen(x, y, d, count, false);
+}
+
+bool OcclusionCuller::rasterizeScreen(const float* sx, const float* sy, const float* sd, int count, bool merge) {
+    float area;
+    if (!screenArea(sx, sy, count, area)) return false;
+    float x[kMaxPolygon], y[kMaxPolygon], d[kMaxPolygon];
+    std::copy(sx, sx + count, x);
+    std::copy(sy, sy + count, y);
+    std::copy(sd, sd + count, d);
+    if (area < 0.0f) {
+        // 两面都写：统一成同一绕向
+        std::reverse(x, x + count);
+        std::reverse(y, y + count);
+        std::reverse(d, d + count);
+    }
+
+    float minX = x[0], maxX = x[0], minY = y[0], maxY = y[0], minD = d[0];
+    for (int i = 1; i < count; ++i) {
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+        minD = std::min(minD, d[i]);
+    }
+    int x0 = std::max(0, int(std::floor(minX)));
+    int x1 = std::min(width_ - 1, int(std::ceil(maxX)));
+    int y0 = std::max(0, int(std::floor(minY)));
+    int y1 = std::min(height_ - 1, int(std::ceil(maxY)));
+    if (x0 > x1 || y0 > y1) return true;
+    occluderTriangles_ += size_t(count - 2);
+
+    // 深度平面 dA * x + dB * y + dC 取自三个分得较开的顶点（多边形是平面的）
+    const int p = 0, q = count / 3, r = 2 * count / 3;
+    const float ux = x[q] - x[p], uy = y[q] - y[p];
+    const float vx = x[r] - x[p], vy = y[r] - y[p];
+    const float det = ux * vy - vx * uy;
+    const float du = d[q] - d[p], dv = d[r] - d[p];
+    const float dA = (du * vy - dv * uy) / det;
+    const float dB = (dv * ux - du * vx) / det;
+    // 内保守：线性函数在纹素（中心 +-0.5 像素）上的最小值 = 中心值 - 0.5 * (|A| + |B|)。
+    // 边函数减去这一项后仍在中心采样，>= 0 即纹素的四个角都在边内侧，部分覆盖的纹素不写；
+    // 深度平面同样减去，写入的是纹素内最远的深度，不比多边形在该纹素内的任何一点近。
+    // 工作层的覆盖按中心采样，即收缩前的边函数 >= 0
+    const float planeC = d[p] - dA * x[p] - dB * y[p];
+    const float dC = planeC - 0.5f * (std::fabs(dA) + std::fabs(dB));
+    Edge e[kMaxPolygon];
+    float shrink[kMaxPolygon];
+    for (int i = 0; i < count; ++i) {
+        int j = (i + 1) % count;
+        e[i].setup(x[i], y[i], x[j], y[j]);
+        shrink[i] = 0.5f * (std::fabs(e[i].a) + std::fabs(e[i].b));
+        e[i].c -= shrink[i];
+    }
+
+    float* depth = levels_[0].depth.data();
+    uint32_t* bits = tileBits_.data();
+    x0 &= ~3;
+#if THC_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 ea[kMaxPolygon], ed[kMaxPolygon], center[kMaxPolygon];
+    for (int k = 0; k < count; ++k) {
+        ea[k] = _mm_set1_ps(e[k].a);
+        ed[k] = _mm_set1_ps(4.0f * e[k].a);
+        center[k] = _mm_set1_ps(-shrink[k]);
+    }
+    const __m128 da = _mm_set1_ps(dA);
+    const __m128 dd = _mm_set1_ps(4.0f * dA);
+    for (int row = y0; row <= y1; ++row) {
+        const float py = float(row) + 0.5f;
+        const __m128 px = _mm_add_ps(_mm_set1_ps(float(x0)), offsets);
+        __m128 v[kMaxPolygon];
+        for (int k = 0; k < count; ++k) v[k] = _mm_add_ps(_mm_mul_ps(ea[k], px), _mm_set1_ps(e[k].b * py + e[k].c));
+        __m128 dv = _mm_add_ps(_mm_mul_ps(da, px), _mm_set1_ps(dB * py + dC));
+        float* line = depth + size_t(row) * size_t(width_);
+        uint32_t* tileRow = bits + size_t(row / kTileHeight) * size_t(tilesX_);
+        const int shift = 4 * (row % kTileHeight);
+        for (int col = x0; col <= x1; col += 4) {
+            __m128 inside = _mm_cmpge_ps(v[0], zero);
+            for (int k = 1; k < count; ++k) inside = _mm_and_ps(inside, _mm_cmpge_ps(v[k], zero));
+            if (_mm_movemask_ps(inside) != 0) {
+                __m128 old = _mm_loadu_ps(line + col);
+                __m128 nearer = _mm_max_ps(old, dv);
+                _mm_storeu_ps(line + col, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+            if (merge) {
+                __m128 covered = _mm_cmpge_ps(v[0], center[0]);
+                for (int k = 1; k < count; ++k) covered = _mm_and_ps(covered, _mm_cmpge_ps(v[k], center[k]));
+                tileRow[col / kTileWidth] |= uint32_t(_mm_movemask_ps(covered)) << shift;
+            }
+            for (int k = 0; k < count; ++k) v[k] = _mm_add_ps(v[k], ed[k]);
+            dv = _mm_add_ps(dv, dd);
+        }
+    }
+#else
+    for (int row = y0; row <= y1; ++row) {
+        const float py = float(row) + 0.5f;
+        float* line = depth + size_t(row) * size_t(width_);
+        uint32_t* tileRow = bits + size_t(row / kTileHeight) * size_t(tilesX_);
+        const int shift = 4 * (row % kTileHeight);
+        for (int col = x0; col <= x1; ++col) {
+            const float px = float(col) + 0.5f;
+            bool inside = true, covered = true;
+            for (int k = 0; k < count; ++k) {
+                const float v = e[k].at(px, py);
+                inside = inside && v >= 0.0f;
+                covered = covered && v >= -shrink[k];
+            }
+            if (inside) line[col] = std::max(line[col], dA * px + dB * py + dC);
+            if (merge && covered) tileRow[col / kTileWidth] |= 1u << (shift + col % kTileWidth);
+        }
+    }
+#endif
+    if (!merge) return true;
+
+    // 合并到块的工作层：三角形在块内最远的深度取深度平面在块四角的最小值，
+    // 平面延伸到三角形外会偏小（更远），再用顶点中最远的深度截住
+    for (int ty = y0 / kTileHeight; ty <= y1 / kTileHeight; ++ty) {
+        const float tileY0 = float(ty * kTileHeight);
+        const float tileY1 = float(std::min((ty + 1) * kTileHeight, height_));
+        const uint32_t outside = outsideRows(ty, height_);
+        for (int tx = x0 / kTileWidth; tx <= x1 / kTileWidth; ++tx) {
+            const size_t t = size_t(ty) * size_t(tilesX_) + size_t(tx);
+            const float tileX0 = float(tx * kTileWidth);
+            const float tileX1 = tileX0 + float(kTileWidth);
+            const float farthest = planeC + dA * (dA > 0.0f ? tileX0 : tileX1) + dB * (dB > 0.0f ? tileY0 : tileY1);
+            tileFar_[t] = std::min(tileFar_[t], std::max(farthest, minD));
+            tileMask_[t] |= bits[t] & ~tileBoundary_[t];
+            bits[t] = 0;
+            if ((tileMask_[t] | outside) == ~0u) resolveTile(t);
+        }
+    }
+    return true;
+}
+
+void OcclusionCuller::markBoundary(float ax, float ay, float bx, float by) {
+    // 纹素与线段的包围盒相交，且中心到直线的距离不超过半个纹素（按边函数的收缩量）
+    Edge e;
+    e.setup(ax, ay, bx, by);
+    const float slab = 0.5f * (std::fabs(e.a) + std::fabs(e.b));
+    const int x0 = std::max(0, int(std::floor(std::min(ax, bx))));
+    const int x1 = std::min(width_ - 1, int(std::floor(std::max(ax, bx))));
+    const int y0 = std::max(0, int(std::floor(std::min(ay, by))));
+    const int y1 = std::min(height_ - 1, int(std::floor(std::max(ay, by))));
+    for (int row = y0; row <= y1; ++row) {
+        uint32_t* tileRow = tileBoundary_.data() + size_t(row / kTileHeight) * size_t(tilesX_);
+        const int shift = 4 * (row % kTileHeight);
+        for (int col = x0; col <= x1; ++col) {
+            if (std::fabs(e.at(float(col) + 0.5f, float(row) + 0.5f)) <= slab) {
+                tileRow[col / kTileWidth] |= 1u << (shift + col % kTileWidth);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::resolveTile(size_t tile) {
+    const int tx = int(tile % size_t(tilesX_));
+    const int ty = int(tile / size_t(tilesX_));
+    const float farthest = tileFar_[tile];
+    const int rowEnd = std::min((ty + 1) * kTileHeight, height_);
+    for (int row = ty * kTileHeight; row < rowEnd; ++row) {
+        float* line = levels_[0].depth.data() + size_t(row) * size_t(width_) + size_t(tx * kTileWidth);
+        for (int k = 0; k < kTileWidth; ++k) line[k] = std::max(line[k], farthest);
+    }
+    tileFar_[tile] = std::numeric_limits<float>::max();
+    tileMask_[tile] = 0;
+}
+
+void OcclusionCuller::addOccluder(const float* positions, const uint32_t* indices, size_t triangleCount) {
+    auto t0 = std::chrono::steady_clock::now();
+    pyramidReady_ = false;
+    // 每个顶点只变换一次
+    size_t vertexCount = 0;
+    for (size_t i = 0; i < 3 * triangleCount; ++i) vertexCount = std::max(vertexCount, size_t(indices[i]) + 1);
+    std::vector<float> sx(vertexCount), sy(vertexCount), sd(vertexCount);
+    std::vector<uint8_t> inFront(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const float* p = positions + 3 * v;
+        inFront[v] = toScreen(viewProjection_ * glm::vec4(p[0], p[1], p[2], 1.0f), float(width_), float(height_), sx[v],
+            sy[v], sd[v]) ? 1 : 0;
+    }
+
+    // 按坐标焊接顶点（经纬球的极点、带接缝的网格在同一位置有多个下标），再按边找邻接
+    std::vector<uint32_t> weld(vertexCount);
+    {
+        std::vector<uint32_t> sorted(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) sorted[v] = uint32_t(v);
+        std::sort(sorted.begin(), sorted.end(), [positions](uint32_t a, uint32_t b) {
+            return std::lexicographical_compare(positions + 3 * size_t(a), positions + 3 * size_t(a) + 3,
+                positions + 3 * size_t(b), positions + 3 * size_t(b) + 3);
+        });
+        for (size_t i = 0; i < vertexCount; ++i) {
+            const bool same = i > 0 && samePosition(positions + 3 * size_t(sorted[i]), positions + 3 * size_t(sorted[i - 1]));
+            weld[sorted[i]] = same ? weld[sorted[i - 1]] : sorted[i];
+        }
+    }
+    const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+    // 边 3 * t + k 从三角形 t 的第 k 个顶点到第 k + 1 个
+    std::vector<std::pair<uint64_t, uint32_t>> edges;
+    edges.reserve(3 * triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t w[3] = { weld[indices[3 * t]], weld[indices[3 * t + 1]], weld[indices[3 * t + 2]] };
+        // 焊接后退化的三角形不参与邻接
+        if (w[0] == w[1] || w[1] == w[2] || w[2] == w[0]) continue;
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = w[k], b = w[(k + 1) % 3];
+            edges.push_back(std::make_pair((uint64_t(std::min(a, b)) << 32) | std::max(a, b), uint32_t(3 * t + k)));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::vector<uint32_t> neighbor(3 * triangleCount, kNone);
+    bool closed = true;
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j].first == edges[i].first) ++j;
+        if (j - i == 2) {
+            const uint32_t e0 = edges[i].second, e1 = edges[i + 1].second;
+            neighbor[e0] = e1;
+            neighbor[e1] = e0;
+            // 绕向一致时两个三角形沿相反方向经过共享边
+            const uint32_t from0 = weld[indices[e0]];
+            const uint32_t from1 = weld[indices[e1]];
+            closed = closed && from0 != from1;
+        } else {
+            closed = false;
+        }
+        i = j;
+    }
+
+    // 画哪些三角形：三个顶点都在近平面前、面积不退化；封闭网格只画正面
+    std::vector<uint8_t> drawn(triangleCount, 0);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* v = indices + 3 * t;
+        if (!inFront[v[0]] || !inFront[v[1]] || !inFront[v[2]]) continue;
+        if (weld[v[0]] == weld[v[1]] || weld[v[1]] == weld[v[2]] || weld[v[2]] == weld[v[0]]) continue;
+        const float x[3] = { sx[v[0]], sx[v[1]], sx[v[2]] };
+        const float y[3] = { sy[v[0]], sy[v[1]], sy[v[2]] };
+        float area;
+        if (!screenArea(x, y, 3, area)) continue;
+        drawn[t] = !closed || area < 0.0f ? 1 : 0;
+    }
+    // 内部边：邻接三角形也画，且两个三角形在屏幕上分居边的两侧（不是轮廓上的折边）
+    std::vector<uint8_t> interior(3 * triangleCount, 0);
+    bool anyInterior = false;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!drawn[t]) continue;
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t n = neighbor[3 * t + k];
+            if (n == kNone || !drawn[n / 3]) continue;
+            const uint32_t a = indices[3 * t + k], b = indices[3 * t + (k + 1) % 3];
+            const uint32_t c = indices[3 * t + (k + 2) % 3];
+            const uint32_t o = indices[3 * (n / 3) + (n % 3 + 2) % 3];
+            Edge e;
+            e.setup(sx[a], sy[a], sx[b], sy[b]);
+            if (e.at(sx[c], sy[c]) * e.at(sx[o], sy[o]) < 0.0f) {
+                interior[3 * t + k] = 1;
+                anyInterior = true;
+            }
+        }
+    }
+    // 没有内部边（单独的三角形）时工作层帮不上忙，只按内保守覆盖写
+    if (anyInterior) {
+        std::fill(tileBoundary_.begin(), tileBoundary_.end(), 0u);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (!drawn[t]) continue;
+            for (int k = 0; k < 3; ++k) {
+                if (interior[3 * t + k]) continue;
+                const uint32_t a = indices[3 * t + k], b = indices[3 * t + (k + 1) % 3];
+                markBoundary(sx[a], sy[a], sx[b], sy[b]);
+            }
+        }
+    }
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!drawn[t]) continue;
+        const uint32_t* v = indices + 3 * t;
+        const float x[3] = { sx[v[0]], sx[v[1]], sx[v[2]] };
+        const float y[3] = { sy[v[0]], sy[v[1]], sy[v[2]] };
+        const float d[3] = { sd[v[0]], sd[v[1]], sd[v[2]] };
+        rasterizeScreen(x, y, d, 3, anyInterior);
+    }
+    rasterMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void OcclusionCuller::addSphereOccluder(const float center[3], float radius) {
+    auto t0 = std::chrono::steady_clock::now();
+    pyramidReady_ = false;
+    const glm::vec3 c(center[0], center[1], center[2]);
+    // 大圆的内接正八边形（覆盖圆面积的 90%），顶点到球心的距离为 radius
+    glm::vec4 corners[8];
+    for (int k = 0; k < 8; ++k) {
+        const float angle = float(k) * 0.78539816f;
+        glm::vec3 p = c + radius * (std::cos(angle) * cameraRight_ + std::sin(angle) * cameraUp_);
+        corners[k] = viewProjection_ * glm::vec4(p, 1.0f);
+    }
+    // 整个八边形作为一个凸多边形光栅化：拆成三角形的话，内保守覆盖会在对角线上留下一串没写的纹素
+    rasterizePolygon(corners, 8);
+    rasterMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void OcclusionCuller::buildPyramid() {
+    auto t0 = std::chrono::steady_clock::now();
+    levels_.resize(1);
+    while (levels_.back().width > 1 || levels_.back().height > 1) {
+        const Level& src = levels_.back();
+        Level dst{ (src.width + 1) / 2, (src.height + 1) / 2, std::vector<float>() };
+        dst.depth.resize(size_t(dst.width) * size_t(dst.height));
+        // 每个纹素取下一级 2x2 中最远（最小）的深度；奇数边上的最后一列 / 行只取到边界
+        for (int y = 0; y < dst.height; ++y) {
+            const float* r0 = src.depth.data() + size_t(2 * y) * size_t(src.width);
+            const float* r1 = src.depth.data() + size_t(std::min(2 * y + 1, src.height - 1)) * size_t(src.width);
+            float* out = dst.depth.data() + size_t(y) * size_t(dst.width);
+            for (int x = 0; x < dst.width; ++x) {
+                int xa = 2 * x;
+                int xb = std::min(2 * x + 1, src.width - 1);
+                out[x] = std::min(std::min(r0[xa], r0[xb]), std::min(r1[xa], r1[xb]));
+            }
+        }
+        levels_.push_back(std::move(dst));
+    }
+    pyramidReady_ = true;
+    pyramidMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+bool OcclusionCuller::visible(const float lo[3], const float hi[3]) const {
+    if (!pyramidReady_) return true;
+    float minX = std::numeric_limits<float>::max(), minY = minX;
+    float maxX = -minX, maxY = -minX;
+    float nearest = 0.0f;
+    // 裁剪坐标对位置是线性的：八个角由一个角加三条棱的组合得到
+    const glm::vec4 base = viewProjection_ * glm::vec4(lo[0], lo[1], lo[2], 1.0f);
+    const glm::vec4 edgeX = viewProjection_[0] * (hi[0] - lo[0]);
+    const glm::vec4 edgeY = viewProjection_[1] * (hi[1] - lo[1]);
+    const glm::vec4 edgeZ = viewProjection_[2] * (hi[2] - lo[2]);
+    for (int k = 0; k < 8; ++k) {
+        glm::vec4 c = base;
+        if (k & 1) c += edgeX;
+        if (k & 2) c += edgeY;
+        if (k & 4) c += edgeZ;
+        // 盒子跨过视点平面：投影矩形无界，按可见处理
+        if (c.w < kMinW) return true;
+        float invW = 1.0f / c.w;
+        float sx = (c.x * invW * 0.5f + 0.5f) * float(width_);
+        float sy = (0.5f - c.y * invW * 0.5f) * float(height_);
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        nearest = std::max(nearest, invW);
+    }
+    if (maxX < 0.0f || maxY < 0.0f || minX >= float(width_) || minY >= float(height_)) return true;
+    int x0 = std::max(0, int(minX));
+    int y0 = std::max(0, int(minY));
+    int x1 = std::min(width_ - 1, int(maxX));
+    int y1 = std::min(height_ - 1, int(maxY));
+    // 选一级，使矩形在该级最多跨 2x2 个纹素
+    int level = 0;
+    while (level + 1 < int(levels_.size()) && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) ++level;
+    const Level& l = levels_[level];
+    for (int y = y0 >> level; y <= (y1 >> level); ++y) {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x) {
+            // 纹素内最远的遮挡不比盒子最近的点近，就可能看得见
+            if (l.depth[size_t(y) * size_t(l.width) + size_t(x)] <= nearest) return true;
+        }
+    }
+    return false;
+}
+
+size_t OcclusionCuller::cull(const AabbArray& boxes, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& visible) {
+    auto t0 = std::chrono::steady_clock::now();
+    const size_t n = candidates.size();
+    std::vector<uint8_t> keep(n);
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) {
+            uint32_t b = candidates[i];
+            const float lo[3] = { boxes.minX[b], boxes.minY[b], boxes.minZ[b] };
+            const float hi[3] = { boxes.maxX[b], boxes.maxY[b], boxes.maxZ[b] };
+            keep[i] = this->visible(lo, hi) ? 1 : 0;
+        }
+    }, 4096);
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!keep[i]) continue;
+        visible.push_back(candidates[i]);
+        ++count;
+    }
+    tested_ = n;
+    visible_ = count;
+    cullMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return count;
+}
@@ -0,0 +1,90 @@
+﻿// PackedMeshRenderer v 1.0
+#include <glad/glad.h>
+#include "PackedMeshRenderer.h"
+#include <utility>
+
+namespace {
+    const GLuint kPositionAttrib = 0;
+    const GLuint kNormalAttrib = 1;
+    const GLuint kAtomIdAttrib = 2;
+    const int kPositionUnit = 0;
+    const int kColorUnit = 1;
+}
+
+void PackedMeshRenderer::setMesh(const Mesh& mesh, const RenderAnchor& anchor) {
+    packMesh(mesh, mesh_);
+    anchor_ = anchor;
+    meshDirty_ = true;
+}
+
+void PackedMeshRenderer::setMesh(PackedMesh&& mesh, const RenderAnchor& anchor) {
+    mesh_ = std::move(mesh);
+    anchor_ = anchor;
+    meshDirty_ = true;
+}
+
+bool PackedMeshRenderer::createGL(const std::string& vertexPath, const std::string& fragmentPath) {
+    error_.clear();
+    if (!shader_.loadFiles(vertexPath, fragmentPath)) {
+        error_ = shader_.lastError();
+        return false;
+    }
+    destroyGL();
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vertexBuffer_);
+    glGenBuffers(1, &indexBuffer_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    setPackedVertexAttribs(kPositionAttrib, kNormalAttrib, kAtomIdAttrib);
+    // 下标缓冲绑定记录在 VAO 中
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shader_.use();
+    shader_.setInt("uColors", kColorUnit);
+    glUseProgram(0);
+    uploadedIndices_ = 0;
+    meshDirty_ = true;
+    return true;
+}
+
+void PackedMeshRenderer::destroyGL() {
+    if (indexBuffer_ != 0) glDeleteBuffers(1, &indexBuffer_);
+    if (vertexBuffer_ != 0) glDeleteBuffers(1, &vertexBuffer_);
+    if (vao_ != 0) glDeleteVertexArrays(1, &vao_);
+    indexBuffer_ = 0;
+    vertexBuffer_ = 0;
+    vao_ = 0;
+    uploadedIndices_ = 0;
+}
+
+void PackedMeshRenderer::upload() {
+    if (vao_ == 0 || !meshDirty_) return;
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(mesh_.vertexBytes()), mesh_.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // GL_ELEMENT_ARRAY_BUFFER 的绑定属于 VAO，先绑 VAO 再传，避免改动别人的 VAO
+    glBindVertexArray(vao_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(mesh_.indices.size() * sizeof(uint32_t)), mesh_.indices.data(),
+        GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    uploadedIndices_ = mesh_.indices.size();
+    uploadedOrigin_ = glm::vec3(mesh_.origin[0], mesh_.origin[1], mesh_.origin[2]);
+    uploadedExtent_ = glm::vec3(mesh_.extent[0], mesh_.extent[1], mesh_.extent[2]);
+    meshDirty_ = false;
+}
+
+void PackedMeshRenderer::draw(const Camera& camera, const glm::mat4& projection) const {
+    if (vao_ == 0 || uploadedIndices_ == 0 || atoms_ == nullptr || !atoms_->isReady()) return;
+    shader_.use();
+    shader_.setMat4("uModelView", anchor_.modelView(camera));
+    shader_.setMat4("uProjection", projection);
+    shader_.setVec3("uOrigin", uploadedOrigin_);
+    shader_.setVec3("uExtent", uploadedExtent_);
+    atoms_->bind(kPositionUnit, kColorUnit);
+    glBindVertexArray(vao_);
+    glDrawElements(GL_TRIANGLES, GLsizei(uploadedIndices_), GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,84 @@
+﻿// Parallel v 1.0
+#include "Parallel.h"
+
+namespace {
+    // 标记当前线程是否正在执行池内任务，防止嵌套调用造成死锁
+    thread_local bool tlsInPool = false;
+}
+
+ThreadPool::ThreadPool() {
+    unsigned n = std::thread::hardware_concurrency();
+    if (n == 0) n = 1;
+    for (unsigned i = 1; i < n; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_) {
+        t.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop() {
+    tlsInPool = true;
+    size_t seen = 0;
+    for (;;) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        wake_.wait(lk, [&]() { return stop_ || generation_ != seen; });
+        if (stop_) return;
+        seen = generation_;
+        const std::function<void(size_t)>* task = task_;
+        size_t count = taskCount_;
+        lk.unlock();
+
+        for (size_t i = next_.fetch_add(1); i < count; i = next_.fetch_add(1)) {
+            (*task)(i);
+        }
+
+        lk.lock();
+        if (--active_ == 0) done_.notify_one();
+    }
+}
+
+void ThreadPool::run(size_t taskCount, const std::function<void(size_t)>& task) {
+    if (taskCount == 0) return;
+    if (tlsInPool || taskCount == 1 || workers_.empty() || !runMutex_.try_lock()) {
+        for (size_t i = 0; i < taskCount; ++i) task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        task_ = &task;
+        taskCount_ = taskCount;
+        next_ = 0;
+        active_ = static_cast<unsigned>(workers_.size());
+        ++generation_;
+    }
+    wake_.notify_all();
+
+    // 调用线程同样领取任务
+    tlsInPool = true;
+    for (size_t i = next_.fetch_add(1); i < taskCount; i = next_.fetch_add(1)) {
+        task(i);
+    }
+    tlsInPool = false;
+
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        done_.wait(lk, [&]() { return active_ == 0; });
+        task_ = nullptr;
+    }
+    runMutex_.unlock();
+}
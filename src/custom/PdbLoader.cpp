@@ -0,0 +1,290 @@
+﻿// PdbLoader v 1.0
+#include "PdbLoader.h"
+#include "Element.h"
+#include "FastNumber.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+
+namespace {
+    const size_t kMinChunkBytes = 1 << 20;
+
+    // 每个线程解析一块，块内的残基与链使用局部编号，拼接时再统一偏移
+    struct Chunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        std::vector<float> x, y, z;
+        std::vector<uint8_t> element, flags;
+        std::vector<uint32_t> name;
+        std::vector<int32_t> residueLocal;
+
+        std::vector<Residue> residues;        // chain 字段暂存链标识字符
+        std::vector<uint8_t> residueNewChain; // 该残基是否开始一条新链（TER 或链标识变化）
+        bool pendingTer = false;              // 块末尾是否有尚未消耗的 TER
+        std::vector<SecondaryStructureRange> ss;
+
+        size_t atomOffset = 0;
+        size_t residueOffset = 0;
+        bool mergeFirstResidue = false;
+    };
+
+    // 取第 [a, b] 列（1 起始，含两端），超出行长的部分视为空
+    inline std::string_view column(const char* line, size_t len, size_t a, size_t b) {
+        if (a > len) return std::string_view();
+        size_t end = std::min(b, len);
+        return std::string_view(line + a - 1, end - a + 1);
+    }
+
+    inline char columnChar(const char* line, size_t len, size_t a) {
+        return a <= len ? line[a - 1] : ' ';
+    }
+
+    uint8_t guessElement(const char* line, size_t len) {
+        std::string_view sym = column(line, len, 77, 78);
+        uint8_t e = elementFromSymbol(sym.data(), sym.size());
+        if (e != 0) return e;
+
+        // 没有元素列时根据原子名推断：第 13 列为空格或数字时为单字母元素
+        std::string_view atomName = column(line, len, 13, 16);
+        if (atomName.size() < 2) return 0;
+        char c0 = atomName[0];
+        if (c0 == ' ' || (c0 >= '0' && c0 <= '9')) {
+            return elementFromSymbol(atomName.data() + 1, 1);
+        }
+        e = elementFromSymbol(atomName.data(), 2);
+        return e != 0 ? e : elementFromSymbol(atomName.data(), 1);
+    }
+
+    void parseAtom(Chunk& c, const char* line, size_t len, bool hetero) {
+        char altLoc = columnChar(line, len, 17);
+        if (altLoc != ' ' && altLoc != 'A' && altLoc != '1') return;
+
+        std::string_view xs = column(line, len, 31, 38);
+        std::string_view ys = column(line, len, 39, 46);
+        std::string_view zs = column(line, len, 47, 54);
+        std::string_view atomName = column(line, len, 13, 16);
+        std::string_view resName = column(line, len, 18, 20);
+        std::string_view resSeq = column(line, len, 23, 26);
+        char chain = columnChar(line, len, 22);
+        char insertion = columnChar(line, len, 27);
+
+        uint32_t packedRes = packName4(resName.data(), resName.size());
+        int32_t seq = parseIntField(resSeq.data(), resSeq.data() + resSeq.size());
+
+        bool newResidue = c.residues.empty() || c.pendingTer;
+        if (!newResidue) {
+            const Residue& last = c.residues.back();
+            newResidue = last.seq != seq || last.insertion != insertion ||
+                last.name != packedRes || char(last.chain) != chain;
+        }
+        if (newResidue) {
+            Residue r;
+            r.name = packedRes;
+            r.seq = seq;
+            r.insertion = insertion;
+            r.chain = chain;
+            r.firstAtom = static_cast<uint32_t>(c.x.size());
+            // 块内第一个残基是否接着上一块的链要到拼接时才知道，这里只记录 TER
+            bool newChain = c.pendingTer || (!c.residues.empty() && char(c.residues.back().chain) != chain);
+            c.residues.push_back(r);
+            c.residueNewChain.push_back(newChain ? 1 : 0);
+            c.pendingTer = false;
+        }
+        c.residues.back().atomCount++;
+
+        c.x.push_back(parseFloatField(xs.data(), xs.data() + xs.size()));
+        c.y.push_back(parseFloatField(ys.data(), ys.data() + ys.size()));
+        c.z.push_back(parseFloatField(zs.data(), zs.data() + zs.size()));
+        c.element.push_back(guessElement(line, len));
+        c.name.push_back(packName4(atomName.data(), atomName.size()));
+        c.flags.push_back(hetero ? AtomHetero : 0);
+        c.residueLocal.push_back(static_cast<int32_t>(c.residues.size() - 1));
+    }
+
+    void parseHelix(Chunk& c, const char* line, size_t len) {
+        // HELIX 记录：起始链 20，起始序号 22-25，插入码 26，终止序号 34-37，插入码 38，类型 39-40
+        std::string_view b = column(line, len, 22, 25);
+        std::string_view e = column(line, len, 34, 37);
+        std::string_view cls = column(line, len, 39, 40);
+        int helixClass = parseIntField(cls.data(), cls.data() + cls.size());
+        SecondaryStructureRange r;
+        r.type = helixClass == 5 ? SecondaryStructure::Helix310 :
+            helixClass == 3 ? SecondaryStructure::PiHelix : SecondaryStructure::AlphaHelix;
+        r.chain = packName4(line + 19, len >= 20 ? 1 : 0);
+        r.beginSeq = parseIntField(b.data(), b.data() + b.size());
+        r.beginInsertion = columnChar(line, len, 26);
+        r.endSeq = parseIntField(e.data(), e.data() + e.size());
+        r.endInsertion = columnChar(line, len, 38);
+        c.ss.push_back(r);
+    }
+
+    void parseSheet(Chunk& c, const char* line, size_t len) {
+        // SHEET 记录：起始链 22，起始序号 23-26，插入码 27，终止序号 34-37，插入码 38
+        std::string_view b = column(line, len, 23, 26);
+        std::string_view e = column(line, len, 34, 37);
+        SecondaryStructureRange r;
+        r.type = SecondaryStructure::Strand;
+        r.chain = packName4(line + 21, len >= 22 ? 1 : 0);
+        r.beginSeq = parseIntField(b.data(), b.data() + b.size());
+        r.beginInsertion = columnChar(line, len, 27);
+        r.endSeq = parseIntField(e.data(), e.data() + e.size());
+        r.endInsertion = columnChar(line, len, 38);
+        c.ss.push_back(r);
+    }
+
+    void parseChunk(Chunk& c) {
+        // 按平均每行 81 字节预估容量，减少扩容
+        size_t estimate = static_cast<size_t>(c.end - c.begin) / 81 + 16;
+        c.x.reserve(estimate);
+        c.y.reserve(estimate);
+        c.z.reserve(estimate);
+        c.element.reserve(estimate);
+        c.name.reserve(estimate);
+        c.flags.reserve(estimate);
+        c.residueLocal.reserve(estimate);
+
+        const char* p = c.begin;
+        while (p < c.end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', size_t(c.end - p)));
+            if (eol == nullptr) eol = c.end;
+            size_t len = size_t(eol - p);
+            if (len > 0 && p[len - 1] == '\r') --len;
+
+            if (len >= 6) {
+                if (std::memcmp(p, "ATOM  ", 6) == 0) parseAtom(c, p, len, false);
+                else if (std::memcmp(p, "HETATM", 6) == 0) parseAtom(c, p, len, true);
+                else if (std::memcmp(p, "TER", 3) == 0) c.pendingTer = true;
+                else if (std::memcmp(p, "HELIX ", 6) == 0) parseHelix(c, p, len);
+                else if (std::memcmp(p, "SHEET ", 6) == 0) parseSheet(c, p, len);
+            }
+            else if (len >= 3 && std::memcmp(p, "TER", 3) == 0) {
+                c.pendingTer = true;
+            }
+            p = eol + 1;
+        }
+    }
+}
+
+bool PdbLoader::load(const std::string& path, AtomTable& out) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    return parse(file.data(), file.size(), out);
+}
+
+bool PdbLoader::parse(const char* data, size_t size, AtomTable& out) {
+    auto start = std::chrono::steady_clock::now();
+    error_.clear();
+    out.clear();
+
+    // 只解析第一个模型：截断到第一条 ENDMDL
+    std::string_view text(data, size);
+    size_t endModel = text.find("\nENDMDL");
+    if (endModel != std::string_view::npos) size = endModel + 1;
+
+    // 切块，块边界对齐到行首
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(size / kMinChunkBytes, size_t(workerCount()) * 4));
+    std::vector<Chunk> chunks(chunkCount);
+    const char* end = data + size;
+    const char* p = data;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        chunks[i].begin = p;
+        const char* target = (i + 1 == chunkCount) ? end : data + size * (i + 1) / chunkCount;
+        if (target < p) target = p;
+        if (target < end) {
+            const char* nl = static_cast<const char*>(std::memchr(target, '\n', size_t(end - target)));
+            target = nl ? nl + 1 : end;
+        }
+        chunks[i].end = target;
+        p = target;
+    }
+
+    ThreadPool::instance().run(chunkCount, [&](size_t i) { parseChunk(chunks[i]); });
+
+    // 串行拼接残基与链（数量远少于原子）
+    size_t atomTotal = 0;
+    bool terBefore = false;
+    for (Chunk& c : chunks) {
+        c.atomOffset = atomTotal;
+        atomTotal += c.x.size();
+        if (c.residues.empty()) {
+            terBefore = terBefore || c.pendingTer;
+            continue;
+        }
+
+        if (terBefore) c.residueNewChain[0] = 1;
+        if (!out.residues.empty()) {
+            const Residue& last = out.residues.back();
+            const Residue& first = c.residues.front();
+            char lastChainId = char(out.chains.back().id & 0xFF);
+            if (lastChainId == 0) lastChainId = ' ';
+            bool sameChain = !c.residueNewChain[0] && lastChainId == char(first.chain);
+            if (!sameChain) c.residueNewChain[0] = 1;
+            c.mergeFirstResidue = sameChain && last.seq == first.seq &&
+                last.insertion == first.insertion && last.name == first.name;
+        }
+        else {
+            c.residueNewChain[0] = 1;
+        }
+
+        c.residueOffset = out.residues.size() - (c.mergeFirstResidue ? 1 : 0);
+        for (size_t r = 0; r < c.residues.size(); ++r) {
+            Residue res = c.residues[r];
+            if (r == 0 && c.mergeFirstResidue) {
+                out.residues.back().atomCount += res.atomCount;
+                continue;
+            }
+            if (c.residueNewChain[r]) {
+                Chain chain;
+                char id = char(res.chain);
+                chain.id = packName4(&id, 1);
+                chain.firstResidue = static_cast<uint32_t>(out.residues.size());
+                out.chains.push_back(chain);
+            }
+            res.chain = static_cast<int32_t>(out.chains.size() - 1);
+            res.firstAtom += static_cast<uint32_t>(c.atomOffset);
+            out.residues.push_back(res);
+            out.chains.back().residueCount++;
+        }
+        terBefore = c.pendingTer;
+    }
+
+    // 并行拷贝原子数组
+    out.resizeAtoms(atomTotal);
+    ThreadPool::instance().run(chunkCount, [&](size_t i) {
+        const Chunk& c = chunks[i];
+        size_t n = c.x.size();
+        if (n == 0) return;
+        size_t o = c.atomOffset;
+        std::copy(c.x.begin(), c.x.end(), out.x.begin() + o);
+        std::copy(c.y.begin(), c.y.end(), out.y.begin() + o);
+        std::copy(c.z.begin(), c.z.end(), out.z.begin() + o);
+        std::copy(c.element.begin(), c.element.end(), out.element.begin() + o);
+        std::copy(c.name.begin(), c.name.end(), out.name.begin() + o);
+        std::copy(c.flags.begin(), c.flags.end(), out.flags.begin() + o);
+        for (size_t a = 0; a < n; ++a) {
+            int32_t r = c.residueLocal[a] + static_cast<int32_t>(c.residueOffset);
+            out.residueIndex[o + a] = r;
+            out.chainIndex[o + a] = out.residues[size_t(r)].chain;
+        }
+    });
+
+    std::vector<SecondaryStructureRange> ranges;
+    for (const Chunk& c : chunks) {
+        ranges.insert(ranges.end(), c.ss.begin(), c.ss.end());
+    }
+    applySecondaryStructure(out, ranges);
+
+    parseMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (atomTotal == 0) {
+        error_ = "no ATOM/HETATM records";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,251 @@
+﻿// Picker v 1.0
+#include "Picker.h"
+#include "Element.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    inline float dot3(const float a[3], const float b[3]) {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // 射线与球的近交点（起点在球内时取出射点），不相交返回 false
+    bool raySphere(const float origin[3], const float dir[3], const float center[3], float radius, float& t) {
+        const float oc[3] = { origin[0] - center[0], origin[1] - center[1], origin[2] - center[2] };
+        float b = dot3(oc, dir);
+        float c = dot3(oc, oc) - radius * radius;
+        float h = b * b - c;
+        if (h < 0.0f) return false;
+        h = std::sqrt(h);
+        t = -b - h;
+        if (t < 0.0f) t = -b + h;
+        return t >= 0.0f;
+    }
+
+    // 射线与有限圆柱（轴 a -> b，不含端面，端面藏在原子球里）的交点，s 为交点在轴上的参数 [0, 1]
+    bool rayCylinder(const float origin[3], const float dir[3], const float a[3], const float b[3], float radius,
+        float& t, float& s) {
+        const float ba[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float oc[3] = { origin[0] - a[0], origin[1] - a[1], origin[2] - a[2] };
+        float baba = dot3(ba, ba);
+        if (baba <= 0.0f) return false;
+        float bard = dot3(ba, dir);
+        float baoc = dot3(ba, oc);
+        float k2 = baba - bard * bard;
+        float k1 = baba * dot3(oc, dir) - baoc * bard;
+        float k0 = baba * dot3(oc, oc) - baoc * baoc - radius * radius * baba;
+        if (k2 <= 0.0f) return false;
+        float h = k1 * k1 - k2 * k0;
+        if (h < 0.0f) return false;
+        h = std::sqrt(h);
+        float roots[2] = { (-k1 - h) / k2, (-k1 + h) / k2 };
+        for (float r : roots) {
+            if (r < 0.0f) continue;
+            float y = baoc + r * bard;
+            if (y < 0.0f || y > baba) continue;
+            t = r;
+            s = y / baba;
+            return true;
+        }
+        return false;
+    }
+
+    // Möller-Trumbore，两面都算；u、v 为 p1、p2 的重心坐标
+    bool rayTriangle(const float origin[3], const float dir[3], const float* p0, const float* p1, const float* p2,
+        float& t, float& u, float& v) {
+        const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        const float p[3] = { dir[1] * e2[2] - dir[2] * e2[1], dir[2] * e2[0] - dir[0] * e2[2], dir[0] * e2[1] - dir[1] * e2[0] };
+        float det = dot3(e1, p);
+        if (std::fabs(det) < 1e-12f) return false;
+        float inv = 1.0f / det;
+        const float s[3] = { origin[0] - p0[0], origin[1] - p0[1], origin[2] - p0[2] };
+        u = dot3(s, p) * inv;
+        if (u < 0.0f || u > 1.0f) return false;
+        const float q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+        v = dot3(dir, q) * inv;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        t = dot3(e2, q) * inv;
+        return t >= 0.0f;
+    }
+
+    inline void boxCenter(const AabbArray& boxes, uint32_t i, float c[3]) {
+        c[0] = 0.5f * (boxes.minX[i] + boxes.maxX[i]);
+        c[1] = 0.5f * (boxes.minY[i] + boxes.maxY[i]);
+        c[2] = 0.5f * (boxes.minZ[i] + boxes.maxZ[i]);
+    }
+}
+
+void Picker::setAtoms(const AtomTable& atoms, float radiusScale) {
+    auto t0 = std::chrono::steady_clock::now();
+    const size_t n = atoms.atomCount();
+    radii_.resize(n);
+    for (size_t i = 0; i < n; ++i) radii_[i] = vdwRadius(atoms.element[i]) * radiusScale;
+    atoms_.build(atoms.x.data(), atoms.y.data(), atoms.z.data(), radii_.data(), n);
+    // 原子变了，旧的键下标不再有效
+    pairs_.clear();
+    bonds_.build(AabbArray());
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Picker::updateBondBoxes() {
+    const AabbArray& atomBoxes = atoms_.boxes();
+    const size_t n = pairs_.size() / 2;
+    bondBoxes_.resize(n);
+    const float r = bondRadius_;
+    parallelFor(0, n, [&](size_t b0, size_t b1) {
+        for (size_t i = b0; i < b1; ++i) {
+            float a[3], b[3];
+            boxCenter(atomBoxes, atoms_.slot(pairs_[2 * i]), a);
+            boxCenter(atomBoxes, atoms_.slot(pairs_[2 * i + 1]), b);
+            const float lo[3] = { std::min(a[0], b[0]) - r, std::min(a[1], b[1]) - r, std::min(a[2], b[2]) - r };
+            const float hi[3] = { std::max(a[0], b[0]) + r, std::max(a[1], b[1]) + r, std::max(a[2], b[2]) + r };
+            bondBoxes_.set(i, lo, hi);
+        }
+    }, 16384);
+}
+
+void Picker::setBonds(const BondTable& bonds, float radius) {
+    std::vector<uint32_t> pairs;
+    pairs.reserve(bonds.neighbors.size());
+    const size_t atomCount = bonds.offsets.empty() ? 0 : bonds.offsets.size() - 1;
+    for (size_t a = 0; a < atomCount; ++a) {
+        for (uint32_t k = bonds.offsets[a]; k < bonds.offsets[a + 1]; ++k) {
+            uint32_t b = bonds.neighbors[k];
+            // 每条键在两端各出现一次，只取 a < b 的一次
+            if (b <= a) continue;
+            pairs.push_back(uint32_t(a));
+            pairs.push_back(b);
+        }
+    }
+    setBonds(pairs, radius);
+}
+
+void Picker::setBonds(const std::vector<uint32_t>& pairs, float radius) {
+    auto t0 = std::chrono::steady_clock::now();
+    pairs_ = pairs;
+    bondRadius_ = radius;
+    updateBondBoxes();
+    bonds_.build(bondBoxes_);
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Picker::setMesh(const Mesh* mesh) {
+    auto t0 = std::chrono::steady_clock::now();
+    mesh_ = mesh;
+    AabbArray boxes;
+    if (mesh) {
+        const size_t n = mesh->triangleCount();
+        boxes.resize(n);
+        const float* pos = mesh->positions.data();
+        const uint32_t* idx = mesh->indices.data();
+        parallelFor(0, n, [&](size_t b0, size_t b1) {
+            for (size_t i = b0; i < b1; ++i) {
+                const float* p0 = pos + 3 * idx[3 * i];
+                const float* p1 = pos + 3 * idx[3 * i + 1];
+                const float* p2 = pos + 3 * idx[3 * i + 2];
+                float lo[3], hi[3];
+                for (int d = 0; d < 3; ++d) {
+                    lo[d] = std::min(p0[d], std::min(p1[d], p2[d]));
+                    hi[d] = std::max(p0[d], std::max(p1[d], p2[d]));
+                }
+                boxes.set(i, lo, hi);
+            }
+        }, 16384);
+    }
+    triangles_.build(boxes);
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Picker::updatePositions(const float* x, const float* y, const float* z) {
+    auto t0 = std::chrono::steady_clock::now();
+    atoms_.refit(x, y, z, radii_.data(), radii_.size());
+    if (!pairs_.empty()) {
+        updateBondBoxes();
+        bonds_.refit(bondBoxes_);
+    }
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void Picker::cursorRay(const Camera& camera, const glm::mat4& projection, float cursorX, float cursorY,
+    float width, float height, glm::vec3& origin, glm::vec3& dir) {
+    // 窗口 y 向下，NDC y 向上；反投影近、远平面上的两点
+    float ndcX = 2.0f * cursorX / std::max(width, 1.0f) - 1.0f;
+    float ndcY = 1.0f - 2.0f * cursorY / std::max(height, 1.0f);
+    // 在相对渲染原点的坐标里求逆（数值小，远离世界原点时也不丢精度），最后再加回原点
+    glm::mat4 inv = glm::inverse(projection * camera.getRenderView());
+    glm::vec4 nearPoint = inv * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = inv * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    glm::vec3 local = glm::vec3(nearPoint) / nearPoint.w;
+    dir = glm::normalize(glm::vec3(farPoint) / farPoint.w - local);
+    origin = glm::vec3(camera.toWorld(local));
+}
+
+bool Picker::pickRay(const glm::vec3& origin, const glm::vec3& dir, PickHit& hit, float maxDistance) {
+    auto t0 = std::chrono::steady_clock::now();
+    const float o[3] = { origin.x, origin.y, origin.z };
+    const float d[3] = { dir.x, dir.y, dir.z };
+    hit = PickHit();
+    // 三个 Bvh 共用 tMax：后面的遍历直接跳过比已有交点远的节点
+    float tMax = maxDistance;
+
+    const AabbArray& atomBoxes = atoms_.boxes();
+    atoms_.traceRay(o, d, tMax, [&](uint32_t i, float& t) {
+        // 图元包围盒按叶子顺序存放
+        const uint32_t k = atoms_.slot(i);
+        float c[3];
+        boxCenter(atomBoxes, k, c);
+        float th;
+        if (!raySphere(o, d, c, 0.5f * (atomBoxes.maxX[k] - atomBoxes.minX[k]), th) || th >= t) return;
+        t = th;
+        hit.kind = PickKind::Atom;
+        hit.index = i;
+        hit.atom = i;
+    });
+
+    bonds_.traceRay(o, d, tMax, [&](uint32_t i, float& t) {
+        float a[3], b[3];
+        boxCenter(atomBoxes, atoms_.slot(pairs_[2 * i]), a);
+        boxCenter(atomBoxes, atoms_.slot(pairs_[2 * i + 1]), b);
+        float th, s;
+        if (!rayCylinder(o, d, a, b, bondRadius_, th, s) || th >= t) return;
+        t = th;
+        hit.kind = PickKind::Bond;
+        hit.index = i;
+        hit.atom = pairs_[2 * i + (s < 0.5f ? 0 : 1)];
+    });
+
+    if (mesh_) {
+        const float* pos = mesh_->positions.data();
+        const uint32_t* idx = mesh_->indices.data();
+        triangles_.traceRay(o, d, tMax, [&](uint32_t i, float& t) {
+            float th, u, v;
+            if (!rayTriangle(o, d, pos + 3 * idx[3 * i], pos + 3 * idx[3 * i + 1], pos + 3 * idx[3 * i + 2], th, u, v) ||
+                th >= t) return;
+            t = th;
+            hit.kind = PickKind::Triangle;
+            hit.index = i;
+            // 重心坐标最大的顶点
+            float w = 1.0f - u - v;
+            int corner = w >= u && w >= v ? 0 : (u >= v ? 1 : 2);
+            hit.atom = mesh_->atomIds.empty() ? 0 : mesh_->atomIds[idx[3 * i + corner]];
+        });
+    }
+
+    if (hit.kind != PickKind::None) {
+        hit.t = tMax;
+        for (int k = 0; k < 3; ++k) hit.position[k] = o[k] + tMax * d[k];
+    }
+    hit_ = hit;
+    pickMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return hit.kind != PickKind::None;
+}
+
+bool Picker::pick(const Camera& camera, const glm::mat4& projection, float cursorX, float cursorY,
+    float width, float height, PickHit& hit) {
+    glm::vec3 origin, dir;
+    cursorRay(camera, projection, cursorX, cursorY, width, height, origin, dir);
+    return pickRay(origin, dir, hit);
+}
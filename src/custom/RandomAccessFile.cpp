@@ -0,0 +1,99 @@
+﻿// RandomAccessFile v 1.0
+#include "RandomAccessFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool RandomAccessFile::open(const std::string& path) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    handle_ = file;
+    size_ = static_cast<uint64_t>(size.QuadPart);
+    return true;
+}
+
+void RandomAccessFile::close() {
+    if (handle_ != nullptr) CloseHandle(handle_);
+    handle_ = nullptr;
+    size_ = 0;
+}
+
+bool RandomAccessFile::readAt(uint64_t offset, void* dst, size_t size) const {
+    if (handle_ == nullptr || offset > size_ || size > size_ - offset) return false;
+    char* out = static_cast<char*>(dst);
+    while (size > 0) {
+        // 单次 ReadFile 最多 DWORD 字节，按 1GB 分段
+        DWORD chunk = static_cast<DWORD>(size < (1u << 30) ? size : (1u << 30));
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        if (!ReadFile(handle_, out, chunk, &got, &ov) || got == 0) return false;
+        out += got;
+        offset += got;
+        size -= got;
+    }
+    return true;
+}
+
+#else
+
+bool RandomAccessFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    size_ = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void RandomAccessFile::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+}
+
+bool RandomAccessFile::readAt(uint64_t offset, void* dst, size_t size) const {
+    if (fd_ < 0 || offset > size_ || size > size_ - offset) return false;
+    char* out = static_cast<char*>(dst);
+    while (size > 0) {
+        ssize_t got = pread(fd_, out, size, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        out += got;
+        offset += static_cast<uint64_t>(got);
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+#endif
+
+RandomAccessFile::~RandomAccessFile()
+{
+    close();
+}
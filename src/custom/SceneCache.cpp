@@ -0,0 +1,193 @@
+﻿// SceneCache v 1.0
+#include <glad/glad.h>
+#include "SceneCache.h"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const char kMagic[8] = { 'T', 'H', 'C', 'S', 'C', 'E', 'N', 'E' };
+    const uint32_t kByteOrder = 0x01020304u;
+    const uint64_t kAlignment = 64;
+
+    inline uint64_t alignUp(uint64_t v) {
+        return (v + kAlignment - 1) & ~(kAlignment - 1);
+    }
+
+    // Residue/Chain 按原样写盘，布局变化时必须递增 kSceneCacheFormatVersion
+    static_assert(sizeof(Residue) == 24, "Residue layout changed, bump kSceneCacheFormatVersion");
+    static_assert(sizeof(Chain) == 12, "Chain layout changed, bump kSceneCacheFormatVersion");
+
+    template <typename T>
+    bool copySection(const SceneCache& cache, SceneSection type, size_t expected, std::vector<T>& out) {
+        size_t count = 0;
+        const T* p = cache.sectionAs<T>(type, &count);
+        if (p == nullptr || count != expected) return false;
+        out.assign(p, p + count);
+        return true;
+    }
+}
+
+void SceneCacheWriter::addSection(SceneSection type, const void* data, size_t size, uint32_t elementSize) {
+    Pending p;
+    p.type = type;
+    p.data = data;
+    p.size = size;
+    p.elementSize = elementSize == 0 ? 1 : elementSize;
+    sections_.push_back(p);
+}
+
+void SceneCacheWriter::addAtomTable(const AtomTable& table) {
+    addSection(SceneSection::AtomX, table.x);
+    addSection(SceneSection::AtomY, table.y);
+    addSection(SceneSection::AtomZ, table.z);
+    addSection(SceneSection::AtomElement, table.element);
+    addSection(SceneSection::AtomName, table.name);
+    addSection(SceneSection::AtomFlags, table.flags);
+    addSection(SceneSection::AtomResidue, table.residueIndex);
+    addSection(SceneSection::AtomChain, table.chainIndex);
+    addSection(SceneSection::Residues, table.residues);
+    addSection(SceneSection::Chains, table.chains);
+}
+
+bool SceneCacheWriter::write(const std::string& path) const {
+    SceneCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kSceneCacheFormatVersion;
+    header.byteOrder = kByteOrder;
+    header.generatorVersion = kSceneGeneratorVersion;
+    header.sourceHash = sourceHash_;
+    header.sourceSize = sourceSize_;
+    header.sectionCount = static_cast<uint32_t>(sections_.size());
+
+    std::vector<SceneCacheSection> table(sections_.size());
+    uint64_t offset = alignUp(sizeof(header) + table.size() * sizeof(SceneCacheSection));
+    for (size_t i = 0; i < sections_.size(); ++i) {
+        table[i].type = static_cast<uint32_t>(sections_[i].type);
+        table[i].elementSize = sections_[i].elementSize;
+        table[i].offset = offset;
+        table[i].size = sections_[i].size;
+        table[i].count = sections_[i].size / sections_[i].elementSize;
+        offset = alignUp(offset + sections_[i].size);
+    }
+
+    std::string temp = path + ".tmp";
+    std::FILE* f = std::fopen(temp.c_str(), "wb");
+    if (f == nullptr) return false;
+
+    static const char zeros[kAlignment] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok && !table.empty()) {
+        ok = std::fwrite(table.data(), sizeof(SceneCacheSection), table.size(), f) == table.size();
+    }
+    uint64_t written = sizeof(header) + table.size() * sizeof(SceneCacheSection);
+    for (size_t i = 0; ok && i < sections_.size(); ++i) {
+        uint64_t pad = table[i].offset - written;
+        if (pad > 0) ok = std::fwrite(zeros, 1, size_t(pad), f) == pad;
+        if (ok && sections_[i].size > 0) ok = std::fwrite(sections_[i].data, 1, sections_[i].size, f) == sections_[i].size;
+        written = table[i].offset + sections_[i].size;
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) {
+        std::remove(temp.c_str());
+        return false;
+    }
+
+    // Windows 上 rename 不覆盖已有文件
+    std::remove(path.c_str());
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool SceneCache::open(const std::string& path, uint64_t sourceHash, uint64_t sourceSize) {
+    close();
+    if (!file_.open(path) || file_.size() < sizeof(SceneCacheHeader)) {
+        file_.close();
+        return false;
+    }
+
+    const SceneCacheHeader* header = reinterpret_cast<const SceneCacheHeader*>(file_.data());
+    bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+        header->formatVersion == kSceneCacheFormatVersion &&
+        header->byteOrder == kByteOrder &&
+        header->generatorVersion == kSceneGeneratorVersion &&
+        header->sourceHash == sourceHash &&
+        header->sourceSize == sourceSize;
+
+    uint64_t fileSize = file_.size();
+    uint64_t tableEnd = sizeof(SceneCacheHeader) + uint64_t(header->sectionCount) * sizeof(SceneCacheSection);
+    if (valid && tableEnd > fileSize) valid = false;
+
+    const SceneCacheSection* sections = reinterpret_cast<const SceneCacheSection*>(file_.data() + sizeof(SceneCacheHeader));
+    for (uint32_t i = 0; valid && i < header->sectionCount; ++i) {
+        const SceneCacheSection& s = sections[i];
+        if (s.offset % kAlignment != 0 || s.offset < tableEnd || s.offset > fileSize ||
+            s.size > fileSize - s.offset || s.elementSize == 0 || s.count > s.size / s.elementSize) {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        file_.close();
+        return false;
+    }
+
+    header_ = header;
+    sections_ = sections;
+    return true;
+}
+
+void SceneCache::close() {
+    header_ = nullptr;
+    sections_ = nullptr;
+    file_.close();
+}
+
+const SceneCacheSection* SceneCache::find(SceneSection type) const {
+    if (header_ == nullptr) return nullptr;
+    for (uint32_t i = 0; i < header_->sectionCount; ++i) {
+        if (sections_[i].type == static_cast<uint32_t>(type)) return &sections_[i];
+    }
+    return nullptr;
+}
+
+const void* SceneCache::section(SceneSection type, size_t* size, size_t* count) const {
+    const SceneCacheSection* s = find(type);
+    if (s == nullptr) return nullptr;
+    if (size) *size = size_t(s->size);
+    if (count) *count = size_t(s->count);
+    return file_.data() + s->offset;
+}
+
+bool SceneCache::loadAtomTable(AtomTable& out) const {
+    out.clear();
+    size_t n = 0;
+    if (sectionAs<float>(SceneSection::AtomX, &n) == nullptr) return false;
+
+    size_t residueCount = 0;
+    size_t chainCount = 0;
+    if (sectionAs<Residue>(SceneSection::Residues, &residueCount) == nullptr ||
+        sectionAs<Chain>(SceneSection::Chains, &chainCount) == nullptr) {
+        return false;
+    }
+
+    bool ok = copySection(*this, SceneSection::AtomX, n, out.x) &&
+        copySection(*this, SceneSection::AtomY, n, out.y) &&
+        copySection(*this, SceneSection::AtomZ, n, out.z) &&
+        copySection(*this, SceneSection::AtomElement, n, out.element) &&
+        copySection(*this, SceneSection::AtomName, n, out.name) &&
+        copySection(*this, SceneSection::AtomFlags, n, out.flags) &&
+        copySection(*this, SceneSection::AtomResidue, n, out.residueIndex) &&
+        copySection(*this, SceneSection::AtomChain, n, out.chainIndex) &&
+        copySection(*this, SceneSection::Residues, residueCount, out.residues) &&
+        copySection(*this, SceneSection::Chains, chainCount, out.chains);
+    if (!ok) out.clear();
+    return ok;
+}
+
+bool SceneCache::uploadSection(SceneSection type, unsigned int target, unsigned int buffer, unsigned int usage) const {
+    size_t size = 0;
+    const void* data = section(type, &size);
+    if (data == nullptr) return false;
+    glBindBuffer(GLenum(target), GLuint(buffer));
+    glBufferData(GLenum(target), GLsizeiptr(size), data, GLenum(usage));
+    return true;
+}
@@ -0,0 +1,112 @@
+﻿// Shader v 1.0
+#include <glad/glad.h>
+#include "Shader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+    bool readText(const std::string& path, std::string& out) {
+        MappedFile file;
+        if (!file.open(path)) return false;
+        out.assign(file.data(), file.size());
+        return true;
+    }
+}
+
+bool Shader::compile(unsigned int type, const std::string& source, unsigned int& shader) {
+    shader = glCreateShader(GLenum(type));
+    const char* text = source.c_str();
+    GLint length = GLint(source.size());
+    glShaderSource(shader, 1, &text, &length);
+    glCompileShader(shader);
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (ok == GL_TRUE) return true;
+    GLint logLength = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+    std::string log(size_t(std::max(logLength, 1)), '\0');
+    glGetShaderInfoLog(shader, GLsizei(log.size()), nullptr, &log[0]);
+    error_ = (type == GL_VERTEX_SHADER ? "vertex shader: " : "fragment shader: ") + log;
+    glDeleteShader(shader);
+    shader = 0;
+    return false;
+}
+
+bool Shader::loadSources(const std::string& vertexSource, const std::string& fragmentSource) {
+    error_.clear();
+    GLuint vs = 0;
+    GLuint fs = 0;
+    if (!compile(GL_VERTEX_SHADER, vertexSource, vs)) return false;
+    if (!compile(GL_FRAGMENT_SHADER, fragmentSource, fs)) {
+        glDeleteShader(vs);
+        return false;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (ok != GL_TRUE) {
+        GLint logLength = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+        std::string log(size_t(std::max(logLength, 1)), '\0');
+        glGetProgramInfoLog(program, GLsizei(log.size()), nullptr, &log[0]);
+        error_ = "link: " + log;
+        glDeleteProgram(program);
+        return false;
+    }
+    destroy();
+    program_ = program;
+    return true;
+}
+
+bool Shader::loadFiles(const std::string& vertexPath, const std::string& fragmentPath) {
+    std::string vertexSource;
+    std::string fragmentSource;
+    if (!readText(vertexPath, vertexSource)) {
+        error_ = "cannot read " + vertexPath;
+        return false;
+    }
+    if (!readText(fragmentPath, fragmentSource)) {
+        error_ = "cannot read " + fragmentPath;
+        return false;
+    }
+    return loadSources(vertexSource, fragmentSource);
+}
+
+void Shader::destroy() {
+    if (program_ != 0) glDeleteProgram(program_);
+    program_ = 0;
+}
+
+void Shader::use() const {
+    glUseProgram(program_);
+}
+
+int Shader::uniform(const char* name) const {
+    return program_ != 0 ? glGetUniformLocation(program_, name) : -1;
+}
+
+void Shader::setInt(const char* name, int value) const {
+    int location = uniform(name);
+    if (location >= 0) glUniform1i(location, value);
+}
+
+void Shader::setFloat(const char* name, float value) const {
+    int location = uniform(name);
+    if (location >= 0) glUniform1f(location, value);
+}
+
+void Shader::setVec3(const char* name, const glm::vec3& value) const {
+    int location = uniform(name);
+    if (location >= 0) glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void Shader::setMat4(const char* name, const glm::mat4& value) const {
+    int location = uniform(name);
+    if (location >= 0) glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
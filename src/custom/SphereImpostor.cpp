@@ -0,0 +1,172 @@
+﻿// SphereImpostor v 1.3
+#include <glad/glad.h>
+#include "SphereImpostor.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    // 四边形的四个角，按 GL_TRIANGLE_STRIP 顺序
+    const float kQuadCorners[8] = {
+        -1.0f, -1.0f,
+        1.0f, -1.0f,
+        -1.0f, 1.0f,
+        1.0f, 1.0f
+    };
+
+    const GLuint kCornerAttrib = 0;
+    const GLuint kSphereAttrib = 1;     // vec4：xyz 球心，w 半径
+    const GLuint kColorAttrib = 2;      // vec4：RGBA8 归一化
+    const int kPositionUnit = 0;
+    const int kColorUnit = 1;
+    const int kBlockUnit = 2;
+    const int kOffsetUnit = 3;
+
+    // 逐实例属性从第 first 个实例读起（GL 3.3 没有 baseInstance，按段改属性的起始偏移）
+    void setInstanceAttribs(size_t first) {
+        const size_t base = first * sizeof(SphereInstance);
+        glVertexAttribPointer(kSphereAttrib, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+            reinterpret_cast<const void*>(base + offsetof(SphereInstance, x)));
+        glVertexAttribPointer(kColorAttrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SphereInstance),
+            reinterpret_cast<const void*>(base + offsetof(SphereInstance, color)));
+    }
+}
+
+void SphereImpostor::setInstances(const SphereInstance* instances, size_t count, const RenderAnchor& anchor) {
+    instances_.assign(instances, instances + count);
+    batches_.assign(1, SphereBatch());
+    batches_[0].count = uint32_t(count);
+    batches_[0].anchor = anchor;
+    instancesDirty_ = true;
+}
+
+void SphereImpostor::setInstances(const std::vector<SphereInstance>& instances, const std::vector<SphereBatch>& batches) {
+    instances_ = instances;
+    batches_ = batches;
+    instancesDirty_ = true;
+}
+
+size_t SphereImpostor::sphereCount() const {
+    if (atoms_) return atoms_->atomCount();
+    size_t count = 0;
+    for (const SphereBatch& b : batches_) count += b.count;
+    return count;
+}
+
+bool SphereImpostor::createGL(const std::string& vertexPath, const std::string& fragmentPath) {
+    error_.clear();
+    if (!shader_.loadFiles(vertexPath, fragmentPath)) {
+        error_ = shader_.lastError();
+        return false;
+    }
+    destroyGL();
+
+    glGenVertexArrays(1, &vao_);
+    glGenVertexArrays(1, &atomVao_);
+    glGenBuffers(1, &quadBuffer_);
+    glGenBuffers(1, &instanceBuffer_);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kQuadCorners), kQuadCorners, GL_STATIC_DRAW);
+
+    // 画原子的 VAO 不启用逐实例属性：实例缓冲可能是空的或比原子数短，启用的话按原子数实例化会越界读取。
+    // 禁用的属性读常量值，着色器在 uFromAtoms 时也不用它们
+    glBindVertexArray(atomVao_);
+    glEnableVertexAttribArray(kCornerAttrib);
+    glVertexAttribPointer(kCornerAttrib, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glDisableVertexAttribArray(kSphereAttrib);
+    glDisableVertexAttribArray(kColorAttrib);
+    glVertexAttrib4f(kSphereAttrib, 0.0f, 0.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(kColorAttrib, 1.0f, 1.0f, 1.0f, 1.0f);
+
+    glBindVertexArray(vao_);
+    glEnableVertexAttribArray(kCornerAttrib);
+    glVertexAttribPointer(kCornerAttrib, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+
+    // 自有实例的属性每个实例前进一次，只在实例数 = uploadedCount_ 时使用
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+    glEnableVertexAttribArray(kSphereAttrib);
+    glVertexAttribDivisor(kSphereAttrib, 1);
+    glEnableVertexAttribArray(kColorAttrib);
+    glVertexAttribDivisor(kColorAttrib, 1);
+    setInstanceAttribs(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shader_.use();
+    shader_.setInt("uPositions", kPositionUnit);
+    shader_.setInt("uColors", kColorUnit);
+    shader_.setInt("uAtomBlocks", kBlockUnit);
+    shader_.setInt("uBlockOffsets", kOffsetUnit);
+    glUseProgram(0);
+    capacity_ = 0;
+    uploadedCount_ = 0;
+    instancesDirty_ = true;
+    return true;
+}
+
+void SphereImpostor::destroyGL() {
+    if (instanceBuffer_ != 0) glDeleteBuffers(1, &instanceBuffer_);
+    if (quadBuffer_ != 0) glDeleteBuffers(1, &quadBuffer_);
+    if (vao_ != 0) glDeleteVertexArrays(1, &vao_);
+    if (atomVao_ != 0) glDeleteVertexArrays(1, &atomVao_);
+    instanceBuffer_ = 0;
+    atomVao_ = 0;
+    quadBuffer_ = 0;
+    vao_ = 0;
+    capacity_ = 0;
+    uploadedCount_ = 0;
+}
+
+void SphereImpostor::upload() {
+    auto t0 = std::chrono::steady_clock::now();
+    uploadBytes_ = 0;
+    if (instanceBuffer_ == 0 || !instancesDirty_) return;
+    size_t n = instances_.size();
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+    if (n > capacity_) {
+        capacity_ = n;
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(capacity_ * sizeof(SphereInstance)), instances_.data(),
+            GL_DYNAMIC_DRAW);
+    }
+    else if (n > 0) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(n * sizeof(SphereInstance)), instances_.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploadBytes_ = n * sizeof(SphereInstance);
+    uploadedCount_ = n;
+    instancesDirty_ = false;
+    uploadMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void SphereImpostor::draw(const Camera& camera, const glm::mat4& projection) const {
+    if (vao_ == 0 || !shader_.isValid()) return;
+    shader_.use();
+    shader_.setMat4("uProjection", projection);
+    shader_.setFloat("uRadiusScale", radiusScale_);
+    shader_.setInt("uFromAtoms", atoms_ != nullptr ? 1 : 0);
+    if (atoms_ != nullptr) {
+        if (!atoms_->isReady() || atoms_->atomCount() == 0) return;
+        // 原子坐标加上块偏移后相对渲染原点
+        shader_.setMat4("uModelView", camera.getRenderView());
+        atoms_->bind(kPositionUnit, kColorUnit);
+        atoms_->bindBlocks(kBlockUnit, kOffsetUnit);
+        glBindVertexArray(atomVao_);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(atoms_->atomCount()));
+        glBindVertexArray(0);
+        return;
+    }
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+    for (const SphereBatch& b : batches_) {
+        // 只画已上传的部分
+        const size_t first = std::min<size_t>(b.first, uploadedCount_);
+        const size_t count = std::min<size_t>(b.count, uploadedCount_ - first);
+        if (count == 0) continue;
+        shader_.setMat4("uModelView", b.anchor.modelView(camera));
+        setInstanceAttribs(first);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(count));
+    }
+    setInstanceAttribs(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,314 @@
+﻿// StructureLod v 1.2
+#include "StructureLod.h"
+#include "Element.h"
+#include "MolecularSurface.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    // 原子表示的典型直径（埃），只用于估计投影大小
+    const float kAtomDiameter = 3.0f;
+    // 均匀实心球的回转半径为 sqrt(3/5) R，链球按同样回转半径的实心球取半径
+    const double kBlobRadiusScale = 1.2909944;
+
+    uint32_t averageColor(const double sum[4], double count) {
+        uint32_t color = 0;
+        for (int k = 0; k < 4; ++k) {
+            double c = count > 0.0 ? sum[k] / count : 255.0;
+            color |= uint32_t(std::min(255.0, std::max(0.0, c + 0.5))) << (8 * k);
+        }
+        return color;
+    }
+
+    void accumulateColor(uint32_t color, double sum[4]) {
+        for (int k = 0; k < 4; ++k) sum[k] += double((color >> (8 * k)) & 0xFF);
+    }
+
+    LodLevel coarser(LodLevel level) {
+        return level == LodLevel::Blob ? LodLevel::Blob : LodLevel(uint8_t(level) + 1);
+    }
+}
+
+void StructureLod::build(const AtomTable& atoms) {
+    auto t0 = std::chrono::steady_clock::now();
+    const size_t residueCount = atoms.residues.size();
+    const size_t chainCount = atoms.chains.size();
+    // 锚点取原子包围盒的中心，链的锚点取链的质心；质心在双精度下算好再减去锚点。
+    // 先算链（残基球要减去所在链的锚点），残基球的平均直径最后补上
+    float lo[3], hi[3];
+    atomBounds(atoms, lo, hi);
+    anchor_.setWorld(0.5 * (glm::dvec3(lo[0], lo[1], lo[2]) + glm::dvec3(hi[0], hi[1], hi[2])));
+    const double anchor[3] = { anchor_.world.x, anchor_.world.y, anchor_.world.z };
+    float radius[256];
+    uint32_t color[256];
+    for (int e = 0; e < 256; ++e) {
+        radius[e] = vdwRadius(uint8_t(e));
+        color[e] = elementColor(uint8_t(e));
+    }
+
+    chains_.assign(chainCount, ChainInfo());
+    chainAnchors_.assign(chainCount, anchor_);
+    chainBlobs_.resize(chainCount);
+    chainBounds_.resize(chainCount);
+    parallelFor(0, chainCount, [&](size_t b0, size_t b1) {
+        for (size_t c = b0; c < b1; ++c) {
+            const Chain& chain = atoms.chains[c];
+            ChainInfo& info = chains_[c];
+            SphereInstance& blob = chainBlobs_[c];
+            info.firstResidue = chain.firstResidue;
+            info.residueCount = chain.residueCount;
+            blob = SphereInstance{ 0.0f, 0.0f, 0.0f, 0.0f, 0xFFFFFFFFu };
+            chainBounds_.setSphere(c, info.center, 0.0f);
+            if (chain.residueCount == 0) continue;
+            const Residue& first = atoms.residues[chain.firstResidue];
+            const Residue& last = atoms.residues[chain.firstResidue + chain.residueCount - 1];
+            info.firstAtom = first.firstAtom;
+            info.atomCount = last.firstAtom + last.atomCount - first.firstAtom;
+            const size_t end = size_t(info.firstAtom) + info.atomCount;
+
+            double center[3] = { 0.0, 0.0, 0.0 };
+            double vdw = 0.0;
+            double rgba[4] = { 0.0, 0.0, 0.0, 0.0 };
+            for (size_t a = info.firstAtom; a < end; ++a) {
+                center[0] += atoms.x[a];
+                center[1] += atoms.y[a];
+                center[2] += atoms.z[a];
+                vdw += radius[atoms.element[a]];
+                accumulateColor(color[atoms.element[a]], rgba);
+            }
+            const double n = double(std::max<uint32_t>(info.atomCount, 1));
+            for (int d = 0; d < 3; ++d) center[d] /= n;
+            double rg2 = 0.0;
+            double bound = 0.0;
+            for (size_t a = info.firstAtom; a < end; ++a) {
+                double dx = atoms.x[a] - center[0];
+                double dy = atoms.y[a] - center[1];
+                double dz = atoms.z[a] - center[2];
+                double d2 = dx * dx + dy * dy + dz * dz;
+                rg2 += d2;
+                bound = std::max(bound, std::sqrt(d2) + radius[atoms.element[a]]);
+            }
+            chainAnchors_[c].setWorld(glm::dvec3(center[0], center[1], center[2]));
+            for (int d = 0; d < 3; ++d) info.center[d] = float(center[d] - anchor[d]);
+            info.radius = float(bound);
+            blob.x = info.center[0];
+            blob.y = info.center[1];
+            blob.z = info.center[2];
+            blob.radius = float(kBlobRadiusScale * std::sqrt(rg2 / n) + vdw / n);
+            blob.color = averageColor(rgba, n);
+            chainBounds_.setSphere(c, info.center, info.radius);
+        }
+    }, 16);
+
+    residueSpheres_.resize(residueCount);
+    parallelFor(0, residueCount, [&](size_t b0, size_t b1) {
+        for (size_t r = b0; r < b1; ++r) {
+            const Residue& res = atoms.residues[r];
+            SphereInstance& s = residueSpheres_[r];
+            double c[3] = { 0.0, 0.0, 0.0 };
+            double vdw = 0.0;
+            double rgba[4] = { 0.0, 0.0, 0.0, 0.0 };
+            const size_t end = size_t(res.firstAtom) + res.atomCount;
+            for (size_t a = res.firstAtom; a < end; ++a) {
+                c[0] += atoms.x[a];
+                c[1] += atoms.y[a];
+                c[2] += atoms.z[a];
+                vdw += radius[atoms.element[a]];
+                accumulateColor(color[atoms.element[a]], rgba);
+            }
+            const double n = double(res.atomCount);
+            if (n > 0.0) {
+                for (int d = 0; d < 3; ++d) c[d] /= n;
+            }
+            double rg2 = 0.0;
+            for (size_t a = res.firstAtom; a < end; ++a) {
+                double dx = atoms.x[a] - c[0];
+                double dy = atoms.y[a] - c[1];
+                double dz = atoms.z[a] - c[2];
+                rg2 += dx * dx + dy * dy + dz * dz;
+            }
+            const glm::dvec3& origin = res.chain >= 0 ? chainAnchors_[size_t(res.chain)].world : anchor_.world;
+            s.x = float(c[0] - origin.x);
+            s.y = float(c[1] - origin.y);
+            s.z = float(c[2] - origin.z);
+            s.radius = n > 0.0 ? float(std::sqrt(rg2 / n) + vdw / n) : 0.0f;
+            s.color = averageColor(rgba, n);
+        }
+    }, 1024);
+
+    for (size_t c = 0; c < chainCount; ++c) {
+        ChainInfo& info = chains_[c];
+        if (info.residueCount == 0) continue;
+        double diameter = 0.0;
+        for (uint32_t r = 0; r < info.residueCount; ++r) diameter += 2.0 * residueSpheres_[info.firstResidue + r].radius;
+        info.residueDiameter = float(diameter / info.residueCount);
+    }
+
+    // 链多时按链并行（表面与简化内部的并行自动退化为串行），链少时逐条生成，用表面与简化内部的并行
+    surfaces_.assign(chainCount, MeshLod());
+    if (buildSurfaces_) {
+        auto buildSurface = [&](size_t c) {
+            const ChainInfo& info = chains_[c];
+            if (info.residueCount == 0) return;
+            std::vector<float> x(info.residueCount), y(info.residueCount), z(info.residueCount), r(info.residueCount);
+            for (uint32_t i = 0; i < info.residueCount; ++i) {
+                const SphereInstance& s = residueSpheres_[info.firstResidue + i];
+                x[i] = s.x;
+                y[i] = s.y;
+                z[i] = s.z;
+                r[i] = s.radius;
+            }
+            MolecularSurface surface;
+            surface.setSpacing(surfaceSpacing_);
+            Mesh mesh;
+            surface.build(x.data(), y.data(), z.data(), r.data(), info.residueCount, SurfaceKind::GaussianDensity, mesh);
+            for (uint32_t& id : mesh.atomIds) id += info.firstResidue;
+            MeshSimplifier simplifier;
+            simplifier.build(std::move(mesh), surfaces_[c]);
+        };
+        if (chainCount >= 4 * size_t(workerCount())) {
+            ThreadPool::instance().run(chainCount, buildSurface);
+        } else {
+            for (size_t c = 0; c < chainCount; ++c) buildSurface(c);
+        }
+    }
+
+    selection_.assign(chainCount, Selection());
+    for (std::vector<uint32_t>& list : visible_) list.clear();
+    primitives_ = 0;
+    buildMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+size_t StructureLod::primitiveCount(size_t chain, const Selection& s) const {
+    switch (s.level) {
+    case LodLevel::Atoms:
+        return chains_[chain].atomCount;
+    case LodLevel::Residues:
+        return chains_[chain].residueCount;
+    case LodLevel::Surface:
+        return surfaces_[chain].levels[s.surfaceLevel].triangleCount();
+    default:
+        return 1;
+    }
+}
+
+void StructureLod::select(const Camera& camera, float fovY, float viewportHeight, FrustumCuller* culler,
+    OcclusionCuller* occlusion) {
+    auto t0 = std::chrono::steady_clock::now();
+    const size_t chainCount = chains_.size();
+    const glm::vec3 eye = anchor_.eye(camera);
+    const float pixelsAtUnit = viewportHeight / (2.0f * std::tan(0.5f * fovY));
+    const float relaxed = 1.0f - hysteresis_;
+
+    for (Selection& s : selection_) s.visible = culler == nullptr;
+    if (culler) {
+        inFrustum_.clear();
+        culler->cull(chainBounds_, inFrustum_);
+        for (uint32_t c : inFrustum_) selection_[c].visible = true;
+    }
+    if (occlusion) {
+        if (!culler) {
+            inFrustum_.resize(chainCount);
+            for (size_t c = 0; c < chainCount; ++c) inFrustum_[c] = uint32_t(c);
+        }
+        unoccluded_.clear();
+        occlusion->cull(chainBounds_, inFrustum_, unoccluded_);
+        for (uint32_t c : inFrustum_) selection_[c].visible = false;
+        for (uint32_t c : unoccluded_) selection_[c].visible = true;
+    }
+
+    parallelFor(0, chainCount, [&](size_t b0, size_t b1) {
+        for (size_t c = b0; c < b1; ++c) {
+            const ChainInfo& info = chains_[c];
+            Selection& s = selection_[c];
+            const LodLevel previous = s.level;
+            glm::vec3 center(info.center[0], info.center[1], info.center[2]);
+            // 到包围球最近处的距离；相机在球内时按很近处理，取最细的表示
+            float distance = std::max(glm::length(center - eye) - info.radius, 1e-3f);
+            float scale = pixelsAtUnit / distance;
+            // 当前用的是 level 或更细的表示时阈值放宽，避免在阈值附近来回切换
+            auto fits = [&](LodLevel level, float size, float threshold) {
+                return size * scale >= (previous <= level ? threshold * relaxed : threshold);
+            };
+            s.pixels = 2.0f * info.radius * scale;
+            s.surfaceLevel = 0;
+            if (fits(LodLevel::Atoms, kAtomDiameter, atomPixels_)) {
+                s.level = LodLevel::Atoms;
+            } else if (fits(LodLevel::Residues, info.residueDiameter, residuePixels_)) {
+                s.level = LodLevel::Residues;
+            } else if (!surfaces_[c].levels.empty() && fits(LodLevel::Surface, 2.0f * info.radius, blobPixels_)) {
+                s.level = LodLevel::Surface;
+                s.surfaceLevel = uint32_t(surfaces_[c].selectLevel(chainAnchors_[c].modelView(camera), fovY,
+                    viewportHeight, surfacePixelError_));
+            } else {
+                s.level = LodLevel::Blob;
+            }
+        }
+    }, 256);
+
+    // 视锥外的链照常更新表示（回到视野时滞回状态连续），只是不计数
+    size_t total = 0;
+    for (size_t c = 0; c < chainCount; ++c) {
+        if (selection_[c].visible) total += primitiveCount(c, selection_[c]);
+    }
+
+    // 超出预算：按投影从小到大，每轮每条链变粗一级（表面先换更粗的简化级），直到回到预算以内
+    if (total > maxPrimitives_) {
+        std::vector<uint32_t> order;
+        for (size_t c = 0; c < chainCount; ++c) {
+            if (selection_[c].visible) order.push_back(uint32_t(c));
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return selection_[a].pixels < selection_[b].pixels;
+        });
+        bool changed = true;
+        while (total > maxPrimitives_ && changed) {
+            changed = false;
+            for (uint32_t c : order) {
+                if (total <= maxPrimitives_) break;
+                Selection& s = selection_[c];
+                const MeshLod& lod = surfaces_[c];
+                size_t before = primitiveCount(c, s);
+                if (s.level == LodLevel::Surface && s.surfaceLevel + 1 < lod.levels.size()) {
+                    ++s.surfaceLevel;
+                } else if (s.level != LodLevel::Blob) {
+                    s.level = coarser(s.level);
+                    if (s.level == LodLevel::Surface) {
+                        // 表面的三角形可能比残基球多，取不多于原来图元数的简化级，没有就直接用链球
+                        s.surfaceLevel = 0;
+                        if (!lod.levels.empty()) {
+                            s.surfaceLevel = uint32_t(lod.selectLevel(chainAnchors_[c].modelView(camera), fovY,
+                                viewportHeight, surfacePixelError_));
+                            while (s.surfaceLevel + 1 < lod.levels.size() && primitiveCount(c, s) > before) ++s.surfaceLevel;
+                        }
+                        if (lod.levels.empty() || primitiveCount(c, s) > before) s.level = LodLevel::Blob;
+                    }
+                } else {
+                    continue;
+                }
+                total = total - before + primitiveCount(c, s);
+                changed = true;
+            }
+        }
+    }
+
+    for (std::vector<uint32_t>& list : visible_) list.clear();
+    for (size_t c = 0; c < chainCount; ++c) {
+        if (selection_[c].visible) visible_[size_t(selection_[c].level)].push_back(uint32_t(c));
+    }
+    primitives_ = total;
+    selectMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+void StructureLod::residueBatches(std::vector<SphereBatch>& batches) const {
+    batches.clear();
+    for (uint32_t c : visible_[size_t(LodLevel::Residues)]) {
+        SphereBatch batch;
+        batch.first = chains_[c].firstResidue;
+        batch.count = chains_[c].residueCount;
+        batch.anchor = chainAnchors_[c];
+        batches.push_back(batch);
+    }
+}
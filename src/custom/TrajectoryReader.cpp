@@ -0,0 +1,25 @@
+﻿// TrajectoryReader v 1.0
+#include "TrajectoryReader.h"
+#include "Parallel.h"
+#include <atomic>
+
+bool TrajectoryReader::readFrame(size_t index, TrajectoryFrame& out) const {
+    uint64_t offset = 0;
+    size_t size = 0;
+    if (!frameExtent(index, offset, size)) return false;
+
+    // 每个线程复用自己的读缓冲
+    thread_local std::vector<uint8_t> buffer;
+    if (buffer.size() < size) buffer.resize(size);
+    if (!file_.readAt(offset, buffer.data(), size)) return false;
+    return decodeFrame(index, buffer.data(), size, out);
+}
+
+bool TrajectoryReader::readFrames(size_t first, size_t count, TrajectoryFrame* out) const {
+    if (first > frameCount() || count > frameCount() - first) return false;
+    std::atomic<bool> ok{ true };
+    ThreadPool::instance().run(count, [&](size_t i) {
+        if (!readFrame(first + i, out[i])) ok = false;
+    });
+    return ok;
+}
@@ -0,0 +1,155 @@
+﻿// TrrReader v 1.0
+#include "TrrReader.h"
+#include <cstring>
+
+namespace {
+    const int32_t kTrrMagic = 1993;
+    const float kNmToAngstrom = 10.0f;
+    // 帧头最长：magic、版本字符串、13 个整数、两个 double
+    const size_t kMaxHeader = 4 + 4 + 4 + 12 + 13 * 4 + 16;
+
+    inline int32_t readInt(const uint8_t* p) {
+        return int32_t((uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]);
+    }
+
+    inline float readFloat(const uint8_t* p) {
+        uint32_t bits = uint32_t(readInt(p));
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return f;
+    }
+
+    inline double readDouble(const uint8_t* p) {
+        uint64_t bits = (uint64_t(uint32_t(readInt(p))) << 32) | uint32_t(readInt(p + 4));
+        double d;
+        std::memcpy(&d, &bits, 8);
+        return d;
+    }
+
+    inline float readReal(const uint8_t* p, size_t real) {
+        return real == 8 ? float(readDouble(p)) : readFloat(p);
+    }
+
+    struct TrrHeader {
+        size_t headerSize = 0;
+        size_t real = 4;        // 4 单精度，8 双精度
+        uint64_t boxSize = 0;
+        uint64_t xOffset = 0;   // 坐标相对帧开头的偏移
+        uint64_t xSize = 0;
+        uint64_t frameSize = 0;
+        size_t atomCount = 0;
+        int64_t step = 0;
+        float time = 0.0f;
+    };
+
+    // 解析帧头，available 为 p 之后可读的字节数
+    bool parseHeader(const uint8_t* p, size_t available, TrrHeader& h) {
+        if (available < 24 || readInt(p) != kTrrMagic) return false;
+        uint32_t versionLength = uint32_t(readInt(p + 8));
+        size_t ints = 12 + ((size_t(versionLength) + 3) & ~size_t(3));
+        if (versionLength > 64 || ints + 13 * 4 > available) return false;
+
+        // ir e box vir pres top sym x v f natoms step nre
+        uint64_t sizes[10];
+        for (int k = 0; k < 10; ++k) {
+            int32_t v = readInt(p + ints + 4 * k);
+            if (v < 0) return false;
+            sizes[k] = uint64_t(v);
+        }
+        int32_t natoms = readInt(p + ints + 40);
+        if (natoms <= 0) return false;
+        h.atomCount = size_t(natoms);
+        h.step = readInt(p + ints + 44);
+
+        // 实数精度由盒子或坐标/速度/力数组的字节数推断
+        uint64_t n3 = 3 * uint64_t(natoms);
+        if (sizes[2] != 0) h.real = size_t(sizes[2] / 9);
+        else if (sizes[7] != 0) h.real = size_t(sizes[7] / n3);
+        else if (sizes[8] != 0) h.real = size_t(sizes[8] / n3);
+        else if (sizes[9] != 0) h.real = size_t(sizes[9] / n3);
+        if (h.real != 4 && h.real != 8) return false;
+
+        h.headerSize = ints + 13 * 4 + 2 * h.real;
+        if (h.headerSize > available) return false;
+        h.time = readReal(p + ints + 13 * 4, h.real);
+
+        uint64_t data = 0;
+        for (int k = 0; k < 10; ++k) data += sizes[k];
+        h.boxSize = sizes[2];
+        // 数据顺序：box vir pres x v f
+        h.xOffset = h.headerSize + sizes[2] + sizes[3] + sizes[4];
+        h.xSize = sizes[7];
+        h.frameSize = h.headerSize + data;
+        if (h.xSize != 0 && h.xSize != n3 * h.real) return false;
+        return true;
+    }
+}
+
+bool TrrReader::open(const std::string& path) {
+    close();
+    error_.clear();
+    if (!file_.open(path)) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+
+    uint64_t fileSize = file_.size();
+    uint64_t offset = 0;
+    uint8_t header[kMaxHeader];
+    while (offset < fileSize) {
+        size_t available = size_t(fileSize - offset < kMaxHeader ? fileSize - offset : kMaxHeader);
+        TrrHeader h;
+        if (!file_.readAt(offset, header, available) || !parseHeader(header, available, h)) break;
+        // 末尾被截断的帧直接忽略
+        if (h.frameSize > fileSize - offset) break;
+        if (atomCount_ == 0) atomCount_ = h.atomCount;
+        else if (h.atomCount != atomCount_) break;
+        if (h.xSize != 0) frames_.push_back({ offset, h.xOffset + h.xSize });
+        offset += h.frameSize;
+    }
+    if (frames_.empty()) {
+        error_ = "no TRR frames with coordinates";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TrrReader::close() {
+    file_.close();
+    frames_.clear();
+    atomCount_ = 0;
+}
+
+bool TrrReader::frameExtent(size_t index, uint64_t& offset, size_t& size) const {
+    if (index >= frames_.size()) return false;
+    offset = frames_[index].offset;
+    size = size_t(frames_[index].size);
+    return true;
+}
+
+bool TrrReader::decodeFrame(size_t index, const uint8_t* data, size_t size, TrajectoryFrame& out) const {
+    TrrHeader h;
+    if (index >= frames_.size() || !parseHeader(data, size, h) || h.atomCount != atomCount_ ||
+        h.xSize == 0 || h.xOffset + h.xSize > size) {
+        return false;
+    }
+
+    std::memset(out.box, 0, sizeof(out.box));
+    if (h.boxSize == 9 * h.real) {
+        for (int k = 0; k < 9; ++k) out.box[k] = readReal(data + h.headerSize + k * h.real, h.real) * kNmToAngstrom;
+    }
+
+    out.resize(atomCount_);
+    const uint8_t* c = data + h.xOffset;
+    size_t stride = 3 * h.real;
+    for (size_t a = 0; a < atomCount_; ++a, c += stride) {
+        out.x[a] = readReal(c, h.real) * kNmToAngstrom;
+        out.y[a] = readReal(c + h.real, h.real) * kNmToAngstrom;
+        out.z[a] = readReal(c + 2 * h.real, h.real) * kNmToAngstrom;
+    }
+    out.step = h.step;
+    out.time = h.time;
+    out.index = index;
+    return true;
+}
@@ -0,0 +1,136 @@
+﻿// VertexFormat v 1.1
+#include <glad/glad.h>
+#include "VertexFormat.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+    const float kSnorm16 = 32767.0f;
+
+    // 八面体展开：单位球投影到 |x| + |y| + |z| = 1，下半球沿对角线翻折到正方形的四角
+    glm::vec2 octahedralWrap(const glm::vec3& n) {
+        float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        if (sum <= 0.0f) return glm::vec2(0.0f, 0.0f);
+        glm::vec2 p(n.x / sum, n.y / sum);
+        if (n.z < 0.0f) {
+            glm::vec2 folded((1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+            p = folded;
+        }
+        return p;
+    }
+
+    glm::vec3 octahedralUnwrap(const glm::vec2& e) {
+        glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+        float t = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+}
+
+uint32_t encodeOctahedral(const glm::vec3& normal) {
+    glm::vec2 p = octahedralWrap(normal);
+    // 四舍五入不一定最准：在包围的四个格点里选解码后与原法线夹角最小的
+    float fx = std::floor(p.x * kSnorm16);
+    float fy = std::floor(p.y * kSnorm16);
+    glm::vec2 best(0.0f);
+    float bestDot = -2.0f;
+    for (int i = 0; i < 4; ++i) {
+        glm::vec2 q(std::min(fx + float(i & 1), kSnorm16) / kSnorm16,
+            std::min(fy + float(i >> 1), kSnorm16) / kSnorm16);
+        float d = glm::dot(octahedralUnwrap(q), normal);
+        if (d > bestDot) {
+            bestDot = d;
+            best = q;
+        }
+    }
+    return glm::packSnorm2x16(best);
+}
+
+glm::vec3 decodeOctahedral(uint32_t packed) {
+    return octahedralUnwrap(glm::unpackSnorm2x16(packed));
+}
+
+void packMesh(const Mesh& mesh, PackedMesh& out) {
+    const size_t vertexCount = mesh.vertexCount();
+    out.vertices.resize(vertexCount);
+    out.indices = mesh.indices;
+    for (int d = 0; d < 3; ++d) {
+        out.origin[d] = 0.0f;
+        out.extent[d] = 0.0f;
+    }
+    if (vertexCount == 0) return;
+
+    float lo[3] = { mesh.positions[0], mesh.positions[1], mesh.positions[2] };
+    float hi[3] = { lo[0], lo[1], lo[2] };
+    for (size_t v = 1; v < vertexCount; ++v) {
+        for (int d = 0; d < 3; ++d) {
+            lo[d] = std::min(lo[d], mesh.positions[3 * v + d]);
+            hi[d] = std::max(hi[d], mesh.positions[3 * v + d]);
+        }
+    }
+    glm::vec3 origin(lo[0], lo[1], lo[2]);
+    glm::vec3 scale(0.0f);
+    for (int d = 0; d < 3; ++d) {
+        out.origin[d] = lo[d];
+        out.extent[d] = hi[d] - lo[d];
+        if (out.extent[d] > 0.0f) scale[d] = 1.0f / out.extent[d];
+    }
+
+    parallelFor(0, vertexCount, [&](size_t b0, size_t b1) {
+        for (size_t v = b0; v < b1; ++v) {
+            PackedVertex& pv = out.vertices[v];
+            glm::vec3 p(mesh.positions[3 * v], mesh.positions[3 * v + 1], mesh.positions[3 * v + 2]);
+            uint64_t position = glm::packUnorm4x16(glm::vec4((p - origin) * scale, 0.0f));
+            std::memcpy(pv.position, &position, sizeof(pv.position));
+            pv.reserved = 0;
+            pv.normal = encodeOctahedral(glm::vec3(mesh.normals[3 * v], mesh.normals[3 * v + 1], mesh.normals[3 * v + 2]));
+            pv.atomId = mesh.atomIds[v];
+        }
+    }, 4096);
+}
+
+glm::vec3 unpackPosition(const PackedMesh& packed, size_t vertex) {
+    uint64_t position = 0;
+    std::memcpy(&position, packed.vertices[vertex].position, sizeof(packed.vertices[vertex].position));
+    glm::vec4 u = glm::unpackUnorm4x16(position);
+    return glm::vec3(packed.origin[0] + u.x * packed.extent[0],
+        packed.origin[1] + u.y * packed.extent[1],
+        packed.origin[2] + u.z * packed.extent[2]);
+}
+
+void unpackMesh(const PackedMesh& packed, Mesh& out) {
+    const size_t vertexCount = packed.vertices.size();
+    out.resizeVertices(vertexCount);
+    out.indices = packed.indices;
+    parallelFor(0, vertexCount, [&](size_t b0, size_t b1) {
+        for (size_t v = b0; v < b1; ++v) {
+            glm::vec3 p = unpackPosition(packed, v);
+            glm::vec3 n = decodeOctahedral(packed.vertices[v].normal);
+            for (int d = 0; d < 3; ++d) {
+                out.positions[3 * v + d] = p[d];
+                out.normals[3 * v + d] = n[d];
+            }
+            out.atomIds[v] = packed.vertices[v].atomId;
+        }
+    }, 4096);
+}
+
+void setPackedVertexAttribs(unsigned int positionAttrib, unsigned int normalAttrib, unsigned int atomIdAttrib) {
+    const GLsizei stride = sizeof(PackedVertex);
+    glEnableVertexAttribArray(positionAttrib);
+    glVertexAttribPointer(positionAttrib, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+        reinterpret_cast<const void*>(offsetof(PackedVertex, position)));
+    glEnableVertexAttribArray(normalAttrib);
+    glVertexAttribPointer(normalAttrib, 2, GL_SHORT, GL_TRUE, stride,
+        reinterpret_cast<const void*>(offsetof(PackedVertex, normal)));
+    // 原子下标按整数读取
+    glEnableVertexAttribArray(atomIdAttrib);
+    glVertexAttribIPointer(atomIdAttrib, 1, GL_UNSIGNED_INT, stride,
+        reinterpret_cast<const void*>(offsetof(PackedVertex, atomId)));
+}
@@ -0,0 +1,384 @@
+﻿// XtcReader v 1.0
+#include "XtcReader.h"
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const int32_t kXtcMagic = 1995;
+    // 帧头：magic natoms step time box[9] natoms
+    const size_t kFrameHeader = 56;
+    // 压缩帧还有 precision minint[3] maxint[3] smallidx byteCount
+    const size_t kCompressedHeader = 92;
+    const float kNmToAngstrom = 10.0f;
+    const char kIndexMagic[8] = { 'T', 'H', 'C', 'X', 'T', 'C', 'I', 'X' };
+
+    const int kFirstIdx = 9;
+    const int kMagicInts[] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 10, 12, 16, 20, 25, 32, 40, 50, 64,
+        80, 101, 128, 161, 203, 256, 322, 406, 512, 645, 812, 1024, 1290,
+        1625, 2048, 2580, 3250, 4096, 5060, 6501, 8192, 10321, 13003,
+        16384, 20642, 26007, 32768, 41285, 52015, 65536, 82570, 104031,
+        131072, 165140, 208063, 262144, 330280, 416127, 524287, 660561,
+        832255, 1048576, 1321122, 1664510, 2097152, 2642245, 3329021,
+        4194304, 5284491, 6658042, 8388607, 10568983, 13316085, 16777216
+    };
+    const int kMagicCount = int(sizeof(kMagicInts) / sizeof(kMagicInts[0]));
+
+    inline int32_t readInt(const uint8_t* p) {
+        return int32_t((uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3]);
+    }
+
+    inline float readFloat(const uint8_t* p) {
+        uint32_t bits = uint32_t(readInt(p));
+        float f;
+        std::memcpy(&f, &bits, 4);
+        return f;
+    }
+
+    // 高位在前的位流读取，64 位缓冲一次补满，越界部分按 0 读
+    struct BitReader {
+        const uint8_t* p;
+        const uint8_t* end;
+        uint64_t acc = 0;
+        int bits = 0;
+
+        BitReader(const uint8_t* begin, const uint8_t* e) : p(begin), end(e) {
+        }
+
+        inline uint32_t read(int n) {
+            if (bits < n) {
+                while (bits <= 56) {
+                    acc = (acc << 8) | (p < end ? *p++ : 0u);
+                    bits += 8;
+                }
+            }
+            bits -= n;
+            return uint32_t((acc >> bits) & ((uint64_t(1) << n) - 1));
+        }
+    };
+
+    int sizeOfInt(unsigned size) {
+        unsigned num = 1;
+        int bits = 0;
+        while (size >= num && bits < 32) {
+            ++bits;
+            num <<= 1;
+        }
+        return bits;
+    }
+
+    // 三个范围之积所需的位数（与 xdrfile 的 sizeofints 逐字节算法一致）
+    int sizeOfInts(const unsigned sizes[3]) {
+        unsigned bytes[32] = { 1 };
+        int byteCount = 1;
+        for (int i = 0; i < 3; ++i) {
+            unsigned tmp = 0;
+            int b = 0;
+            for (; b < byteCount; ++b) {
+                tmp = bytes[b] * sizes[i] + tmp;
+                bytes[b] = tmp & 0xFF;
+                tmp >>= 8;
+            }
+            while (tmp != 0 && b < 32) {
+                bytes[b++] = tmp & 0xFF;
+                tmp >>= 8;
+            }
+            byteCount = b;
+        }
+        unsigned num = 1;
+        int bits = 0;
+        --byteCount;
+        while (bytes[byteCount] >= num) {
+            ++bits;
+            num *= 2;
+        }
+        return bits + byteCount * 8;
+    }
+
+    // 读取按混合进制打包的三个整数。位数不超过 64 时直接用整数除法，
+    // 否则退回逐字节长除法
+    inline void receiveInts(BitReader& br, int bitCount, const unsigned sizes[3], int nums[3]) {
+        if (bitCount <= 64) {
+            uint64_t v = 0;
+            int shift = 0;
+            while (bitCount > 8) {
+                v |= uint64_t(br.read(8)) << shift;
+                shift += 8;
+                bitCount -= 8;
+            }
+            if (bitCount > 0) v |= uint64_t(br.read(bitCount)) << shift;
+            nums[2] = int(v % sizes[2]);
+            v /= sizes[2];
+            nums[1] = int(v % sizes[1]);
+            nums[0] = int(v / sizes[1]);
+            return;
+        }
+
+        unsigned bytes[32] = {};
+        int byteCount = 0;
+        while (bitCount > 8) {
+            bytes[byteCount++] = br.read(8);
+            bitCount -= 8;
+        }
+        if (bitCount > 0) bytes[byteCount++] = br.read(bitCount);
+        for (int i = 2; i > 0; --i) {
+            unsigned num = 0;
+            for (int j = byteCount - 1; j >= 0; --j) {
+                num = (num << 8) | bytes[j];
+                unsigned q = num / sizes[i];
+                bytes[j] = q;
+                num -= q * sizes[i];
+            }
+            nums[i] = int(num);
+        }
+        nums[0] = int(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24));
+    }
+
+    // xdr3dfcoord 解压（frame 指向整帧，长度已确认不小于 kCompressedHeader + byteCount）
+    bool decodeCompressed(const uint8_t* frame, size_t frameSize, size_t atomCount, TrajectoryFrame& out) {
+        const uint8_t* h = frame + kFrameHeader;
+        float precision = readFloat(h);
+        int minInt[3], maxInt[3];
+        unsigned sizeInt[3];
+        int bitSizeInt[3] = {};
+        for (int k = 0; k < 3; ++k) {
+            minInt[k] = readInt(h + 4 + 4 * k);
+            maxInt[k] = readInt(h + 16 + 4 * k);
+            sizeInt[k] = unsigned(maxInt[k] - minInt[k]) + 1;
+        }
+        int bitSize = 0;
+        if ((sizeInt[0] | sizeInt[1] | sizeInt[2]) > 0xFFFFFF) {
+            for (int k = 0; k < 3; ++k) bitSizeInt[k] = sizeOfInt(sizeInt[k]);
+        }
+        else {
+            bitSize = sizeOfInts(sizeInt);
+        }
+
+        int smallIdx = readInt(h + 28);
+        size_t byteCount = size_t(uint32_t(readInt(h + 32)));
+        if (precision <= 0.0f || smallIdx < kFirstIdx || smallIdx >= kMagicCount ||
+            kCompressedHeader + byteCount > frameSize) {
+            return false;
+        }
+
+        int smaller = kMagicInts[smallIdx - 1 > kFirstIdx ? smallIdx - 1 : kFirstIdx] / 2;
+        int smallNum = kMagicInts[smallIdx] / 2;
+        unsigned sizeSmall[3];
+        sizeSmall[0] = sizeSmall[1] = sizeSmall[2] = unsigned(kMagicInts[smallIdx]);
+
+        const float scale = kNmToAngstrom / precision;
+        float* ox = out.x.data();
+        float* oy = out.y.data();
+        float* oz = out.z.data();
+        size_t o = 0;
+
+        BitReader br(h + 36, h + 36 + byteCount);
+        int run = 0;
+        size_t i = 0;
+        while (i < atomCount) {
+            int cur[3];
+            if (bitSize == 0) {
+                cur[0] = int(br.read(bitSizeInt[0]));
+                cur[1] = int(br.read(bitSizeInt[1]));
+                cur[2] = int(br.read(bitSizeInt[2]));
+            }
+            else {
+                receiveInts(br, bitSize, sizeInt, cur);
+            }
+            ++i;
+            int prev[3] = { cur[0] + minInt[0], cur[1] + minInt[1], cur[2] + minInt[2] };
+
+            int isSmaller = 0;
+            if (br.read(1) == 1) {
+                run = int(br.read(5));
+                isSmaller = run % 3;
+                run -= isSmaller;
+                --isSmaller;
+            }
+            if (run > 0) {
+                if (i + size_t(run / 3) > atomCount) return false;
+                for (int k = 0; k < run; k += 3) {
+                    receiveInts(br, smallIdx, sizeSmall, cur);
+                    ++i;
+                    cur[0] += prev[0] - smallNum;
+                    cur[1] += prev[1] - smallNum;
+                    cur[2] += prev[2] - smallNum;
+                    if (k == 0) {
+                        // 写入端为了压缩水分子交换了前两个原子，这里换回来
+                        ox[o] = float(cur[0]) * scale;
+                        oy[o] = float(cur[1]) * scale;
+                        oz[o] = float(cur[2]) * scale;
+                        ++o;
+                        std::swap(cur[0], prev[0]);
+                        std::swap(cur[1], prev[1]);
+                        std::swap(cur[2], prev[2]);
+                        // 交换后 prev 是刚解出的原子，cur 是大坐标原子
+                        ox[o] = float(cur[0]) * scale;
+                        oy[o] = float(cur[1]) * scale;
+                        oz[o] = float(cur[2]) * scale;
+                        ++o;
+                    }
+                    else {
+                        prev[0] = cur[0];
+                        prev[1] = cur[1];
+                        prev[2] = cur[2];
+                        ox[o] = float(cur[0]) * scale;
+                        oy[o] = float(cur[1]) * scale;
+                        oz[o] = float(cur[2]) * scale;
+                        ++o;
+                    }
+                }
+            }
+            else {
+                ox[o] = float(prev[0]) * scale;
+                oy[o] = float(prev[1]) * scale;
+                oz[o] = float(prev[2]) * scale;
+                ++o;
+            }
+
+            smallIdx += isSmaller;
+            if (smallIdx < kFirstIdx || smallIdx >= kMagicCount) return false;
+            if (isSmaller < 0) {
+                smallNum = smaller;
+                smaller = smallIdx > kFirstIdx ? kMagicInts[smallIdx - 1] / 2 : 0;
+            }
+            else if (isSmaller > 0) {
+                smaller = smallNum;
+                smallNum = kMagicInts[smallIdx] / 2;
+            }
+            sizeSmall[0] = sizeSmall[1] = sizeSmall[2] = unsigned(kMagicInts[smallIdx]);
+        }
+        return o == atomCount;
+    }
+
+    // 由帧头得到整帧长度，头部不完整或不合法时返回 0
+    uint64_t frameLength(const uint8_t* header, size_t available, size_t& atomCount) {
+        if (available < kFrameHeader || readInt(header) != kXtcMagic) return 0;
+        int32_t n = readInt(header + 4);
+        if (n <= 0 || readInt(header + 52) != n) return 0;
+        atomCount = size_t(n);
+        if (n <= 9) return kFrameHeader + 12 * uint64_t(n);
+        if (available < kCompressedHeader) return 0;
+        uint64_t bytes = uint32_t(readInt(header + 88));
+        return kCompressedHeader + ((bytes + 3) & ~uint64_t(3));
+    }
+}
+
+bool XtcReader::open(const std::string& path) {
+    close();
+    error_.clear();
+    if (!file_.open(path)) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    std::string indexPath = path + ".idx";
+    if (loadIndex(indexPath)) return true;
+    if (!buildIndex()) {
+        close();
+        return false;
+    }
+    saveIndex(indexPath);
+    return true;
+}
+
+void XtcReader::close() {
+    file_.close();
+    offsets_.clear();
+    atomCount_ = 0;
+}
+
+bool XtcReader::buildIndex() {
+    uint64_t fileSize = file_.size();
+    uint64_t offset = 0;
+    uint8_t header[kCompressedHeader];
+    while (offset < fileSize) {
+        size_t available = size_t(fileSize - offset < kCompressedHeader ? fileSize - offset : kCompressedHeader);
+        if (!file_.readAt(offset, header, available)) break;
+        size_t n = 0;
+        uint64_t length = frameLength(header, available, n);
+        // 末尾被截断的帧（模拟仍在写入）直接忽略
+        if (length == 0 || length > fileSize - offset) break;
+        if (offsets_.empty()) atomCount_ = n;
+        else if (n != atomCount_) break;
+        offsets_.push_back(offset);
+        offset += length;
+    }
+    if (offsets_.empty()) {
+        error_ = "no XTC frames";
+        return false;
+    }
+    offsets_.push_back(offset);
+    return true;
+}
+
+bool XtcReader::loadIndex(const std::string& path) {
+    RandomAccessFile index;
+    uint64_t head[3];
+    char magic[8];
+    if (!index.open(path) || !index.readAt(0, magic, 8) || std::memcmp(magic, kIndexMagic, 8) != 0 ||
+        !index.readAt(8, head, sizeof(head))) {
+        return false;
+    }
+    // head: 轨迹文件大小、原子数、帧数
+    uint64_t frames = head[2];
+    if (head[0] != file_.size() || frames == 0 || index.size() != 32 + (frames + 1) * 8) return false;
+
+    std::vector<uint64_t> offsets(size_t(frames + 1));
+    if (!index.readAt(32, offsets.data(), offsets.size() * 8) || offsets.back() > file_.size()) return false;
+
+    // 抽查第一帧的帧头，防止旁路文件与轨迹不匹配
+    uint8_t header[kCompressedHeader];
+    size_t available = size_t(offsets[1] - offsets[0] < kCompressedHeader ? offsets[1] - offsets[0] : kCompressedHeader);
+    size_t n = 0;
+    if (!file_.readAt(offsets[0], header, available) ||
+        frameLength(header, available, n) != offsets[1] - offsets[0] || n != head[1]) {
+        return false;
+    }
+    offsets_.swap(offsets);
+    atomCount_ = n;
+    return true;
+}
+
+void XtcReader::saveIndex(const std::string& path) const {
+    // 目录不可写时静默放弃，下次重新建立索引
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) return;
+    uint64_t head[3] = { file_.size(), uint64_t(atomCount_), uint64_t(frameCount()) };
+    bool ok = std::fwrite(kIndexMagic, 8, 1, f) == 1 &&
+        std::fwrite(head, sizeof(head), 1, f) == 1 &&
+        std::fwrite(offsets_.data(), 8, offsets_.size(), f) == offsets_.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) std::remove(path.c_str());
+}
+
+bool XtcReader::frameExtent(size_t index, uint64_t& offset, size_t& size) const {
+    if (index >= frameCount()) return false;
+    offset = offsets_[index];
+    size = size_t(offsets_[index + 1] - offset);
+    return true;
+}
+
+bool XtcReader::decodeFrame(size_t index, const uint8_t* data, size_t size, TrajectoryFrame& out) const {
+    size_t n = 0;
+    if (frameLength(data, size, n) != size || n != atomCount_) return false;
+
+    out.resize(atomCount_);
+    out.step = readInt(data + 8);
+    out.time = readFloat(data + 12);
+    for (int k = 0; k < 9; ++k) out.box[k] = readFloat(data + 16 + 4 * k) * kNmToAngstrom;
+
+    if (atomCount_ <= 9) {
+        const uint8_t* c = data + kFrameHeader;
+        for (size_t a = 0; a < atomCount_; ++a) {
+            out.x[a] = readFloat(c + 12 * a) * kNmToAngstrom;
+            out.y[a] = readFloat(c + 12 * a + 4) * kNmToAngstrom;
+            out.z[a] = readFloat(c + 12 * a + 8) * kNmToAngstrom;
+        }
+    }
+    else if (!decodeCompressed(data, size, atomCount_, out)) {
+        out.index = size_t(-1);
+        return false;
+    }
+    out.index = index;
+    return true;
+}